@@ -28,6 +28,10 @@
 //		Cleaned up C++ structure for modern compilers
 //	Revision 1.1  05/03/05
 //		Added fixed-radius k-NN searching
+//	Revision 1.1-dfx  10/19/26
+//		Added ANNkd_flat_tree
+//		Added parallel construction of kd- and bd-trees
+//		Made standard search reentrant, and added batch search
 //----------------------------------------------------------------------
 
 //----------------------------------------------------------------------
@@ -91,6 +95,7 @@
 
 #include <cmath>			// math includes
 #include <iostream>			// I/O streams
+#include <cstddef>			// size_t
 
 //----------------------------------------------------------------------
 // Limits
@@ -628,19 +633,33 @@ const int ANN_N_SHRINK_RULES	= 4;	// number of shrink rules
 //		builds a tree from a file description that was created by the
 //		Dump operation.
 //
+//		The last argument of the constructor is the maximum number of
+//		threads to build the tree with (default = 1, and 0 means one
+//		per processor).  With more than one, large subtrees are built
+//		in parallel.  The resulting tree is identical to the one built
+//		with a single thread, so searches return the same results.
+//
 //		Search:
 //		-------
 //		There are two search methods:
 //
 //			Standard search (annkSearch()):
 //				Searches nodes in tree-traversal order, always visiting
-//				the closer child first.
+//				the closer child first.  This keeps its state on the
+//				stack, so several threads may search one tree at once.
+//				annkSearchBatch() does standard searches for many query
+//				points, ordered so that consecutive queries tend to
+//				visit the same nodes, and optionally with several
+//				threads (0 = one per processor).  The results for the
+//				i-th query point are elements i*k through i*k+k-1 of
+//				the result arrays.
 //			Priority search (annkPriSearch()):
 //				Searches nodes in order of increasing distance of the
 //				associated cell from the query point.  For many
 //				distributions the standard search seems to work just
 //				fine, but priority search is safer for worst-case
-//				performance.
+//				performance.  (Priority and fixed-radius searches use
+//				global variables, so only one may run at a time.)
 //
 //		Printing:
 //		---------
@@ -693,6 +712,9 @@ const int ANN_N_SHRINK_RULES	= 4;	// number of shrink rules
 //		bkt_size				Maximum bucket size (no. of points per leaf)
 //		bnd_box_lo				Bounding box low point
 //		bnd_box_hi				Bounding box high point
+//		arena					Storage of the nodes, if the tree was
+//								built in parallel (otherwise NULL, and
+//								the nodes are allocated individually)
 //		splitRule				Splitting method used
 //
 //----------------------------------------------------------------------
@@ -704,6 +726,8 @@ const int ANN_N_SHRINK_RULES	= 4;	// number of shrink rules
 class ANNkdStats;				// stats on kd-tree
 class ANNkd_node;				// generic node in a kd-tree
 typedef ANNkd_node*	ANNkd_ptr;	// pointer to a kd-tree node
+class ANNkd_flat_tree;			// flattened kd-tree
+class ANNkd_arena;				// node storage for parallel builds
 
 class DLL_API ANNkd_tree: public ANNpointSet {
 protected:
@@ -715,6 +739,7 @@ protected:
 	ANNkd_ptr		root;				// root of kd-tree
 	ANNpoint		bnd_box_lo;			// bounding box low point
 	ANNpoint		bnd_box_hi;			// bounding box high point
+	ANNkd_arena*	arena;				// node storage (parallel builds)
 
 	void SkeletonTree(					// construct skeleton tree
 		int				n,				// number of points
@@ -734,7 +759,8 @@ public:
 		int				n,				// number of points
 		int				dd,				// dimension
 		int				bs = 1,			// bucket size
-		ANNsplitRule	split = ANN_KD_SUGGEST);	// splitting method
+		ANNsplitRule	split = ANN_KD_SUGGEST,		// splitting method
+		int				n_threads = 1);	// max threads to build with
 
 	ANNkd_tree(							// build from dump file
 		std::istream&	in);			// input stream for dump file
@@ -748,6 +774,15 @@ public:
 		ANNdistArray	dd,				// dist to near neighbors (modified)
 		double			eps=0.0);		// error bound
 
+	void annkSearchBatch(				// many k near neighbor searches
+		ANNpointArray	q,				// query points
+		int				m,				// number of query points
+		int				k,				// number of near neighbors to return
+		ANNidxArray		nn_idx,			// nearest neighbor array (modified)
+		ANNdistArray	dd,				// dist to near neighbors (modified)
+		double			eps=0.0,		// error bound
+		int				n_threads=1);	// max threads to search with
+
 	void annkPriSearch( 				// priority k near neighbor search
 		ANNpoint		q,				// query point
 		int				k,				// number of near neighbors to return
@@ -782,6 +817,8 @@ public:
 								
 	virtual void getStats(				// compute tree statistics
 		ANNkdStats&		st);			// the statistics (modified)
+
+	friend class ANNkd_flat_tree;		// allow flattening us
 };								
 
 //----------------------------------------------------------------------
@@ -811,12 +848,113 @@ public:
 		int				dd,				// dimension
 		int				bs = 1,			// bucket size
 		ANNsplitRule	split  = ANN_KD_SUGGEST,	// splitting rule
-		ANNshrinkRule	shrink = ANN_BD_SUGGEST);	// shrinking rule
+		ANNshrinkRule	shrink = ANN_BD_SUGGEST,	// shrinking rule
+		int				n_threads = 1);	// max threads to build with
 
 	ANNbd_tree(							// build from dump file
 		std::istream&	in);			// input stream for dump file
 };
 
+//----------------------------------------------------------------------
+//	Flattened kd-tree
+//		A flattened kd-tree answers the same queries as the kd-tree it
+//		was made from, with the same results, but it lives in a single
+//		block of memory (its "image") that holds no pointers and
+//		contains its own copy of the points.  The image can be written
+//		to a file and then used in place, for instance from a
+//		read-only memory mapping shared by several processes.
+//
+//		Construction:
+//		-------------
+//		The first constructor flattens an existing kd-tree into a newly
+//		allocated image, which is deleted with the flattened tree.  The
+//		original tree (and its points) may be deleted afterwards.
+//		bd-trees cannot be flattened, since there is no flat form of
+//		shrinking nodes.
+//
+//		The second constructor uses an existing image, which is not
+//		copied, and which must remain unchanged throughout the lifetime
+//		of the flattened tree.  The image must be valid, which can be
+//		checked beforehand with isValidImage().  An image is only valid
+//		on machines with the same byte order and coordinate type as the
+//		one that made it, and it must be aligned to 64 bytes.
+//
+//		Search:
+//		-------
+//		Standard search (annkSearch()) visits nodes in the same order
+//		as ANNkd_tree::annkSearch().  It keeps all of its state on the
+//		stack, so one flattened tree may be searched by several threads
+//		at once.  annkSearchBatch() is as in ANNkd_tree.  Where SIMD instructions are available, the points of
+//		a bucket are compared with the query point several at a time,
+//		so trees built with a bucket size of 8 or so are generally
+//		searched faster than trees with one point per leaf.
+//
+//		See the file src/kd_flat.h for the layout of the image.
+//----------------------------------------------------------------------
+
+struct ANNflatNode;						// node in a flattened kd-tree
+
+class DLL_API ANNkd_flat_tree {
+	int				dim;				// dimension of space
+	int				n_pts;				// number of points in tree
+	int				n_nodes;			// number of nodes in tree
+	void*			owned_image;		// image storage (if we own it)
+	const char*		image;				// the image
+	size_t			image_size;			// size of image in bytes
+	const ANNflatNode* nodes;			// tree nodes (in the image)
+	const ANNcoord*	bnd_box_lo;			// bounding box low point
+	const ANNcoord*	bnd_box_hi;			// bounding box high point
+	const ANNidx*	pidx;				// point indices
+	const ANNcoord*	coords;				// point coordinates, by bucket
+
+	void bindImage();					// locate sections of image
+
+	ANNkd_flat_tree(const ANNkd_flat_tree&);			// not copyable
+	ANNkd_flat_tree& operator=(const ANNkd_flat_tree&);
+
+public:
+	ANNkd_flat_tree(					// flatten a kd-tree
+		ANNkd_tree&		tree);			// the tree
+
+	ANNkd_flat_tree(					// use an existing image
+		const void*		img,			// the image
+		size_t			size);			// size of image in bytes
+
+	~ANNkd_flat_tree();					// tree destructor
+
+	static ANNbool isValidImage(		// can an image be used?
+		const void*		img,			// the image
+		size_t			size);			// size of image in bytes
+
+	void annkSearch(					// approx k near neighbor search
+		ANNpoint		q,				// query point
+		int				k,				// number of near neighbors to return
+		ANNidxArray		nn_idx,			// nearest neighbor array (modified)
+		ANNdistArray	dd,				// dist to near neighbors (modified)
+		double			eps=0.0) const;	// error bound
+
+	void annkSearchBatch(				// many k near neighbor searches
+		ANNpointArray	q,				// query points
+		int				m,				// number of query points
+		int				k,				// number of near neighbors to return
+		ANNidxArray		nn_idx,			// nearest neighbor array (modified)
+		ANNdistArray	dd,				// dist to near neighbors (modified)
+		double			eps=0.0,		// error bound
+		int				n_threads=1) const;	// max threads to search with
+
+	int theDim() const					// return dimension of space
+		{ return dim; }
+
+	int nPoints() const					// return number of points
+		{ return n_pts; }
+
+	const void* theImage() const		// return the image
+		{ return image; }
+
+	size_t theImageSize() const			// return size of image in bytes
+		{ return image_size; }
+};
+
 //----------------------------------------------------------------------
 //	Other functions
 //	annMaxPtsVisit		Sets a limit on the maximum number of points
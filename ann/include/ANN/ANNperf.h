@@ -185,15 +185,22 @@ public :
 //
 //	data_pts	The number of data points.  This is not
 //				a counter, but used in stats computation.
+//
+//	The per-query counters are thread-local, since searches can run
+//	on several threads at once.  (Building a tree doesn't touch
+//	them.)  annResetCounts() and annUpdateStats() see only the
+//	calling thread's counts, so the work of threaded batch searches
+//	is not included in the statistics.  The statistics themselves
+//	are not guarded, so only one thread should collect them.
 //----------------------------------------------------------------------
 
 extern int			ann_Ndata_pts;	// number of data points
-extern int			ann_Nvisit_lfs;	// number of leaf nodes visited
-extern int			ann_Nvisit_spl;	// number of splitting nodes visited
-extern int			ann_Nvisit_shr;	// number of shrinking nodes visited
-extern int			ann_Nvisit_pts;	// visited points for one query
-extern int			ann_Ncoord_hts;	// coordinate hits for one query
-extern int			ann_Nfloat_ops;	// floating ops for one query
+extern thread_local int	ann_Nvisit_lfs;	// number of leaf nodes visited
+extern thread_local int	ann_Nvisit_spl;	// number of splitting nodes visited
+extern thread_local int	ann_Nvisit_shr;	// number of shrinking nodes visited
+extern thread_local int	ann_Nvisit_pts;	// visited points for one query
+extern thread_local int	ann_Ncoord_hts;	// coordinate hits for one query
+extern thread_local int	ann_Nfloat_ops;	// floating ops for one query
 extern ANNsampStat	ann_visit_lfs;	// stats on leaf nodes visits
 extern ANNsampStat	ann_visit_spl;	// stats on splitting nodes visits
 extern ANNsampStat	ann_visit_shr;	// stats on shrinking nodes visits
@@ -2,7 +2,7 @@
 // File:			bd_search.cpp
 // Programmer:		David Mount
 // Description:		Standard bd-tree search
-// Last modified:	01/04/05 (Version 1.0)
+// Last modified:	10/19/26 (Version 1.1-dfx)
 //----------------------------------------------------------------------
 // Copyright (c) 1997-2005 University of Maryland and Sunil Arya and
 // David Mount.  All Rights Reserved.
@@ -20,6 +20,9 @@
 // History:
 //	Revision 0.1  03/04/98
 //		Initial release
+//	Revision 1.1-dfx  10/19/26
+//		Replaced the search globals with a search context
+//		Added ann_path
 //----------------------------------------------------------------------
 
 #include "bd_tree.h"					// bd-tree declarations
@@ -36,26 +39,46 @@
 //	bd_shrink::ann_search - search a shrinking node
 //----------------------------------------------------------------------
 
-void ANNbd_shrink::ann_search(ANNdist box_dist)
+void ANNbd_shrink::ann_search(ANNkd_search &s, ANNdist box_dist)
 {
 												// check dist calc term cond.
-	if (ANNmaxPtsVisited != 0 && ANNptsVisited > ANNmaxPtsVisited) return;
+	if (ANNmaxPtsVisited != 0 && s.pts_visited > ANNmaxPtsVisited) return;
 
 	ANNdist inner_dist = 0;						// distance to inner box
 	for (int i = 0; i < n_bnds; i++) {			// is query point in the box?
-		if (bnds[i].out(ANNkdQ)) {				// outside this bounding side?
+		if (bnds[i].out(s.q)) {					// outside this bounding side?
 												// add to inner distance
-			inner_dist = (ANNdist) ANN_SUM(inner_dist, bnds[i].dist(ANNkdQ));
+			inner_dist = (ANNdist) ANN_SUM(inner_dist, bnds[i].dist(s.q));
 		}
 	}
 	if (inner_dist <= box_dist) {				// if inner box is closer
-		child[ANN_IN]->ann_search(inner_dist);	// search inner child first
-		child[ANN_OUT]->ann_search(box_dist);	// ...then outer child
+		child[ANN_IN]->ann_search(s, inner_dist);	// search inner child first
+		child[ANN_OUT]->ann_search(s, box_dist);	// ...then outer child
 	}
 	else {										// if outer box is closer
-		child[ANN_OUT]->ann_search(box_dist);	// search outer child first
-		child[ANN_IN]->ann_search(inner_dist);	// ...then outer child
+		child[ANN_OUT]->ann_search(s, box_dist);	// search outer child first
+		child[ANN_IN]->ann_search(s, inner_dist);	// ...then outer child
 	}
 	ANN_FLOP(3*n_bnds)							// increment floating ops
 	ANN_SHR(1)									// one more shrinking node
 }
+
+//----------------------------------------------------------------------
+//	bd_shrink::ann_path - find the path to the leaf a query visits first
+//		(This takes the inner child if the query is inside its box,
+//		otherwise the outer child.  See kd_search.cpp.)
+//----------------------------------------------------------------------
+
+void ANNbd_shrink::ann_path(ANNpoint q, int depth, uint64_t &path)
+{
+	if (depth == 0) return;						// deep enough
+	int side = ANN_IN;
+	for (int i = 0; i < n_bnds; i++) {			// is query point in the box?
+		if (bnds[i].out(q)) {
+			side = ANN_OUT;
+			break;
+		}
+	}
+	path = (path << 1) | side;
+	child[side]->ann_path(q, depth-1, path);
+}
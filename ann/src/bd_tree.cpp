@@ -2,7 +2,7 @@
 // File:			bd_tree.cpp
 // Programmer:		David Mount
 // Description:		Basic methods for bd-trees.
-// Last modified:	01/04/05 (Version 1.0)
+// Last modified:	10/19/26 (Version 1.1-dfx)
 //----------------------------------------------------------------------
 // Copyright (c) 1997-2005 University of Maryland and Sunil Arya and
 // David Mount.  All Rights Reserved.
@@ -24,8 +24,12 @@
 //		Fixed centroid shrink threshold condition to depend on the
 //			dimension.
 //		Moved dump routine to kd_dump.cpp.
+//	Revision 1.1-dfx  10/19/26
+//		Added parallel construction.
 //----------------------------------------------------------------------
 
+#include <memory>						// uninitialized_copy
+
 #include "bd_tree.h"					// bd-tree declarations
 #include "kd_util.h"					// kd-tree utilities
 #include "kd_split.h"					// kd-tree splitting rules
@@ -111,7 +115,8 @@ ANNkd_ptr rbd_tree(						// recursive construction of bd-tree
 	int					bsp,			// bucket space
 	ANNorthRect			&bnd_box,		// bounding box for current node
 	ANNkd_splitter		splitter,		// splitting routine
-	ANNshrinkRule		shrink);		// shrinking rule
+	ANNshrinkRule		shrink,			// shrinking rule
+	ANNkd_build			*bld);			// parallel build context
 
 ANNbd_tree::ANNbd_tree(					// construct from point array
 	ANNpointArray		pa,				// point array (with at least n pts)
@@ -119,12 +124,21 @@ ANNbd_tree::ANNbd_tree(					// construct from point array
 	int					dd,				// dimension
 	int					bs,				// bucket size
 	ANNsplitRule		split,			// splitting rule
-	ANNshrinkRule		shrink)			// shrinking rule
+	ANNshrinkRule		shrink,			// shrinking rule
+	int					n_threads)		// max threads to build with
 	: ANNkd_tree(n, dd, bs)				// build skeleton base tree
 {
 	pts = pa;							// where the points are
 	if (n == 0) return;					// no points--no sweat
 
+	ANNkd_build build = {NULL, annNumThreads(n_threads)};
+	ANNkd_build *bld = NULL;			// build context (if parallel)
+	if (build.n_threads > 1) {
+		arena = new ANNkd_arena;
+		build.arena = arena;
+		bld = &build;
+	}
+
 	ANNorthRect bnd_box(dd);			// bounding box for points
 										// construct bounding rectangle
 	annEnclRect(pa, pidx, n, dd, bnd_box);
@@ -134,21 +148,21 @@ ANNbd_tree::ANNbd_tree(					// construct from point array
 
 	switch (split) {					// build by rule
 	case ANN_KD_STD:					// standard kd-splitting rule
-		root = rbd_tree(pa, pidx, n, dd, bs, bnd_box, kd_split, shrink);
+		root = rbd_tree(pa, pidx, n, dd, bs, bnd_box, kd_split, shrink, bld);
 		break;
 	case ANN_KD_MIDPT:					// midpoint split
-		root = rbd_tree(pa, pidx, n, dd, bs, bnd_box, midpt_split, shrink);
+		root = rbd_tree(pa, pidx, n, dd, bs, bnd_box, midpt_split, shrink, bld);
 		break;
 	case ANN_KD_SUGGEST:				// best (in our opinion)
 	case ANN_KD_SL_MIDPT:				// sliding midpoint split
-		root = rbd_tree(pa, pidx, n, dd, bs, bnd_box, sl_midpt_split, shrink);
+		root = rbd_tree(pa, pidx, n, dd, bs, bnd_box, sl_midpt_split, shrink, bld);
 		break;
 	case ANN_KD_FAIR:					// fair split
-		root = rbd_tree(pa, pidx, n, dd, bs, bnd_box, fair_split, shrink);
+		root = rbd_tree(pa, pidx, n, dd, bs, bnd_box, fair_split, shrink, bld);
 		break;
 	case ANN_KD_SL_FAIR:				// sliding fair split
 		root = rbd_tree(pa, pidx, n, dd, bs,
-						bnd_box, sl_fair_split, shrink);
+						bnd_box, sl_fair_split, shrink, bld);
 		break;
 	default:
 		annError("Illegal splitting method", ANNabort);
@@ -329,7 +343,8 @@ ANNdecomp selectDecomp(			// select decomposition method
 //		procedure returns a bounding box, from which we extract the
 //		appropriate shrinking bounds, and create a shrinking node.
 //		Finally the points are subdivided, and the procedure is
-//		invoked recursively on the two subsets to form the children.
+//		invoked recursively on the two subsets to form the children
+//		(in parallel, if there is a build context that allows it).
 //----------------------------------------------------------------------
 
 ANNkd_ptr rbd_tree(				// recursive construction of bd-tree
@@ -340,8 +355,10 @@ ANNkd_ptr rbd_tree(				// recursive construction of bd-tree
 	int					bsp,			// bucket space
 	ANNorthRect			&bnd_box,		// bounding box for current node
 	ANNkd_splitter		splitter,		// splitting routine
-	ANNshrinkRule		shrink)			// shrinking rule
+	ANNshrinkRule		shrink,			// shrinking rule
+	ANNkd_build			*bld)			// parallel build context
 {
+	ANNkd_arena *arena = (bld != NULL ? bld->arena : NULL);
 	ANNdecomp decomp;					// decomposition method
 
 	ANNorthRect inner_box(dim);			// inner box (if shrinking)
@@ -350,7 +367,7 @@ ANNkd_ptr rbd_tree(				// recursive construction of bd-tree
 		if (n == 0)						// empty leaf node
 			return KD_TRIVIAL;			// return (canonical) empty leaf
 		else							// construct the node and return
-			return new ANNkd_leaf(n, pidx); 
+			return new (arena) ANNkd_leaf(n, pidx); 
 	}
 	
 	decomp = selectDecomp(				// select decomposition method
@@ -370,19 +387,24 @@ ANNkd_ptr rbd_tree(				// recursive construction of bd-tree
 		ANNcoord lv = bnd_box.lo[cd];	// save bounds for cutting dimension
 		ANNcoord hv = bnd_box.hi[cd];
 
-		bnd_box.hi[cd] = cv;			// modify bounds for left subtree
-		ANNkd_ptr lo = rbd_tree(		// build left subtree
-				pa, pidx, n_lo,			// ...from pidx[0..n_lo-1]
-				dim, bsp, bnd_box, splitter, shrink);
-		bnd_box.hi[cd] = hv;			// restore bounds
-
-		bnd_box.lo[cd] = cv;			// modify bounds for right subtree
-		ANNkd_ptr hi = rbd_tree(		// build right subtree
-				pa, pidx + n_lo, n-n_lo,// ...from pidx[n_lo..n-1]
-				dim, bsp, bnd_box, splitter, shrink);
-		bnd_box.lo[cd] = lv;			// restore bounds
+		ANNkd_ptr lo, hi;				// low and high children
+		annBuildChildren(bld, n, dim, bnd_box,
+			[&](ANNkd_build *b, ANNorthRect &box) {
+				box.hi[cd] = cv;		// modify bounds for left subtree
+				lo = rbd_tree(			// build left subtree
+						pa, pidx, n_lo,	// ...from pidx[0..n_lo-1]
+						dim, bsp, box, splitter, shrink, b);
+				box.hi[cd] = hv;		// restore bounds
+			},
+			[&](ANNkd_build *b, ANNorthRect &box) {
+				box.lo[cd] = cv;		// modify bounds for right subtree
+				hi = rbd_tree(			// build right subtree
+						pa, pidx + n_lo, n-n_lo,// ...from pidx[n_lo..n-1]
+						dim, bsp, box, splitter, shrink, b);
+				box.lo[cd] = lv;		// restore bounds
+			});
 										// create the splitting node
-		return new ANNkd_split(cd, cv, lv, hv, lo, hi);
+		return new (arena) ANNkd_split(cd, cv, lv, hv, lo, hi);
 	}
 	else {								// shrink selected
 		int n_in;						// number of points in box
@@ -396,10 +418,18 @@ ANNkd_ptr rbd_tree(				// recursive construction of bd-tree
 				inner_box,				// inner box
 				n_in);					// number of points inside (returned)
 
-		ANNkd_ptr in = rbd_tree(		// build inner subtree pidx[0..n_in-1]
-				pa, pidx, n_in, dim, bsp, inner_box, splitter, shrink);
-		ANNkd_ptr out = rbd_tree(		// build outer subtree pidx[n_in..n]
-				pa, pidx+n_in, n - n_in, dim, bsp, bnd_box, splitter, shrink);
+		ANNkd_ptr in, out;				// inner and outer children
+										// (the inner box is separate,
+										// so the boxes aren't passed)
+		annBuildChildren(bld, n, dim, bnd_box,
+			[&](ANNkd_build *b, ANNorthRect &) {
+				in = rbd_tree(			// build inner subtree pidx[0..n_in-1]
+						pa, pidx, n_in, dim, bsp, inner_box, splitter, shrink, b);
+			},
+			[&](ANNkd_build *b, ANNorthRect &) {
+				out = rbd_tree(			// build outer subtree pidx[n_in..n]
+						pa, pidx+n_in, n - n_in, dim, bsp, bnd_box, splitter, shrink, b);
+			});
 
 		ANNorthHSArray bnds = NULL;		// bounds (alloc in Box2Bnds and
 										// ...freed in bd_shrink destroyer)
@@ -411,7 +441,14 @@ ANNkd_ptr rbd_tree(				// recursive construction of bd-tree
 				n_bnds,					// number of bounds (returned)
 				bnds);					// bounds array (modified)
 
+		if (arena != NULL) {			// move the bounds to the arena
+			ANNorthHSArray arena_bnds = (ANNorthHSArray)
+					arena->alloc(n_bnds * sizeof(ANNorthHalfSpace));
+			uninitialized_copy(bnds, bnds + n_bnds, arena_bnds);
+			delete [] bnds;
+			bnds = arena_bnds;
+		}
 										// return shrinking node
-		return new ANNbd_shrink(n_bnds, bnds, in, out);
+		return new (arena) ANNbd_shrink(n_bnds, bnds, in, out);
 	}
 } 
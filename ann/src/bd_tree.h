@@ -22,6 +22,8 @@
 //		Initial release
 //	Revision 1.0  04/01/05
 //		Changed IN, OUT to ANN_IN, ANN_OUT
+//	Revision 1.1-dfx  10/19/26
+//		Added flatten, and made standard search reentrant
 //----------------------------------------------------------------------
 
 #ifndef ANN_bd_tree_H
@@ -91,8 +93,12 @@ public:
 				ANNorthRect &bnd_box);			// bounding box
 	virtual void print(int level, ostream &out);// print node
 	virtual void dump(ostream &out);			// dump node
+	virtual void flatten(ANNkd_flattener &fl);	// flatten node
+												// path to query's leaf
+	virtual void ann_path(ANNpoint q, int depth, uint64_t &path);
 
-	virtual void ann_search(ANNdist);			// standard search
+												// standard search
+	virtual void ann_search(ANNkd_search &s, ANNdist);
 	virtual void ann_pri_search(ANNdist);		// priority search
 	virtual void ann_FR_search(ANNdist); 		// fixed-radius search
 };
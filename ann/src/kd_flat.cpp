@@ -0,0 +1,519 @@
+//----------------------------------------------------------------------
+// File:			kd_flat.cpp
+// Programmer:		Destroy FX
+// Description:		Flattened kd-trees
+// Last modified:	10/19/26 (Version 1.1-dfx)
+//----------------------------------------------------------------------
+// Copyright (c) 1997-2005 University of Maryland and Sunil Arya and
+// David Mount.  All Rights Reserved.
+//
+// This software and related documentation is part of the Approximate
+// Nearest Neighbor Library (ANN).  This software is provided under
+// the provisions of the Lesser GNU Public License (LGPL).  See the
+// file ../ReadMe.txt for further information.
+//
+// The University of Maryland (U.M.) and the authors make no
+// representations about the suitability or fitness of this software for
+// any purpose.  It is provided "as is" without express or implied
+// warranty.
+//----------------------------------------------------------------------
+// History:
+//	Revision 1.1-dfx  10/19/26
+//		Initial release
+//		Added SIMD leaf scanning
+//		Added batch searching
+//----------------------------------------------------------------------
+// This file contains routines for flattening kd-trees into a single
+// pointer-free image, for checking such images, and for searching
+// them.  (The bd-tree node routine is here too, as in kd_dump.cpp.)
+//----------------------------------------------------------------------
+
+#include <cstring>						// memcpy, memcmp, memset
+#include <new>							// aligned operator new
+
+#include "kd_tree.h"					// kd-tree declarations
+#include "kd_util.h"					// kd-tree utilities
+#include "bd_tree.h"					// bd-tree declarations
+#include "kd_flat.h"					// flattened tree declarations
+#include "kd_search.h"					// batch searching
+#include "pr_queue_k.h"					// k-element priority queue
+
+#include <ANN/ANNperf.h>				// performance evaluation
+
+using namespace std;					// make std:: available
+
+//----------------------------------------------------------------------
+//	SIMD support
+//		Leaves store their points by coordinate, so distances to
+//		ANN_FLAT_LANES points of a bucket can be computed at once,
+//		one coordinate at a time.  Define ANN_FLAT_NO_SIMD to use
+//		the scalar code everywhere (for comparison).
+//----------------------------------------------------------------------
+
+#if defined(ANN_FLAT_NO_SIMD)
+	#define ANN_FLAT_SIMD 0
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>				// SSE
+	#define ANN_FLAT_SIMD 1
+	typedef __m128 ANNflatVec;
+	#define ANN_FLAT_SPLAT(x)		_mm_set1_ps(x)
+	#define ANN_FLAT_LOAD(p)		_mm_loadu_ps(p)
+	#define ANN_FLAT_STORE(p, v)	_mm_storeu_ps(p, v)
+	#define ANN_FLAT_ADD(x, y)		_mm_add_ps(x, y)
+	#define ANN_FLAT_SUB(x, y)		_mm_sub_ps(x, y)
+	#define ANN_FLAT_MUL(x, y)		_mm_mul_ps(x, y)
+	#define ANN_FLAT_ALL_GT(x, y)	(_mm_movemask_ps(_mm_cmpgt_ps(x, y)) == 0xF)
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#include <arm_neon.h>				// NEON
+	#define ANN_FLAT_SIMD 1
+	typedef float32x4_t ANNflatVec;
+	#define ANN_FLAT_SPLAT(x)		vdupq_n_f32(x)
+	#define ANN_FLAT_LOAD(p)		vld1q_f32(p)
+	#define ANN_FLAT_STORE(p, v)	vst1q_f32(p, v)
+	#define ANN_FLAT_ADD(x, y)		vaddq_f32(x, y)
+	#define ANN_FLAT_SUB(x, y)		vsubq_f32(x, y)
+	#define ANN_FLAT_MUL(x, y)		vmulq_f32(x, y)
+	#define ANN_FLAT_ALL_GT(x, y)	(vminvq_u32(vcgtq_f32(x, y)) != 0)
+#else
+	#define ANN_FLAT_SIMD 0
+#endif
+
+#if ANN_FLAT_SIMD
+const int		ANN_FLAT_LANES		= 4;	// points per SIMD step
+										// (these are float vectors)
+static_assert(sizeof(ANNcoord) == sizeof(float), "SIMD leaf scanning assumes float coordinates");
+static_assert(sizeof(ANNdist) == sizeof(float), "SIMD leaf scanning assumes float distances");
+#endif
+
+static_assert(sizeof(ANNidx) == sizeof(int32_t), "point indices are stored as 32 bits");
+
+//----------------------------------------------------------------------
+//	annFlatLayout - compute the section offsets of an image
+//----------------------------------------------------------------------
+
+static size_t annFlatAlign(size_t offset)	// round up to section boundary
+{
+	return (offset + ANN_FLAT_ALIGN - 1) & ~(ANN_FLAT_ALIGN - 1);
+}
+
+ANNflatLayout annFlatLayout(			// compute section offsets
+	int					dim,			// dimension of space
+	int					n_pts,			// number of points
+	int					n_nodes)		// number of nodes
+{
+	ANNflatLayout lay;
+	lay.nodes = annFlatAlign(sizeof(ANNflatHeader));
+	lay.bnd_box_lo = annFlatAlign(lay.nodes + (size_t) n_nodes * sizeof(ANNflatNode));
+	lay.bnd_box_hi = annFlatAlign(lay.bnd_box_lo + (size_t) dim * sizeof(ANNcoord));
+	lay.pidx = annFlatAlign(lay.bnd_box_hi + (size_t) dim * sizeof(ANNcoord));
+	lay.coords = annFlatAlign(lay.pidx + (size_t) n_pts * sizeof(ANNidx));
+	lay.size = annFlatAlign(lay.coords + (size_t) n_pts * dim * sizeof(ANNcoord));
+	return lay;
+}
+
+//----------------------------------------------------------------------
+//	flatten - append a node (and its subtree) to a flattener
+//		Nodes are appended in preorder, so the low child of a
+//		splitting node is always the next node.  Each leaf appends
+//		its bucket's point indices and coordinates.
+//----------------------------------------------------------------------
+
+void ANNkd_split::flatten(				// flatten a splitting node
+		ANNkd_flattener &fl)			// flattener
+{
+	ANNflatNode nd;
+	nd.cut_val = cut_val;
+	nd.cd_bnds[ANN_LO] = cd_bnds[ANN_LO];
+	nd.cd_bnds[ANN_HI] = cd_bnds[ANN_HI];
+	nd.cut_dim = cut_dim;
+	nd.hi_child = 0;					// filled in below
+	nd.bkt_start = 0;
+	nd.bkt_size = 0;
+
+	size_t here = fl.nodes.size();
+	fl.nodes.push_back(nd);
+	child[ANN_LO]->flatten(fl);			// low child follows directly
+	fl.nodes[here].hi_child = (int32_t) fl.nodes.size();
+	child[ANN_HI]->flatten(fl);			// then the high child
+}
+
+void ANNkd_leaf::flatten(				// flatten a leaf node
+		ANNkd_flattener &fl)			// flattener
+{
+	ANNflatNode nd;
+	nd.cut_val = 0;
+	nd.cd_bnds[ANN_LO] = 0;
+	nd.cd_bnds[ANN_HI] = 0;
+	nd.cut_dim = ANN_FLAT_LEAF;
+	nd.hi_child = 0;
+	nd.bkt_start = (int32_t) fl.pidx.size();
+	nd.bkt_size = n_pts;				// (zero for KD_TRIVIAL)
+	fl.nodes.push_back(nd);
+
+	for (int j = 0; j < n_pts; j++) {	// point indices
+		fl.pidx.push_back(bkt[j]);
+	}
+	for (int d = 0; d < fl.dim; d++) {	// coordinates, one dim at a time
+		for (int j = 0; j < n_pts; j++) {
+			fl.coords.push_back(fl.pts[bkt[j]][d]);
+		}
+	}
+}
+
+void ANNbd_shrink::flatten(				// flatten a shrinking node
+		ANNkd_flattener &)				// flattener (unused)
+{
+	annError("Flattened trees cannot hold bd-tree shrinking nodes", ANNabort);
+}
+
+//----------------------------------------------------------------------
+//	Flattened tree constructors and destructor
+//----------------------------------------------------------------------
+
+ANNkd_flat_tree::ANNkd_flat_tree(		// flatten a kd-tree
+	ANNkd_tree&			tree)			// the tree
+{
+	ANNkd_flattener fl(tree.dim, tree.pts);
+	tree.root->flatten(fl);				// collect nodes in preorder
+
+	dim = tree.dim;
+	n_pts = (int) fl.pidx.size();
+	n_nodes = (int) fl.nodes.size();
+	ANNflatLayout lay = annFlatLayout(dim, n_pts, n_nodes);
+
+	image_size = lay.size;
+	owned_image = ::operator new(image_size, align_val_t(ANN_FLAT_ALIGN));
+	char* img = (char*) owned_image;
+	memset(img, 0, image_size);			// (so padding is reproducible)
+
+	ANNflatHeader hdr;
+	memcpy(hdr.magic, ANN_FLAT_MAGIC, sizeof(hdr.magic));
+	hdr.version = ANN_FLAT_VERSION;
+	hdr.byte_order = ANN_FLAT_BYTE_ORDER;
+	hdr.coord_size = sizeof(ANNcoord);
+	hdr.dim = dim;
+	hdr.n_pts = n_pts;
+	hdr.n_nodes = n_nodes;
+	hdr.image_size = image_size;
+	memcpy(img, &hdr, sizeof(hdr));
+
+	memcpy(img + lay.nodes, fl.nodes.data(), n_nodes * sizeof(ANNflatNode));
+	memcpy(img + lay.bnd_box_lo, tree.bnd_box_lo, dim * sizeof(ANNcoord));
+	memcpy(img + lay.bnd_box_hi, tree.bnd_box_hi, dim * sizeof(ANNcoord));
+	memcpy(img + lay.pidx, fl.pidx.data(), n_pts * sizeof(ANNidx));
+	memcpy(img + lay.coords, fl.coords.data(), fl.coords.size() * sizeof(ANNcoord));
+
+	image = img;
+	bindImage();
+}
+
+ANNkd_flat_tree::ANNkd_flat_tree(		// use an existing image
+	const void*			img,			// the image
+	size_t				size)			// size of image in bytes
+{
+	if (!isValidImage(img, size)) {
+		annError("Invalid flattened kd-tree image", ANNabort);
+	}
+	owned_image = NULL;
+	image = (const char*) img;
+	image_size = size;
+
+	ANNflatHeader hdr;
+	memcpy(&hdr, image, sizeof(hdr));
+	dim = hdr.dim;
+	n_pts = hdr.n_pts;
+	n_nodes = hdr.n_nodes;
+	bindImage();
+}
+
+ANNkd_flat_tree::~ANNkd_flat_tree()		// tree destructor
+{
+	if (owned_image != NULL) {
+		::operator delete(owned_image, align_val_t(ANN_FLAT_ALIGN));
+	}
+}
+
+void ANNkd_flat_tree::bindImage()		// locate sections of image
+{
+	ANNflatLayout lay = annFlatLayout(dim, n_pts, n_nodes);
+	nodes = (const ANNflatNode*) (image + lay.nodes);
+	bnd_box_lo = (const ANNcoord*) (image + lay.bnd_box_lo);
+	bnd_box_hi = (const ANNcoord*) (image + lay.bnd_box_hi);
+	pidx = (const ANNidx*) (image + lay.pidx);
+	coords = (const ANNcoord*) (image + lay.coords);
+}
+
+//----------------------------------------------------------------------
+//	isValidImage - check that an image can be searched safely
+//		Besides the header, this checks every node and point index,
+//		so that searching a corrupt image cannot wander outside of it.
+//		(Child indices always increase, so searches terminate.)
+//----------------------------------------------------------------------
+
+ANNbool ANNkd_flat_tree::isValidImage(	// can an image be used?
+	const void*			img,			// the image
+	size_t				size)			// size of image in bytes
+{
+	const char* base = (const char*) img;
+	if (base == NULL || ((size_t) base % ANN_FLAT_ALIGN) != 0) return ANNfalse;
+	if (size < sizeof(ANNflatHeader)) return ANNfalse;
+
+	ANNflatHeader hdr;
+	memcpy(&hdr, base, sizeof(hdr));
+	if (memcmp(hdr.magic, ANN_FLAT_MAGIC, sizeof(hdr.magic)) != 0) return ANNfalse;
+	if (hdr.version != ANN_FLAT_VERSION) return ANNfalse;
+	if (hdr.byte_order != ANN_FLAT_BYTE_ORDER) return ANNfalse;
+	if (hdr.coord_size != sizeof(ANNcoord)) return ANNfalse;
+	if (hdr.dim <= 0 || hdr.n_pts < 0 || hdr.n_nodes <= 0) return ANNfalse;
+										// (also guards the layout math)
+	if ((uint64_t) hdr.n_pts * (uint64_t) hdr.dim > size / sizeof(ANNcoord)) return ANNfalse;
+	if ((uint64_t) hdr.n_nodes > size / sizeof(ANNflatNode)) return ANNfalse;
+
+	ANNflatLayout lay = annFlatLayout(hdr.dim, hdr.n_pts, hdr.n_nodes);
+	if (hdr.image_size != lay.size || size < lay.size) return ANNfalse;
+
+	const ANNflatNode* nds = (const ANNflatNode*) (base + lay.nodes);
+	for (int i = 0; i < hdr.n_nodes; i++) {
+		const ANNflatNode &nd = nds[i];
+		if (nd.cut_dim == ANN_FLAT_LEAF) {
+			if (nd.bkt_start < 0 || nd.bkt_size < 0) return ANNfalse;
+			if ((int64_t) nd.bkt_start + nd.bkt_size > hdr.n_pts) return ANNfalse;
+		}
+		else {
+			if (nd.cut_dim < 0 || nd.cut_dim >= hdr.dim) return ANNfalse;
+			if (nd.hi_child <= i+1 || nd.hi_child >= hdr.n_nodes) return ANNfalse;
+		}
+	}
+
+	const ANNidx* idx = (const ANNidx*) (base + lay.pidx);
+	for (int i = 0; i < hdr.n_pts; i++) {
+		if (idx[i] < 0 || idx[i] >= hdr.n_pts) return ANNfalse;
+	}
+	return ANNtrue;
+}
+
+//----------------------------------------------------------------------
+//	Search state
+//		These are the flattened equivalents of the kd-tree search's
+//		global variables (see kd_search.cpp), kept in one structure
+//		on the caller's stack so that searches are reentrant.
+//----------------------------------------------------------------------
+
+struct ANNflatSearch {
+	const ANNflatNode*	nodes;			// tree nodes
+	const ANNidx*		pidx;			// point indices
+	const ANNcoord*		coords;			// point coordinates, by bucket
+	int					dim;			// dimension of space
+	ANNpoint			q;				// query point
+	double				max_err;		// max tolerable squared error
+	ANNmin_k*			point_mk;		// set of k closest points
+	int					pts_visited;	// number of points visited
+};
+
+//----------------------------------------------------------------------
+//	annFlatLeafSearch - search the points in a leaf
+//		A point is a candidate exactly when its whole distance is no
+//		more than the k-th smallest distance so far (partial sums only
+//		grow), so the SIMD steps compute whole distances and then
+//		consider the points one by one, in the same order as the
+//		scalar code.  A step stops early once all of its points are
+//		too far away.
+//----------------------------------------------------------------------
+
+static void annFlatLeafSearch(
+	ANNflatSearch		&s,				// search state
+	const ANNflatNode	&nd)			// the leaf
+{
+	ANNdist min_dist = s.point_mk->max_key();
+	int m = nd.bkt_size;
+	const ANNcoord* bkt = s.coords + (size_t) nd.bkt_start * s.dim;
+	int j = 0;
+
+#if ANN_FLAT_SIMD
+	for (; j + ANN_FLAT_LANES <= m; j += ANN_FLAT_LANES) {
+		ANNflatVec dist = ANN_FLAT_SPLAT(0);
+		ANNflatVec limit = ANN_FLAT_SPLAT(min_dist);
+		int d;
+
+		for (d = 0; d < s.dim; d++) {
+			ANN_COORD(ANN_FLAT_LANES)	// more coordinates hit
+			ANN_FLOP(4*ANN_FLAT_LANES)	// increment floating ops
+
+			ANNflatVec t = ANN_FLAT_SUB(ANN_FLAT_SPLAT(s.q[d]),
+					ANN_FLAT_LOAD(bkt + (size_t) d * m + j));
+			dist = ANN_FLAT_ADD(dist, ANN_FLAT_MUL(t, t));
+										// all exceed dist to k-th smallest?
+			if (ANN_FLAT_ALL_GT(dist, limit)) {
+				break;
+			}
+		}
+		if (d < s.dim) continue;		// none of them are among the k best
+
+		ANNdist lane_dist[ANN_FLAT_LANES];
+		ANN_FLAT_STORE(lane_dist, dist);
+		for (int l = 0; l < ANN_FLAT_LANES; l++) {
+			if (!(lane_dist[l] > min_dist) &&	// among the k best?
+			   (ANN_ALLOW_SELF_MATCH || lane_dist[l]!=0)) { // and no self-match problem
+				s.point_mk->insert(lane_dist[l], s.pidx[nd.bkt_start + j + l]);
+				min_dist = s.point_mk->max_key();
+			}
+		}
+	}
+#endif
+
+	for (; j < m; j++) {				// check remaining points in bucket
+		const ANNcoord* pp = bkt + j;	// first coord of this point
+		ANNdist dist = 0;
+		int d;
+
+		for (d = 0; d < s.dim; d++) {
+			ANN_COORD(1)				// one more coordinate hit
+			ANN_FLOP(4)					// increment floating ops
+
+			ANNcoord t = s.q[d] - pp[(size_t) d * m];
+										// exceeds dist to k-th smallest?
+			if( (dist = ANN_SUM(dist, ANN_POW(t))) > min_dist) {
+				break;
+			}
+		}
+
+		if (d >= s.dim &&					// among the k best?
+		   (ANN_ALLOW_SELF_MATCH || dist!=0)) { // and no self-match problem
+			s.point_mk->insert(dist, s.pidx[nd.bkt_start + j]);
+			min_dist = s.point_mk->max_key();
+		}
+	}
+	ANN_LEAF(1)							// one more leaf node visited
+	ANN_PTS(m)							// increment points visited
+	s.pts_visited += m;
+}
+
+//----------------------------------------------------------------------
+//	annFlatSearch - search a node of a flattened tree
+//		This follows ANNkd_split::ann_search and ANNkd_leaf::ann_search,
+//		computing each distance with the same operations in the same
+//		order, so that the results are identical to the kd-tree's.
+//----------------------------------------------------------------------
+
+static void annFlatSearch(
+	ANNflatSearch		&s,				// search state
+	int					i,				// node to search
+	ANNdist				box_dist)		// distance to the node's cell
+{
+	const ANNflatNode &nd = s.nodes[i];
+
+	if (nd.cut_dim == ANN_FLAT_LEAF) {	// leaf node
+		annFlatLeafSearch(s, nd);
+		return;
+	}
+										// check dist calc term condition
+	if (ANNmaxPtsVisited != 0 && s.pts_visited > ANNmaxPtsVisited) return;
+
+										// distance to cutting plane
+	ANNcoord cut_diff = s.q[nd.cut_dim] - nd.cut_val;
+
+	if (cut_diff < 0) {					// left of cutting plane
+		annFlatSearch(s, i+1, box_dist);// visit closer child first
+
+		ANNcoord box_diff = nd.cd_bnds[ANN_LO] - s.q[nd.cut_dim];
+		if (box_diff < 0)				// within bounds - ignore
+			box_diff = 0;
+										// distance to further box
+		box_dist = (ANNdist) ANN_SUM(box_dist,
+				ANN_DIFF(ANN_POW(box_diff), ANN_POW(cut_diff)));
+
+										// visit further child if close enough
+		if (box_dist * s.max_err < s.point_mk->max_key())
+			annFlatSearch(s, nd.hi_child, box_dist);
+	}
+	else {								// right of cutting plane
+		annFlatSearch(s, nd.hi_child, box_dist);// visit closer child first
+
+		ANNcoord box_diff = s.q[nd.cut_dim] - nd.cd_bnds[ANN_HI];
+		if (box_diff < 0)				// within bounds - ignore
+			box_diff = 0;
+										// distance to further box
+		box_dist = (ANNdist) ANN_SUM(box_dist,
+				ANN_DIFF(ANN_POW(box_diff), ANN_POW(cut_diff)));
+
+										// visit further child if close enough
+		if (box_dist * s.max_err < s.point_mk->max_key())
+			annFlatSearch(s, i+1, box_dist);
+	}
+	ANN_FLOP(10)						// increment floating ops
+	ANN_SPL(1)							// one more splitting node visited
+}
+
+//----------------------------------------------------------------------
+//	annkSearch - search for the k nearest neighbors
+//----------------------------------------------------------------------
+
+void ANNkd_flat_tree::annkSearch(
+	ANNpoint			q,				// the query point
+	int					k,				// number of near neighbors to return
+	ANNidxArray			nn_idx,			// nearest neighbor indices (returned)
+	ANNdistArray		dd,				// the approximate nearest neighbor
+	double				eps) const		// the error bound
+{
+	if (k > n_pts) {					// too many near neighbors?
+		annError("Requesting more near neighbors than data points", ANNabort);
+	}
+
+	ANNmin_k point_mk(k);				// set for closest k points
+
+	ANNflatSearch s;
+	s.nodes = nodes;
+	s.pidx = pidx;
+	s.coords = coords;
+	s.dim = dim;
+	s.q = q;
+	s.max_err = ANN_POW(1.0 + eps);
+	s.point_mk = &point_mk;
+	s.pts_visited = 0;
+	ANN_FLOP(2)							// increment floating op count
+
+										// search starting at the root
+	annFlatSearch(s, 0, annBoxDistance(q, (ANNpoint) bnd_box_lo, (ANNpoint) bnd_box_hi, dim));
+
+	for (int i = 0; i < k; i++) {		// extract the k-th closest points
+		dd[i] = point_mk.ith_smallest_key(i);
+		nn_idx[i] = point_mk.ith_smallest_info(i);
+	}
+}
+
+//----------------------------------------------------------------------
+//	annkSearchBatch - search for the k nearest neighbors of many points
+//		(See ANNkd_tree::annkSearchBatch() and ann_path() in
+//		kd_search.cpp.)
+//----------------------------------------------------------------------
+
+void ANNkd_flat_tree::annkSearchBatch(
+	ANNpointArray		q,				// the query points
+	int					m,				// number of query points
+	int					k,				// number of near neighbors to return
+	ANNidxArray			nn_idx,			// nearest neighbor indices (returned)
+	ANNdistArray		dd,				// the approximate nearest neighbors
+	double				eps,			// the error bound
+	int					n_threads) const// max threads to search with
+{
+	if (k > n_pts) {					// too many near neighbors?
+		annError("Requesting more near neighbors than data points", ANNabort);
+	}
+
+	annBatch(m, n_threads,
+		[&](int i) {					// path of a query
+			uint64_t path = 0;
+			int depth = ANN_PATH_DEPTH;
+			int j = 0;
+			while (depth > 0 && nodes[j].cut_dim != ANN_FLAT_LEAF) {
+				int side = (q[i][nodes[j].cut_dim] < nodes[j].cut_val ? ANN_LO : ANN_HI);
+				path = (path << 1) | side;
+				j = (side == ANN_LO ? j+1 : nodes[j].hi_child);
+				depth--;
+			}
+			return path << depth;		// pad to full depth
+		},
+		[&](int i) {					// search for a query
+			annkSearch(q[i], k, nn_idx + (size_t) i * k, dd + (size_t) i * k, eps);
+		});
+}
@@ -0,0 +1,122 @@
+//----------------------------------------------------------------------
+// File:			kd_flat.h
+// Programmer:		Destroy FX
+// Description:		Declarations for flattened kd-tree images
+// Last modified:	10/19/26 (Version 1.1-dfx)
+//----------------------------------------------------------------------
+// Copyright (c) 1997-2005 University of Maryland and Sunil Arya and
+// David Mount.  All Rights Reserved.
+//
+// This software and related documentation is part of the Approximate
+// Nearest Neighbor Library (ANN).  This software is provided under
+// the provisions of the Lesser GNU Public License (LGPL).  See the
+// file ../ReadMe.txt for further information.
+//
+// The University of Maryland (U.M.) and the authors make no
+// representations about the suitability or fitness of this software for
+// any purpose.  It is provided "as is" without express or implied
+// warranty.
+//----------------------------------------------------------------------
+// History:
+//	Revision 1.1-dfx  10/19/26
+//		Initial release
+//----------------------------------------------------------------------
+
+#ifndef ANN_kd_flat_H
+#define ANN_kd_flat_H
+
+#include <cstddef>						// size_t
+#include <cstdint>						// fixed-width integers
+#include <vector>						// flattener storage
+
+#include <ANN/ANNx.h>					// all ANN includes
+
+//----------------------------------------------------------------------
+//	Flattened kd-tree image
+//		A flattened kd-tree is a single block of memory with no
+//		pointers in it, so that it can be written to a file and later
+//		used in place (for example, from a read-only memory mapping).
+//		The image consists of the following sections, each of which
+//		begins on an ANN_FLAT_ALIGN byte boundary:
+//
+//		header			An ANNflatHeader.
+//		nodes			The tree nodes (ANNflatNode) in preorder.  The
+//						low child of a splitting node immediately
+//						follows it, and it stores the index of its
+//						high child.
+//		bnd_box_lo		The bounding box low point (dim coordinates).
+//		bnd_box_hi		The bounding box high point (dim coordinates).
+//		pidx			Point indices (n_pts ANNidx's), bucket by
+//						bucket, in the order of the leaves.
+//		coords			Point coordinates (n_pts*dim ANNcoord's), also
+//						bucket by bucket.  Within a bucket of m points
+//						starting at s, coordinate d of the j-th point
+//						is at coords[s*dim + d*m + j], that is, each
+//						bucket stores its points by coordinate.
+//
+//		The image is only usable on machines with the same byte order
+//		and the same ANNcoord type as the one that made it.
+//----------------------------------------------------------------------
+
+const char		ANN_FLAT_MAGIC[8]	= "ANNflat";	// image signature
+const uint32_t	ANN_FLAT_VERSION	= 1;			// image format version
+const uint32_t	ANN_FLAT_BYTE_ORDER	= 0x01020304;	// byte order mark
+const size_t	ANN_FLAT_ALIGN		= 64;			// section alignment
+const int32_t	ANN_FLAT_LEAF		= -1;			// cut_dim of a leaf
+
+struct ANNflatHeader {					// image header
+	char		magic[8];				// ANN_FLAT_MAGIC
+	uint32_t	version;				// ANN_FLAT_VERSION
+	uint32_t	byte_order;				// ANN_FLAT_BYTE_ORDER as written
+	uint32_t	coord_size;				// sizeof(ANNcoord) as written
+	int32_t		dim;					// dimension of space
+	int32_t		n_pts;					// number of points
+	int32_t		n_nodes;				// number of nodes
+	uint64_t	image_size;				// size of entire image in bytes
+};
+
+struct ANNflatNode {					// node of a flattened tree
+	ANNcoord	cut_val;				// location of cutting plane
+	ANNcoord	cd_bnds[2];				// bounds of cell along cut_dim
+	int32_t		cut_dim;				// cutting dim (or ANN_FLAT_LEAF)
+	int32_t		hi_child;				// index of high child (splits)
+	int32_t		bkt_start;				// first point in bucket (leaves)
+	int32_t		bkt_size;				// no. points in bucket (leaves)
+};
+
+struct ANNflatLayout {					// byte offsets of the sections
+	size_t		nodes;					// tree nodes
+	size_t		bnd_box_lo;				// bounding box low point
+	size_t		bnd_box_hi;				// bounding box high point
+	size_t		pidx;					// point indices
+	size_t		coords;					// point coordinates
+	size_t		size;					// size of entire image
+};
+
+ANNflatLayout annFlatLayout(			// compute section offsets
+	int					dim,			// dimension of space
+	int					n_pts,			// number of points
+	int					n_nodes);		// number of nodes
+
+//----------------------------------------------------------------------
+//	Flattener
+//		This collects the contents of a flattened image while the
+//		nodes of a kd-tree are visited in preorder (see the flatten()
+//		node methods in kd_flat.cpp).
+//----------------------------------------------------------------------
+
+class ANNkd_flattener {
+public:
+	int						dim;		// dimension of space
+	ANNpointArray			pts;		// the points
+	std::vector<ANNflatNode> nodes;		// nodes in preorder
+	std::vector<ANNidx>		pidx;		// point indices
+	std::vector<ANNcoord>	coords;		// coordinates, by bucket
+
+	ANNkd_flattener(					// constructor
+		int				dd,				// dimension
+		ANNpointArray	pa)				// point array
+		: dim(dd), pts(pa) {}
+};
+
+#endif
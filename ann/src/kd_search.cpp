@@ -2,7 +2,7 @@
 // File:			kd_search.cpp
 // Programmer:		Sunil Arya and David Mount
 // Description:		Standard kd-tree search
-// Last modified:	01/04/05 (Version 1.0)
+// Last modified:	10/19/26 (Version 1.1-dfx)
 //----------------------------------------------------------------------
 // Copyright (c) 1997-2005 University of Maryland and Sunil Arya and
 // David Mount.  All Rights Reserved.
@@ -22,6 +22,9 @@
 //		Initial release
 //	Revision 1.0  04/01/05
 //		Changed names LO, HI to ANN_LO, ANN_HI
+//	Revision 1.1-dfx  10/19/26
+//		Replaced the search globals with a search context
+//		Added batch searching
 //----------------------------------------------------------------------
 
 #include "kd_search.h"					// kd-search declarations
@@ -53,7 +56,8 @@
 //		381-390.
 //
 //		The main entry points is annkSearch() which sets things up and
-//		then call the recursive routine ann_search().  This is a recursive
+//		then call the recursive routine ann_search(), passing it the
+//		search context (see kd_search.h).  This is a recursive
 //		routine which performs the processing for one node in the kd-tree.
 //		There are two versions of this virtual procedure, one for splitting
 //		nodes and one for leaves.  When a splitting node is visited, we
@@ -70,18 +74,6 @@
 //		the parent rectangle.
 //----------------------------------------------------------------------
 
-//----------------------------------------------------------------------
-//		To keep argument lists short, a number of global variables
-//		are maintained which are common to all the recursive calls.
-//		These are given below.
-//----------------------------------------------------------------------
-
-int				ANNkdDim;				// dimension of space
-ANNpoint		ANNkdQ;					// query point
-double			ANNkdMaxErr;			// max tolerable squared error
-ANNpointArray	ANNkdPts;				// the points
-ANNmin_k		*ANNkdPointMK;			// set of k closest points
-
 //----------------------------------------------------------------------
 //	annkSearch - search for the k nearest neighbors
 //----------------------------------------------------------------------
@@ -93,46 +85,96 @@ void ANNkd_tree::annkSearch(
 	ANNdistArray		dd,				// the approximate nearest neighbor
 	double				eps)			// the error bound
 {
-
-	ANNkdDim = dim;						// copy arguments to static equivs
-	ANNkdQ = q;
-	ANNkdPts = pts;
-	ANNptsVisited = 0;					// initialize count of points visited
-
 	if (k > n_pts) {					// too many near neighbors?
 		annError("Requesting more near neighbors than data points", ANNabort);
 	}
 
-	ANNkdMaxErr = ANN_POW(1.0 + eps);
+	ANNmin_k point_mk(k);				// set for closest k points
+	ANNkd_search s;						// search context
+	s.dim = dim;
+	s.q = q;
+	s.max_err = ANN_POW(1.0 + eps);
+	s.pts = pts;
+	s.point_mk = &point_mk;
+	s.pts_visited = 0;					// initialize count of points visited
 	ANN_FLOP(2)							// increment floating op count
 
-	ANNkdPointMK = new ANNmin_k(k);		// create set for closest k points
 										// search starting at the root
-	root->ann_search(annBoxDistance(q, bnd_box_lo, bnd_box_hi, dim));
+	root->ann_search(s, annBoxDistance(q, bnd_box_lo, bnd_box_hi, dim));
 
 	for (int i = 0; i < k; i++) {		// extract the k-th closest points
-		dd[i] = ANNkdPointMK->ith_smallest_key(i);
-		nn_idx[i] = ANNkdPointMK->ith_smallest_info(i);
+		dd[i] = point_mk.ith_smallest_key(i);
+		nn_idx[i] = point_mk.ith_smallest_info(i);
 	}
-	delete ANNkdPointMK;				// deallocate closest point set
+}
+
+//----------------------------------------------------------------------
+//	annkSearchBatch - search for the k nearest neighbors of many points
+//		The results for q[i] are nn_idx[i*k..i*k+k-1] and the same
+//		part of dd.
+//----------------------------------------------------------------------
+
+void ANNkd_tree::annkSearchBatch(
+	ANNpointArray		q,				// the query points
+	int					m,				// number of query points
+	int					k,				// number of near neighbors to return
+	ANNidxArray			nn_idx,			// nearest neighbor indices (returned)
+	ANNdistArray		dd,				// the approximate nearest neighbors
+	double				eps,			// the error bound
+	int					n_threads)		// max threads to search with
+{
+	if (k > n_pts) {					// too many near neighbors?
+		annError("Requesting more near neighbors than data points", ANNabort);
+	}
+
+	annBatch(m, n_threads,
+		[&](int i) {					// path of a query
+			uint64_t path = 0;
+			root->ann_path(q[i], ANN_PATH_DEPTH, path);
+			return path;
+		},
+		[&](int i) {					// search for a query
+			annkSearch(q[i], k, nn_idx + (size_t) i * k, dd + (size_t) i * k, eps);
+		});
+}
+
+//----------------------------------------------------------------------
+//	ann_path - find the path to the leaf a query visits first
+//		Each splitting node appends the side of the query point (a
+//		0 or 1 bit) to the path, and the leaf pads it out to depth
+//		bits, so that paths of different lengths compare in tree
+//		order.
+//----------------------------------------------------------------------
+
+void ANNkd_split::ann_path(ANNpoint q, int depth, uint64_t &path)
+{
+	if (depth == 0) return;				// deep enough
+	int side = (q[cut_dim] < cut_val ? ANN_LO : ANN_HI);
+	path = (path << 1) | side;
+	child[side]->ann_path(q, depth-1, path);
+}
+
+void ANNkd_leaf::ann_path(ANNpoint /*q*/, int depth, uint64_t &path)
+{
+	path <<= depth;						// pad to full depth
 }
 
 //----------------------------------------------------------------------
 //	kd_split::ann_search - search a splitting node
 //----------------------------------------------------------------------
 
-void ANNkd_split::ann_search(ANNdist box_dist)
+void ANNkd_split::ann_search(ANNkd_search &s, ANNdist box_dist)
 {
 										// check dist calc term condition
-	if (ANNmaxPtsVisited != 0 && ANNptsVisited > ANNmaxPtsVisited) return;
+	if (ANNmaxPtsVisited != 0 && s.pts_visited > ANNmaxPtsVisited) return;
 
 										// distance to cutting plane
-	ANNcoord cut_diff = ANNkdQ[cut_dim] - cut_val;
+	ANNcoord cut_diff = s.q[cut_dim] - cut_val;
 
 	if (cut_diff < 0) {					// left of cutting plane
-		child[ANN_LO]->ann_search(box_dist);// visit closer child first
+		child[ANN_LO]->ann_search(s, box_dist);// visit closer child first
 
-		ANNcoord box_diff = cd_bnds[ANN_LO] - ANNkdQ[cut_dim];
+		ANNcoord box_diff = cd_bnds[ANN_LO] - s.q[cut_dim];
 		if (box_diff < 0)				// within bounds - ignore
 			box_diff = 0;
 										// distance to further box
@@ -140,14 +182,14 @@ void ANNkd_split::ann_search(ANNdist box_dist)
 				ANN_DIFF(ANN_POW(box_diff), ANN_POW(cut_diff)));
 
 										// visit further child if close enough
-		if (box_dist * ANNkdMaxErr < ANNkdPointMK->max_key())
-			child[ANN_HI]->ann_search(box_dist);
+		if (box_dist * s.max_err < s.point_mk->max_key())
+			child[ANN_HI]->ann_search(s, box_dist);
 
 	}
 	else {								// right of cutting plane
-		child[ANN_HI]->ann_search(box_dist);// visit closer child first
+		child[ANN_HI]->ann_search(s, box_dist);// visit closer child first
 
-		ANNcoord box_diff = ANNkdQ[cut_dim] - cd_bnds[ANN_HI];
+		ANNcoord box_diff = s.q[cut_dim] - cd_bnds[ANN_HI];
 		if (box_diff < 0)				// within bounds - ignore
 			box_diff = 0;
 										// distance to further box
@@ -155,8 +197,8 @@ void ANNkd_split::ann_search(ANNdist box_dist)
 				ANN_DIFF(ANN_POW(box_diff), ANN_POW(cut_diff)));
 
 										// visit further child if close enough
-		if (box_dist * ANNkdMaxErr < ANNkdPointMK->max_key())
-			child[ANN_LO]->ann_search(box_dist);
+		if (box_dist * s.max_err < s.point_mk->max_key())
+			child[ANN_LO]->ann_search(s, box_dist);
 
 	}
 	ANN_FLOP(10)						// increment floating ops
@@ -169,7 +211,7 @@ void ANNkd_split::ann_search(ANNdist box_dist)
 //		some fine tuning to replace indexing by pointer operations.
 //----------------------------------------------------------------------
 
-void ANNkd_leaf::ann_search(ANNdist box_dist)
+void ANNkd_leaf::ann_search(ANNkd_search &s, ANNdist box_dist)
 {
 	register ANNdist dist;				// distance to data point
 	register ANNcoord* pp;				// data coordinate pointer
@@ -178,15 +220,15 @@ void ANNkd_leaf::ann_search(ANNdist box_dist)
 	register ANNcoord t;
 	register int d;
 
-	min_dist = ANNkdPointMK->max_key(); // k-th smallest distance so far
+	min_dist = s.point_mk->max_key();	// k-th smallest distance so far
 
 	for (int i = 0; i < n_pts; i++) {	// check points in bucket
 
-		pp = ANNkdPts[bkt[i]];			// first coord of next data point
-		qq = ANNkdQ;					// first coord of query point
+		pp = s.pts[bkt[i]];				// first coord of next data point
+		qq = s.q;						// first coord of query point
 		dist = 0;
 
-		for(d = 0; d < ANNkdDim; d++) {
+		for(d = 0; d < s.dim; d++) {
 			ANN_COORD(1)				// one more coordinate hit
 			ANN_FLOP(4)					// increment floating ops
 
@@ -197,14 +239,14 @@ void ANNkd_leaf::ann_search(ANNdist box_dist)
 			}
 		}
 
-		if (d >= ANNkdDim &&					// among the k best?
+		if (d >= s.dim &&						// among the k best?
 		   (ANN_ALLOW_SELF_MATCH || dist!=0)) { // and no self-match problem
 												// add it to the list
-			ANNkdPointMK->insert(dist, bkt[i]);
-			min_dist = ANNkdPointMK->max_key();
+			s.point_mk->insert(dist, bkt[i]);
+			min_dist = s.point_mk->max_key();
 		}
 	}
 	ANN_LEAF(1)							// one more leaf node visited
 	ANN_PTS(n_pts)						// increment points visited
-	ANNptsVisited += n_pts;				// increment number of points visited
+	s.pts_visited += n_pts;				// increment number of points visited
 }
@@ -2,7 +2,7 @@
 // File:			kd_search.h
 // Programmer:		Sunil Arya and David Mount
 // Description:		Standard kd-tree search
-// Last modified:	01/04/05 (Version 1.0)
+// Last modified:	10/19/26 (Version 1.1-dfx)
 //----------------------------------------------------------------------
 // Copyright (c) 1997-2005 University of Maryland and Sunil Arya and
 // David Mount.  All Rights Reserved.
@@ -20,11 +20,19 @@
 // History:
 //	Revision 0.1  03/04/98
 //		Initial release
+//	Revision 1.1-dfx  10/19/26
+//		Replaced the search globals with a search context
+//		Added batch searching
 //----------------------------------------------------------------------
 
 #ifndef ANN_kd_search_H
 #define ANN_kd_search_H
 
+#include <algorithm>					// sort
+#include <thread>						// batch search threads
+#include <utility>						// pair
+#include <vector>						// batch order
+
 #include "kd_tree.h"					// kd-tree declarations
 #include "kd_util.h"					// kd-tree utilities
 #include "pr_queue_k.h"					// k-element priority queue
@@ -32,17 +40,71 @@
 #include <ANN/ANNperf.h>				// performance evaluation
 
 //----------------------------------------------------------------------
-//	More global variables
-//		These are active for the life of each call to annkSearch(). They
-//		are set to save the number of variables that need to be passed
-//		among the various search procedures.
+//	Search context
+//		This holds everything that is common to all the recursive
+//		calls of one annkSearch(), so that the argument lists stay
+//		short.  (It used to be a set of global variables.)  Since it
+//		is made anew for each search, several threads may search the
+//		same tree at once.
+//----------------------------------------------------------------------
+
+struct ANNkd_search {					// state of a standard search
+	int					dim;			// dimension of space
+	ANNpoint			q;				// query point
+	double				max_err;		// max tolerable squared error
+	ANNpointArray		pts;			// the points
+	ANNmin_k			*point_mk;		// set of k closest points
+	int					pts_visited;	// number of points visited
+};
+
 //----------------------------------------------------------------------
+//	Batch search
+//		annkSearchBatch() searches for each of many query points.  To
+//		make good use of the cache, the queries are sorted by their
+//		paths down the tree, that is, by the leaf each one would visit
+//		first, so that consecutive queries tend to visit the same
+//		nodes.  (Paths are ANN_PATH_DEPTH levels deep at most.)  The
+//		sorted queries are then divided among threads, with at least
+//		ANN_BATCH_PTS queries per thread.
+//
+//		annBatch() does this for any kind of tree, with path(i)
+//		giving the path of the i-th query and search(i) searching for
+//		it (results go directly to the caller's arrays, so the order
+//		doesn't show).
+//----------------------------------------------------------------------
+
+const int ANN_PATH_DEPTH = 32;			// max levels in query paths
+const int ANN_BATCH_PTS = 64;			// fewest queries per thread
+
+template <class Path, class Search>
+void annBatch(							// search for a batch of queries
+	int					m,				// number of queries
+	int					n_threads,		// max threads (0 = per processor)
+	Path				path,			// path of a query
+	Search				search)			// search for a query
+{
+	vector<pair<uint64_t, int> > order(m);	// queries in path order
+	for (int i = 0; i < m; i++) {
+		order[i] = make_pair(path(i), i);
+	}
+	sort(order.begin(), order.end());
 
-extern int				ANNkdDim;		// dimension of space (static copy)
-extern ANNpoint			ANNkdQ;			// query point (static copy)
-extern double			ANNkdMaxErr;	// max tolerable squared error
-extern ANNpointArray	ANNkdPts;		// the points (static copy)
-extern ANNmin_k			*ANNkdPointMK;	// set of k closest points
-extern int				ANNptsVisited;	// number of points visited
+	n_threads = min(annNumThreads(n_threads), max(1, m / ANN_BATCH_PTS));
+	auto search_range = [&](int first, int last) {
+		for (int j = first; j < last; j++) {
+			search(order[j].second);
+		}
+	};
+	vector<thread> threads;				// all but the last range
+	for (int t = 0; t < n_threads - 1; t++) {
+		threads.push_back(thread(search_range,
+				(int) ((long long) m * t / n_threads),
+				(int) ((long long) m * (t+1) / n_threads)));
+	}
+	search_range((int) ((long long) m * (n_threads-1) / n_threads), m);
+	for (size_t t = 0; t < threads.size(); t++) {
+		threads[t].join();
+	}
+}
 
 #endif
@@ -2,7 +2,7 @@
 // File:			kd_tree.cpp
 // Programmer:		Sunil Arya and David Mount
 // Description:		Basic methods for kd-trees.
-// Last modified:	01/04/05 (Version 1.0)
+// Last modified:	10/19/26 (Version 1.1-dfx)
 //----------------------------------------------------------------------
 // Copyright (c) 1997-2005 University of Maryland and Sunil Arya and
 // David Mount.  All Rights Reserved.
@@ -26,8 +26,12 @@
 //		Added optional pa, pi arguments to Skeleton kd_tree constructor
 //			for use in load constructor.
 //		Added annClose() to eliminate KD_TRIVIAL memory leak.
+//	Revision 1.1-dfx  10/19/26
+//		Added node arenas and parallel construction.
 //----------------------------------------------------------------------
 
+#include <algorithm>						// max
+
 #include "kd_tree.h"					// kd-tree declarations
 #include "kd_split.h"					// kd-tree splitting rules
 #include "kd_util.h"					// kd-tree utilities
@@ -208,7 +212,8 @@ void ANNkd_tree::getStats(						// get tree statistics
 
 ANNkd_tree::~ANNkd_tree()				// tree destructor
 {
-	if (root != NULL) delete root;
+	if (arena != NULL) delete arena;	// nodes are all in the arena
+	else if (root != NULL) delete root;
 	if (pidx != NULL) delete [] pidx;
 	if (bnd_box_lo != NULL) annDeallocPt(bnd_box_lo);
 	if (bnd_box_hi != NULL) annDeallocPt(bnd_box_hi);
@@ -254,6 +259,7 @@ void ANNkd_tree::SkeletonTree(			// construct skeleton tree
 	pts = pa;							// initialize points array
 
 	root = NULL;						// no associated tree yet
+	arena = NULL;						// (nodes come from the heap)
 
 	if (pi == NULL) {					// point indices provided?
 		pidx = new ANNidx[n];			// no, allocate space for point indices
@@ -276,6 +282,67 @@ ANNkd_tree::ANNkd_tree(					// basic constructor
 		int bs)							// bucket size
 {  SkeletonTree(n, dd, bs);  }			// construct skeleton tree
 
+//----------------------------------------------------------------------
+//	Node arena
+//		Storage is handed out from blocks of ANN_ARENA_BLOCK bytes
+//		(or larger, for larger requests), rounded up to keep it
+//		suitably aligned for anything.
+//----------------------------------------------------------------------
+
+const size_t ANN_ARENA_BLOCK = 65536;	// arena block size
+const size_t ANN_ARENA_ALIGN = alignof(std::max_align_t);
+
+ANNkd_arena::ANNkd_arena()				// constructor
+{
+	next = NULL;
+	avail = 0;
+}
+
+ANNkd_arena::~ANNkd_arena()				// destructor
+{
+	for (size_t i = 0; i < blocks.size(); i++) {
+		::operator delete(blocks[i]);
+	}
+}
+
+void* ANNkd_arena::alloc(				// allocate storage
+		size_t size)					// number of bytes
+{
+	size = (size + ANN_ARENA_ALIGN - 1) & ~(ANN_ARENA_ALIGN - 1);
+	if (size > avail) {					// need a new block?
+		size_t block_size = max(size, ANN_ARENA_BLOCK);
+		next = (char*) ::operator new(block_size);
+		avail = block_size;
+		blocks.push_back(next);
+	}
+	void *p = next;
+	next += size;
+	avail -= size;
+	return p;
+}
+
+void ANNkd_arena::adopt(				// take another arena's storage
+		ANNkd_arena &other)				// the other arena (emptied)
+{
+	blocks.insert(blocks.end(), other.blocks.begin(), other.blocks.end());
+	other.blocks.clear();
+	other.next = NULL;
+	other.avail = 0;
+}
+
+//----------------------------------------------------------------------
+//	annNumThreads - number of threads to build or search with
+//----------------------------------------------------------------------
+
+int annNumThreads(						// threads to use
+		int n_threads)					// requested (0 = one per processor)
+{
+	if (n_threads == 0) {				// one per processor
+		n_threads = (int) thread::hardware_concurrency();
+	}
+	return max(n_threads, 1);
+}
+
 //----------------------------------------------------------------------
 //	rkd_tree - recursive procedure to build a kd-tree
 //
@@ -309,6 +376,13 @@ ANNkd_tree::ANNkd_tree(					// basic constructor
 //		This procedure selects a cutting dimension and cutting value,
 //		partitions pa about these values, and returns the number of
 //		points on the low side of the cut.
+//
+//		When building in parallel, the last argument is the build
+//		context (see kd_tree.h), which says where to allocate nodes
+//		and how many threads may build the subtree.  The children are
+//		built on separate threads when the subtree is large enough.
+//		Since they hold disjoint parts of pidx, the result is the
+//		same as when building serially.
 //----------------------------------------------------------------------
 
 ANNkd_ptr rkd_tree(				// recursive construction of kd-tree
@@ -318,13 +392,16 @@ ANNkd_ptr rkd_tree(				// recursive construction of kd-tree
 	int					dim,			// dimension of space
 	int					bsp,			// bucket space
 	ANNorthRect			&bnd_box,		// bounding box for current node
-	ANNkd_splitter		splitter)		// splitting routine
+	ANNkd_splitter		splitter,		// splitting routine
+	ANNkd_build			*bld)			// parallel build context
 {
+	ANNkd_arena *arena = (bld != NULL ? bld->arena : NULL);
+
 	if (n <= bsp) {						// n small, make a leaf node
 		if (n == 0)						// empty leaf node
 			return KD_TRIVIAL;			// return (canonical) empty leaf
 		else							// construct the node and return
-			return new ANNkd_leaf(n, pidx); 
+			return new (arena) ANNkd_leaf(n, pidx); 
 	}
 	else {								// n large, make a splitting node
 		int cd;							// cutting dimension
@@ -338,20 +415,23 @@ ANNkd_ptr rkd_tree(				// recursive construction of kd-tree
 		ANNcoord lv = bnd_box.lo[cd];	// save bounds for cutting dimension
 		ANNcoord hv = bnd_box.hi[cd];
 
-		bnd_box.hi[cd] = cv;			// modify bounds for left subtree
-		lo = rkd_tree(					// build left subtree
-				pa, pidx, n_lo,			// ...from pidx[0..n_lo-1]
-				dim, bsp, bnd_box, splitter);
-		bnd_box.hi[cd] = hv;			// restore bounds
-
-		bnd_box.lo[cd] = cv;			// modify bounds for right subtree
-		hi = rkd_tree(					// build right subtree
-				pa, pidx + n_lo, n-n_lo,// ...from pidx[n_lo..n-1]
-				dim, bsp, bnd_box, splitter);
-		bnd_box.lo[cd] = lv;			// restore bounds
-
+		annBuildChildren(bld, n, dim, bnd_box,
+			[&](ANNkd_build *b, ANNorthRect &box) {
+				box.hi[cd] = cv;		// modify bounds for left subtree
+				lo = rkd_tree(			// build left subtree
+						pa, pidx, n_lo,	// ...from pidx[0..n_lo-1]
+						dim, bsp, box, splitter, b);
+				box.hi[cd] = hv;		// restore bounds
+			},
+			[&](ANNkd_build *b, ANNorthRect &box) {
+				box.lo[cd] = cv;		// modify bounds for right subtree
+				hi = rkd_tree(			// build right subtree
+						pa, pidx + n_lo, n-n_lo,// ...from pidx[n_lo..n-1]
+						dim, bsp, box, splitter, b);
+				box.lo[cd] = lv;		// restore bounds
+			});
 										// create the splitting node
-		ANNkd_split *ptr = new ANNkd_split(cd, cv, lv, hv, lo, hi);
+		ANNkd_split *ptr = new (arena) ANNkd_split(cd, cv, lv, hv, lo, hi);
 
 		return ptr;						// return pointer to this node
 	}
@@ -363,6 +443,8 @@ ANNkd_ptr rkd_tree(				// recursive construction of kd-tree
 //		It first builds a skeleton tree, then computes the bounding box
 //		of the data points, and then invokes rkd_tree() to actually
 //		build the tree, passing it the appropriate splitting routine.
+//		If more than one thread may be used, the nodes are allocated
+//		from an arena which belongs to the tree.
 //----------------------------------------------------------------------
 
 ANNkd_tree::ANNkd_tree(					// construct from point array
@@ -370,12 +452,21 @@ ANNkd_tree::ANNkd_tree(					// construct from point array
 	int					n,				// number of points
 	int					dd,				// dimension
 	int					bs,				// bucket size
-	ANNsplitRule		split)			// splitting method
+	ANNsplitRule		split,			// splitting method
+	int					n_threads)		// max threads to build with
 {
 	SkeletonTree(n, dd, bs);			// set up the basic stuff
 	pts = pa;							// where the points are
 	if (n == 0) return;					// no points--no sweat
 
+	ANNkd_build build = {NULL, annNumThreads(n_threads)};
+	ANNkd_build *bld = NULL;			// build context (if parallel)
+	if (build.n_threads > 1) {
+		arena = new ANNkd_arena;
+		build.arena = arena;
+		bld = &build;
+	}
+
 	ANNorthRect bnd_box(dd);			// bounding box for points
 	annEnclRect(pa, pidx, n, dd, bnd_box);// construct bounding rectangle
 										// copy to tree structure
@@ -384,20 +475,20 @@ ANNkd_tree::ANNkd_tree(					// construct from point array
 
 	switch (split) {					// build by rule
 	case ANN_KD_STD:					// standard kd-splitting rule
-		root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, kd_split);
+		root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, kd_split, bld);
 		break;
 	case ANN_KD_MIDPT:					// midpoint split
-		root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, midpt_split);
+		root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, midpt_split, bld);
 		break;
 	case ANN_KD_FAIR:					// fair split
-		root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, fair_split);
+		root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, fair_split, bld);
 		break;
 	case ANN_KD_SUGGEST:				// best (in our opinion)
 	case ANN_KD_SL_MIDPT:				// sliding midpoint split
-		root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, sl_midpt_split);
+		root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, sl_midpt_split, bld);
 		break;
 	case ANN_KD_SL_FAIR:				// sliding fair split
-		root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, sl_fair_split);
+		root = rkd_tree(pa, pidx, n, dd, bs, bnd_box, sl_fair_split, bld);
 		break;
 	default:
 		annError("Illegal splitting method", ANNabort);
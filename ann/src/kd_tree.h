@@ -22,15 +22,55 @@
 //		Initial release
 //	Revision 1.1  05/03/05
 //		Added fixed radius kNN search
+//	Revision 1.1-dfx  10/19/26
+//		Added flatten for flattened kd-tree images
+//		Added node arenas and parallel construction
+//		Made standard search reentrant, and added query paths
 //----------------------------------------------------------------------
 
 #ifndef ANN_kd_tree_H
 #define ANN_kd_tree_H
 
+#include <cstddef>						// size_t
+#include <thread>						// parallel construction
+#include <vector>						// arena blocks
+
 #include <ANN/ANNx.h>					// all ANN includes
+#include "kd_flat.h"					// flattened tree declarations
 
 using namespace std;					// make std:: available
 
+//----------------------------------------------------------------------
+//	annNumThreads - number of threads to build or search with
+//----------------------------------------------------------------------
+
+int annNumThreads(						// threads to use
+	int					n_threads);		// requested (0 = one per processor)
+
+//----------------------------------------------------------------------
+//	Node arena
+//		Trees built in parallel allocate their nodes (and the bounds
+//		of their shrinking nodes) from an arena, so that the threads
+//		building them do not contend for the heap.  Nodes in an arena
+//		are never deleted individually; the whole arena is deleted
+//		with the tree instead.  An arena is used by one thread at a
+//		time, so each thread of a parallel build has its own, and
+//		they are merged with adopt() when the thread is done.
+//----------------------------------------------------------------------
+
+class ANNkd_arena {						// storage for tree nodes
+	std::vector<char*>	blocks;			// allocated blocks
+	char*				next;			// next free byte
+	size_t				avail;			// bytes free after next
+public:
+	ANNkd_arena();						// constructor
+	~ANNkd_arena();						// destructor (frees everything)
+	void* alloc(size_t size);			// allocate storage
+	void adopt(ANNkd_arena &other);		// take the other's storage
+};
+
+struct ANNkd_search;						// state of a standard search
+
 //----------------------------------------------------------------------
 //	Generic kd-tree node
 //
@@ -47,7 +87,8 @@ class ANNkd_node{						// generic kd-tree node (empty shell)
 public:
 	virtual ~ANNkd_node() {}					// virtual distroyer
 
-	virtual void ann_search(ANNdist) = 0;		// tree search
+												// tree search
+	virtual void ann_search(ANNkd_search &s, ANNdist) = 0;
 	virtual void ann_pri_search(ANNdist) = 0;	// priority search
 	virtual void ann_FR_search(ANNdist) = 0;	// fixed-radius search
 
@@ -58,6 +99,17 @@ public:
 												// print node
 	virtual void print(int level, ostream &out) = 0;
 	virtual void dump(ostream &out) = 0;		// dump node
+												// flatten node
+	virtual void flatten(ANNkd_flattener &fl) = 0;
+												// path to query's leaf
+	virtual void ann_path(ANNpoint q, int depth, uint64_t &path) = 0;
+												// allocate (from arena)
+	void* operator new(size_t size, ANNkd_arena *arena = NULL)
+		{ return arena != NULL ? arena->alloc(size) : ::operator new(size); }
+	void operator delete(void *p)				// deallocate (not arena)
+		{ ::operator delete(p); }
+	void operator delete(void *p, ANNkd_arena *arena)
+		{ if (arena == NULL) ::operator delete(p); }
 
 	friend class ANNkd_tree;					// allow kd-tree to access us
 };
@@ -79,6 +131,60 @@ typedef void (*ANNkd_splitter)(			// splitting routine for kd-trees
 	ANNcoord			&cut_val,		// cutting value (returned)
 	int					&n_lo);			// num of points on low side (returned)
 
+//----------------------------------------------------------------------
+//	Build context
+//		This is passed down through the recursive construction of a
+//		tree built in parallel.  While a subtree has threads to spare
+//		and at least ANN_PAR_PTS points, its low child is built on a
+//		new thread (with half of the threads) while the high child is
+//		built on this one.  The same splits are made either way, so
+//		the tree is the same as one built serially.  (The serial
+//		builder passes no context and allocates nodes from the heap.)
+//----------------------------------------------------------------------
+
+const int ANN_PAR_PTS = 4096;			// smallest subtree to fork
+
+struct ANNkd_build {					// build context
+	ANNkd_arena*		arena;			// where to allocate nodes
+	int					n_threads;		// threads this subtree may use
+};
+
+
+//----------------------------------------------------------------------
+//	annBuildChildren - build the two children of a node
+//		The children are built by build_lo(bld, box) and then
+//		build_hi(bld, box), each passed the context to build with and
+//		the node's bounding box (which they may modify, so long as
+//		they restore it).  If the subtree is large enough to fork,
+//		build_lo is run on a new thread with its own arena and its
+//		own copy of the box.
+//----------------------------------------------------------------------
+
+template <class BuildLo, class BuildHi>
+void annBuildChildren(					// build children of a node
+	ANNkd_build			*bld,			// build context (NULL if serial)
+	int					n,				// number of points in the node
+	int					dim,			// dimension of space
+	ANNorthRect			&bnd_box,		// bounding box for the node
+	BuildLo				build_lo,		// builds the low child
+	BuildHi				build_hi)		// builds the high child
+{
+	if (bld == NULL || bld->n_threads < 2 || n < ANN_PAR_PTS) {
+		build_lo(bld, bnd_box);
+		build_hi(bld, bnd_box);
+		return;
+	}
+	ANNorthRect lo_box(dim, bnd_box);	// the new thread's box
+	ANNkd_arena lo_arena;				// and its nodes
+	ANNkd_build lo_bld = {&lo_arena, bld->n_threads / 2};
+	ANNkd_build hi_bld = {bld->arena, bld->n_threads - lo_bld.n_threads};
+
+	std::thread lo_thread([&]() { build_lo(&lo_bld, lo_box); });
+	build_hi(&hi_bld, bnd_box);
+	lo_thread.join();
+	bld->arena->adopt(lo_arena);		// keep the new thread's nodes
+}
+
 //----------------------------------------------------------------------
 //	Leaf kd-tree node
 //		Leaf nodes of the kd-tree store the set of points associated
@@ -109,8 +215,12 @@ public:
 				ANNorthRect &bnd_box);			// bounding box
 	virtual void print(int level, ostream &out);// print node
 	virtual void dump(ostream &out);			// dump node
+	virtual void flatten(ANNkd_flattener &fl);	// flatten node
+												// path to query's leaf
+	virtual void ann_path(ANNpoint q, int depth, uint64_t &path);
 
-	virtual void ann_search(ANNdist);			// standard search
+												// standard search
+	virtual void ann_search(ANNkd_search &s, ANNdist);
 	virtual void ann_pri_search(ANNdist);		// priority search
 	virtual void ann_FR_search(ANNdist);		// fixed-radius search
 };
@@ -175,8 +285,12 @@ public:
 				ANNorthRect &bnd_box);			// bounding box
 	virtual void print(int level, ostream &out);// print node
 	virtual void dump(ostream &out);			// dump node
+	virtual void flatten(ANNkd_flattener &fl);	// flatten node
+												// path to query's leaf
+	virtual void ann_path(ANNpoint q, int depth, uint64_t &path);
 
-	virtual void ann_search(ANNdist);			// standard search
+												// standard search
+	virtual void ann_search(ANNkd_search &s, ANNdist);
 	virtual void ann_pri_search(ANNdist);		// priority search
 	virtual void ann_FR_search(ANNdist);		// fixed-radius search
 };
@@ -192,6 +306,7 @@ ANNkd_ptr rkd_tree(				// recursive construction of kd-tree
 	int					dim,			// dimension of space
 	int					bsp,			// bucket space
 	ANNorthRect			&bnd_box,		// bounding box for current node
-	ANNkd_splitter		splitter);		// splitting routine
+	ANNkd_splitter		splitter,		// splitting routine
+	ANNkd_build			*bld = NULL);	// parallel build context
 
 #endif
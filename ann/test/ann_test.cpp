@@ -32,9 +32,14 @@
 //		Added fixed radius kNN search
 //	Revision 1.1.1 08/04/06
 //		Added planted distribution
+//	Revision 1.1-dfx  10/19/26
+//		Added flattened kd-tree search
+//		Added build_threads option and time_build operation
+//		Added batch searches and search_threads option
 //----------------------------------------------------------------------
 
 #include <ctime>						// clock
+#include <chrono>						// wall clock (for time_build)
 #include <cmath>						// math routines
 #include <string>						// C string ops
 #include <fstream>						// file I/O
@@ -95,6 +100,13 @@ using namespace std;					// make std:: available
 //								structure for the current data set, using
 //								the selected splitting rules.  Any existing
 //								tree will be destroyed.
+//		time_build				Build the structure for the current data
+//								set serially and then with build_threads
+//								threads, and report the elapsed (wall
+//								clock) time of each.  If there are query
+//								points, check that both trees give the
+//								same search results.  The current tree
+//								is not affected.
 //
 //		Query Generation/Searching:
 //		---------------------------
@@ -109,6 +121,15 @@ using namespace std;					// make std:: available
 //								strategy.  Possible strategies are:
 //									standard = standard kd-tree search
 //									priority = priority search
+//									flat = flattened kd-tree search
+//										(the tree must have no
+//										shrinking nodes)
+//									batch = standard search of all
+//										query points in one call
+//									flat_batch = the same, with the
+//										flattened kd-tree
+//								(Batches only collect performance
+//								statistics for the whole batch.)
 //
 //		Miscellaneous:
 //		--------------
@@ -153,6 +174,9 @@ using namespace std;					// make std:: available
 //								bd_tree.cc for more information.
 //		bucket_size <int>		Bucket size, that is, the maximum number of
 //								points stored in each leaf node.
+//		build_threads <int>		Maximum number of threads to build the
+//								tree with (0 = one per processor).  The
+//								tree is the same either way.  Default = 1.
 //
 // Options affecting data and query point generation:
 // --------------------------------------------------
@@ -199,6 +223,9 @@ using namespace std;					// make std:: available
 // ------------------------------------------
 //		epsilon <float>			Error bound for approx. near neigh. search.
 //		near_neigh <int>		Number of nearest neighbors to compute.
+//		search_threads <int>	Maximum number of threads for batch
+//								searches (0 = one per processor).
+//								Default = 1.
 //		max_pts_visit <int>		Maximum number of points to visit before
 //								terminating.  (Used in applications where
 //								real-time performance is important.)
@@ -446,6 +473,8 @@ const Distrib	def_distr		= UNIFORM;		// def distribution
 const double	def_std_dev		= 1.00;			// def standard deviation
 const double	def_corr_coef	= 0.05;			// def correlation coef
 const int		def_bucket_size = 1;			// def bucket size
+const int		def_build_threads = 1;			// def build threads
+const int		def_search_threads = 1;			// def search threads
 const double	def_epsilon		= 0.0;			// def error bound
 const int		def_near_neigh	= 1;			// def number of near neighbors
 const int		def_max_visit	= 0;			// def number of points visited
@@ -477,6 +506,8 @@ double			std_dev;				// standard deviation
 double			std_dev_lo;				// low standard deviation
 double			std_dev_hi;				// high standard deviation
 int				bucket_size;			// bucket size
+int				build_threads;			// max threads to build with
+int				search_threads;			// max threads to search with
 double			epsilon;				// error bound
 int				near_neigh;				// number of near neighbors
 int				max_pts_visit;			// max number of points to visit
@@ -557,6 +588,8 @@ void initGlobals()
 	max_dim				= def_max_dim;
 	n_color				= def_n_color;
 	bucket_size			= def_bucket_size;
+	build_threads		= def_build_threads;
+	search_threads		= def_search_threads;
 	epsilon				= def_epsilon;
 	near_neigh			= def_near_neigh;
 	max_pts_visit		= def_max_visit;
@@ -676,6 +709,12 @@ int main(int argc, char** argv)
 		else if (!strcmp(directive,"bucket_size")) {
 			cin >> bucket_size;
 		}
+		else if (!strcmp(directive,"build_threads")) {
+			cin >> build_threads;
+		}
+		else if (!strcmp(directive,"search_threads")) {
+			cin >> search_threads;
+		}
 		else if (!strcmp(directive,"epsilon")) {
 			cin >> epsilon;
 		}
@@ -866,7 +905,8 @@ int main(int argc, char** argv)
 					dim,						// dimension of space
 					bucket_size,				// maximum bucket size
 					split,						// splitting rule
-					shrink);					// shrinking rule
+					shrink,						// shrinking rule
+					build_threads);				// max threads to build with
 
 			//------------------------------------------------------------
 			//	Print summary
@@ -880,6 +920,8 @@ int main(int argc, char** argv)
 				cout << "  data_size     = " << data_size << "\n";
 				cout << "  dim           = " << dim << "\n";
 				cout << "  bucket_size   = " << bucket_size << "\n";
+				if (build_threads != 1)
+					cout << "  build_threads = " << build_threads << "\n";
 
 				if (stats >= EXEC_TIME) {		// output processing time
 					cout << "  process_time  = "
@@ -900,6 +942,75 @@ int main(int argc, char** argv)
 			}
 		}
 		//----------------------------------------------------------------
+		//	time_build operation
+		//		Builds two trees, one serially and one with build_threads
+		//		threads.  Since clock() counts the time of every thread,
+		//		the elapsed time is measured instead.
+		//----------------------------------------------------------------
+		else if (!strcmp(directive,"time_build")) {
+			if (data_pts == NULL) {
+				Error("No data set constructed", ANNabort);
+			}
+			typedef chrono::steady_clock wall_clock;
+			ANNbd_tree* trees[2];
+			double build_times[2];
+			for (int t = 0; t < 2; t++) {
+				wall_clock::time_point start = wall_clock::now();
+				trees[t] = new ANNbd_tree(
+						data_pts,				// the data points
+						data_size,				// number of points
+						dim,					// dimension of space
+						bucket_size,			// maximum bucket size
+						split,					// splitting rule
+						shrink,					// shrinking rule
+						t == 0 ? 1 : build_threads);
+				build_times[t] = chrono::duration<double>(
+						wall_clock::now() - start).count();
+			}
+												// compare search results
+			ANNbool same = ANNtrue;
+			if (query_pts != NULL) {
+				ANNidxArray idx[2];
+				ANNdistArray dists[2];
+				for (int t = 0; t < 2; t++) {
+					idx[t] = new ANNidx[near_neigh];
+					dists[t] = new ANNdist[near_neigh];
+				}
+				for (int i = 0; i < query_size && same; i++) {
+					for (int t = 0; t < 2; t++) {
+						trees[t]->annkSearch(query_pts[i], near_neigh,
+								idx[t], dists[t], epsilon);
+					}
+					for (int j = 0; j < near_neigh; j++) {
+						if (idx[0][j] != idx[1][j] || dists[0][j] != dists[1][j])
+							same = ANNfalse;
+					}
+				}
+				for (int t = 0; t < 2; t++) {
+					delete [] idx[t];
+					delete [] dists[t];
+				}
+			}
+			delete trees[0];
+			delete trees[1];
+
+			if (stats > SILENT) {
+				cout << "[Time build:\n";
+				cout << "  data_size     = " << data_size << "\n";
+				cout << "  dim           = " << dim << "\n";
+				cout << "  bucket_size   = " << bucket_size << "\n";
+				cout << "  build_threads = " << build_threads << "\n";
+				cout << "  serial_time   = " << build_times[0] << " sec\n";
+				cout << "  parallel_time = " << build_times[1] << " sec\n";
+				if (query_pts != NULL)
+					cout << "  same_results  = " << (same ? "yes" : "no") << "\n";
+				cout << "]\n";
+			}
+			if (!same) {
+				Error("Serial and parallel trees differ", ANNabort);
+			}
+		}
+		//----------------------------------------------------------------
 		//	dump operation
 		//----------------------------------------------------------------
 		else if (!strcmp(directive,"dump")) {
@@ -963,7 +1074,7 @@ int main(int argc, char** argv)
 		//		This section does all the query processing.  It consists
 		//		of the following subsections:
 		//
-		//		**	input the argument (standard or priority) and output
+		//		**	input the argument (standard, priority or flat) and output
 		//			the header describing the essential information.
 		//		**	allocate space for the results to be stored.
 		//		**	run the queries by invoking the appropriate search
@@ -982,7 +1093,7 @@ int main(int argc, char** argv)
 			//------------------------------------------------------------
 			//	Input arguments and print summary
 			//------------------------------------------------------------
-			enum {STANDARD, PRIORITY} method;
+			enum {STANDARD, PRIORITY, FLAT, BATCH, FLAT_BATCH} method;
 
 			cin >> arg;							// input argument
 			if (!strcmp(arg, "standard")) {
@@ -991,10 +1102,19 @@ int main(int argc, char** argv)
 			else if (!strcmp(arg, "priority")) {
 				method = PRIORITY;
 			}
+			else if (!strcmp(arg, "flat")) {
+				method = FLAT;
+			}
+			else if (!strcmp(arg, "batch")) {
+				method = BATCH;
+			}
+			else if (!strcmp(arg, "flat_batch")) {
+				method = FLAT_BATCH;
+			}
 			else {
 				cerr << "Search type: " << arg << "\n";
-				Error("Search type must be \"standard\" or \"priority\"",
-						ANNabort);
+				Error("Search type must be \"standard\", \"priority\", "
+						"\"flat\", \"batch\" or \"flat_batch\"", ANNabort);
 			}
 			if (data_pts == NULL || query_pts == NULL) {
 				Error("Either data set and query set not constructed", ANNabort);
@@ -1007,6 +1127,11 @@ int main(int argc, char** argv)
 			//	Set up everything
 			//------------------------------------------------------------
 
+			ANNkd_flat_tree* the_flat_tree = NULL;
+			if (method == FLAT || method == FLAT_BATCH) {	// flatten (not timed)
+				the_flat_tree = new ANNkd_flat_tree(*the_tree);
+			}
+
 			#ifdef ANN_PERF						// performance only
 				annResetStats(data_size);			// reset statistics
 			#endif
@@ -1030,6 +1155,29 @@ int main(int argc, char** argv)
 			ANNidxArray	  curr_nn_idx = apx_nn_idx;
 			ANNdistArray  curr_dists  = apx_dists;
 
+			if (radius_bound == 0) {			// batches are searched at once
+				if (method == BATCH) {
+					the_tree->annkSearchBatch(
+						query_pts,				// query points
+						query_size,				// number of query points
+						near_neigh,				// number of near neighbors
+						apx_nn_idx,				// nearest neighbors (returned)
+						apx_dists,				// distance (returned)
+						epsilon,				// error bound
+						search_threads);		// max threads to search with
+				}
+				else if (method == FLAT_BATCH) {
+					the_flat_tree->annkSearchBatch(
+						query_pts,				// query points
+						query_size,				// number of query points
+						near_neigh,				// number of near neighbors
+						apx_nn_idx,				// nearest neighbors (returned)
+						apx_dists,				// distance (returned)
+						epsilon,				// error bound
+						search_threads);		// max threads to search with
+				}
+			}
+
 			for (int i = 0; i < query_size; i++) {
 				#ifdef ANN_PERF
 					annResetCounts();			// reset counters
@@ -1053,6 +1201,17 @@ int main(int argc, char** argv)
 							curr_dists,			// distance (returned)
 							epsilon);			// error bound
 					}
+					else if (method == FLAT) {
+						the_flat_tree->annkSearch(
+							query_pts[i],		// query point
+							near_neigh,			// number of near neighbors
+							curr_nn_idx,		// nearest neighbors (returned)
+							curr_dists,			// distance (returned)
+							epsilon);			// error bound
+					}
+					else if (method == BATCH || method == FLAT_BATCH) {
+						// (already searched, above)
+					}
 					else {
 						Error("Internal error - invalid method", ANNabort);
 					}
@@ -1080,6 +1239,8 @@ int main(int argc, char** argv)
 
 			long query_time = clock() - clock0; // end of query time
 
+			if (the_flat_tree != NULL) delete the_flat_tree;
+
 			if (validate) {						// validation requested
 				if (valid_dirty) getTrueNN();	// get true near neighbors
 				doValidation();					// validate
@@ -1096,6 +1257,8 @@ int main(int argc, char** argv)
 				cout << "  search_method = " << arg << "\n";
 				cout << "  epsilon       = " << epsilon << "\n";
 				cout << "  near_neigh    = " << near_neigh << "\n";
+				if ((method == BATCH || method == FLAT_BATCH) && search_threads != 1)
+					cout << "  search_threads = " << search_threads << "\n";
 				if (max_pts_visit != 0)
 					cout << "  max_pts_visit = " << max_pts_visit << "\n";
 				if (radius_bound != 0)
@@ -27,6 +27,9 @@ Broken FFT 2.0: Featuring the Super Destroy FX Windowing System!
 #include "fourier.h"
 
 #include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -73,43 +76,31 @@ PLUGIN::PLUGIN(audioMasterCallback audioMaster)
 
   setup();
 
-  in0 = (float*)malloc(maxframe * sizeof (float));
-  out0 = (float*)malloc(maxframe * 2 * sizeof (float));
+  echor = dfx::MakeUniqueAlignedArray<float>(MAXECHO);
+  echoc = dfx::MakeUniqueAlignedArray<float>(MAXECHO);
 
-  /* prevmix is only a single third long */
-  prevmix = (float*)malloc((maxframe / 2) * sizeof (float));
+  ampl = dfx::MakeUniqueAlignedArray<float>(maxframe);
+  spikekeep = dfx::MakeUniqueAlignedArray<float>(maxframe);
 
-  echor = (float*)malloc(MAXECHO * sizeof(float));
-  echoc = (float*)malloc(MAXECHO * sizeof(float));
-
-  ampl = (amplentry*)malloc(sizeof (amplentry) * maxframe);
-
-  fftr = (float*)malloc(maxframe * sizeof(float));
-  ffti = (float*)malloc(maxframe * sizeof(float));
-  tmp = (float*)malloc(maxframe * sizeof(float));
-  oot = (float*)malloc(maxframe * sizeof(float));
+  fftr = dfx::MakeUniqueAlignedArray<float>(maxframe);
+  ffti = dfx::MakeUniqueAlignedArray<float>(maxframe);
+  tmp = dfx::MakeUniqueAlignedArray<float>(maxframe);
+  oot = dfx::MakeUniqueAlignedArray<float>(maxframe);
 
   framesize = MKBUFSIZE(bufsizep);
-  plan = rfftw_create_plan(framesize, FFTW_FORWARD, FFTW_ESTIMATE);
-  rplan = rfftw_create_plan(framesize, FFTW_BACKWARD, FFTW_ESTIMATE);
+  fft.emplace(framesize);
 
   changed = 0;
 }
 
 PLUGIN::~PLUGIN() {
-  free (in0);
-  free (out0);
-
-  free (prevmix);
-
   if (programs) delete[] programs;
 }
 
 void PLUGIN::resume() {
 
-  for(int i = 0; i < MAXECHO; i++) {
-    echor[i] = echoc[i] = 0.0f;
-  }
+  std::fill_n(echor.get(), MAXECHO, 0.0f);
+  std::fill_n(echoc.get(), MAXECHO, 0.0f);
 
   amplhold = 1;
   stopat = 1;
@@ -121,29 +112,17 @@ void PLUGIN::resume() {
   samplesleft = 0;
 
   framesize = MKBUFSIZE(bufsizep);
-  third = framesize / 2;
-  bufsize = third * 3;
-
-  plan = rfftw_create_plan(framesize, FFTW_FORWARD, FFTW_ESTIMATE);
-  rplan = rfftw_create_plan(framesize, FFTW_BACKWARD, FFTW_ESTIMATE);
 
-  /* set up buffers. Prevmix and first frame of output are always
-     filled with zeros. */
-
-  for (int ii = 0; ii < third; ii ++) {
-    prevmix[ii] = 0.0f;
+  if (fft->size() != static_cast<size_t>(framesize)) {
+    fft.emplace(framesize);
   }
 
-  for (int j = 0; j < framesize; j ++) {
-    out0[j] = 0.0f;
-  }
-  
   /* start input at beginning. Output has a frame of silence. */
-  insize = 0;
-  outstart = 0;
-  outsize = framesize;
+  windowing.setFrameSize(framesize);
+  windowshape = -1.0f;
+  updatewindowshape();
 
-  setInitialDelay(framesize);
+  setInitialDelay(windowing.getLatency());
   changed = 0;
   needIdle();
 
@@ -165,7 +144,7 @@ long PLUGIN::fxIdle() {
 }
 
 /* tail is the same as delay, of course */
-long PLUGIN::getTailSize() { return framesize; }
+long PLUGIN::getTailSize() { return windowing.getLatency(); }
 
 void PLUGIN::setParameter(long index, float value) {
   switch (index) {
@@ -260,11 +239,11 @@ void PLUGIN::getParameterLabel(long index, char *label) {
 
 inline float quantize(float q, float old) {
   /*	if (q >= 1.0) return old;*/
-  long scale = ( long)(512 * q);
-  if (scale == 0) scale = 2;
-  long X = ( long)(scale * old);
-	
-  return (float)(X / (float)scale);
+  /* truncating in floating point, rather than through an integer,
+     vectorizes and can't overflow */
+  float scale = std::trunc(512 * q);
+  scale = (scale == 0.0f) ? 2.0f : scale;
+  return std::trunc(scale * old) / scale;
 }
 
 #define MAXVALUE 1000.0f
@@ -284,32 +263,89 @@ void PLUGIN::normalize(long samples, float much) {
   if (mai > 0.0001) faci = MAXVALUE / mai;
 
   for(int ji = 0; ji < samples; ji ++) {
-    fftr[ji] = (much * facr * fftr[ji]) + ((1.0 - much) * fftr[ji]);
-    ffti[ji] = (much * faci * ffti[ji]) + ((1.0 - much) * ffti[ji]);
+    fftr[ji] = (much * facr * fftr[ji]) + ((1.0f - much) * fftr[ji]);
+    ffti[ji] = (much * faci * ffti[ji]) + ((1.0f - much) * ffti[ji]);
+  }
+
+}
+
+/* the per-bin operations of fftops, for when none of them
+   moves bins around, each as its own pass over the bins */
+void PLUGIN::binops(long samples) {
+
+  /* what operation bq would leave behind, if it were on */
+  sampler = fftr[samples - 1];
+  samplei = ffti[samples - 1];
+  samplesleft = 1;
+
+  /* operation Q */
+  if (quant <= 0.9999999) {
+    /* (a local, since writing the bins could otherwise change quant) */
+    float const q = quant;
+    for(int i = 0; i < samples; i ++) {
+      fftr[i] = quantize(fftr[i], q);
+      ffti[i] = quantize(ffti[i], q);
+    }
+  }
+
+  /* perturb (rand isn't vectorizable, but it is called in the same order) */
+  if (perturb > 0.000001) {
+    for(int i = 0; i < samples; i ++) {
+      fftr[i] = (rand()/(float)RAND_MAX) * perturb + fftr[i]*(1.0f-perturb);
+      ffti[i] = (rand()/(float)RAND_MAX) * perturb + ffti[i]*(1.0f-perturb);
+    }
+  }
+
+  /* compress */
+  if (compress < 0.9999999) {
+    for(int i = 0; i < samples; i ++) {
+      fftr[i] = fsign(fftr[i]) * powf(fabsf(fftr[i]), compress);
+      ffti[i] = fsign(ffti[i]) * powf(fabsf(ffti[i]), compress);
+    }
+  }
+
+  /* M.U.G. */
+  if (makeupgain > 0.00001) {
+    float const gain = 1.0f + (3.0f*makeupgain);
+    for(int i = 0; i < samples; i ++) {
+      fftr[i] *= gain;
+      ffti[i] *= gain;
+    }
   }
 
 }
 
 /* this function modifies 'samples' number of floats in
-   fftr and ffti */
+   fftr and ffti.
+
+   Most operations are plain loops over the bins, with nothing carried
+   from one bin to the next, so that the compiler can vectorize them.
+   (The ones that are inherently sequential are noted.) */
 void PLUGIN::fftops(long samples) {
 
-  for(int li = lowpass * lowpass * samples; li < samples; li ++) {
-    fftr[li] = 0;
-    ffti[li] = 0;
-  }
+  /* (fill_n does nothing for a negative count) */
+  int lowend = lowpass * lowpass * samples;
+  std::fill_n(fftr.get() + lowend, samples - lowend, 0.0f);
+  std::fill_n(ffti.get() + lowend, samples - lowend, 0.0f);
 
   /* convolve */
 
   if (convolve > 0.0001f) {
+    float const wet = convolve, dry = 1.0f - convolve;
     for(int ci = 0; ci < samples; ci ++) {
-      fftr[ci] = convolve * tmp[ci] + (1.0 - convolve) * fftr[ci];
-      ffti[ci] = convolve * tmp[ci] * ffti[ci] + (1.0 - convolve) * ffti[ci];
+      fftr[ci] = wet * tmp[ci] + dry * fftr[ci];
+      ffti[ci] = wet * tmp[ci] * ffti[ci] + dry * ffti[ci];
     }
     normalize(samples, 1.0);
   }
 
-  for(int i = 0; i < samples; i ++) {
+  /* Operations bq and "very special" and rotate move bins around as
+     they go, so they have to happen one bin at a time along with
+     everything else. Without them, each operation is its own pass. */
+  if (binquant <= 0.0 && destruct >= 1.0 &&
+      ((int)(rotate * samples)) % samples == 0) {
+    binops(samples);
+  } else for(int i = 0; i < samples; i ++) {
 
     /* operation bq */
     if (binquant > 0.0 && (samplesleft -- > 0)) {
@@ -371,7 +407,7 @@ void PLUGIN::fftops(long samples) {
 
   }
 
-  /* pretty expensive spike operation */
+  /* spike operation */
   if (spike < 0.999999) {
 
     double loudness = 0.0;
@@ -382,43 +418,44 @@ void PLUGIN::fftops(long samples) {
     
     if (! -- amplhold) {
       for ( long i=0; i<samples; i++ ) {
-	ampl[i].a = fftr[i]*fftr[i] + ffti[i]*ffti[i];
-	ampl[i].i = i;
+	ampl[i] = fftr[i]*fftr[i] + ffti[i]*ffti[i];
       }
 
-      /* sort the amplitude bins */
+      /* keep only the loudest bins */
 
       stopat = 1+(int)((spike*spike*spike)*samples);
 
-      /* consider a special case for when abs(stopat-samples) < lg samples? */ 
-      tqsort(ampl, samples, stopat);
-
-      /* chop of everything after the first i */
+      spikerank(samples, stopat - 1);
 
       amplhold = 1 + (int)(spikehold * (20.0));
 
     }
 
-    double newloudness = loudness;
-    for(long iw = stopat - 1; iw < samples; iw++) {
-      newloudness -= ampl[iw].a;
-      fftr[ampl[iw].i] = 0.0f;
-      ffti[ampl[iw].i] = 0.0f;
-    }
-
-    /* boost what remains. */
-    double boostby = loudness / newloudness;
+    /* chop off the rest (as ranked back then, while holding) and
+       boost what remains. */
+    double newloudness = loudness - spikedropped;
+    float boostby = loudness / newloudness;
     for(long ie = 0; ie < samples; ie ++) {
-      fftr[ie] *= boostby;
+      fftr[ie] = fftr[ie] * spikekeep[ie] * boostby;
       /* XXX ffti? */
+      ffti[ie] *= spikekeep[ie];
     }
 
   }
 
   /* EO FX */
 
-
-  for(long iy = 0; iy < samples; iy ++) {
+  /* without the mix, this just records the bins */
+  if (echomix <= 0.000001) {
+    for(long iy = 0; iy < samples; ) {
+      long chunk = std::min(samples - iy, (long)(MAXECHO - echoctr));
+      std::copy_n(fftr.get() + iy, chunk, echor.get() + echoctr);
+      std::copy_n(ffti.get() + iy, chunk, echoc.get() + echoctr);
+      iy += chunk;
+      echoctr = (echoctr + chunk) % MAXECHO;
+    }
+  /* the feedback reads what it wrote, so it goes one bin at a time */
+  } else for(long iy = 0; iy < samples; iy ++) {
     echor[echoctr] = fftr[iy];
     echoc[echoctr++] = ffti[iy];
     echoctr %= MAXECHO;
@@ -449,15 +486,13 @@ void PLUGIN::fftops(long samples) {
     }
   }
 
-  /* bufferride */
+  /* bufferride: repeat the first md + 1 bins all the way up */
   if (bride < 0.999999f) {
-    int smd = 0;
-    int md = bride * samples;
-    for(int ss = 0; ss < samples; ss ++) {
-      fftr[ss] = fftr[smd];
-      ffti[ss] = ffti[smd];
-      smd++;
-      if (smd > md) smd = 0;
+    int period = 1 + (int)(bride * samples);
+    for(int ss = period; ss < samples; ss += period) {
+      int n = std::min(period, (int)samples - ss);
+      std::copy_n(fftr.get(), n, fftr.get() + ss);
+      std::copy_n(ffti.get(), n, ffti.get() + ss);
     }
   }
 
@@ -517,14 +552,12 @@ void PLUGIN::fftops(long samples) {
   /* post-processing rotate-up */
   if (postrot > 0.5f) {
     int rotn = (postrot - 0.5f) * 1.0f * samples;
-    if (rotn != 0) 
-      for(int v = samples - 1; v >= 0; v --) {
-	if (v < rotn) fftr[v] = ffti[v] = 0.0f;
-	else { 
-	  fftr[v] = fftr[v - rotn];
-	  ffti[v] = ffti[v - rotn];
-	}
-      }
+    if (rotn != 0) {
+      std::copy_backward(fftr.get(), fftr.get() + samples - rotn, fftr.get() + samples);
+      std::copy_backward(ffti.get(), ffti.get() + samples - rotn, ffti.get() + samples);
+      std::fill_n(fftr.get(), rotn, 0.0f);
+      std::fill_n(ffti.get(), rotn, 0.0f);
+    }
   } else if (postrot < 0.5f) {
     int rotn = (int)((0.5f - postrot) * 1.0f * MKBUFSIZE(bufsizep));
     if (rotn != 0)
@@ -550,10 +583,9 @@ void PLUGIN::fftops(long samples) {
 
   }
 
-  for(int ali = afterlow * afterlow * samples; ali < samples; ali ++) {
-    fftr[ali] = 0;
-    ffti[ali] = 0;
-  }
+  int afterend = afterlow * afterlow * samples;
+  std::fill_n(fftr.get() + afterend, samples - afterend, 0.0f);
+  std::fill_n(ffti.get() + afterend, samples - afterend, 0.0f);
 
   if (norm > 0.0001f) {
     normalize(samples, norm);
@@ -564,7 +596,7 @@ void PLUGIN::fftops(long samples) {
 /* XXX I'm probably copying more times than I need to!
    PS, use memmove!
 */
-void PLUGIN::processw(float * in, float * out) {
+void PLUGIN::processw(float const * in, float * out) {
 
   int samples = framesize;
 
@@ -575,17 +607,17 @@ void PLUGIN::processw(float * in, float * out) {
   /* do the processing */
   if (method < 0.25) { 
     /* Don Cross style */
-    fft_float(samples, 0, tmp, 0, fftr, ffti);
+    fft_float(samples, 0, tmp.get(), 0, fftr.get(), ffti.get());
     fftops(samples);
-    fft_float(samples, 1, fftr, ffti, oot, tmp);
+    fft_float(samples, 1, fftr.get(), ffti.get(), oot.get(), tmp.get());
   } else if (method < 0.50) {
-    /* FFTW .. this still doesn't work. How come? */
-    rfftw_one(plan, tmp, fftr);
-    memcpy(ffti, fftr, samples * sizeof(float)); /* dup? */
+    /* FFTW style .. this still doesn't work. How come? */
+    fft->forwardHalfComplex(tmp.get(), fftr.get());
+    memcpy(ffti.get(), fftr.get(), samples * sizeof(float)); /* dup? */
 
     fftops(samples);
 
-    rfftw_one(rplan, fftr, oot);
+    fft->inverseHalfComplex(fftr.get(), oot.get());
 
     float div = 1.0 / samples;
     for(int xa = 0; xa < samples; xa++) {
@@ -593,11 +625,11 @@ void PLUGIN::processw(float * in, float * out) {
     }
 
   } else {
-    /* bug -- using forward plan both ways, not normalizing */
-    rfftw_one(plan, tmp, fftr);
-    memcpy(ffti, fftr, samples * sizeof(float)); /* dup? */
+    /* bug -- using forward transform both ways, not normalizing */
+    fft->forwardHalfComplex(tmp.get(), fftr.get());
+    memcpy(ffti.get(), fftr.get(), samples * sizeof(float)); /* dup? */
     fftops(samples);
-    rfftw_one(plan, fftr, oot);
+    fft->forwardHalfComplex(fftr.get(), oot.get());
   } 
 
   for (int cc = 0; cc < samples; cc++) out[cc] = oot[cc];
@@ -605,192 +637,109 @@ void PLUGIN::processw(float * in, float * out) {
 }
 
 
-/* tqsort partitions the array (of n elements) so that the first STOP
-   elements are each less than the remaining elements. */
+/* Marks (in spikekeep) the keep bins with the greatest ampl and
+   totals the ampl of the others (in spikedropped), without sorting:
+   since ampl is never negative, its bit patterns order the same way
+   as its values, so this radix-selects the keep-th greatest one
+   digit by digit, then keeps everything above it and enough of its
+   ties (lowest bins first). */
+void PLUGIN::spikerank(long samples, long keep) {
 
-void PLUGIN::tqsort(amplentry * low, int n, int stop) {
-
-  /* temporaries for swaps */
-  float t;
-  int i;
-  if (n <= 1) return;
-  if (stop <= 0) return;
-  if (stop >= n) return; 
-  
-  if (n == 2) {
-    if (low->a >= low[1].a) return;
-    t = low->a;
-    i = low->i;
-    low->a = low[1].a;
-    low->i = low[1].i;
-    low[1].a = t;
-    low[1].i = i;
-#if 0
-  } else if (n == 3) {
-    /* add this ... */
-#endif
-  } else {
-    int pivot = rand() % n;
-    t = low[pivot].a;
-    i = low[pivot].i;
-    low[pivot].a = low->a;
-    low[pivot].i = low->i;
-    low->a = t;
-    low->i = i;
-
-    int l = 1, r = n - 1;
-
-    while (l < r) {
-      /* move fingers. 
-	 it's possible to run off the array if
-	 the pivot is equal to one of the last
-	 or first elements (so check that). */
-
-      while ((l < n) && low[l].a >= low->a) l++;
-      while (r && low[r].a <= low->a) r--;
-      if (l >= r) break;
-      /* swap */
-      t = low[l].a;
-      i = low[l].i;
-      low[l].a = low[r].a;
-      low[l].i = low[r].i;
-      low[r].a = t;
-      low[r].i = i;
+  if (keep <= 0 || keep >= samples) {
+    std::fill_n(spikekeep.get(), samples, (keep > 0) ? 1.0f : 0.0f);
+    spikedropped = 0.0;
+    if (keep <= 0) {
+      for(long i = 0; i < samples; i ++) spikedropped += ampl[i];
     }
+    return;
+  }
 
-    /* put the pivot back. */
-    
-    t = low[l-1].a;
-    i = low[l-1].i;
-    low[l-1].a = low->a;
-    low[l-1].i = low->i;
-    low->a = t;
-    low->i = i;
-    
-    /* recurse. */
+  /* the digits, most significant first: 11, 11, and 10 bits */
+  constexpr int shifts[] = {21, 10, 0};
+  uint32_t prefix = 0, prefixmask = 0;
+  /* how many more to keep among those matching the prefix */
+  long left = keep;
+  for (int shift : shifts) {
+    uint32_t const digitmask = (shift == 0) ? 0x3FF : 0x7FF;
+    spikehistogram.fill(0);
+    for(long i = 0; i < samples; i ++) {
+      uint32_t const u = std::bit_cast<uint32_t>(ampl[i]);
+      if ((u & prefixmask) == prefix) {
+	spikehistogram[(u >> shift) & digitmask]++;
+      }
+    }
+    uint32_t digit = digitmask;
+    while (spikehistogram[digit] < left) {
+      left -= spikehistogram[digit];
+      digit--;
+    }
+    prefix |= digit << shift;
+    prefixmask |= digitmask << shift;
+  }
 
-    if (stop <= l) {
-      tqsort(low, l - 1, stop);
-    } else {
-      tqsort(low+l, n-l, stop - l);
+  /* now prefix is the threshold itself, and left is how many of
+     the bins equal to it to keep */
+  spikedropped = 0.0;
+  for(long i = 0; i < samples; i ++) {
+    uint32_t const u = std::bit_cast<uint32_t>(ampl[i]);
+    bool stays = (u > prefix);
+    if (u == prefix && left > 0) {
+      stays = true;
+      left--;
     }
-    /* done. */
+    spikekeep[i] = stays ? 1.0f : 0.0f;
+    if (!stays) spikedropped += ampl[i];
   }
 
 }
 
-/* this fake processX function reads samples one at a time
-   from the true input. It simultaneously copies samples from
-   the beginning of the output buffer to the true output.
-   We maintain that out0 always has at least 'third' samples
-   in it; this is enough to pick up for the delay of input
-   processing and to make sure we always have enough samples
-   to fill the true output buffer.
-
-   If the input frame is full:
-    - calls wprocess on this full input frame
-    - applies the windowing envelope to the tail of out0 (output frame)
-    - mixes in prevmix with the first half of the output frame
-    - increases outsize so that the first half of the output frame is
-      now available output
-    - copies the second half of the output to be prevmix for next frame.
-    - copies the second half of the input buffer to the first,
-      resets the size (thus we process each third-size chunk twice)
-
-  If we have read more than 'third' samples out of the out0 buffer:
-   - Slide contents to beginning of buffer
-   - Reset outstart
-
-*/
-
-/* to improve: 
-   - use memcpy and arithmetic instead of
-     sample-by-sample copy 
-   - can we use tail of out0 as prevmix, instead of copying?
-   - can we use circular buffers instead of memmoving a lot
-     (probably not)
-*/
+/* rebuild the window envelope, but only once the shape
+   parameter lands on a different shape */
+void PLUGIN::updatewindowshape() {
+  if (shape == windowshape) return;
+  windowshape = shape;
+
+  using WindowShape = decltype(windowing)::WindowShape;
+  if (shape < 0.20f) {
+    windowing.setWindowShape(WindowShape::Wedge);
+  } else if (shape < 0.40f) {
+    windowing.setWindowShape(WindowShape::Arrow);
+  } else if (shape < 0.60f) {
+    windowing.setWindowShape(WindowShape::Triangle);
+  } else if (shape < 0.80f) {
+    windowing.setWindowShape(WindowShape::Cosine);
+  } else {
+    /* squared cosine */
+    windowing.setWindowShape([](float phase) {
+      float p = 0.5f * (-cosf(float(pi) * phase) + 1.0f);
+      return p * p;
+    });
+  }
+}
 
+/* the windowing engine collects overlapping frames of the true
+   input for processw and overlap-adds the windowed FFT output,
+   so the true output is delayed by one frame. */
 void PLUGIN::processX(float **trueinputs, float **trueoutputs, long samples, 
 		      int replacing) {
   float * tin  = *trueinputs;
   float * tout = *trueoutputs;
 
-  for (int ii = 0; ii < samples; ii++) {
-
-    /* copy sample in */
-    in0[insize] = tin[ii];
-    insize ++;
- 
-    if (insize == framesize) {
-      /* frame is full! */
-
-      /* in0 -> process -> out0(first free space) */
-      processw(in0, out0+outstart+outsize);
-
-      float oneDivThird = 1.0f / (float)third;
-      /* apply envelope */
-
-      if (shape < 0.20f) {
-	for(int z = 0; z < third; z++) {
-	  float p = sqrtf((float)z * oneDivThird);
-	  out0[z+outstart+outsize] *= p;
-	  out0[z+outstart+outsize+third] *= (1.0f - p);
-	}
-      } else if (shape < 0.40f) {
-	for(int z = 0; z < third; z++) {
-	  float p = (float)z * oneDivThird;
-	  p *= p;
-	  out0[z+outstart+outsize] *= p;
-	  out0[z+outstart+outsize+third] *= (1.0f - p);
-	}
-      } else if (shape < 0.60f) {
-	for(int z = 0; z < third; z++) {
-	  out0[z+outstart+outsize] *= ((float)z * oneDivThird);
-	  out0[z+outstart+outsize+third] *= (1.0f - ((float)z * oneDivThird));
-	}
-      } else if (shape < 0.80f) {
-	for(int z = 0; z < third; z ++) {
-	  float p = 0.5f * (-cos(float(pi * ((float)z * oneDivThird))) + 1.0f);
-	  out0[z+outstart+outsize] *= p;
-	  out0[z+outstart+outsize+third] *= (1.0f - p);
-	}
-      } else {
-	for(int z = 0; z < third; z ++) {
-	  float p = 0.5f * (-cos(float(pi * ((float)z * oneDivThird))) + 1.0f);
-	  p = p * p;
-	  out0[z+outstart+outsize] *= p;
-	  out0[z+outstart+outsize+third] *= (1.0f - p);
-	}
-      }
-
-      /* mix in prevmix */
-      for(int u = 0; u < third; u ++)
-	out0[u+outstart+outsize] += prevmix[u];
-
-      /* prevmix becomes out1 */
-      memcpy(prevmix, out0 + outstart + outsize + third, third * sizeof (float));
-
-      /* copy 2nd third of input over in0 (need to re-use it for next frame), 
-	 now insize = third */
-      memcpy(in0, in0 + third, third * sizeof (float));
+  updatewindowshape();
 
-      insize = third;
-      
-      outsize += third;
-    }
-
-    /* send sample out */
-    if (replacing) tout[ii] = out0[outstart];
-    else tout[ii] += out0[outstart];
+  auto const processframe = [this](float const * in, float * out, size_t) {
+    processw(in, out);
+  };
 
-    outstart ++;
-    outsize --;
-
-    /* make sure there is always enough room for a frame in out buffer */
-    if (outstart == third) {
-      memmove(out0, out0 + outstart, outsize * sizeof (float));
-      outstart = 0;
+  if (replacing) {
+    windowing.process(std::span<float const>(tin, samples), std::span<float>(tout, samples), processframe);
+  } else {
+    /* accumulating: render in pieces and add them to the true output */
+    float accum[512];
+    for (long ii = 0; ii < samples; ii += 512) {
+      long const n = std::min(samples - ii, 512L);
+      windowing.process(std::span<float const>(tin + ii, n), std::span<float>(accum, n), processframe);
+      for (long jj = 0; jj < n; jj++) tout[ii + jj] += accum[jj];
     }
   }
 }
@@ -1,5 +1,5 @@
 /*---------------------------------------------------------------
-Copyright (C) 2001-2025  Tom Murphy 7
+Copyright (C) 2001-2026  Tom Murphy 7
 
 This file is part of BrokenFFT.
 
@@ -24,9 +24,14 @@ BrokenFFT 2, featuring the Super Destroy FX Windowing System!
 #ifndef DFX_BROKENFFT_H
 #define DFX_BROKENFFT_H
 
+#include <algorithm>
 #include <array>
 #include <audioeffectx.h>
-#include "rfftw.h"
+#include <optional>
+
+#include "dfxfft.h"
+#include "dfxmisc.h"
+#include "dfxwindowing.h"
 
 #ifdef WIN32
 /* turn off warnings about default but no cases in switch, etc. */
@@ -86,11 +91,6 @@ struct param {
   float def;
 };
 
-struct amplentry {
-  float a;
-  int i;
-};
-
 class PLUGINPROGRAM {
   friend class PLUGIN;
 public:
@@ -134,7 +134,7 @@ public:
   virtual void resume();
   virtual long fxIdle();
 
-  virtual void processw(float * in, float * out);
+  virtual void processw(float const * in, float * out);
 
   void normalize(long, float);
 
@@ -177,36 +177,22 @@ protected:
   float bufsizep;
   /* shape of envelope */
   float shape;
+  /* the shape that the window envelope was last built for */
+  float windowshape = -1.0f;
 
-  /* input and output buffers. out is framesize*2 samples long, in is framesize
-     samples long. (for maximum framesize)
-  */
-  float * in0, * out0;
-
-  /* third-sized tail of previous processed frame. already has mixing envelope
-     applied.
-   */
-  float * prevmix;
-
-  /* number of samples in in0 */
-  int insize;
-
-  /* number of samples and starting position of valid samples in out0 */
-  int outsize;
-  int outstart;
+  void updatewindowshape();
 
   static constexpr std::array buffersizes {
     2, 4, 8, 16, 32, 64, 128, 256, 512,
     1024, 2048, 4096, 8192, 16384, 32768
   };
 
-  static void tqsort(amplentry * low, int n, int stop);
-  
 
-  /* buffersize is 3 * third, framesize is 2 * third 
-     buffersize is used for outbuf.
-  */
-  long bufsize, framesize, third;
+  /* samples per frame, which is also the FFT size */
+  long framesize;
+
+  /* overlapping input frames for processw, overlap-added output */
+  dfx::OverlapAdd<float> windowing {static_cast<size_t>(*std::ranges::max_element(buffersizes))};
 
   /* 1 if need to do ioChanged since buffer settings are different now */
   int changed;
@@ -214,6 +200,9 @@ protected:
 
   /* BAD FFT STUFF */
   void fftops(long samples);
+  void binops(long samples);
+  /* marks the keep loudest bins in spikekeep, by their ampl */
+  void spikerank(long samples, long keep);
 
   float destruct;
 
@@ -238,14 +227,20 @@ protected:
   float echomix, echotime;
 
   int amplhold, stopat;
-  amplentry * ampl;
-  float * echor;
-  float * echoc;
+  /* for spike: the squared magnitude of each bin, whether each bin
+     stays (1) or goes (0) as of the last ranking, and the loudness
+     of those that went */
+  dfx::UniqueAlignedArray<float> ampl, spikekeep;
+  double spikedropped = 0.0;
+  /* counts of the bins by each digit of ampl, for ranking */
+  std::array<int, 2048> spikehistogram {};
+
+  dfx::UniqueAlignedArray<float> echor, echoc;
 
   float echofb;
 
   /* fft work area */
-  float * tmp, * oot, * fftr, * ffti;
+  dfx::UniqueAlignedArray<float> tmp, oot, fftr, ffti;
 
   float echomodw, echomodf;
   float echolow, echohi;
@@ -268,8 +263,8 @@ protected:
 
   float method;
 
-  rfftw_plan plan;
-  rfftw_plan rplan;
+  /* for the framesize */
+  std::optional<dfx::FFT> fft;
 
 };
 
@@ -1,4 +1,4 @@
 
-cl /nologo /O2 /Ot /Og /Oi /Oy /Gs /I..\vstsdk\ /LD ..\brokenfft\brokenfft.cpp ..\vstsdk\AudioEffect.cpp ..\vstsdk\audioeffectx.cpp ..\fft-lib\fftdom.cpp ..\fft-lib\fftmisc.c ..\fft-lib\fourierf.c            ..\fftw\rfftw\fcr_1.c ..\fftw\rfftw\fcr_10.c ..\fftw\rfftw\fcr_11.c ..\fftw\rfftw\fcr_12.c ..\fftw\rfftw\fcr_128.c ..\fftw\rfftw\fcr_13.c ..\fftw\rfftw\fcr_14.c ..\fftw\rfftw\fcr_15.c ..\fftw\rfftw\fcr_16.c ..\fftw\rfftw\fcr_2.c ..\fftw\rfftw\fcr_3.c ..\fftw\rfftw\fcr_32.c ..\fftw\rfftw\fcr_4.c ..\fftw\rfftw\fcr_5.c ..\fftw\rfftw\fcr_6.c ..\fftw\rfftw\fcr_64.c ..\fftw\rfftw\fcr_7.c ..\fftw\rfftw\fcr_8.c ..\fftw\rfftw\fcr_9.c ..\fftw\rfftw\fhb_10.c ..\fftw\rfftw\fhb_16.c ..\fftw\rfftw\fhb_2.c ..\fftw\rfftw\fhb_3.c ..\fftw\rfftw\fhb_32.c ..\fftw\rfftw\fhb_4.c ..\fftw\rfftw\fhb_5.c ..\fftw\rfftw\fhb_6.c ..\fftw\rfftw\fhb_7.c ..\fftw\rfftw\fhb_8.c ..\fftw\rfftw\fhb_9.c ..\fftw\rfftw\fhf_10.c ..\fftw\rfftw\fhf_16.c ..\fftw\rfftw\fhf_2.c ..\fftw\rfftw\fhf_3.c ..\fftw\rfftw\fhf_32.c ..\fftw\rfftw\fhf_4.c ..\fftw\rfftw\fhf_5.c ..\fftw\rfftw\fhf_6.c ..\fftw\rfftw\fhf_7.c ..\fftw\rfftw\fhf_8.c ..\fftw\rfftw\fhf_9.c ..\fftw\rfftw\frc_1.c ..\fftw\rfftw\frc_10.c ..\fftw\rfftw\frc_11.c ..\fftw\rfftw\frc_12.c ..\fftw\rfftw\frc_128.c ..\fftw\rfftw\frc_13.c ..\fftw\rfftw\frc_14.c ..\fftw\rfftw\frc_15.c ..\fftw\rfftw\frc_16.c ..\fftw\rfftw\frc_2.c ..\fftw\rfftw\frc_3.c ..\fftw\rfftw\frc_32.c ..\fftw\rfftw\frc_4.c ..\fftw\rfftw\frc_5.c ..\fftw\rfftw\frc_6.c ..\fftw\rfftw\frc_64.c ..\fftw\rfftw\frc_7.c ..\fftw\rfftw\frc_8.c ..\fftw\rfftw\frc_9.c ..\fftw\rfftw\rconfig.c ..\fftw\rfftw\rexec.c ..\fftw\rfftw\rexec2.c ..\fftw\rfftw\rfftwf77.c ..\fftw\rfftw\rfftwnd.c ..\fftw\rfftw\rgeneric.c ..\fftw\rfftw\rplanner.c            ..\fftw\fftw\config.c ..\fftw\fftw\executor.c ..\fftw\fftw\fftwf77.c ..\fftw\fftw\fftwnd.c ..\fftw\fftw\fn_1.c ..\fftw\fftw\fn_10.c ..\fftw\fftw\fn_11.c ..\fftw\fftw\fn_12.c ..\fftw\fftw\fn_13.c ..\fftw\fftw\fn_14.c ..\fftw\fftw\fn_15.c ..\fftw\fftw\fn_16.c ..\fftw\fftw\fn_2.c ..\fftw\fftw\fn_3.c ..\fftw\fftw\fn_32.c ..\fftw\fftw\fn_4.c ..\fftw\fftw\fn_5.c ..\fftw\fftw\fn_6.c ..\fftw\fftw\fn_64.c ..\fftw\fftw\fn_7.c ..\fftw\fftw\fn_8.c ..\fftw\fftw\fn_9.c ..\fftw\fftw\fni_1.c ..\fftw\fftw\fni_10.c ..\fftw\fftw\fni_11.c ..\fftw\fftw\fni_12.c ..\fftw\fftw\fni_13.c ..\fftw\fftw\fni_14.c ..\fftw\fftw\fni_15.c ..\fftw\fftw\fni_16.c ..\fftw\fftw\fni_2.c ..\fftw\fftw\fni_3.c ..\fftw\fftw\fni_32.c ..\fftw\fftw\fni_4.c ..\fftw\fftw\fni_5.c ..\fftw\fftw\fni_6.c ..\fftw\fftw\fni_64.c ..\fftw\fftw\fni_7.c ..\fftw\fftw\fni_8.c ..\fftw\fftw\fni_9.c ..\fftw\fftw\ftw_10.c ..\fftw\fftw\ftw_16.c ..\fftw\fftw\ftw_2.c ..\fftw\fftw\ftw_3.c ..\fftw\fftw\ftw_32.c ..\fftw\fftw\ftw_4.c ..\fftw\fftw\ftw_5.c ..\fftw\fftw\ftw_6.c ..\fftw\fftw\ftw_64.c ..\fftw\fftw\ftw_7.c ..\fftw\fftw\ftw_8.c ..\fftw\fftw\ftw_9.c ..\fftw\fftw\ftwi_10.c ..\fftw\fftw\ftwi_16.c ..\fftw\fftw\ftwi_2.c ..\fftw\fftw\ftwi_3.c ..\fftw\fftw\ftwi_32.c ..\fftw\fftw\ftwi_4.c ..\fftw\fftw\ftwi_5.c ..\fftw\fftw\ftwi_6.c ..\fftw\fftw\ftwi_64.c ..\fftw\fftw\ftwi_7.c ..\fftw\fftw\ftwi_8.c ..\fftw\fftw\ftwi_9.c ..\fftw\fftw\generic.c ..\fftw\fftw\malloc.c ..\fftw\fftw\planner.c ..\fftw\fftw\putils.c ..\fftw\fftw\rader.c ..\fftw\fftw\timer.c ..\fftw\fftw\twiddle.c ..\fftw\fftw\wisdom.c ..\fftw\fftw\wisdomio.c         -I..\fftw\rfftw\ -I..\fftw\fftw\  -I..\fft-lib\ brokenfft.def /Fec:\progra~1\steinberg\vstplugins\dfx-brokenfft.dll
+cl /nologo /O2 /Ot /Og /Oi /Oy /Gs /I..\vstsdk\ /LD ..\brokenfft\brokenfft.cpp ..\dfx-library\dfxfft.cpp ..\vstsdk\AudioEffect.cpp ..\vstsdk\audioeffectx.cpp ..\fft-lib\fftdom.cpp ..\fft-lib\fftmisc.c ..\fft-lib\fourierf.c -I..\fft-lib\ -I..\dfx-library\ brokenfft.def /Fec:\progra~1\steinberg\vstplugins\dfx-brokenfft.dll
 
 
@@ -0,0 +1,504 @@
+/*------------------------------------------------------------------------
+Destroy FX Library is a collection of foundation code
+for creating audio processing plug-ins.
+Copyright (C) 2026  Sophia Poirier and Tom Murphy 7
+
+This file is part of the Destroy FX Library (version 1.0).
+
+Destroy FX Library is free software:  you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+Destroy FX Library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Destroy FX Library.  If not, see <http://www.gnu.org/licenses/>.
+
+To contact the author, use the contact form at http://destroyfx.org
+
+Destroy FX is a sovereign entity comprised of Sophia Poirier and Tom Murphy 7.
+This is a real fast Fourier transform.
+------------------------------------------------------------------------*/
+
+#include "dfxfft.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <type_traits>
+#include <utility>
+
+
+// How it works:
+// The N real samples are taken as N/2 complex ones (even samples real, odd
+// samples imaginary), which get a complex FFT of size M = N/2, and then the
+// bins of the real signal are untangled from that.  The inverse tangles the
+// bins up the same way and then runs the complex FFT backwards, which is the
+// forward one with the real and imaginary parts swapped going in and out.
+// The complex FFT is a Stockham autosort FFT of radix-4 passes (and a final
+// radix-2 pass when M is an odd power of two), which ping-pong between two
+// buffers and leave the result in order, with no bit-reversal.  Complex values
+// are kept split into arrays of real parts and imaginary parts, so that every
+// pass works on runs of neighboring values.
+// Compilers vectorize loops of unknown length only at higher optimization
+// levels (and then have to check whether the arrays overlap), but they do
+// vectorize straight-line arithmetic on small arrays at -O2, so everything
+// works on Blocks of kBlock neighboring values, which become vector registers.
+
+
+
+namespace
+{
+
+constexpr size_t kBlock = 4;
+
+//-----------------------------------------------------------------------------
+struct Block
+{
+	float mValues[kBlock];
+
+	// inStride apart, which is negative to go backward
+	static Block load(float const* inSource, ptrdiff_t inStride = 1)
+	{
+		Block result;
+		for (size_t j = 0; j < kBlock; j++)
+		{
+			result.mValues[j] = inSource[static_cast<ptrdiff_t>(j) * inStride];
+		}
+		return result;
+	}
+	void store(float* outDestination, ptrdiff_t inStride = 1) const
+	{
+		for (size_t j = 0; j < kBlock; j++)
+		{
+			outDestination[static_cast<ptrdiff_t>(j) * inStride] = mValues[j];
+		}
+	}
+
+	template <typename OpF>
+	static Block apply(Block const& inA, Block const& inB, OpF inOp)
+	{
+		Block result;
+		for (size_t j = 0; j < kBlock; j++)
+		{
+			result.mValues[j] = inOp(inA.mValues[j], inB.mValues[j]);
+		}
+		return result;
+	}
+	friend Block operator+(Block const& inA, Block const& inB)
+	{
+		return apply(inA, inB, [](float a, float b){ return a + b; });
+	}
+	friend Block operator-(Block const& inA, Block const& inB)
+	{
+		return apply(inA, inB, [](float a, float b){ return a - b; });
+	}
+	friend Block operator*(Block const& inA, Block const& inB)
+	{
+		return apply(inA, inB, [](float a, float b){ return a * b; });
+	}
+	friend Block operator*(Block const& inA, float inB)
+	{
+		return apply(inA, inA, [inB](float a, float){ return a * inB; });
+	}
+};
+
+//-----------------------------------------------------------------------------
+// so that the same code can work on one value (float) or a Block of them
+template <typename T>
+T Load(float const* inSource, ptrdiff_t inStride = 1)
+{
+	if constexpr (std::is_same_v<T, Block>)
+	{
+		return Block::load(inSource, inStride);
+	}
+	else
+	{
+		return *inSource;
+	}
+}
+
+void Store(float inValue, float* outDestination, ptrdiff_t /*inStride*/ = 1)
+{
+	*outDestination = inValue;
+}
+
+void Store(Block const& inValues, float* outDestination, ptrdiff_t inStride = 1)
+{
+	inValues.store(outDestination, inStride);
+}
+
+//-----------------------------------------------------------------------------
+// Calls inF.template operator()<T>(k) for k from inBegin up to inEnd,
+// with T as Block for as many values as it can, and then float for the rest.
+template <typename F>
+void ForEachBlock(size_t inBegin, size_t inEnd, F&& inF)
+{
+	auto k = inBegin;
+	for (; (k + kBlock) <= inEnd; k += kBlock)
+	{
+		inF.template operator()<Block>(k);
+	}
+	for (; k < inEnd; k++)
+	{
+		inF.template operator()<float>(k);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// A radix-4 butterfly of a..d (each a float or a Block of them), multiplying
+// the outputs y1..y3 by the twiddles t1..t3 (one for all, or a Block).
+template <typename T, typename TwiddleT>
+struct Butterfly4
+{
+	T y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i;
+
+	Butterfly4(T const& ar, T const& ai, T const& br, T const& bi, T const& cr, T const& ci, T const& dr, T const& di,
+			   TwiddleT const& t1r, TwiddleT const& t1i, TwiddleT const& t2r, TwiddleT const& t2i, TwiddleT const& t3r, TwiddleT const& t3i)
+	{
+		auto const apcr = ar + cr, apci = ai + ci;
+		auto const amcr = ar - cr, amci = ai - ci;
+		auto const bpdr = br + dr, bpdi = bi + di;
+		auto const bmdr = br - dr, bmdi = bi - di;
+		// (a - c) - i (b - d), (a + c) - (b + d), (a - c) + i (b - d)
+		auto const u1r = amcr + bmdi, u1i = amci - bmdr;
+		auto const u2r = apcr - bpdr, u2i = apci - bpdi;
+		auto const u3r = amcr - bmdi, u3i = amci + bmdr;
+		y0r = apcr + bpdr;
+		y0i = apci + bpdi;
+		y1r = (u1r * t1r) - (u1i * t1i);
+		y1i = (u1r * t1i) + (u1i * t1r);
+		y2r = (u2r * t2r) - (u2i * t2i);
+		y2i = (u2r * t2i) + (u2i * t2r);
+		y3r = (u3r * t3r) - (u3i * t3i);
+		y3i = (u3r * t3i) + (u3i * t3r);
+	}
+};
+
+//-----------------------------------------------------------------------------
+// The first radix-4 pass, over the whole sequence of length inLength, which
+// takes the complex values straight from the interleaved real signal
+// (or its tangled bins, when inverting).
+// The twiddles are the real and imaginary parts of W^p, W^2p and W^3p
+// (W = e^(-2 pi i / inLength)) for the inLength / 4 values of p.
+void Radix4FirstPass(size_t inLength, float const* __restrict inInterleaved,
+					 float* __restrict outReal, float* __restrict outImaginary, float const* __restrict inTwiddles)
+{
+	auto const quarter = inLength / 4;
+	auto const w1r = inTwiddles, w1i = w1r + quarter;
+	auto const w2r = w1i + quarter, w2i = w2r + quarter;
+	auto const w3r = w2i + quarter, w3i = w3r + quarter;
+	auto const a = inInterleaved, b = a + (quarter * 2), c = b + (quarter * 2), d = c + (quarter * 2);
+
+	// the outputs of each butterfly are neighbors, so here a Block is of butterflies
+	ForEachBlock(0, quarter, [=]<typename T>(size_t p)
+	{
+		auto const x = p * 2;
+		Butterfly4<T, T> const y(Load<T>(a + x, 2), Load<T>(a + x + 1, 2), Load<T>(b + x, 2), Load<T>(b + x + 1, 2),
+								 Load<T>(c + x, 2), Load<T>(c + x + 1, 2), Load<T>(d + x, 2), Load<T>(d + x + 1, 2),
+								 Load<T>(w1r + p), Load<T>(w1i + p), Load<T>(w2r + p),
+								 Load<T>(w2i + p), Load<T>(w3r + p), Load<T>(w3i + p));
+		auto const yr = outReal + (p * 4), yi = outImaginary + (p * 4);
+		Store(y.y0r, yr, 4);
+		Store(y.y0i, yi, 4);
+		Store(y.y1r, yr + 1, 4);
+		Store(y.y1i, yi + 1, 4);
+		Store(y.y2r, yr + 2, 4);
+		Store(y.y2i, yi + 2, 4);
+		Store(y.y3r, yr + 3, 4);
+		Store(y.y3i, yi + 3, 4);
+	});
+}
+
+//-----------------------------------------------------------------------------
+// Every later radix-4 pass, over inStride (a multiple of kBlock) interleaved
+// sequences of length inLength.
+void Radix4Pass(size_t inLength, size_t inStride,
+				float const* __restrict inReal, float const* __restrict inImaginary,
+				float* __restrict outReal, float* __restrict outImaginary, float const* __restrict inTwiddles)
+{
+	auto const quarter = inLength / 4;
+	auto const w1r = inTwiddles, w1i = w1r + quarter;
+	auto const w2r = w1i + quarter, w2i = w2r + quarter;
+	auto const w3r = w2i + quarter, w3i = w3r + quarter;
+	auto const sequenceStride = inStride * quarter;
+
+	for (size_t p = 0; p < quarter; p++)
+	{
+		auto const xr = inReal + (inStride * p), xi = inImaginary + (inStride * p);
+		auto const yr = outReal + (inStride * p * 4), yi = outImaginary + (inStride * p * 4);
+		for (size_t q = 0; q < inStride; q += kBlock)
+		{
+			Butterfly4<Block, float> const y(Block::load(xr + q), Block::load(xi + q),
+											 Block::load(xr + sequenceStride + q), Block::load(xi + sequenceStride + q),
+											 Block::load(xr + (sequenceStride * 2) + q), Block::load(xi + (sequenceStride * 2) + q),
+											 Block::load(xr + (sequenceStride * 3) + q), Block::load(xi + (sequenceStride * 3) + q),
+											 w1r[p], w1i[p], w2r[p], w2i[p], w3r[p], w3i[p]);
+			y.y0r.store(yr + q);
+			y.y0i.store(yi + q);
+			y.y1r.store(yr + inStride + q);
+			y.y1i.store(yi + inStride + q);
+			y.y2r.store(yr + (inStride * 2) + q);
+			y.y2i.store(yi + (inStride * 2) + q);
+			y.y3r.store(yr + (inStride * 3) + q);
+			y.y3i.store(yi + (inStride * 3) + q);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// the last pass, when the size is an odd power of two, which needs no twiddles
+void Radix2Pass(size_t inStride, float const* __restrict inReal, float const* __restrict inImaginary,
+				float* __restrict outReal, float* __restrict outImaginary)
+{
+	for (size_t q = 0; q < inStride; q += kBlock)
+	{
+		auto const ar = Block::load(inReal + q), ai = Block::load(inImaginary + q);
+		auto const br = Block::load(inReal + inStride + q), bi = Block::load(inImaginary + inStride + q);
+		(ar + br).store(outReal + q);
+		(ai + bi).store(outImaginary + q);
+		(ar - br).store(outReal + inStride + q);
+		(ai - bi).store(outImaginary + inStride + q);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Gets bins 1 through M - 1 of the real signal from its half-size transform z,
+// calling inStore(k, real, imaginary) with T (float or Block) values for
+// bins k onward.
+// (DC is z0r + z0i and Nyquist is z0r - z0i.)
+template <typename StoreF>
+void Untangle(size_t inHalfSize, float const* __restrict zr, float const* __restrict zi,
+			  float const* __restrict inCos, float const* __restrict inSin, StoreF&& inStore)
+{
+	ForEachBlock(1, inHalfSize, [&]<typename T>(size_t k)
+	{
+		auto const ar = Load<T>(zr + k), ai = Load<T>(zi + k);
+		auto const br = Load<T>(zr + inHalfSize - k, -1), bi = Load<T>(zi + inHalfSize - k, -1);
+		// the transforms of the even samples and of the odd samples
+		auto const evenr = (ar + br) * 0.5f, eveni = (ai - bi) * 0.5f;
+		auto const oddr = (ai + bi) * 0.5f, oddi = (br - ar) * 0.5f;
+		auto const c = Load<T>(inCos + k), s = Load<T>(inSin + k);
+		inStore(k, evenr + (c * oddr) + (s * oddi), eveni + (c * oddi) - (s * oddr));
+	});
+}
+
+//-----------------------------------------------------------------------------
+// The reverse of Untangle, from bins 1 through M - 1 gotten with
+// inLoad.template operator()<T>(k), which returns the pair of real and
+// imaginary T values for bins k onward, and the real parts of DC and Nyquist.
+// It writes twice the half-size transform, interleaved, with its real and
+// imaginary parts swapped, ready to go backwards.
+template <typename LoadF>
+void Tangle(size_t inHalfSize, float inDC, float inNyquist,
+			float const* __restrict inCos, float const* __restrict inSin, LoadF&& inLoad, float* __restrict outZ)
+{
+	outZ[0] = inDC - inNyquist;
+	outZ[1] = inDC + inNyquist;
+	ForEachBlock(1, inHalfSize, [&]<typename T>(size_t k)
+	{
+		auto const [ar, ai] = inLoad.template operator()<T>(k, 1);
+		auto const [br, bi] = inLoad.template operator()<T>(inHalfSize - k, -1);
+		auto const evenr = ar + br, eveni = ai - bi;
+		auto const diffr = ar - br, diffi = ai + bi;
+		auto const c = Load<T>(inCos + k), s = Load<T>(inSin + k);
+		auto const oddr = (diffr * c) - (diffi * s), oddi = (diffr * s) + (diffi * c);
+		// even + i odd, swapped
+		Store(eveni + oddr, outZ + (k * 2), 2);
+		Store(evenr - oddi, outZ + (k * 2) + 1, 2);
+	});
+}
+
+}  // namespace
+
+
+
+#pragma mark -
+
+//-----------------------------------------------------------------------------
+dfx::FFT::FFT(size_t inSize)
+:	mSize(inSize),
+	mHalfSize(inSize / 2),
+	mRealCos(mHalfSize),
+	mRealSin(mHalfSize),
+	mWorkAReal(mHalfSize),
+	mWorkAImaginary(mHalfSize),
+	mWorkBReal(mHalfSize),
+	mWorkBImaginary(mHalfSize),
+	mTangled(inSize)
+{
+	assert(isSupportedSize(inSize));
+
+	auto const log2HalfSize = static_cast<size_t>(std::countr_zero(mHalfSize));
+	mNumRadix4Passes = log2HalfSize / 2;
+	mHasRadix2Pass = (log2HalfSize % 2) != 0;
+
+	// (in double precision, to get the twiddles right to the last bit)
+	constexpr double twoPi = 2. * std::numbers::pi;
+	for (size_t length = mHalfSize, pass = 0; pass < mNumRadix4Passes; length /= 4, pass++)
+	{
+		auto const quarter = length / 4;
+		auto const start = mPassTwiddles.size();
+		mPassTwiddles.resize(start + (quarter * 6));
+		for (size_t p = 0; p < quarter; p++)
+		{
+			for (size_t power = 1; power <= 3; power++)
+			{
+				auto const angle = -twoPi * static_cast<double>(power * p) / static_cast<double>(length);
+				mPassTwiddles[start + (quarter * ((power - 1) * 2)) + p] = static_cast<float>(std::cos(angle));
+				mPassTwiddles[start + (quarter * ((power - 1) * 2 + 1)) + p] = static_cast<float>(std::sin(angle));
+			}
+		}
+	}
+	for (size_t k = 0; k < mHalfSize; k++)
+	{
+		auto const angle = twoPi * static_cast<double>(k) / static_cast<double>(mSize);
+		mRealCos[k] = static_cast<float>(std::cos(angle));
+		mRealSin[k] = static_cast<float>(std::sin(angle));
+	}
+}
+
+//-----------------------------------------------------------------------------
+dfx::FFT::SplitComplex dfx::FFT::transformHalf(float const* inInterleaved)
+{
+	SplitComplex source {mWorkAReal.data(), mWorkAImaginary.data()};
+	SplitComplex destination {mWorkBReal.data(), mWorkBImaginary.data()};
+
+	// the smallest sizes are nothing at all, or a lone radix-2 butterfly
+	if (mHalfSize == 1)
+	{
+		source.mReal[0] = inInterleaved[0];
+		source.mImaginary[0] = inInterleaved[1];
+		return source;
+	}
+	if (mNumRadix4Passes == 0)
+	{
+		source.mReal[0] = inInterleaved[0] + inInterleaved[2];
+		source.mImaginary[0] = inInterleaved[1] + inInterleaved[3];
+		source.mReal[1] = inInterleaved[0] - inInterleaved[2];
+		source.mImaginary[1] = inInterleaved[1] - inInterleaved[3];
+		return source;
+	}
+
+	auto twiddles = mPassTwiddles.data();
+	Radix4FirstPass(mHalfSize, inInterleaved, source.mReal, source.mImaginary, twiddles);
+	twiddles += (mHalfSize / 4) * 6;
+	size_t length = mHalfSize / 4, stride = 4;
+	for (size_t pass = 1; pass < mNumRadix4Passes; pass++)
+	{
+		Radix4Pass(length, stride, source.mReal, source.mImaginary, destination.mReal, destination.mImaginary, twiddles);
+		std::swap(source, destination);
+		twiddles += (length / 4) * 6;
+		length /= 4;
+		stride *= 4;
+	}
+	if (mHasRadix2Pass)
+	{
+		Radix2Pass(stride, source.mReal, source.mImaginary, destination.mReal, destination.mImaginary);
+		std::swap(source, destination);
+	}
+	return source;
+}
+
+//-----------------------------------------------------------------------------
+template <typename StoreF>
+std::pair<float, float> dfx::FFT::forward(float const* inSignal, StoreF&& inStore)
+{
+	// the even and odd samples are the real and imaginary parts of the half-size transform's input
+	auto const z = transformHalf(inSignal);
+	Untangle(mHalfSize, z.mReal, z.mImaginary, mRealCos.data(), mRealSin.data(), std::forward<StoreF>(inStore));
+	return {z.mReal[0] + z.mImaginary[0], z.mReal[0] - z.mImaginary[0]};
+}
+
+//-----------------------------------------------------------------------------
+void dfx::FFT::forward(float const* inSignal, float* outReal, float* outImaginary)
+{
+	auto const [dc, nyquist] = forward(inSignal, [outReal, outImaginary](size_t k, auto const& re, auto const& im)
+	{
+		Store(re, outReal + k);
+		Store(im, outImaginary + k);
+	});
+	outReal[0] = dc;
+	outImaginary[0] = 0.f;
+	outReal[mHalfSize] = nyquist;
+	outImaginary[mHalfSize] = 0.f;
+}
+
+//-----------------------------------------------------------------------------
+void dfx::FFT::forward(float const* inSignal, std::complex<float>* outBins)
+{
+	// (std::complex is guaranteed to be laid out as an array of its real and imaginary parts)
+	auto const outInterleaved = reinterpret_cast<float*>(outBins);
+	auto const [dc, nyquist] = forward(inSignal, [outInterleaved](size_t k, auto const& re, auto const& im)
+	{
+		Store(re, outInterleaved + (k * 2), 2);
+		Store(im, outInterleaved + (k * 2) + 1, 2);
+	});
+	outBins[0] = dc;
+	outBins[mHalfSize] = nyquist;
+}
+
+//-----------------------------------------------------------------------------
+void dfx::FFT::forwardHalfComplex(float const* inSignal, float* outHalfComplex)
+{
+	auto const outImaginaryEnd = outHalfComplex + mSize;
+	auto const [dc, nyquist] = forward(inSignal, [outHalfComplex, outImaginaryEnd](size_t k, auto const& re, auto const& im)
+	{
+		Store(re, outHalfComplex + k);
+		Store(im, outImaginaryEnd - k, -1);
+	});
+	outHalfComplex[0] = dc;
+	outHalfComplex[mHalfSize] = nyquist;
+}
+
+//-----------------------------------------------------------------------------
+void dfx::FFT::inverseFromTangled(float* outSignal)
+{
+	// transformHalf doesn't know that the parts are swapped, so the swap back is here
+	auto const z = transformHalf(mTangled.data());
+	float const* __restrict const zr = z.mReal;
+	float const* __restrict const zi = z.mImaginary;
+	float* __restrict const out = outSignal;
+	ForEachBlock(0, mHalfSize, [=]<typename T>(size_t k)
+	{
+		Store(Load<T>(zi + k), out + (k * 2), 2);
+		Store(Load<T>(zr + k), out + (k * 2) + 1, 2);
+	});
+}
+
+//-----------------------------------------------------------------------------
+void dfx::FFT::inverse(float const* inReal, float const* inImaginary, float* outSignal)
+{
+	Tangle(mHalfSize, inReal[0], inReal[mHalfSize], mRealCos.data(), mRealSin.data(), [inReal, inImaginary]<typename T>(size_t k, ptrdiff_t inStride)
+	{
+		return std::pair(Load<T>(inReal + k, inStride), Load<T>(inImaginary + k, inStride));
+	}, mTangled.data());
+	inverseFromTangled(outSignal);
+}
+
+//-----------------------------------------------------------------------------
+void dfx::FFT::inverse(std::complex<float> const* inBins, float* outSignal)
+{
+	auto const inInterleaved = reinterpret_cast<float const*>(inBins);
+	Tangle(mHalfSize, inBins[0].real(), inBins[mHalfSize].real(), mRealCos.data(), mRealSin.data(), [inInterleaved]<typename T>(size_t k, ptrdiff_t inStride)
+	{
+		return std::pair(Load<T>(inInterleaved + (k * 2), inStride * 2), Load<T>(inInterleaved + (k * 2) + 1, inStride * 2));
+	}, mTangled.data());
+	inverseFromTangled(outSignal);
+}
+
+//-----------------------------------------------------------------------------
+void dfx::FFT::inverseHalfComplex(float const* inHalfComplex, float* outSignal)
+{
+	auto const inImaginaryEnd = inHalfComplex + mSize;
+	Tangle(mHalfSize, inHalfComplex[0], inHalfComplex[mHalfSize], mRealCos.data(), mRealSin.data(), [inHalfComplex, inImaginaryEnd]<typename T>(size_t k, ptrdiff_t inStride)
+	{
+		return std::pair(Load<T>(inHalfComplex + k, inStride), Load<T>(inImaginaryEnd - k, -inStride));
+	}, mTangled.data());
+	inverseFromTangled(outSignal);
+}
@@ -0,0 +1,126 @@
+/*------------------------------------------------------------------------
+Destroy FX Library is a collection of foundation code
+for creating audio processing plug-ins.
+Copyright (C) 2026  Sophia Poirier and Tom Murphy 7
+
+This file is part of the Destroy FX Library (version 1.0).
+
+Destroy FX Library is free software:  you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+Destroy FX Library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Destroy FX Library.  If not, see <http://www.gnu.org/licenses/>.
+
+To contact the author, use the contact form at http://destroyfx.org
+
+Destroy FX is a sovereign entity comprised of Sophia Poirier and Tom Murphy 7.
+This is a real fast Fourier transform.
+------------------------------------------------------------------------*/
+
+#pragma once
+
+
+#include <bit>
+#include <complex>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+
+namespace dfx
+{
+
+
+//-----------------------------------------------------------------------------
+// A fast Fourier transform of real signals, for the power-of-two sizes
+// from kMinSize to kMaxSize (every frame size that our spectral plugins offer).
+// A signal of size() samples has getNumBins() = size() / 2 + 1 frequency bins,
+// from DC up to Nyquist, whose imaginary parts are always zero.
+// The sign convention and scaling are those of FFTW:  the forward transform
+// uses e^(-i 2 pi k n / size) and neither direction normalizes, so the inverse
+// of the forward transform is the signal multiplied by size().
+// The bins can be laid out in any of three ways:  split (an array of real parts
+// and another of imaginary parts), interleaved (std::complex), or the
+// "halfcomplex" array of size() values r0, r1, ..., r(size/2), i(size/2-1), ..., i1
+// that FFTW's rfftw_one uses.
+// Everything is allocated upon construction, so transforming is realtime-safe,
+// but each FFT has working buffers, so use a separate one on each thread.
+// Inputs and outputs must not overlap.
+class FFT
+{
+public:
+	static constexpr size_t kMinSize = 2;
+	static constexpr size_t kMaxSize = 32768;
+
+	static constexpr bool isSupportedSize(size_t inSize) noexcept
+	{
+		return (inSize >= kMinSize) && (inSize <= kMaxSize) && std::has_single_bit(inSize);
+	}
+
+	// inSize must be supported
+	explicit FFT(size_t inSize);
+
+	size_t size() const noexcept
+	{
+		return mSize;
+	}
+	size_t getNumBins() const noexcept
+	{
+		return (mSize / 2) + 1;
+	}
+
+	// size() samples in, getNumBins() bins out
+	void forward(float const* inSignal, float* outReal, float* outImaginary);
+	void forward(float const* inSignal, std::complex<float>* outBins);
+	// size() samples in, size() halfcomplex values out
+	void forwardHalfComplex(float const* inSignal, float* outHalfComplex);
+
+	// getNumBins() bins in (the imaginary parts of DC and Nyquist are ignored), size() samples out
+	void inverse(float const* inReal, float const* inImaginary, float* outSignal);
+	void inverse(std::complex<float> const* inBins, float* outSignal);
+	// size() halfcomplex values in, size() samples out
+	void inverseHalfComplex(float const* inHalfComplex, float* outSignal);
+
+private:
+	// the real transform is done as a complex one of half the size
+	struct SplitComplex
+	{
+		float* mReal = nullptr;
+		float* mImaginary = nullptr;
+	};
+
+	// the complex forward transform of mHalfSize interleaved values,
+	// returning which of the work buffers the result ends up in
+	SplitComplex transformHalf(float const* inInterleaved);
+	// calls inStore(k, real, imaginary) for bins 1 through mHalfSize - 1 (with one value each,
+	// or a block of them for bins k onward), and returns the real parts of DC and Nyquist
+	template <typename StoreF>
+	std::pair<float, float> forward(float const* inSignal, StoreF&& inStore);
+	// the inverse complex transform of the tangled bins in mTangled, interleaved into the signal
+	void inverseFromTangled(float* outSignal);
+
+	size_t const mSize;
+	size_t const mHalfSize;
+	size_t mNumRadix4Passes = 0;
+	bool mHasRadix2Pass = false;
+
+	// for each radix-4 pass, the real and imaginary parts of W^p, W^2p and W^3p, one after another
+	std::vector<float> mPassTwiddles;
+	// cos and sin of 2 pi k / size, for untangling the half-size transform
+	std::vector<float> mRealCos, mRealSin;
+	// ping-pong buffers for the passes
+	std::vector<float> mWorkAReal, mWorkAImaginary, mWorkBReal, mWorkBImaginary;
+	// the bins to invert, tangled up into the input of the half-size transform
+	std::vector<float> mTangled;
+};
+
+
+}  // namespace dfx
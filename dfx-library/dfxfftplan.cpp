@@ -0,0 +1,292 @@
+/*------------------------------------------------------------------------
+Destroy FX Library is a collection of foundation code
+for creating audio processing plug-ins.
+Copyright (C) 2026  Sophia Poirier and Tom Murphy 7
+
+This file is part of the Destroy FX Library (version 1.0).
+
+Destroy FX Library is free software:  you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+Destroy FX Library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Destroy FX Library.  If not, see <http://www.gnu.org/licenses/>.
+
+To contact the author, use the contact form at http://destroyfx.org
+
+Destroy FX is a sovereign entity comprised of Sophia Poirier and Tom Murphy 7.
+This is a process-wide cache of FFTW plans.
+------------------------------------------------------------------------*/
+
+#include "dfxfftplan.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+
+// read-only plans can be shared between threads, and wisdom makes an estimated plan as good as a measured one
+static constexpr int kEstimateFlags = FFTW_ESTIMATE | FFTW_USE_WISDOM | FFTW_THREADSAFE;
+static constexpr int kMeasureFlags = FFTW_MEASURE | FFTW_USE_WISDOM | FFTW_THREADSAFE;
+
+
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+class PlanCache
+{
+public:
+	~PlanCache()
+	{
+		for (auto const& [key, entry] : mPlans)
+		{
+			rfftw_destroy_plan(entry.mPlan);
+		}
+		std::ranges::for_each(mRetiredPlans, rfftw_destroy_plan);
+	}
+
+	rfftw_plan get(int inSize, fftw_direction inDirection);
+	void measure(std::stop_token inStopToken);
+
+private:
+	using Key = std::pair<int, fftw_direction>;
+	struct Entry
+	{
+		rfftw_plan mPlan = nullptr;
+		bool mMeasured = false;
+	};
+
+	rfftw_plan find(Key inKey);
+	void loadWisdom();
+	void saveWisdom();
+
+	// FFTW's planner and its wisdom are global and not thread-safe, so all planning happens under this lock
+	std::mutex mPlannerLock;
+	bool mWisdomLoaded = false;
+	std::string mSavedWisdom;
+
+	// (measuring holds the planner for a long time, but never this)
+	std::mutex mPlansLock;
+	std::map<Key, Entry> mPlans;
+	// replaced plans, which whoever got them earlier might still be using
+	std::vector<rfftw_plan> mRetiredPlans;
+};
+
+//-----------------------------------------------------------------------------
+rfftw_plan PlanCache::find(Key inKey)
+{
+	std::lock_guard const guard(mPlansLock);
+	auto const found = mPlans.find(inKey);
+	return (found != mPlans.end()) ? found->second.mPlan : nullptr;
+}
+
+//-----------------------------------------------------------------------------
+rfftw_plan PlanCache::get(int inSize, fftw_direction inDirection)
+{
+	Key const key(inSize, inDirection);
+	if (auto const plan = find(key))
+	{
+		return plan;
+	}
+
+	std::lock_guard const plannerGuard(mPlannerLock);
+	// somebody else might have made it while we waited for the planner
+	if (auto const plan = find(key))
+	{
+		return plan;
+	}
+	if (!std::exchange(mWisdomLoaded, true))
+	{
+		loadWisdom();
+	}
+	auto const plan = rfftw_create_plan(inSize, inDirection, kEstimateFlags);
+	if (plan)
+	{
+		std::lock_guard const guard(mPlansLock);
+		mPlans.emplace(key, Entry{plan});
+	}
+	return plan;
+}
+
+//-----------------------------------------------------------------------------
+void PlanCache::measure(std::stop_token inStopToken)
+{
+	std::vector<Key> keys;
+	{
+		std::lock_guard const guard(mPlansLock);
+		for (auto const& [key, entry] : mPlans)
+		{
+			if (!entry.mMeasured)
+			{
+				keys.push_back(key);
+			}
+		}
+	}
+	if (keys.empty())
+	{
+		return;
+	}
+
+	std::lock_guard const plannerGuard(mPlannerLock);
+	for (auto const& key : keys)
+	{
+		if (inStopToken.stop_requested())
+		{
+			break;
+		}
+		// (instant when the wisdom already knows it)
+		auto const plan = rfftw_create_plan(key.first, key.second, kMeasureFlags);
+		if (!plan)
+		{
+			continue;
+		}
+		std::lock_guard const guard(mPlansLock);
+		auto& entry = mPlans[key];
+		mRetiredPlans.push_back(std::exchange(entry.mPlan, plan));
+		entry.mMeasured = true;
+	}
+	saveWisdom();
+}
+
+//-----------------------------------------------------------------------------
+void PlanCache::loadWisdom()
+{
+	auto const path = dfx::GetFFTWisdomFilePath();
+	if (path.empty())
+	{
+		return;
+	}
+	std::ifstream in(path, std::ios::binary);
+	std::string wisdom((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	if (wisdom.empty())
+	{
+		return;
+	}
+	if (fftw_import_wisdom_from_string(wisdom.c_str()) == FFTW_SUCCESS)
+	{
+		mSavedWisdom = std::move(wisdom);
+	}
+	else
+	{
+		// it may have taken some of a corrupt file before noticing
+		fftw_forget_wisdom();
+	}
+}
+
+//-----------------------------------------------------------------------------
+void PlanCache::saveWisdom()
+{
+	std::unique_ptr<char, decltype(&fftw_free)> const exported(fftw_export_wisdom_to_string(), fftw_free);
+	if (!exported || (mSavedWisdom == exported.get()))
+	{
+		return;
+	}
+	auto const path = dfx::GetFFTWisdomFilePath();
+	if (path.empty())
+	{
+		return;
+	}
+
+	// write it beside the destination and then move it into place,
+	// since other processes might be reading the file that's there
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+	auto tempPath = path;
+	tempPath += ".tmp";
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		out << exported.get();
+		out.close();
+		if (!out)
+		{
+			std::filesystem::remove(tempPath, error);
+			return;
+		}
+	}
+	std::filesystem::rename(tempPath, path, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return;
+	}
+	mSavedWisdom = exported.get();
+}
+
+//-----------------------------------------------------------------------------
+PlanCache& GetPlanCache()
+{
+	static PlanCache cache;
+	return cache;
+}
+
+}  // namespace
+
+
+
+//-----------------------------------------------------------------------------
+rfftw_plan dfx::GetRealFFTPlan(int inSize, fftw_direction inDirection)
+{
+	return GetPlanCache().get(inSize, inDirection);
+}
+
+//-----------------------------------------------------------------------------
+void dfx::MeasureFFTPlans(std::stop_token inStopToken)
+{
+	GetPlanCache().measure(inStopToken);
+}
+
+//-----------------------------------------------------------------------------
+std::filesystem::path dfx::GetFFTWisdomFilePath()
+{
+	auto const getDirectory = [](char const* inVariableName) -> std::filesystem::path
+	{
+		auto const value = std::getenv(inVariableName);
+		return (value && *value) ? value : std::filesystem::path();
+	};
+
+	std::filesystem::path directory;
+#if defined(_WIN32)
+	directory = getDirectory("LOCALAPPDATA");
+	if (!directory.empty())
+	{
+		directory /= "Destroy FX";
+	}
+#elif defined(__APPLE__)
+	directory = getDirectory("HOME");
+	if (!directory.empty())
+	{
+		directory /= "Library/Caches/Destroy FX";
+	}
+#else
+	directory = getDirectory("XDG_CACHE_HOME");
+	if (directory.empty())
+	{
+		directory = getDirectory("HOME");
+		if (!directory.empty())
+		{
+			directory /= ".cache";
+		}
+	}
+	if (!directory.empty())
+	{
+		directory /= "destroyfx";
+	}
+#endif
+	return directory.empty() ? directory : (directory / "fftw-wisdom.txt");
+}
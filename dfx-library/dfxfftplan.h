@@ -0,0 +1,68 @@
+/*------------------------------------------------------------------------
+Destroy FX Library is a collection of foundation code
+for creating audio processing plug-ins.
+Copyright (C) 2026  Sophia Poirier and Tom Murphy 7
+
+This file is part of the Destroy FX Library (version 1.0).
+
+Destroy FX Library is free software:  you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+Destroy FX Library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Destroy FX Library.  If not, see <http://www.gnu.org/licenses/>.
+
+To contact the author, use the contact form at http://destroyfx.org
+
+Destroy FX is a sovereign entity comprised of Sophia Poirier and Tom Murphy 7.
+This is a process-wide cache of FFTW plans.
+------------------------------------------------------------------------*/
+
+#pragma once
+
+
+#include <filesystem>
+#include <stop_token>
+
+#include "rfftw.h"
+
+
+
+namespace dfx
+{
+
+
+//-----------------------------------------------------------------------------
+// Returns the shared real FFTW plan for transforms of the given size in
+// the given direction (FFTW_REAL_TO_COMPLEX or FFTW_COMPLEX_TO_REAL),
+// creating it the first time that anybody in the process asks for it.
+// Creating one is quick, and so is getting one that already exists, but
+// don't do either from the audio thread, since the planner has a lock.
+// A new plan is estimated, unless the FFTW wisdom saved by an earlier
+// MeasureFFTPlans already knows the best plan for the size, and then it
+// is that.
+// The cache owns the plans and keeps them for the life of the process,
+// so don't destroy them.  They are read-only while transforming, so any
+// number of threads may use the same plan at the same time.
+// Returns null if FFTW could not make a plan.
+rfftw_plan GetRealFFTPlan(int inSize, fftw_direction inDirection);
+
+// Measures the best plans for every size and direction that has been
+// asked for, saves what it learns as FFTW wisdom in a cache file (so
+// from then on, in every process, the best plans come right away), and
+// replaces the estimated plans with the measured ones for anybody who
+// asks afterward.  Measuring can take seconds, so do it on a background
+// thread.  Stops early, between plans, if a stop is requested.
+void MeasureFFTPlans(std::stop_token inStopToken = {});
+
+// where the FFTW wisdom is kept (empty if there is no place for it)
+std::filesystem::path GetFFTWisdomFilePath();
+
+
+}  // namespace dfx
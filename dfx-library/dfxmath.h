@@ -1,7 +1,7 @@
 /*------------------------------------------------------------------------
 Destroy FX Library is a collection of foundation code 
 for creating audio processing plug-ins.  
-Copyright (C) 2001-2023  Sophia Poirier
+Copyright (C) 2001-2026  Sophia Poirier
 
 This file is part of the Destroy FX Library (version 1.0).
 
@@ -28,11 +28,14 @@ This is our math and numerics shit.
 #pragma once
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <chrono>
 #include <cmath>
 #include <concepts>
+#include <cstdint>
 #include <limits>
+#include <numbers>
 #include <random>
 #include <span>
 #include <tuple>
@@ -256,6 +259,126 @@ constexpr double LambertW(double inValue)
 	}
 }
 
+//-----------------------------------------------------------------------------
+// Exponential, logarithm and cosine approximations made only of arithmetic and bit operations, 
+// with no branches or table lookups, so that loops applying them across arrays can 
+// be auto-vectorized (unlike calls into the standard math library).  They are 
+// accurate to within a few ULP for the arguments that arise in filter design, 
+// but there is no handling of NaN, FastLog is only meant for positive normal values, 
+// and FastCos is only meant for |x| < 2^20 * pi (its result is unbounded beyond that, 
+// so frequencies should be converted with GetAngularFrequency rather than multiplied out).
+
+namespace detail
+{
+// adding then subtracting this rounds to the nearest integer, leaving that integer in the low mantissa bits
+inline constexpr double kRoundingMagic = 6755399441055744.0;  // 1.5 * 2^52
+}
+
+//-----------------------------------------------------------------------------
+constexpr double FastExp(double inValue) noexcept
+{
+	constexpr double kLog2e = 1.4426950408889634074;
+	constexpr double kLn2_hi = 6.93147180369123816490e-01;  // upper bits, exact when multiplied by small integers
+	constexpr double kLn2_lo = 1.90821492927058770002e-10;
+	// keep the result within the normal double range
+	auto x = (inValue < -708.0) ? -708.0 : inValue;
+	x = (x > 709.0) ? 709.0 : x;
+	// x = k * ln(2) + r, where |r| <= ln(2) / 2
+	auto const kShifted = (x * kLog2e) + detail::kRoundingMagic;
+	auto const k = kShifted - detail::kRoundingMagic;
+	auto const r = (x - (k * kLn2_hi)) - (k * kLn2_lo);
+	// Taylor series of e^r, sufficient to 12th order for |r| <= ln(2) / 2
+	auto p = 1.0 / 479001600.0;
+	p = (p * r) + (1.0 / 39916800.0);
+	p = (p * r) + (1.0 / 3628800.0);
+	p = (p * r) + (1.0 / 362880.0);
+	p = (p * r) + (1.0 / 40320.0);
+	p = (p * r) + (1.0 / 5040.0);
+	p = (p * r) + (1.0 / 720.0);
+	p = (p * r) + (1.0 / 120.0);
+	p = (p * r) + (1.0 / 24.0);
+	p = (p * r) + (1.0 / 6.0);
+	p = (p * r) + 0.5;
+	p = (p * r) + 1.0;
+	p = (p * r) + 1.0;
+	// 2^k, built directly as the exponent bits
+	auto const scale = std::bit_cast<double>((std::bit_cast<uint64_t>(kShifted) + 1023) << 52);
+	return p * scale;
+}
+
+//-----------------------------------------------------------------------------
+// natural logarithm
+constexpr double FastLog(double inValue) noexcept
+{
+	constexpr uint64_t kSqrtHalfBits = 0x3FE6A09E667F3BCD;  // sqrt(1/2)
+	constexpr uint64_t kOneBits = 0x3FF0000000000000;
+	constexpr uint64_t kMantissaMask = 0x000FFFFFFFFFFFFF;
+	constexpr double kLn2_hi = 6.93147180369123816490e-01;
+	constexpr double kLn2_lo = 1.90821492927058770002e-10;
+	// x = 2^k * m, where sqrt(1/2) <= m < sqrt(2), by offsetting the bits so that the exponent rolls over at sqrt(2)
+	auto const offsetBits = std::bit_cast<uint64_t>(inValue) + (kOneBits - kSqrtHalfBits);
+	auto const k = static_cast<double>(static_cast<int64_t>(offsetBits >> 52) - 1023);
+	auto const m = std::bit_cast<double>((offsetBits & kMantissaMask) + kSqrtHalfBits);
+	// log(m) = 2 * atanh(z), where z = (m - 1) / (m + 1), and so |z| <= 0.1716
+	auto const z = (m - 1.0) / (m + 1.0);
+	auto const z2 = z * z;
+	// series of atanh(z) / z, sufficient to 20th order for that range
+	auto p = 1.0 / 21.0;
+	p = (p * z2) + (1.0 / 19.0);
+	p = (p * z2) + (1.0 / 17.0);
+	p = (p * z2) + (1.0 / 15.0);
+	p = (p * z2) + (1.0 / 13.0);
+	p = (p * z2) + (1.0 / 11.0);
+	p = (p * z2) + (1.0 / 9.0);
+	p = (p * z2) + (1.0 / 7.0);
+	p = (p * z2) + (1.0 / 5.0);
+	p = (p * z2) + (1.0 / 3.0);
+	p = (p * z2) + 1.0;
+	return (k * kLn2_hi) + ((2.0 * z * p) + (k * kLn2_lo));
+}
+
+//-----------------------------------------------------------------------------
+constexpr double FastCos(double inValue) noexcept
+{
+	constexpr double kInvPi = 0.31830988618379067154;
+	// pi in three parts, the first two exact when multiplied by integers below 2^20
+	constexpr double kPi_1 = 3.14159265346825122833e+00;
+	constexpr double kPi_2 = 1.21542010130123844986e-10;
+	constexpr double kPi_3 = 4.04453249742233291160e-21;
+	auto const x = std::fabs(inValue);
+	// x = n * pi + y, where |y| <= pi / 2, and so cos(x) = (-1)^n * cos(y)
+	auto const nShifted = (x * kInvPi) + detail::kRoundingMagic;
+	auto const n = nShifted - detail::kRoundingMagic;
+	auto const y = ((x - (n * kPi_1)) - (n * kPi_2)) - (n * kPi_3);
+	auto const y2 = y * y;
+	// Taylor series of cos(y), sufficient to 20th order for |y| <= pi / 2
+	auto p = 1.0 / 2432902008176640000.0;
+	p = (p * y2) - (1.0 / 6402373705728000.0);
+	p = (p * y2) + (1.0 / 20922789888000.0);
+	p = (p * y2) - (1.0 / 87178291200.0);
+	p = (p * y2) + (1.0 / 479001600.0);
+	p = (p * y2) - (1.0 / 3628800.0);
+	p = (p * y2) + (1.0 / 40320.0);
+	p = (p * y2) - (1.0 / 720.0);
+	p = (p * y2) + (1.0 / 24.0);
+	p = (p * y2) - 0.5;
+	p = (p * y2) + 1.0;
+	// negate for odd n by flipping the sign bit
+	auto const signBit = (std::bit_cast<uint64_t>(nShifted) & 1) << 63;
+	return std::bit_cast<double>(std::bit_cast<uint64_t>(p) ^ signBit);
+}
+
+//-----------------------------------------------------------------------------
+// converts a frequency in Hz to radians per sample, first aliasing frequencies at or 
+// beyond the sample rate back below it (exactly, via fmod) so that the result is always 
+// within FastCos's valid range, however far above Nyquist the input frequency may be
+inline double GetAngularFrequency(double inFrequency, double inSamplerate) noexcept
+{
+	assert(inSamplerate > 0.);
+	auto const frequency = (std::fabs(inFrequency) < inSamplerate) ? inFrequency : std::fmod(inFrequency, inSamplerate);
+	return frequency * (std::numbers::pi_v<double> * 2.0) / inSamplerate;
+}
+
 //-----------------------------------------------------------------------------
 // provides a good enough parameter smoothing update sample interval for frequency-based parameters;
 // this is targeting an update granularity of every 4 sample frames at a 44.1 kHz sample rate
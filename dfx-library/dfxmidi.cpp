@@ -178,6 +178,12 @@ bool DfxMidi::isNoteActive(int inMidiNote) const
 	return (getNoteState(inMidiNote).mVelocity != 0);
 }
 
+//-----------------------------------------------------------------------------
+bool DfxMidi::isNoteReleasing(int inMidiNote) const
+{
+	return (getNoteState(inMidiNote).mEnvelope.getState() == DfxEnvelope::State::Release);
+}
+
 //-----------------------------------------------------------------------------
 DfxMidi::MusicNote const& DfxMidi::getNoteState(int inMidiNote) const
 {
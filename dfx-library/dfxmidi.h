@@ -178,6 +178,8 @@ public:
 	}
 
 	bool isNoteActive(int inMidiNote) const;
+	// whether the note has ended and is fading out
+	bool isNoteReleasing(int inMidiNote) const;
 
 	// manage the ordered queue of active MIDI notes
 	void insertNote(int inMidiNote);
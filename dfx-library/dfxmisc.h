@@ -35,6 +35,7 @@ These are some generally useful functions.
 #include <cstring>
 #include <initializer_list>
 #include <memory>
+#include <new>
 #include <span>
 #include <string>
 #include <string_view>
@@ -88,6 +89,33 @@ auto MakeUniqueMemoryBlock(size_t size) noexcept
 	return std::unique_ptr<T, D>(static_cast<T*>(std::malloc(size)), D());
 }
 
+//-----------------------------------------------------------------------------
+namespace detail
+{
+	template <size_t Alignment>
+	struct AlignedArrayDeleter
+	{
+		void operator()(void* array) const noexcept
+		{
+			::operator delete[](array, std::align_val_t(Alignment));
+		}
+	};
+}
+
+// an array whose start is aligned for the widest SIMD loads (and to a cache line)
+template <typename T, size_t Alignment = 64>
+using UniqueAlignedArray = std::unique_ptr<T[], detail::AlignedArrayDeleter<Alignment>>;
+
+// count zero-initialized values
+template <typename T, size_t Alignment = 64>
+requires std::is_trivial_v<T>
+UniqueAlignedArray<T, Alignment> MakeUniqueAlignedArray(size_t count)
+{
+	auto const array = static_cast<T*>(::operator new[](count * sizeof(T), std::align_val_t(Alignment)));
+	std::fill_n(array, count, T{});
+	return UniqueAlignedArray<T, Alignment>(array);
+}
+
 //-----------------------------------------------------------------------------
 template <typename T, auto D>
 using UniqueOpaqueType = std::unique_ptr<typename std::remove_pointer_t<T>, detail::UniqueTypeDeleter<T, D>>;
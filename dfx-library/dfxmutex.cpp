@@ -1,7 +1,7 @@
 /*------------------------------------------------------------------------
 Destroy FX Library is a collection of foundation code 
 for creating audio processing plug-ins.  
-Copyright (C) 2002-2021  Sophia Poirier
+Copyright (C) 2002-2026  Sophia Poirier
 
 This file is part of the Destroy FX Library (version 1.0).
 
@@ -26,21 +26,301 @@ This is our mutually exclusive shit.
 
 #include "dfxmutex.h"
 
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#if defined(__APPLE__)
+	#include <mach/mach.h>
+	#include <mach/mach_time.h>
+	#include <mach/thread_policy.h>
+	#include <pthread.h>
+#elif defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#include <immintrin.h>
+#elif defined(_M_ARM64)
+	#include <intrin.h>
+#endif
+
+
+// the wait between attempts doubles, up to this many pause instructions
+static constexpr unsigned int kMaxBackoffSpins = 64;
+// after this many waiting attempts, a non-realtime waiter begins yielding to the scheduler
+static constexpr unsigned int kYieldAfterAttempts = 10;
+// an idle worker checks this many times for a new batch of tasks before going to sleep
+static constexpr unsigned int kWorkerIdleSpins = 4096;
+// the dispatching thread waits this many times for workers to finish their tasks before yielding
+static constexpr unsigned int kDispatcherWaitSpins = 1024;
+
+
+
+//------------------------------------------------------------------------
+// hint to the CPU that we are in a spin-wait loop
+// (reduces power and frees resources for a sibling hyperthread, which may well be the lock holder)
+static inline void CPUPause() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#elif defined(_M_ARM64)
+	__yield();
+#endif
+}
 
 
 //------------------------------------------------------------------------
 
 void dfx::SpinLock::lock()
 {
-	while (!try_lock());
+	lockWithBackoff(true);
+}
+
+void dfx::SpinLock::lock_realtime()
+{
+	lockWithBackoff(false);
 }
 
 bool dfx::SpinLock::try_lock()
 {
-	return !mFlag.test_and_set(std::memory_order_acquire);
+	auto const acquired = !mFlag.test_and_set(std::memory_order_acquire);
+#if DFX_SPINLOCK_STATISTICS
+	(acquired ? mAcquisitions : mFailedTryLocks).fetch_add(1, std::memory_order_relaxed);
+#endif
+	return acquired;
 }
 
 void dfx::SpinLock::unlock()
 {
 	mFlag.clear(std::memory_order_release);
 }
+
+void dfx::SpinLock::lockWithBackoff(bool inAllowYield)
+{
+	if (!mFlag.test_and_set(std::memory_order_acquire))
+	{
+#if DFX_SPINLOCK_STATISTICS
+		mAcquisitions.fetch_add(1, std::memory_order_relaxed);
+#endif
+		return;
+	}
+
+	[[maybe_unused]] uint64_t totalSpins = 0, totalYields = 0;
+	unsigned int backoffSpins = 1, attempt = 0;
+	do
+	{
+		// wait on plain loads until the lock appears free, so that waiters 
+		// are not hammering the cache line with writes while it is held
+		do
+		{
+			if (inAllowYield && (attempt >= kYieldAfterAttempts))
+			{
+				std::this_thread::yield();
+				totalYields++;
+			}
+			else
+			{
+				for (unsigned int i = 0; i < backoffSpins; i++)
+				{
+					CPUPause();
+				}
+				totalSpins += backoffSpins;
+				backoffSpins = std::min(backoffSpins * 2, kMaxBackoffSpins);
+			}
+			attempt++;
+		} while (mFlag.test(std::memory_order_relaxed));
+	} while (mFlag.test_and_set(std::memory_order_acquire));
+
+#if DFX_SPINLOCK_STATISTICS
+	mAcquisitions.fetch_add(1, std::memory_order_relaxed);
+	mContendedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+	mSpinIterations.fetch_add(totalSpins, std::memory_order_relaxed);
+	mYields.fetch_add(totalYields, std::memory_order_relaxed);
+#endif
+}
+
+#if DFX_SPINLOCK_STATISTICS
+dfx::SpinLock::Statistics dfx::SpinLock::getStatistics() const noexcept
+{
+	return {.mAcquisitions = mAcquisitions.load(std::memory_order_relaxed), 
+			.mContendedAcquisitions = mContendedAcquisitions.load(std::memory_order_relaxed), 
+			.mFailedTryLocks = mFailedTryLocks.load(std::memory_order_relaxed), 
+			.mSpinIterations = mSpinIterations.load(std::memory_order_relaxed), 
+			.mYields = mYields.load(std::memory_order_relaxed)};
+}
+
+void dfx::SpinLock::resetStatistics() noexcept
+{
+	mAcquisitions.store(0, std::memory_order_relaxed);
+	mContendedAcquisitions.store(0, std::memory_order_relaxed);
+	mFailedTryLocks.store(0, std::memory_order_relaxed);
+	mSpinIterations.store(0, std::memory_order_relaxed);
+	mYields.store(0, std::memory_order_relaxed);
+}
+#endif
+
+
+
+#pragma mark -
+
+//------------------------------------------------------------------------
+dfx::RealtimeWorkerPool::RealtimeWorkerPool(size_t inNumWorkers)
+{
+	mThreads.reserve(inNumWorkers);
+	for (size_t workerIndex = 0; workerIndex < inNumWorkers; workerIndex++)
+	{
+		mThreads.emplace_back(&RealtimeWorkerPool::workerLoop, this, workerIndex + 1);
+	}
+}
+
+//------------------------------------------------------------------------
+dfx::RealtimeWorkerPool::~RealtimeWorkerPool()
+{
+	mShouldQuit = true;
+	// any change of the batch state wakes the workers
+	mBatchState.fetch_add(uint64_t(1) << kBatchGenerationShift);
+	mBatchState.notify_all();
+	mThreads.clear();
+}
+
+//------------------------------------------------------------------------
+void dfx::RealtimeWorkerPool::dispatch(size_t inNumTasks, TaskTrampoline inTrampoline, void* inContext)
+{
+	assert(inNumTasks <= kMaxTasks);
+	if (inNumTasks == 0)
+	{
+		return;
+	}
+
+	mTaskTrampoline = inTrampoline;
+	mTaskContext = inContext;
+	mIncompleteTasks.store(inNumTasks, std::memory_order_relaxed);
+	auto const generation = (mBatchState.load(std::memory_order_relaxed) >> kBatchGenerationShift) + 1;
+	auto const batchState = (generation << kBatchGenerationShift) | static_cast<uint64_t>(inNumTasks);
+	mBatchState.store(batchState, std::memory_order_release);
+	if (!mThreads.empty() && (inNumTasks > 1))
+	{
+		mBatchState.notify_all();
+	}
+
+	// this claims every task that no worker has, so what remains to wait for is only 
+	// the tasks that workers already have underway, never ones that a worker is yet to wake up for
+	performTasks(batchState, 0);
+
+	// a worker that got preempted mid-task may need this very core to finish, so stop spinning after a while
+	for (unsigned int attempt = 0; mIncompleteTasks.load(std::memory_order_acquire) > 0; attempt++)
+	{
+		if (attempt < kDispatcherWaitSpins)
+		{
+			CPUPause();
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+void dfx::RealtimeWorkerPool::performTasks(uint64_t inBatchState, size_t inParticipantIndex)
+{
+	auto const generation = inBatchState >> kBatchGenerationShift;
+	auto batchState = inBatchState;
+	while (true)
+	{
+		auto const nextTask = (batchState >> kNextTaskShift) & kTaskFieldMask;
+		auto const numTasks = batchState & kTaskFieldMask;
+		if (((batchState >> kBatchGenerationShift) != generation) || (nextTask >= numTasks))
+		{
+			return;
+		}
+		if (mBatchState.compare_exchange_weak(batchState, batchState + (uint64_t(1) << kNextTaskShift), 
+											  std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			mTaskTrampoline(mTaskContext, static_cast<size_t>(nextTask), inParticipantIndex);
+			mIncompleteTasks.fetch_sub(1, std::memory_order_release);
+			batchState = mBatchState.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+void dfx::PromoteCurrentThreadToRealtime()
+{
+#if defined(__APPLE__)
+	mach_timebase_info_data_t timebase {};
+	mach_timebase_info(&timebase);
+	auto const nanosToAbsolute = [timebase](double inNanos)
+	{
+		return static_cast<uint32_t>(inNanos * static_cast<double>(timebase.denom) / static_cast<double>(timebase.numer));
+	};
+	// the period roughly of a 128-sample buffer at 44.1 kHz, needing a fraction of it for computation
+	constexpr double periodNanos = 2'900'000.0;
+	thread_time_constraint_policy_data_t policy {};
+	policy.period = nanosToAbsolute(periodNanos);
+	policy.computation = nanosToAbsolute(periodNanos * 0.25);
+	policy.constraint = nanosToAbsolute(periodNanos);
+	policy.preemptible = true;
+	auto const status = thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_TIME_CONSTRAINT_POLICY, 
+										  reinterpret_cast<thread_policy_t>(&policy), THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+	if (status != KERN_SUCCESS)
+	{
+		pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+	}
+#elif defined(_WIN32)
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#else
+	sched_param param {};
+	param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+	pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+}
+
+//------------------------------------------------------------------------
+void dfx::RealtimeWorkerPool::workerLoop(size_t inParticipantIndex)
+{
+#if defined(__APPLE__)
+	pthread_setname_np("dfx realtime worker");
+#endif
+	// the dispatching audio thread waits for the workers to finish their tasks, so they 
+	// need to be scheduled like it is, otherwise any busier thread could preempt them and 
+	// in turn hold up audio rendering
+	PromoteCurrentThreadToRealtime();
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	// audio hosts flush denormals to zero on their render threads, so do the same for ours
+	_mm_setcsr(_mm_getcsr() | 0x8040);  // FTZ | DAZ
+#endif
+
+	auto const getGeneration = [](uint64_t inBatchState){ return inBatchState >> kBatchGenerationShift; };
+	auto lastGeneration = getGeneration(mBatchState.load(std::memory_order_acquire));
+	while (true)
+	{
+		auto batchState = mBatchState.load(std::memory_order_acquire);
+		for (unsigned int spin = 0; (spin < kWorkerIdleSpins) && (getGeneration(batchState) == lastGeneration); spin++)
+		{
+			CPUPause();
+			batchState = mBatchState.load(std::memory_order_acquire);
+		}
+		if (getGeneration(batchState) == lastGeneration)
+		{
+			// claiming tasks also changes the state, so this can wake up without there being a new batch
+			mBatchState.wait(batchState, std::memory_order_acquire);
+			continue;
+		}
+		if (mShouldQuit)
+		{
+			return;
+		}
+		lastGeneration = getGeneration(batchState);
+		performTasks(batchState, inParticipantIndex);
+	}
+}
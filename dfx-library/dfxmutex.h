@@ -1,7 +1,7 @@
 /*------------------------------------------------------------------------
 Destroy FX Library is a collection of foundation code 
 for creating audio processing plug-ins.  
-Copyright (C) 2002-2021  Sophia Poirier
+Copyright (C) 2002-2026  Sophia Poirier
 
 This file is part of the Destroy FX Library (version 1.0).
 
@@ -28,6 +28,17 @@ This is our mutually exclusive shit.
 
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+// collect counts of acquisitions and contention (a few relaxed atomic increments per lock operation)
+#ifndef DFX_SPINLOCK_STATISTICS
+	#define DFX_SPINLOCK_STATISTICS	DEBUG
+#endif
 
 
 
@@ -39,9 +50,23 @@ namespace dfx
 // even if the realtime thread avoids waiting when acquiring the lock (e.g. using try_lock).  
 // A lightweight spinlock, while having some behavioral disadvantages if waiting to lock, 
 // can meet the wait-free / try_lock performance requirements for such use cases.
+// Waiting to lock spins with exponential backoff on a CPU pause instruction.  The default 
+// lock() will fall back to yielding the thread to the scheduler when contention persists, 
+// whereas lock_realtime() never yields and is what realtime audio threads should use.
 class SpinLock
 {
 public:
+#if DFX_SPINLOCK_STATISTICS
+	struct Statistics
+	{
+		uint64_t mAcquisitions = 0;  // successful lock, lock_realtime, or try_lock
+		uint64_t mContendedAcquisitions = 0;  // lock or lock_realtime that could not acquire on the first attempt
+		uint64_t mFailedTryLocks = 0;
+		uint64_t mSpinIterations = 0;  // total pause instructions executed while waiting
+		uint64_t mYields = 0;  // total scheduler yields while waiting
+	};
+#endif
+
 	SpinLock() noexcept = default;
 	~SpinLock() noexcept = default;
 	SpinLock(SpinLock const&) = delete;
@@ -53,9 +78,102 @@ public:
 	void lock();
 	bool try_lock();
 	void unlock();
+	// same as lock, but never yields the calling thread
+	void lock_realtime();
+
+#if DFX_SPINLOCK_STATISTICS
+	Statistics getStatistics() const noexcept;
+	void resetStatistics() noexcept;
+#endif
 
 private:
+	void lockWithBackoff(bool inAllowYield);
+
 	std::atomic_flag mFlag = ATOMIC_FLAG_INIT;
+
+#if DFX_SPINLOCK_STATISTICS
+	std::atomic<uint64_t> mAcquisitions {0};
+	std::atomic<uint64_t> mContendedAcquisitions {0};
+	std::atomic<uint64_t> mFailedTryLocks {0};
+	std::atomic<uint64_t> mSpinIterations {0};
+	std::atomic<uint64_t> mYields {0};
+#endif
+};
+
+
+
+
+// Gives the calling thread scheduling like that of an audio render thread, for threads 
+// whose work audio rendering relies upon being done on time.  This is best effort, 
+// failing quietly where the system does not allow it (e.g. Linux without realtime 
+// scheduling privileges).
+void PromoteCurrentThreadToRealtime();
+
+
+
+
+// A small pool of worker threads that help a realtime thread (e.g. audio rendering) get 
+// through a batch of independent tasks in parallel.  The dispatching thread works on tasks 
+// too and returns once every task has completed.  Dispatching neither allocates nor locks, 
+// though it does wake any sleeping workers.  Workers that are late to wake up simply miss 
+// out on that batch rather than holding it up.  Idle workers spin briefly before sleeping.
+// Workers run with realtime scheduling where the system permits it, since the dispatching 
+// thread has to wait for any tasks that they have claimed.
+// Only one thread at a time may dispatch tasks to a given pool.
+class RealtimeWorkerPool
+{
+public:
+	// starts this many worker threads in addition to the dispatching thread
+	explicit RealtimeWorkerPool(size_t inNumWorkers);
+	~RealtimeWorkerPool();
+	RealtimeWorkerPool(RealtimeWorkerPool const&) = delete;
+	RealtimeWorkerPool(RealtimeWorkerPool&&) = delete;
+	RealtimeWorkerPool& operator=(RealtimeWorkerPool const&) = delete;
+	RealtimeWorkerPool& operator=(RealtimeWorkerPool&&) = delete;
+
+	// the number of distinct threads that may execute tasks, including the dispatching thread
+	size_t getNumParticipants() const noexcept
+	{
+		return mThreads.size() + 1;
+	}
+
+	// invokes inTask(taskIndex, participantIndex) for every task index less than inNumTasks, 
+	// where the participant index (less than getNumParticipants) identifies the executing 
+	// thread, for the sake of per-thread scratch storage (0 is the dispatching thread)
+	template <typename TaskFunc>
+	void run(size_t inNumTasks, TaskFunc&& inTask)
+	{
+		using TaskFuncT = std::remove_reference_t<TaskFunc>;
+		dispatch(inNumTasks, [](void* inContext, size_t inTaskIndex, size_t inParticipantIndex)
+		{
+			(*static_cast<TaskFuncT*>(inContext))(inTaskIndex, inParticipantIndex);
+		}, const_cast<void*>(static_cast<void const*>(&inTask)));
+	}
+
+	static constexpr size_t kMaxTasks = 0xFFFF;
+
+private:
+	using TaskTrampoline = void(*)(void*, size_t, size_t);
+
+	void dispatch(size_t inNumTasks, TaskTrampoline inTrampoline, void* inContext);
+	// claims and executes tasks of the batch until none remain unclaimed
+	void performTasks(uint64_t inBatchState, size_t inParticipantIndex);
+	void workerLoop(size_t inParticipantIndex);
+
+	// the state of the current batch is packed into a single atomic value so that a task 
+	// can only be claimed from the batch that the claimant thinks it is working on: 
+	// the batch generation (high 32 bits), the next unclaimed task, and the task count
+	static constexpr uint64_t kBatchGenerationShift = 32;
+	static constexpr uint64_t kNextTaskShift = 16;
+	static constexpr uint64_t kTaskFieldMask = kMaxTasks;
+	std::atomic<uint64_t> mBatchState {0};
+	std::atomic<size_t> mIncompleteTasks {0};
+	std::atomic<bool> mShouldQuit {false};
+	// these are written before publishing a new batch, and are not rewritten until every claimed task has completed
+	TaskTrampoline mTaskTrampoline = nullptr;
+	void* mTaskContext = nullptr;
+
+	std::vector<std::jthread> mThreads;
 };
 
 }  // dfx
@@ -32,6 +32,7 @@ This is where we connect the Audio Unit API to our DfxPlugin system.
 #include <cassert>
 #include <CoreServices/CoreServices.h>
 #include <cstring>
+#include <span>
 #include <type_traits>
 
 #include "dfx-au-utilities.h"
@@ -1474,14 +1475,13 @@ OSStatus DfxPlugin::SaveState(CFPropertyListRef* outData)
 	AUSDK_Require_noerr(TARGET_API_BASE_CLASS::SaveState(outData));
 
 #if TARGET_PLUGIN_USES_MIDI
-	// fetch our special data
-	if (auto const dfxData = mDfxSettings->save(true); !dfxData.empty())
+	// create a CF data storage thingy and fill it with our special data
+	auto const dfxDataSize = mDfxSettings->getSaveSize(true);
+	if (auto const cfData = dfx::MakeUniqueCFType(CFDataCreateMutable(kCFAllocatorDefault, 0)); cfData && (dfxDataSize > 0))
 	{
-		// create a CF data storage thingy filled with our special data
-		auto const cfData = dfx::MakeUniqueCFType(CFDataCreate(kCFAllocatorDefault, 
-															   reinterpret_cast<const UInt8*>(dfxData.data()), 
-															   std::ssize(dfxData)));
-		if (cfData)
+		CFDataSetLength(cfData.get(), dfx::math::ToSigned(dfxDataSize));
+		std::span const dfxData(reinterpret_cast<std::byte*>(CFDataGetMutableBytePtr(cfData.get())), dfxDataSize);
+		if (mDfxSettings->saveInto(dfxData, true) == dfxDataSize)
 		{
 			// put the CF data storage thingy into the dfx-data section of the CF dictionary
 			auto const dict = const_cast<CFMutableDictionaryRef>(reinterpret_cast<CFDictionaryRef>(*outData));
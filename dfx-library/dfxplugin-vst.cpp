@@ -1,7 +1,7 @@
 /*------------------------------------------------------------------------
 Destroy FX Library is a collection of foundation code 
 for creating audio processing plug-ins.  
-Copyright (C) 2002-2024  Sophia Poirier
+Copyright (C) 2002-2026  Sophia Poirier
 
 This file is part of the Destroy FX Library (version 1.0).
 
@@ -321,8 +321,11 @@ VstInt32 DfxPlugin::getChunk(void** data, bool isPreset)
 	// savely release it in next suspend/resume call." -audioeffect.cpp.
 	// But can there be multiple calls to getChunk in the meantime?) We
 	// assume not, and just keep a buffer (mLastChunk) with the last
-	// saved chunk.
-	mLastChunk = mDfxSettings->save(isPreset);
+	// saved chunk.  Serializing into it directly lets repeated saves
+	// reuse its allocation.
+	mLastChunk.resize(mDfxSettings->getSaveSize(isPreset));
+	[[maybe_unused]] auto const savedSize = mDfxSettings->saveInto(mLastChunk, isPreset);
+	assert(savedSize == mLastChunk.size());
 	if (data != nullptr)
 	{
 		*data = mLastChunk.data();
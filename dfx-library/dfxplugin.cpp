@@ -43,6 +43,7 @@ This is our class for E-Z plugin-making and E-Z multiple-API support.
 #include "dfxmisc.h"
 
 #ifdef TARGET_API_AUDIOUNIT
+	#include <AudioToolbox/AudioUnitUtilities.h>  // for kAUParameterListener_AnyParameter
 	#include "dfx-au-utilities.h"
 
 #elifdef TARGET_API_VST
@@ -627,45 +628,91 @@ void DfxPlugin::randomizeparameter(dfx::ParameterID inParameterID)
 // randomize all of the parameters at once
 void DfxPlugin::randomizeparameters()
 {
+	std::vector<dfx::ParameterID> parameterIDs;
+	parameterIDs.reserve(getnumparameters());
 	for (dfx::ParameterID i = 0; i < getnumparameters(); i++)
 	{
 		if (!hasparameterattribute(i, DfxParam::kAttribute_OmitFromRandomizeAll) && !hasparameterattribute(i, DfxParam::kAttribute_Unused))
 		{
-			randomizeparameter(i);
+			parameterIDs.push_back(i);
 		}
 	}
+	randomizeparameters(parameterIDs);
+}
+
+//-----------------------------------------------------------------------------
+void DfxPlugin::randomizeparameters(std::span<dfx::ParameterID const> inParameterIDs)
+{
+	GroupedParameterUpdates const groupedUpdates(*this);
+	std::ranges::for_each(inParameterIDs, std::bind_front(&DfxPlugin::randomizeparameter, this));
+}
+
+//-----------------------------------------------------------------------------
+// parameter randomization may occur on the render thread or any other thread, concurrently, 
+// so rather than serializing access to a single random engine, each context gets its own
+dfx::math::RandomEngine& DfxPlugin::getparameterrandomengine()
+{
+	if (isrenderthread())
+	{
+		return mRenderThreadParameterRandomEngine;
+	}
+	thread_local dfx::math::RandomEngine engine(dfx::math::RandomSeed::Entropic);
+	return engine;
 }
 
 //-----------------------------------------------------------------------------
 // do stuff necessary to inform the host of changes, etc.
 void DfxPlugin::update_parameter(dfx::ParameterID inParameterID)
 {
-	if (!parameterisvalid(inParameterID) || hasparameterattribute(inParameterID, DfxParam::kAttribute_Unused))
+	if (!syncparameter(inParameterID))
 	{
 		return;
 	}
 
+#if defined(TARGET_API_VST) && TARGET_PLUGIN_HAS_GUI
+	// the VST2 editor interface has no real listener mechanism for parameters and therefore 
+	// always needs notification pushed in any circumstance where a parameter value changes
+	postupdate_parameter(inParameterID);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+void DfxPlugin::update_parameters(std::span<dfx::ParameterID const> inParameterIDs, bool inStoreInPreset)
+{
+	for (auto const parameterID : inParameterIDs)
+	{
+		syncparameter(parameterID, inStoreInPreset);
+	}
+	// this also covers the notification that VST2 editors always need (see update_parameter)
+	postupdate_parameters(inParameterIDs);
+}
+
+//-----------------------------------------------------------------------------
+// returns false if there is no such parameter in use
+bool DfxPlugin::syncparameter(dfx::ParameterID inParameterID, bool inStoreInPreset)
+{
+	if (!parameterisvalid(inParameterID) || hasparameterattribute(inParameterID, DfxParam::kAttribute_Unused))
+	{
+		return false;
+	}
+
 #ifdef TARGET_API_AUDIOUNIT
 	// make the global-scope element aware of the parameter's value
 	TARGET_API_BASE_CLASS::SetParameter(inParameterID, kAudioUnitScope_Global, kAudioUnitElement0, getparameter_f(inParameterID), 0);
 
 #elifdef TARGET_API_VST
 	auto const vstPresetIndex = getProgram();
-	if ((vstPresetIndex >= 0) && presetisvalid(dfx::math::ToIndex(vstPresetIndex)))
+	if (inStoreInPreset && (vstPresetIndex >= 0) && presetisvalid(dfx::math::ToIndex(vstPresetIndex)))
 	{
 		setpresetparameter(dfx::math::ToIndex(vstPresetIndex), inParameterID, getparameter(inParameterID));
 	}
-	#if TARGET_PLUGIN_HAS_GUI
-	// the VST2 editor interface has no real listener mechanism for parameters and therefore 
-	// always needs notification pushed in any circumstance where a parameter value changes
-	postupdate_parameter(inParameterID);
-	#endif
 
 #elifdef TARGET_API_RTAS
 	SetControlValue(dfx::ParameterID_ToRTAS(inParameterID), ConvertToDigiValue(getparameter_gen(inParameterID)));  // XXX yeah do this?
 #endif
 
 	parameterChanged(inParameterID);
+	return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -686,6 +733,13 @@ void DfxPlugin::postupdate_parameter(dfx::ParameterID inParameterID)
 		return;
 	}
 
+	// withhold the notification to be included in a grouped notification later
+	if (mGroupedParameterUpdatesThreadID.load(std::memory_order_relaxed) == std::this_thread::get_id())
+	{
+		mGroupedParameterUpdates.push_back(inParameterID);
+		return;
+	}
+
 #ifdef TARGET_API_AUDIOUNIT
 	AUParameterChange_TellListeners(GetComponentInstance(), inParameterID);
 
@@ -702,6 +756,59 @@ void DfxPlugin::postupdate_parameter(dfx::ParameterID inParameterID)
 #endif
 }
 
+//-----------------------------------------------------------------------------
+void DfxPlugin::postupdate_parameters(std::span<dfx::ParameterID const> inParameterIDs)
+{
+	if (isrenderthread() || (mGroupedParameterUpdatesThreadID.load(std::memory_order_relaxed) == std::this_thread::get_id()))
+	{
+		std::ranges::for_each(inParameterIDs, std::bind_front(&DfxPlugin::postupdate_parameter, this));
+		return;
+	}
+
+#ifdef TARGET_API_AUDIOUNIT
+	if (std::ranges::any_of(inParameterIDs, [this](auto parameterID)
+	{
+		return parameterisvalid(parameterID) && !hasparameterattribute(parameterID, DfxParam::kAttribute_Unused);
+	}))
+	{
+		AUParameterChange_TellListeners(GetComponentInstance(), kAUParameterListener_AnyParameter);
+	}
+
+#else
+	// no grouped parameter change notification is available, so this is the best we can do
+	std::ranges::for_each(inParameterIDs, std::bind_front(&DfxPlugin::postupdate_parameter, this));
+#endif
+}
+
+//-----------------------------------------------------------------------------
+DfxPlugin::GroupedParameterUpdates::GroupedParameterUpdates(DfxPlugin& inDfxPlugin)
+:	mDfxPlugin(inDfxPlugin)
+{
+	// render thread notifications are already deferred and coalesced
+	if (!mDfxPlugin.isrenderthread())
+	{
+		// if another thread is presently grouping, then this one will just notify normally
+		auto expectedThreadID = std::thread::id{};
+		mIsOutermost = mDfxPlugin.mGroupedParameterUpdatesThreadID.compare_exchange_strong(expectedThreadID, std::this_thread::get_id(), 
+																						  std::memory_order_acquire);
+	}
+}
+
+//-----------------------------------------------------------------------------
+DfxPlugin::GroupedParameterUpdates::~GroupedParameterUpdates()
+{
+	if (mIsOutermost)
+	{
+		// take the withheld notifications before relinquishing grouping to any other thread
+		auto parameterIDs = std::exchange(mDfxPlugin.mGroupedParameterUpdates, {});
+		mDfxPlugin.mGroupedParameterUpdatesThreadID.store({}, std::memory_order_release);
+		std::ranges::sort(parameterIDs);
+		auto const duplicates = std::ranges::unique(parameterIDs);
+		parameterIDs.erase(duplicates.begin(), duplicates.end());
+		mDfxPlugin.postupdate_parameters(parameterIDs);
+	}
+}
+
 //-----------------------------------------------------------------------------
 DfxParam::Value DfxPlugin::getparameter(dfx::ParameterID inParameterID) const
 {
@@ -1189,6 +1296,152 @@ CFStringRef DfxPlugin::getpresetcfname(size_t inPresetIndex) const
 }
 #endif
 
+//-----------------------------------------------------------------------------
+// precompute the interpolation between two presets and activate it for rendering
+bool DfxPlugin::setpresetmorph(size_t inPresetIndexA, size_t inPresetIndexB, std::optional<dfx::ParameterID> inPositionParameterID)
+{
+	if (!presetisvalid(inPresetIndexA) || !presetisvalid(inPresetIndexB))
+	{
+		return false;
+	}
+	if (inPositionParameterID && !parameterisvalid(*inPositionParameterID))
+	{
+		return false;
+	}
+
+	auto morph = std::make_unique<PresetMorph>();
+	morph->mPresetIndexA = inPresetIndexA;
+	morph->mPresetIndexB = inPresetIndexB;
+	morph->mPositionParameterID = inPositionParameterID;
+	for (dfx::ParameterID i = 0; i < getnumparameters(); i++)
+	{
+		if ((i == inPositionParameterID) || hasparameterattribute(i, DfxParam::kAttribute_Unused))
+		{
+			continue;
+		}
+		auto const valueA = getpresetparameter(inPresetIndexA, i);
+		auto const valueB = getpresetparameter(inPresetIndexB, i);
+		if (getparametervaluetype(i) == DfxParam::Value::Type::Float)
+		{
+			auto const genValueA = contractparametervalue(i, valueA.get_f());
+			auto const genValueB = contractparametervalue(i, valueB.get_f());
+			morph->mParameterIDs.push_back(i);
+			morph->mStartValues.push_back(static_cast<float>(genValueA));
+			morph->mValueDeltas.push_back(static_cast<float>(genValueB - genValueA));
+		}
+		else
+		{
+			morph->mDiscreteParameterIDs.push_back(i);
+			morph->mDiscreteValuesA.push_back(valueA);
+			morph->mDiscreteValuesB.push_back(valueB);
+		}
+	}
+	morph->mValues.assign(morph->mParameterIDs.size(), 0.0f);
+	morph->mUpdatedParameterIDs.reserve(morph->mParameterIDs.size() + morph->mDiscreteParameterIDs.size());
+
+	{
+		std::lock_guard const guard(mPresetMorphLock);
+		std::swap(mPresetMorph, morph);
+	}
+	// the previous morph, if any, is freed here, outside of the lock
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void DfxPlugin::clearpresetmorph()
+{
+	std::unique_ptr<PresetMorph> morph;  // declared first so that it is freed after the lock is released
+	std::lock_guard const guard(mPresetMorphLock);
+	std::swap(mPresetMorph, morph);
+}
+
+//-----------------------------------------------------------------------------
+void DfxPlugin::setpresetmorphposition(double inPosition)
+{
+	inPosition = std::clamp(inPosition, 0.0, 1.0);
+	mPresetMorphPosition.store(inPosition, std::memory_order_relaxed);
+
+	std::optional<dfx::ParameterID> positionParameterID;
+	{
+		std::lock_guard const guard(mPresetMorphLock);
+		if (mPresetMorph)
+		{
+			positionParameterID = mPresetMorph->mPositionParameterID;
+		}
+	}
+	// keep the host-facing parameter in agreement when it drives the morph
+	if (positionParameterID)
+	{
+		setparameter_gen(*positionParameterID, inPosition);
+	}
+}
+
+//-----------------------------------------------------------------------------
+double DfxPlugin::getpresetmorphposition() const
+{
+	return mPresetMorphPosition.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// evaluate the active preset morph, if any, at the current morph position
+// (called on the render thread at the start of each processing block)
+void DfxPlugin::processpresetmorph()
+{
+	// never wait on the render thread; if the morph is being replaced, pick it up next time
+	std::unique_lock const guard(mPresetMorphLock, std::try_to_lock);
+	if (!guard.owns_lock() || !mPresetMorph)
+	{
+		return;
+	}
+	auto& morph = *mPresetMorph;
+
+	double position {};
+	if (morph.mPositionParameterID)
+	{
+		position = getparameter_gen(*morph.mPositionParameterID);
+		mPresetMorphPosition.store(position, std::memory_order_relaxed);
+	}
+	else
+	{
+		position = mPresetMorphPosition.load(std::memory_order_relaxed);
+	}
+	if (position == morph.mLastAppliedPosition)
+	{
+		return;
+	}
+	morph.mLastAppliedPosition = position;
+
+	// a single pass over contiguous arrays for all of the continuous parameters, 
+	// which the compiler is free to vectorize
+	auto const position_f = static_cast<float>(position);
+	std::ranges::transform(morph.mStartValues, morph.mValueDeltas, morph.mValues.begin(), [position_f](float startValue, float valueDelta)
+	{
+		return startValue + (valueDelta * position_f);
+	});
+	morph.mUpdatedParameterIDs.clear();
+	for (size_t i = 0; i < morph.mParameterIDs.size(); i++)
+	{
+		auto const parameterID = morph.mParameterIDs[i];
+		mParameters[parameterID].set_gen(morph.mValues[i]);
+		morph.mUpdatedParameterIDs.push_back(parameterID);
+	}
+
+	auto const& discreteValues = (position < 0.5) ? morph.mDiscreteValuesA : morph.mDiscreteValuesB;
+	for (size_t i = 0; i < morph.mDiscreteParameterIDs.size(); i++)
+	{
+		auto const parameterID = morph.mDiscreteParameterIDs[i];
+		if (getparameter(parameterID) != discreteValues[i])
+		{
+			mParameters[parameterID].set(discreteValues[i]);
+			morph.mUpdatedParameterIDs.push_back(parameterID);
+		}
+	}
+
+	// (the capacity was reserved up front, so none of this allocates)
+	// the current preset may be one of the two being morphed between, so its stored values are left alone
+	update_parameters(morph.mUpdatedParameterIDs, false);
+}
+
 //-----------------------------------------------------------------------------
 bool DfxPlugin::settingsMinimalValidate(void const* inData, size_t inBufferSize) const noexcept
 {
@@ -1283,6 +1536,117 @@ void DfxPlugin::updatenumchannels()
 #pragma mark -
 #pragma mark properties
 
+//-----------------------------------------------------------------------------
+dfx::StatusCode DfxPlugin::dfx_GetPropertyInfo(dfx::PropertyID inPropertyID, dfx::Scope /*inScope*/, unsigned int inItemIndex, 
+											   size_t& outDataSize, dfx::PropertyFlags& outFlags)
+{
+	switch (inPropertyID)
+	{
+		case dfx::kPluginProperty_PresetMorph:
+			outDataSize = sizeof(dfx::PresetMorphRequest);
+			outFlags = dfx::kPropertyFlag_Readable | dfx::kPropertyFlag_Writable;
+			return dfx::kStatus_NoError;
+		case dfx::kPluginProperty_PresetMorphPosition:
+			outDataSize = sizeof(double);
+			outFlags = dfx::kPropertyFlag_Readable | dfx::kPropertyFlag_Writable;
+			return dfx::kStatus_NoError;
+#if DFX_SPINLOCK_STATISTICS
+		case dfx::kPluginProperty_SpinLockStatistics:
+			if (inItemIndex >= mSpinLocks.size())
+			{
+				return dfx::kStatus_InvalidPropertyValue;
+			}
+			outDataSize = sizeof(dfx::SpinLock::Statistics);
+			outFlags = dfx::kPropertyFlag_Readable;
+			return dfx::kStatus_NoError;
+#endif
+		default:
+			return dfx::kStatus_InvalidProperty;
+	}
+}
+
+//-----------------------------------------------------------------------------
+dfx::StatusCode DfxPlugin::dfx_GetProperty(dfx::PropertyID inPropertyID, dfx::Scope /*inScope*/, unsigned int inItemIndex, 
+										   void* outData)
+{
+	switch (inPropertyID)
+	{
+		case dfx::kPluginProperty_PresetMorph:
+		{
+			dfx::PresetMorphRequest request;
+			std::lock_guard const guard(mPresetMorphLock);
+			if (mPresetMorph)
+			{
+				request.active = true;
+				request.positionParameterID = mPresetMorph->mPositionParameterID.value_or(dfx::kParameterID_Invalid);
+				request.presetIndexA = mPresetMorph->mPresetIndexA;
+				request.presetIndexB = mPresetMorph->mPresetIndexB;
+			}
+			dfx::MemCpyObject(request, outData);
+			return dfx::kStatus_NoError;
+		}
+		case dfx::kPluginProperty_PresetMorphPosition:
+			dfx::MemCpyObject(getpresetmorphposition(), outData);
+			return dfx::kStatus_NoError;
+#if DFX_SPINLOCK_STATISTICS
+		case dfx::kPluginProperty_SpinLockStatistics:
+			if (inItemIndex >= mSpinLocks.size())
+			{
+				return dfx::kStatus_InvalidPropertyValue;
+			}
+			dfx::MemCpyObject(mSpinLocks[inItemIndex]->getStatistics(), outData);
+			return dfx::kStatus_NoError;
+#endif
+		default:
+			return dfx::kStatus_InvalidProperty;
+	}
+}
+
+//-----------------------------------------------------------------------------
+dfx::StatusCode DfxPlugin::dfx_SetProperty(dfx::PropertyID inPropertyID, dfx::Scope inScope, unsigned int inItemIndex, 
+										   void const* inData, size_t inDataSize)
+{
+	switch (inPropertyID)
+	{
+		case dfx::kPluginProperty_PresetMorph:
+		{
+			if (inDataSize != sizeof(dfx::PresetMorphRequest))
+			{
+				return dfx::kStatus_InvalidPropertyValue;
+			}
+			auto const request = dfx::Enliven<dfx::PresetMorphRequest>(inData);
+			if (request.active)
+			{
+				std::optional<dfx::ParameterID> positionParameterID;
+				if (request.positionParameterID != dfx::kParameterID_Invalid)
+				{
+					positionParameterID = request.positionParameterID;
+				}
+				if (!setpresetmorph(request.presetIndexA, request.presetIndexB, positionParameterID))
+				{
+					return dfx::kStatus_InvalidPropertyValue;
+				}
+			}
+			else
+			{
+				clearpresetmorph();
+			}
+			dfx_PropertyChanged(inPropertyID, inScope, inItemIndex);
+			return dfx::kStatus_NoError;
+		}
+		case dfx::kPluginProperty_PresetMorphPosition:
+			if (inDataSize != sizeof(double))
+			{
+				return dfx::kStatus_InvalidPropertyValue;
+			}
+			setpresetmorphposition(dfx::Enliven<double>(inData));
+			dfx_PropertyChanged(inPropertyID, inScope, inItemIndex);
+			return dfx::kStatus_NoError;
+		default:
+			return dfx::kStatus_InvalidProperty;
+	}
+}
+
 //-----------------------------------------------------------------------------
 void DfxPlugin::dfx_PropertyChanged(dfx::PropertyID inPropertyID, dfx::Scope inScope, unsigned int inItemIndex)
 {
@@ -1362,6 +1726,13 @@ void DfxPlugin::setSmoothedAudioValueTime(double inSmoothingTimeInSeconds)
 	});
 }
 
+//-----------------------------------------------------------------------------
+void DfxPlugin::registerSpinLock(dfx::SpinLock const& inLock)
+{
+	assert(std::ranges::find(mSpinLocks, &inLock) == mSpinLocks.cend());
+	mSpinLocks.push_back(&inLock);
+}
+
 //-----------------------------------------------------------------------------
 void DfxPlugin::do_idle()
 {
@@ -1968,6 +2339,10 @@ void DfxPlugin::preprocessaudio(size_t inNumFrames)
 	mMidiState.preprocessEvents(inNumFrames);
 #endif
 
+	// apply any preset morph before parameter values are cached for DSP cores and before 
+	// change flags are gathered, so that the morph registers as parameter changes in this block
+	processpresetmorph();
+
 #if TARGET_PLUGIN_USES_DSPCORE
 	cacheDSPCoreParameterValues();
 #endif
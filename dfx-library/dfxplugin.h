@@ -131,6 +131,7 @@ VST_NUM_CHANNELS
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -220,6 +221,22 @@ public:
 		std::optional<double> timeSignatureDenominator() const noexcept;
 	};
 
+	// While an instance of this exists, parameter change notifications posted from the thread 
+	// that created it are withheld and then broadcast as a single grouped notification 
+	// when it goes out of scope.  Nesting is allowed, only the outermost one broadcasts.
+	class GroupedParameterUpdates
+	{
+	public:
+		explicit GroupedParameterUpdates(DfxPlugin& inDfxPlugin);
+		~GroupedParameterUpdates();
+		GroupedParameterUpdates(GroupedParameterUpdates const&) = delete;
+		GroupedParameterUpdates& operator=(GroupedParameterUpdates const&) = delete;
+
+	private:
+		DfxPlugin& mDfxPlugin;
+		bool mIsOutermost = false;
+	};
+
 	// ***
 	DfxPlugin(TARGET_API_BASE_INSTANCE_TYPE inInstance, size_t inNumParameters, size_t inNumPresets = 1);
 
@@ -333,12 +350,15 @@ public:
 	virtual void parameterChanged(dfx::ParameterID inParameterID) {}
 	// ***
 	virtual void randomizeparameter(dfx::ParameterID inParameterID);
-	// Randomize all parameters at once. Default implementation just loops over the
-	// eligible parameters and calls randomizeparameter(), but this could also be
+	// Randomize all parameters at once. Default implementation just randomizes the
+	// eligible parameters as a batch via randomizeparameter(), but this could also be
 	// smarter (e.g. keeping the total output volume the same).
 	virtual void randomizeparameters();
+	// randomize the specified parameters via randomizeparameter() with a single grouped change notification
+	void randomizeparameters(std::span<dfx::ParameterID const> inParameterIDs);
 	// broadcast changes to listeners (like GUI)
 	void postupdate_parameter(dfx::ParameterID inParameterID);
+	void postupdate_parameters(std::span<dfx::ParameterID const> inParameterIDs);
 
 	double getparameter_f(dfx::ParameterID inParameterID) const
 	{
@@ -475,25 +495,30 @@ public:
 	int64_t getpresetparameter_i(size_t inPresetIndex, dfx::ParameterID inParameterID) const;
 	bool getpresetparameter_b(size_t inPresetIndex, dfx::ParameterID inParameterID) const;
 
+	// Morph all parameters continuously between two presets, applied at the start of each render.
+	// Continuous parameters are interpolated in the generic (curve-contracted) domain, 
+	// while integer and boolean parameters switch from one preset to the other at the midpoint.
+	// Optionally, one of the plugin's own parameters can be designated to drive the 
+	// morph position (as its generic value), which makes the morph automatable by the host.
+	// The preset values are captured when this is called, and parameters are only 
+	// (re)applied while the morph position changes, so they remain individually adjustable.
+	// These are also available to GUIs and hosts as kPluginProperty_PresetMorph(Position).
+	bool setpresetmorph(size_t inPresetIndexA, size_t inPresetIndexB, std::optional<dfx::ParameterID> inPositionParameterID = {});
+	void clearpresetmorph();
+	// 0 is entirely preset A, 1 is entirely preset B
+	void setpresetmorphposition(double inPosition);
+	double getpresetmorphposition() const;
+
 	bool settingsMinimalValidate(void const* inData, size_t inBufferSize) const noexcept;
 
   	// Overrides to define custom properties. Note that calling these directly will not update listeners;
   	// only the DfxGuiEditor versions do that.
 	virtual dfx::StatusCode dfx_GetPropertyInfo(dfx::PropertyID inPropertyID, dfx::Scope inScope, unsigned int inItemIndex, 
-												size_t& outDataSize, dfx::PropertyFlags& outFlags)
-	{
-		return dfx::kStatus_InvalidProperty;
-	}
+												size_t& outDataSize, dfx::PropertyFlags& outFlags);
 	virtual dfx::StatusCode dfx_GetProperty(dfx::PropertyID inPropertyID, dfx::Scope inScope, unsigned int inItemIndex, 
-											void* outData)
-	{
-		return dfx::kStatus_InvalidProperty;
-	}
+											void* outData);
 	virtual dfx::StatusCode dfx_SetProperty(dfx::PropertyID inPropertyID, dfx::Scope inScope, unsigned int inItemIndex, 
-											void const* inData, size_t inDataSize)
-	{
-		return dfx::kStatus_InvalidProperty;
-	}
+											void const* inData, size_t inDataSize);
 	void dfx_PropertyChanged(dfx::PropertyID inPropertyID, dfx::Scope inScope = dfx::kScope_Global, unsigned int inItemIndex = 0);
 	size_t dfx_GetNumPluginProperties() const
 	{
@@ -571,6 +596,11 @@ public:
 	std::optional<double> getSmoothedAudioValueTime() const;
 	void setSmoothedAudioValueTime(double inSmoothingTimeInSeconds);
 
+	// Register a spinlock so that its contention statistics (if enabled) are readable 
+	// through kPluginProperty_SpinLockStatistics, with the registration order as item index.
+	// The lock must outlive the plugin instance.
+	void registerSpinLock(dfx::SpinLock const& inLock);
+
 	void do_idle();
 	virtual void idle() {}
 
@@ -764,21 +794,53 @@ private:
 	double getparameter_scalar(dfx::ParameterID inParameterID, double inValue) const;
 	// synchronize the underlying API/preset/etc. parameter value representation to the current value in DfxPlugin
 	void update_parameter(dfx::ParameterID inParameterID);
+	// the same for a batch of parameters, followed by a single grouped notification of listeners
+	// (inStoreInPreset false leaves the current preset's stored values as they are)
+	void update_parameters(std::span<dfx::ParameterID const> inParameterIDs, bool inStoreInPreset = true);
+	// the host synchronization part of update_parameter, without any listener notification
+	bool syncparameter(dfx::ParameterID inParameterID, bool inStoreInPreset = true);
 
 	void setpresetparameter(size_t inPresetIndex, dfx::ParameterID inParameterID, DfxParam::Value inValue);
 	DfxParam::Value getpresetparameter(size_t inPresetIndex, dfx::ParameterID inParameterID) const;
 
+	dfx::math::RandomEngine& getparameterrandomengine();
+
+	// everything needed to evaluate a preset morph is precomputed off of the render thread
+	struct PresetMorph
+	{
+		// continuous parameters, as generic values:  start + (delta * position)
+		std::vector<dfx::ParameterID> mParameterIDs;
+		std::vector<float> mStartValues, mValueDeltas, mValues;
+		// discrete parameters, as their literal values in each preset
+		std::vector<dfx::ParameterID> mDiscreteParameterIDs;
+		std::vector<DfxParam::Value> mDiscreteValuesA, mDiscreteValuesB;
+		// preallocated for the batch of parameters changed by each evaluation
+		std::vector<dfx::ParameterID> mUpdatedParameterIDs;
+		size_t mPresetIndexA = 0, mPresetIndexB = 0;
+		std::optional<dfx::ParameterID> mPositionParameterID;
+		double mLastAppliedPosition = std::numeric_limits<double>::quiet_NaN();
+	};
+	void processpresetmorph();
+
 	bool ischannelcountsupported(size_t inNumInputs, size_t inNumOutputs) const;
 
 	std::vector<DfxParam> mParameters;
 	std::vector<bool> mParametersChangedAsOfPreProcess, mParametersTouchedAsOfPreProcess;
 	std::vector<std::atomic_flag> mParametersChangedInProcessHavePosted;
-	// the effect owns a single random engine shared by all parameters rather than each parameter owning its own for efficiency, because its state data can be quite large
-	dfx::math::RandomEngine mParameterRandomEngine {dfx::math::RandomSeed::Entropic};
-	dfx::SpinLock mParameterRandomEngineLock;
+	// Parameter randomization is lock-free by giving each calling context its own random engine:  
+	// the render thread uses this one, seeded up front because seeding is not realtime-safe, 
+	// while every other thread uses its own thread-local engine (see getparameterrandomengine).
+	dfx::math::RandomEngine mRenderThreadParameterRandomEngine {dfx::math::RandomSeed::Entropic};
+	std::vector<dfx::SpinLock const*> mSpinLocks;
+	// the thread currently withholding notifications for GroupedParameterUpdates, and what it has withheld
+	std::atomic<std::thread::id> mGroupedParameterUpdatesThreadID {};
+	std::vector<dfx::ParameterID> mGroupedParameterUpdates;
 	std::vector<std::pair<std::string, std::set<dfx::ParameterID>>> mParameterGroups;
 	std::vector<DfxPreset> mPresets;
 	std::atomic_flag mPresetChangedInProcessHasPosted;
+	dfx::SpinLock mPresetMorphLock;
+	std::unique_ptr<PresetMorph> mPresetMorph;  // guarded by mPresetMorphLock
+	dfx::LockFreeAtomic<double> mPresetMorphPosition {0.};
 
 	std::vector<ChannelConfig> mChannelConfigs;
 
@@ -1410,22 +1472,16 @@ public:
 
 // template implementations follow
 
-// while it is possible for a parameter randomization to be executed from a realtime audio thread, 
-// and therefore locking would be detrimental, the likelihood of contention on this lock is extremely low, 
-// and the critical section extremely brief, and the lock lightweight and out of the scheduler's management, 
-// that this shouldn't actually in practice present any issues
 template <dfx::math::Randomizable T>
 T DfxPlugin::generateParameterRandomValue()
 {
-	std::lock_guard const guard(mParameterRandomEngineLock);
-	return mParameterRandomEngine.next<T>();
+	return getparameterrandomengine().next<T>();
 }
 
 template <dfx::math::Randomizable T>
 T DfxPlugin::generateParameterRandomValue(T const& inRangeMinimum, T const& inRangeMaximum)
 {
-	std::lock_guard const guard(mParameterRandomEngineLock);
-	return mParameterRandomEngine.next<T>(inRangeMinimum, inRangeMaximum);
+	return getparameterrandomengine().next<T>(inRangeMinimum, inRangeMaximum);
 }
 
 #if TARGET_PLUGIN_USES_DSPCORE
@@ -27,6 +27,7 @@ These are our extended Audio Unit property IDs and types.
 #pragma once
 
 #include "dfxmisc.h"
+#include "dfxmutex.h"
 #include "dfxparameter.h"
 
 #ifdef TARGET_API_AUDIOUNIT
@@ -63,9 +64,14 @@ enum : uint32_t
 	kPluginProperty_ParameterMidiAssignment,	// get/set the MIDI assignment for a parameter
 	kPluginProperty_MidiAssignmentsUseChannel,	// get/set whether MIDI parameter assignments use MIDI channel
 	kPluginProperty_MidiAssignmentsSteal,		// get/set whether existing MIDI parameter assignments are unassigned when reused
+	kPluginProperty_PresetMorph,				// get/set the pair of presets being morphed between
+	kPluginProperty_PresetMorphPosition,		// get/set the preset morph position
 #if DEBUG
 	kPluginProperty_DfxPluginInstance,			// get pointer to DfxPlugin instance
 #endif
+#if DFX_SPINLOCK_STATISTICS
+	kPluginProperty_SpinLockStatistics,			// get the contention counters of a registered spinlock (item is registration index)
+#endif
 
 	kPluginProperty_EndOfList,
 	kPluginProperty_NumProperties = kPluginProperty_EndOfList - kPluginProperty_StartID
@@ -146,6 +152,25 @@ struct ParameterValueStringRequest
 static_assert(IsTriviallySerializable<ParameterValueStringRequest>);
 
 
+//-----------------------------------------------------------------------------
+// for kPluginProperty_PresetMorph
+struct PresetMorphRequest
+{
+	uint32_t active = false;  // setting this false clears the morph
+	ParameterID positionParameterID = kParameterID_Invalid;  // the parameter driving the morph position, if any
+	uint64_t presetIndexA = 0;
+	uint64_t presetIndexB = 0;
+};
+static_assert(IsTriviallySerializable<PresetMorphRequest>);
+
+
+#if DFX_SPINLOCK_STATISTICS
+//-----------------------------------------------------------------------------
+// for kPluginProperty_SpinLockStatistics
+static_assert(IsTriviallySerializable<SpinLock::Statistics>);
+#endif
+
+
 #if TARGET_PLUGIN_USES_MIDI
 
 //------------------------------------------------------
@@ -1,7 +1,7 @@
 /*------------------------------------------------------------------------
 Destroy FX Library is a collection of foundation code 
 for creating audio processing plug-ins.  
-Copyright (C) 2002-2023  Sophia Poirier
+Copyright (C) 2002-2026  Sophia Poirier
 
 This file is part of the Destroy FX Library (version 1.0).
 
@@ -28,6 +28,7 @@ Welcome to our settings persistence mess.
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cassert>
 #include <concepts>
 #include <cstddef>
@@ -37,6 +38,7 @@ Welcome to our settings persistence mess.
 #include <cstring>
 #include <numeric>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <string_view>
 #include <type_traits>
@@ -62,6 +64,7 @@ DfxSettings::DfxSettings(uint32_t inMagic, DfxPlugin& inPlugin, size_t inSizeofE
 	mNumPresets(std::max(inPlugin.getnumpresets(), 1uz)),	// we need at least one set of parameters
 	mSizeOfExtendedData(inSizeofExtendedData),
 	mParameterIDMap(mNumParameters, dfx::kParameterID_Invalid),
+	mRestoreParameterValues(mNumParameters),
 	mParameterAssignments(mNumParameters)
 {
 	// default to each parameter having its ID equal its index
@@ -91,6 +94,7 @@ DfxSettings::DfxSettings(uint32_t inMagic, DfxPlugin& inPlugin, size_t inSizeofE
 	mSettingsInfo.mNumStoredPresets = static_cast<uint32_t>(mNumPresets);
 	mSettingsInfo.mStoredParameterAssignmentSize = sizeof(dfx::ParameterAssignment);
 	mSettingsInfo.mStoredExtendedDataSize = static_cast<uint32_t>(inSizeofExtendedData);
+	mSettingsInfo.mFormatVersion = kFormatVersion_LittleEndian;
 
 	clearAssignments();  // initialize all of the parameters to have no MIDI event assignments
 
@@ -224,7 +228,24 @@ private:
 // like when saving a session document or preset files
 std::vector<std::byte> DfxSettings::save(bool inIsPreset) const
 {
-	std::vector<std::byte> data(inIsPreset ? mSizeOfPresetChunk : mSizeOfChunk, std::byte{0});
+	std::vector<std::byte> data(getSaveSize(inIsPreset));
+	[[maybe_unused]] auto const savedSize = saveInto(data, inIsPreset);
+	assert(savedSize == data.size());
+	return data;
+}
+
+//-----------------------------------------------------------------------------
+// the same as save(), but serializes directly into memory owned by the caller 
+// (which, when saving repeatedly, can keep reusing the same allocation)
+size_t DfxSettings::saveInto(std::span<std::byte> outData, bool inIsPreset) const
+{
+	auto const saveSize = getSaveSize(inIsPreset);
+	if (outData.size() < saveSize)
+	{
+		return 0;
+	}
+	auto const data = outData.first(saveSize);
+	std::ranges::fill(data, std::byte{0});
 	SerializedObject<SettingsInfo> const sharedHeader(data.data());
 
 	// and a few references to elements within that data, just for ease of use
@@ -277,8 +298,11 @@ std::vector<std::byte> DfxSettings::save(bool inIsPreset) const
 	std::copy(mParameterAssignments.cbegin(), mParameterAssignments.cend(), sharedParameterAssignments.begin());
 
 	// reverse the order of bytes in the data being sent to the host, if necessary
-	[[maybe_unused]] auto const endianSuccess = correctEndian(data.data(), data.size() - mSizeOfExtendedData, false, inIsPreset);
-	assert(endianSuccess);
+	if constexpr (!serializationIsNativeEndian())
+	{
+		[[maybe_unused]] auto const endianSuccess = correctEndian(data.data(), data.size() - mSizeOfExtendedData, false, inIsPreset);
+		assert(endianSuccess);
+	}
 
 	// allow for the storage of extra data
 	if (mSizeOfExtendedData > 0)
@@ -286,7 +310,7 @@ std::vector<std::byte> DfxSettings::save(bool inIsPreset) const
 		mPlugin.settings_saveExtendedData(data.data() + data.size() - mSizeOfExtendedData, inIsPreset);
 	}
 
-	return data;
+	return data.size();
 }
 
 
@@ -319,7 +343,14 @@ try
 	};
 
 	constexpr auto kMinimumHeaderSize = offsetof(SettingsInfo, mGlobalBehaviorFlags);
-	require(inDataSize >= kMinimumHeaderSize);
+	require(inData && (inDataSize >= kMinimumHeaderSize));
+	auto const isReversed = isByteOrderReversed(inData, inDataSize);
+
+	// the common case (e.g. reopening a session saved by this same build) needs no remapping
+	if (!isReversed && restoreMatchingLayout({static_cast<std::byte const*>(inData), inDataSize}, inIsPreset))
+	{
+		return true;
+	}
 
 	// create our own copy of the data before we muck with it (e.g. reversing endianness, etc.)
 	auto const incomingData_copy = dfx::MakeUniqueMemoryBlock<void>(inDataSize);
@@ -327,7 +358,10 @@ try
 	std::memcpy(incomingData_copy.get(), inData, inDataSize);
 
 	// un-reverse the order of bytes in the received data, if necessary
-	require(correctEndian(incomingData_copy.get(), inDataSize, true, inIsPreset));
+	if (isReversed)
+	{
+		require(correctEndian(incomingData_copy.get(), inDataSize, true, inIsPreset));
+	}
 
 	auto const validateRange = [&incomingData_copy, inDataSize, this](void const* address, size_t length, char const* name)
 	{
@@ -351,6 +385,11 @@ try
 	{
 		storedGlobalBehaviorFlags = GET_SERIALIZED_HEADER_FIELD(incomingData_copy.get(), mGlobalBehaviorFlags);
 	}
+	uint32_t storedFormatVersion = kFormatVersion_BigEndian;
+	if (storedHeaderSize >= (offsetof(SettingsInfo, mFormatVersion) + sizeof(SettingsInfo::mFormatVersion)))
+	{
+		storedFormatVersion = GET_SERIALIZED_HEADER_FIELD(incomingData_copy.get(), mFormatVersion);
+	}
 
 	// The following situations are basically considered to be 
 	// irrecoverable "crisis" situations.  Regardless of what 
@@ -362,6 +401,11 @@ try
 	require(storedMagic == mSettingsInfo.mMagic);
 	require((storedVersion >= mSettingsInfo.mLowestLoadableVersion) &&
 			(mSettingsInfo.mVersion >= storedLowestLoadableVersion));  // TODO: does this second test make sense?
+	// A later layout of the data cannot be understood, and the byte order that the 
+	// data turned out to be in has to be the one that its layout calls for.
+	require(storedFormatVersion <= mSettingsInfo.mFormatVersion);
+	auto const storedEndian = (storedFormatVersion >= kFormatVersion_LittleEndian) ? std::endian::little : std::endian::big;
+	require(isReversed == (storedEndian != std::endian::native));
 
 #ifdef DFX_SUPPORT_OLD_VST_SETTINGS
 	// we started using hex format versions (like below) with the advent 
@@ -583,6 +627,97 @@ catch (...)
 	return false;
 }
 
+//-----------------------------------------------------------------------------
+// Session documents are overwhelmingly restored by the same plugin build that 
+// saved them, in which case the data is exactly what save() produces, in this 
+// machine's byte order.  We can then read straight from the host's buffer, skip 
+// building a parameter map, and take the parameter values and assignments as 
+// whole arrays rather than copying the entire chunk first.
+bool DfxSettings::restoreMatchingLayout(std::span<std::byte const> inData, bool inIsPreset)
+{
+	if (inData.size() != getSaveSize(inIsPreset))
+	{
+		return false;
+	}
+
+	SettingsInfo storedHeader;
+	std::memcpy(&storedHeader, inData.data(), sizeof(storedHeader));
+	auto const expectedPresetCount = inIsPreset ? 1u : mSettingsInfo.mNumStoredPresets;
+	if ((storedHeader.mMagic != mSettingsInfo.mMagic) || (storedHeader.mVersion != mSettingsInfo.mVersion) 
+		|| (storedHeader.mVersion < mSettingsInfo.mLowestLoadableVersion) || (storedHeader.mLowestLoadableVersion > mSettingsInfo.mVersion) 
+		|| (storedHeader.mStoredHeaderSize != mSettingsInfo.mStoredHeaderSize) 
+		|| (storedHeader.mNumStoredParameters != mSettingsInfo.mNumStoredParameters) 
+		|| (storedHeader.mNumStoredPresets != expectedPresetCount) 
+		|| (storedHeader.mStoredParameterAssignmentSize != mSettingsInfo.mStoredParameterAssignmentSize) 
+		|| (storedHeader.mStoredExtendedDataSize != mSettingsInfo.mStoredExtendedDataSize) 
+		|| (storedHeader.mFormatVersion != mSettingsInfo.mFormatVersion))
+	{
+		return false;
+	}
+
+	SerializedObject<uint32_t const> const storedParameterIDs(inData.data() + sizeof(SettingsInfo));
+	if (!std::equal(mParameterIDMap.cbegin(), mParameterIDMap.cend(), storedParameterIDs.begin()))
+	{
+		return false;
+	}
+
+	// from here on, the data is known to be in our own layout
+	setUseChannel(storedHeader.mGlobalBehaviorFlags & kGlobalBehaviorFlag_UseChannel);
+	setSteal(storedHeader.mGlobalBehaviorFlags & kGlobalBehaviorFlag_StealAssignments);
+
+	constexpr auto getPresetNameWithFallback = [](std::string_view presetName) -> std::string_view
+	{
+		return presetName.empty() ? "(unnamed)" : presetName;
+	};
+
+	auto presetAddress = storedParameterIDs.getByteAddress() + mSizeOfParameterIDs;
+	for (size_t presetIndex = 0; presetIndex < storedHeader.mNumStoredPresets; presetIndex++)
+	{
+		// preset names are plain char arrays, but do not trust them to be null-terminated
+		auto const presetNameAddress = reinterpret_cast<GenPresetNameElementT const*>(presetAddress + offsetof(GenPreset, mName));
+		std::string_view const presetName(presetNameAddress, strnlen(presetNameAddress, std::extent_v<GenPresetNameT>));
+
+		std::memcpy(mRestoreParameterValues.data(), presetAddress + offsetof(GenPreset, mParameterValues), 
+					mRestoreParameterValues.size() * sizeof(GenPresetParameterValueT));
+
+		if (inIsPreset)
+		{
+			// see the comment in restore() about why Audio Unit skips this
+			#ifndef TARGET_API_AUDIOUNIT
+			mPlugin.setpresetname(mPlugin.getcurrentpresetnum(), getPresetNameWithFallback(presetName));
+			#endif
+			// one grouped notification for the host and listeners, rather than one per parameter
+			DfxPlugin::GroupedParameterUpdates const groupedUpdates(mPlugin);
+			for (dfx::ParameterID i = 0; i < mRestoreParameterValues.size(); i++)
+			{
+				mPlugin.setparameter_f(i, mRestoreParameterValues[i]);
+				mPlugin.settings_doChunkRestoreSetParameterStuff(i, mRestoreParameterValues[i], storedHeader.mVersion, {});
+			}
+		}
+		else
+		{
+			mPlugin.setpresetname(presetIndex, getPresetNameWithFallback(presetName));
+			for (dfx::ParameterID i = 0; i < mRestoreParameterValues.size(); i++)
+			{
+				mPlugin.setpresetparameter_f(presetIndex, i, mRestoreParameterValues[i]);
+				mPlugin.settings_doChunkRestoreSetParameterStuff(i, mRestoreParameterValues[i], storedHeader.mVersion, presetIndex);
+			}
+		}
+		presetAddress += mSizeOfPreset;
+	}
+
+	// the assignment structure size matches ours, so the whole array can be copied at once
+	std::memcpy(mParameterAssignments.data(), presetAddress, mParameterAssignments.size() * sizeof(dfx::ParameterAssignment));
+
+	if (mSizeOfExtendedData > 0)
+	{
+		auto const extendedDataAddress = presetAddress + (mParameterAssignments.size() * sizeof(dfx::ParameterAssignment));
+		mPlugin.settings_restoreExtendedData(extendedDataAddress, mSizeOfExtendedData, storedHeader.mVersion, inIsPreset);
+	}
+
+	return true;
+}
+
 //-----------------------------------------------------------------------------
 bool DfxSettings::minimalValidate(void const* inData, size_t inDataSize) const noexcept
 {
@@ -593,7 +728,7 @@ bool DfxSettings::minimalValidate(void const* inData, size_t inDataSize) const n
 	}
 	std::memcpy(&settingsInfo, inData, sizeof(settingsInfo));
 
-	if constexpr (!serializationIsNativeEndian())
+	if (isByteOrderReversed(inData, inDataSize))
 	{
 		dfx::ReverseBytes(settingsInfo.mMagic);
 		dfx::ReverseBytes(settingsInfo.mVersion);
@@ -604,9 +739,29 @@ bool DfxSettings::minimalValidate(void const* inData, size_t inDataSize) const n
 }
 
 //-----------------------------------------------------------------------------
-// this function, if called for the non-reference endian architecture, 
-// will reverse the order of bytes in each variable/value of the data 
-// to correct endian differences and make a uniform data chunk
+// The magic signature is the first thing in the data no matter the version, 
+// so whichever byte order it reads correctly in is that of the whole header.
+bool DfxSettings::isByteOrderReversed(void const* inData, size_t inDataSize) const noexcept
+{
+	auto const getHeaderField = [inData](size_t inOffset)
+	{
+		return dfx::Enliven<uint32_t>(static_cast<std::byte const*>(inData) + inOffset);
+	};
+	auto const storedMagic = getHeaderField(offsetof(SettingsInfo, mMagic));
+	auto reversedStoredMagic = storedMagic;
+	dfx::ReverseBytes(reversedStoredMagic);
+	if (storedMagic != reversedStoredMagic)
+	{
+		return (storedMagic != mSettingsInfo.mMagic);
+	}
+	// a palindromic magic signature cannot tell us, but the header size (which is always small) can
+	return (getHeaderField(offsetof(SettingsInfo, mStoredHeaderSize)) > inDataSize);
+}
+
+//-----------------------------------------------------------------------------
+// this function, which is only needed when the data's byte order differs from 
+// this machine's, will reverse the order of bytes in each variable/value of 
+// the data to correct endian differences and make a uniform data chunk
 bool DfxSettings::correctEndian(void* const ioData, size_t const inDataSize, bool inIsReversed, bool inIsPreset) const
 try
 {
@@ -622,11 +777,6 @@ void blah(long long x)
 	}
 }
 */
-	if constexpr (serializationIsNativeEndian())
-	{
-		return true;
-	}
-
 	// start by looking at the header info
 	auto const dataHeaderAddress = ioData;
 	// we need to know how big the header is before dealing with it
@@ -1,7 +1,7 @@
 /*------------------------------------------------------------------------
 Destroy FX Library is a collection of foundation code 
 for creating audio processing plug-ins.  
-Copyright (C) 2002-2024  Sophia Poirier
+Copyright (C) 2002-2026  Sophia Poirier
 
 This file is part of the Destroy FX Library (version 1.0).
 
@@ -137,6 +137,14 @@ public:
 
 	// for adding to your base plugin class methods
 	[[nodiscard]] std::vector<std::byte> save(bool inIsPreset) const;
+	// the byte size of the data that save() or saveInto() produces
+	[[nodiscard]] size_t getSaveSize(bool inIsPreset) const noexcept
+	{
+		return inIsPreset ? mSizeOfPresetChunk : mSizeOfChunk;
+	}
+	// serializes into caller-owned memory rather than allocating, 
+	// returning the number of bytes written (0 if the buffer is too small)
+	size_t saveInto(std::span<std::byte> outData, bool inIsPreset) const;
 	[[nodiscard]] bool restore(void const* inData, size_t inDataSize, bool inIsPreset);
 	[[nodiscard]] bool minimalValidate(void const* inData, size_t inDataSize) const noexcept;
 
@@ -307,9 +315,20 @@ public:
 		return mCrisisBehavior;
 	}
 
+	// the layouts of settings data, as identified by SettingsInfo::mFormatVersion
+	enum : uint32_t
+	{
+		kFormatVersion_BigEndian = 0,
+		kFormatVersion_LittleEndian = 1
+	};
+
+	// Settings data is serialized little-endian (kFormatVersion_LittleEndian).  Data saved 
+	// before that was big-endian, and restore() tells the two apart by the byte order of the 
+	// stored magic signature, which must agree with the stored format version.  
+	// (Extended data is left for the plugin to serialize however it always has.)
 	static consteval bool serializationIsNativeEndian() noexcept
 	{
-		return std::endian::native == std::endian::big;
+		return std::endian::native == std::endian::little;
 	}
 
 
@@ -364,6 +383,9 @@ private:
 		uint32_t mStoredExtendedDataSize = 0;
 		// behaviors that are global to plugin operation
 		uint32_t mGlobalBehaviorFlags = 0;
+		// the layout of the settings data itself, independent of the plugin's version 
+		// (data from before this was stored has the layout of kFormatVersion_BigEndian)
+		uint32_t mFormatVersion = 0;
 	};
 	static_assert(dfx::IsTriviallySerializable<SettingsInfo>);
 
@@ -383,6 +405,13 @@ private:
 	using GenPresetParameterValueT = std::remove_extent_t<decltype(GenPreset::mParameterValues)>;
 	static_assert(!std::is_same_v<decltype(GenPreset::mParameterValues), GenPresetParameterValueT>);
 
+	// restores directly from the received data, without copying or remapping it, 
+	// if its layout exactly matches what we would save (returns false otherwise)
+	[[nodiscard]] bool restoreMatchingLayout(std::span<std::byte const> inData, bool inIsPreset);
+
+	// whether the data's byte order is the opposite of this machine's (e.g. big-endian data from before 
+	// the little-endian layout, when running on a little-endian machine)
+	[[nodiscard]] bool isByteOrderReversed(void const* inData, size_t inDataSize) const noexcept;
 	// reverse the byte order of data
 	[[nodiscard]] bool correctEndian(void* ioData, size_t inDataSize, bool inIsReversed, bool inIsPreset) const;
 
@@ -433,6 +462,8 @@ private:
 	// (this is so that non-parameter-compatible plugin versions can load 
 	// settings and know which stored parameters correspond to theirs)
 	std::vector<uint32_t> mParameterIDMap;
+	// scratch space for decoding a preset's parameter values in restoreMatchingLayout()
+	std::vector<GenPresetParameterValueT> mRestoreParameterValues;
 
 	// what to do if restore() sends data with a mismatched byte size
 	CrisisBehavior mCrisisBehavior = CrisisBehavior::LoadWhatYouCan;
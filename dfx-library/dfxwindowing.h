@@ -0,0 +1,221 @@
+/*------------------------------------------------------------------------
+Destroy FX Library is a collection of foundation code
+for creating audio processing plug-ins.
+Copyright (C) 2026  Sophia Poirier and Tom Murphy 7
+
+This file is part of the Destroy FX Library (version 1.0).
+
+Destroy FX Library is free software:  you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+Destroy FX Library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Destroy FX Library.  If not, see <http://www.gnu.org/licenses/>.
+
+To contact the author, use the contact form at http://destroyfx.org
+
+Destroy FX is a sovereign entity comprised of Sophia Poirier and Tom Murphy 7.
+This is the Super Destroy FX Windowing System, an overlap-add engine.
+------------------------------------------------------------------------*/
+
+#pragma once
+
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <numbers>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+
+
+namespace dfx
+{
+
+
+//-----------------------------------------------------------------------------
+// Feeds overlapping frames of the input audio to a frame processor and
+// crossfades the processed frames back into a continuous output signal.
+// Frames overlap by half, so every input sample gets processed twice,
+// and the output is delayed by one frame size.
+// The frame processor is called as inProcessFrame(input, output, frameSize)
+// with contiguous frames and may write anything into all of the output frame;
+// the window is applied afterward.
+// Both the input history and the overlap-add accumulator are circular,
+// and frames only ever begin on hop boundaries, so audio is moved in blocks
+// and nothing gets shifted around in memory between frames.
+template <std::floating_point T>
+class OverlapAdd
+{
+public:
+	// these rise through the first half of the frame and fall as the complement
+	// through the second half, so that the overlapped halves sum to unity
+	enum class WindowShape
+	{
+		Triangle,
+		Arrow,  // quadratic
+		Wedge,  // square root
+		Cosine
+	};
+
+	explicit OverlapAdd(size_t inMaxFrameSize)
+	:	mInput(inMaxFrameSize + (inMaxFrameSize / 2), T(0)),
+		mOutput(inMaxFrameSize, T(0)),
+		mFrameOutput(inMaxFrameSize, T(0)),
+		mWindow(inMaxFrameSize, T(0))
+	{
+		setFrameSize(inMaxFrameSize);
+	}
+
+	// also clears the audio history, and the window must be set anew afterward
+	void setFrameSize(size_t inFrameSize)
+	{
+		assert(inFrameSize >= 2);
+		assert((inFrameSize % 2) == 0);
+		assert(inFrameSize <= mOutput.size());
+		mFrameSize = inFrameSize;
+		mHopSize = inFrameSize / 2;
+		reset();
+	}
+	size_t getFrameSize() const noexcept
+	{
+		return mFrameSize;
+	}
+	size_t getHopSize() const noexcept
+	{
+		return mHopSize;
+	}
+	size_t getLatency() const noexcept
+	{
+		return mFrameSize;
+	}
+
+	// the output begins with one frame of silence
+	void reset()
+	{
+		std::fill_n(mInput.begin(), mFrameSize + mHopSize, T(0));
+		std::fill_n(mOutput.begin(), mFrameSize, T(0));
+		mPosition = 0;
+		mSamplesUntilFrame = mFrameSize;
+	}
+
+	void setWindowShape(WindowShape inShape)
+	{
+		switch (inShape)
+		{
+			case WindowShape::Triangle:
+				setWindowShape([](T inPhase){ return inPhase; });
+				break;
+			case WindowShape::Arrow:
+				setWindowShape([](T inPhase){ return inPhase * inPhase; });
+				break;
+			case WindowShape::Wedge:
+				setWindowShape([](T inPhase){ return std::sqrt(inPhase); });
+				break;
+			case WindowShape::Cosine:
+				setWindowShape([](T inPhase){ return T(0.5) * (-std::cos(std::numbers::pi_v<T> * inPhase) + T(1)); });
+				break;
+		}
+	}
+	// inRisingHalf maps the phase [0, 1) through the first half of the frame to a gain
+	template <typename F>
+	requires std::is_invocable_r_v<T, F&, T>
+	void setWindowShape(F&& inRisingHalf)
+	{
+		T const phaseScalar = T(1) / static_cast<T>(mHopSize);
+		for (size_t i = 0; i < mHopSize; i++)
+		{
+			T const gain = std::invoke(inRisingHalf, static_cast<T>(i) * phaseScalar);
+			mWindow[i] = gain;
+			mWindow[i + mHopSize] = T(1) - gain;
+		}
+	}
+
+	// inAudio and outAudio may be the same buffer
+	template <typename F>
+	requires std::invocable<F&, T const*, T*, size_t>
+	void process(std::span<T const> inAudio, std::span<T> outAudio, F&& inProcessFrame)
+	{
+		assert(inAudio.size() == outAudio.size());
+
+		for (size_t offset = 0; offset < outAudio.size(); )
+		{
+			// frames begin on hop boundaries, so a block never straddles the end of the rings
+			auto const blockSize = std::min(outAudio.size() - offset, mSamplesUntilFrame);
+			assert((mPosition + blockSize) <= mFrameSize);
+
+			auto const inputBlock = inAudio.subspan(offset, blockSize);
+			std::ranges::copy(inputBlock, std::next(mInput.begin(), mPosition));
+			// mirror the first hop past the end of the ring so that every frame is contiguous
+			if (mPosition < mHopSize)
+			{
+				std::ranges::copy(inputBlock, std::next(mInput.begin(), mPosition + mFrameSize));
+			}
+
+			auto const outputBlock = std::span(mOutput).subspan(mPosition, blockSize);
+			std::copy_n(outputBlock.begin(), blockSize, std::next(outAudio.begin(), offset));
+			std::ranges::fill(outputBlock, T(0));
+
+			mPosition += blockSize;
+			if (mPosition == mFrameSize)
+			{
+				mPosition = 0;
+			}
+			offset += blockSize;
+			mSamplesUntilFrame -= blockSize;
+
+			if (mSamplesUntilFrame == 0)
+			{
+				processFrame(inProcessFrame);
+				mSamplesUntilFrame = mHopSize;
+			}
+		}
+	}
+
+private:
+	// the oldest input sample and the next output sample share the ring position
+	template <typename F>
+	void processFrame(F& inProcessFrame)
+	{
+		std::invoke(inProcessFrame, static_cast<T const*>(mInput.data() + mPosition), mFrameOutput.data(), mFrameSize);
+
+		// the first half lands on the tail of the previous frame, the second half on silence,
+		// and the window is applied in the same pass as the mix
+		auto const accumulate = [this](size_t inFrameOffset, size_t inPosition)
+		{
+			T const* const frameOutput = mFrameOutput.data() + inFrameOffset;
+			T const* const window = mWindow.data() + inFrameOffset;
+			T* const destination = mOutput.data() + inPosition;
+			for (size_t i = 0; i < mHopSize; i++)
+			{
+				destination[i] += frameOutput[i] * window[i];
+			}
+		};
+		accumulate(0, mPosition);
+		accumulate(mHopSize, (mPosition + mHopSize) % mFrameSize);
+	}
+
+	size_t mFrameSize = 0, mHopSize = 0;
+	// one frame of input history, with its first hop duplicated at the end
+	std::vector<T> mInput;
+	// the pending output, one frame long
+	std::vector<T> mOutput;
+	std::vector<T> mFrameOutput;
+	std::vector<T> mWindow;
+	size_t mPosition = 0;
+	size_t mSamplesUntilFrame = 0;
+};
+
+
+}  // namespace
@@ -1,7 +1,7 @@
 /*------------------------------------------------------------------------
 Destroy FX Library is a collection of foundation code 
 for creating audio processing plug-ins.  
-Copyright (C) 2001-2023  Sophia Poirier
+Copyright (C) 2001-2026  Sophia Poirier
 
 This file is part of the Destroy FX Library (version 1.0).
 
@@ -93,6 +93,8 @@ public:
 
 
 	[[nodiscard]] float process(float inSample);
+	// the same, in place, for each sample of a block in turn
+	void process(std::span<float> ioAudio);
 	void processToCache(float inSample);
 
 #ifdef DFX_IIRFILTER_USE_OPTIMIZATION_FOR_EXCLUSIVELY_LP_HP_NOTCH
@@ -102,6 +104,10 @@ public:
 	void processToCacheH2(std::span<float const> inAudio, size_t inPos);
 	void processToCacheH3(std::span<float const> inAudio, size_t inPos);
 	void processToCacheH4(std::span<float const> inAudio, size_t inPos);
+	// the same, but with the input samples already contiguous, so needing no wraparound
+	void processToCacheH2(std::span<float const, 2> inAudio);
+	void processToCacheH3(std::span<float const, 3> inAudio);
+	void processToCacheH4(std::span<float const, 4> inAudio);
 #endif
 
 	// 4-point Hermite spline interpolation for use with IIR filter output histories
@@ -184,6 +190,19 @@ private:
 	return mCurrentOut;
 }
 
+//-----------------------------------------------------------------------------
+inline void IIRFilter::process(std::span<float> ioAudio)
+{
+	// filtering a local copy lets the history stay in registers,
+	// whereas our own could be aliased by the audio being written
+	auto filter = *this;
+	for (auto& sample : ioAudio)
+	{
+		sample = filter.process(sample);
+	}
+	*this = filter;
+}
+
 //-----------------------------------------------------------------------------
 inline void IIRFilter::processToCache(float inSample)
 {
@@ -216,8 +235,14 @@ inline void IIRFilter::processToCacheH2(std::span<float const> inAudio, size_t i
 	assert(!inAudio.empty());
 	assert(inPos < inAudio.size());
 
-	auto const in0 = inAudio[inPos];
-	auto const in1 = inAudio[(inPos + 1) % inAudio.size()];
+	processToCacheH2(std::array{inAudio[inPos], inAudio[(inPos + 1) % inAudio.size()]});
+}
+
+//-----------------------------------------------------------------------------
+inline void IIRFilter::processToCacheH2(std::span<float const, 2> inAudio)
+{
+	auto const in0 = inAudio[0];
+	auto const in1 = inAudio[1];
 
 	mPrevPrevPrevOut = mPrevPrevOut;
 	mPrevPrevOut = mPrevOut;
@@ -243,9 +268,15 @@ inline void IIRFilter::processToCacheH3(std::span<float const> inAudio, size_t i
 	assert(!inAudio.empty());
 	assert(inPos < inAudio.size());
 
-	auto const in0 = inAudio[inPos];
-	auto const in1 = inAudio[(inPos + 1) % inAudio.size()];
-	auto const in2 = inAudio[(inPos + 2) % inAudio.size()];
+	processToCacheH3(std::array{inAudio[inPos], inAudio[(inPos + 1) % inAudio.size()], inAudio[(inPos + 2) % inAudio.size()]});
+}
+
+//-----------------------------------------------------------------------------
+inline void IIRFilter::processToCacheH3(std::span<float const, 3> inAudio)
+{
+	auto const in0 = inAudio[0];
+	auto const in1 = inAudio[1];
+	auto const in2 = inAudio[2];
 
 	// this uses an optimization that only works for LP, HP, and notch filters
 	mPrevPrevPrevOut = ((in0 + mPrevPrevIn) * mCoeff.mIn) + (mPrevIn * mCoeff.mPrevIn)
@@ -271,10 +302,17 @@ inline void IIRFilter::processToCacheH4(std::span<float const> inAudio, size_t i
 	assert(!inAudio.empty());
 	assert(inPos < inAudio.size());
 
-	auto const in0 = inAudio[inPos];
-	auto const in1 = inAudio[(inPos + 1) % inAudio.size()];
-	auto const in2 = inAudio[(inPos + 2) % inAudio.size()];
-	auto const in3 = inAudio[(inPos + 3) % inAudio.size()];
+	processToCacheH4(std::array{inAudio[inPos], inAudio[(inPos + 1) % inAudio.size()], 
+								inAudio[(inPos + 2) % inAudio.size()], inAudio[(inPos + 3) % inAudio.size()]});
+}
+
+//-----------------------------------------------------------------------------
+inline void IIRFilter::processToCacheH4(std::span<float const, 4> inAudio)
+{
+	auto const in0 = inAudio[0];
+	auto const in1 = inAudio[1];
+	auto const in2 = inAudio[2];
+	auto const in3 = inAudio[3];
 
 	// this uses an optimization that only works for LP, HP, and notch filters
 	mPrevPrevPrevOut = ((in0 + mPrevPrevIn) * mCoeff.mIn) + (mPrevIn * mCoeff.mPrevIn)
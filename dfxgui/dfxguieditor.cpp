@@ -25,6 +25,7 @@ To contact the author, use the contact form at http://destroyfx.org
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
@@ -3098,7 +3099,7 @@ DGButton* DfxGuiEditor::CreateMidiResetButton(VSTGUI::CCoord inXpos, VSTGUI::CCo
 template <dfx::TriviallySerializable T>
 [[nodiscard]] T DFXGUI_CorrectEndian(T inValue)
 {
-	if constexpr (!DfxSettings::serializationIsNativeEndian())  // VST program and bank files are also big-endian
+	if constexpr (std::endian::native != std::endian::big)  // VST program and bank files are big-endian
 	{
 		dfx::ReverseBytes(inValue);
 	}
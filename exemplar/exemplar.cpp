@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2006-2023  Tom Murphy 7
+Copyright (C) 2006-2026  Tom Murphy 7
 
 This file is part of Exemplar.
 
@@ -25,8 +25,12 @@ DFX Exemplar, featuring the Super Destroy FX Windowing System!
 
 #include <algorithm>
 #include <array>
+#include <cassert>
 #include <cstdio>
-#include <fstream>
+#include <cstring>
+#include <ranges>
+#include <string>
+#include <utility>
 
 #include "dfxmath.h"
 
@@ -36,6 +40,8 @@ DFX Exemplar, featuring the Super Destroy FX Windowing System!
 static constexpr int DIMENSION = 10;
 // should be param */
 static constexpr int STRIDE = 128;
+/* how many windows go into the smallest index trees */
+static constexpr size_t INDEXBLOCK = 64;
 
 /* this macro does boring entry point stuff for us */
 DFX_ENTRY(Exemplar);
@@ -87,6 +93,9 @@ PLUGIN::PLUGIN(TARGET_API_BASE_INSTANCE_TYPE inInstance)
   setpresetname(0, "Exemplar Default"); /* default preset name */
   makepresets();
 
+  /* nothing to tell anybody about yet */
+  corpussavestatushasposted.test_and_set();
+
   /* allow MIDI keys to be used to control parameters */
   dfxsettings->setAllowPitchbendEvents(true);
   dfxsettings->setAllowNoteEvents(true);
@@ -96,99 +105,511 @@ PLUGIN::PLUGIN(TARGET_API_BASE_INSTANCE_TYPE inInstance)
 #endif
 }
 
+dfx::StatusCode PLUGIN::dfx_GetPropertyInfo(dfx::PropertyID inPropertyID, dfx::Scope inScope, unsigned int inItemIndex,
+                                            size_t& outDataSize, dfx::PropertyFlags& outFlags)
+{
+  switch (inPropertyID)
+  {
+    case PROP_INDEX_PROGRESS:
+      outDataSize = sizeof(float);
+      outFlags = dfx::kPropertyFlag_Readable;
+      return dfx::kStatus_NoError;
+    case PROP_CORPUS_PATH:
+    {
+      std::lock_guard const guard(corpuslock);
+      outDataSize = corpuspath.size() + 1;
+      outFlags = dfx::kPropertyFlag_Readable | dfx::kPropertyFlag_Writable;
+      return dfx::kStatus_NoError;
+    }
+    case PROP_SAVE_CORPUS:
+      outDataSize = CORPUSPATHSIZE;
+      outFlags = dfx::kPropertyFlag_Writable;
+      return dfx::kStatus_NoError;
+    case PROP_CORPUS_SAVE_STATUS:
+      outDataSize = sizeof(int32_t);
+      outFlags = dfx::kPropertyFlag_Readable;
+      return dfx::kStatus_NoError;
+    default:
+      return DfxPlugin::dfx_GetPropertyInfo(inPropertyID, inScope, inItemIndex, outDataSize, outFlags);
+  }
+}
+
+dfx::StatusCode PLUGIN::dfx_GetProperty(dfx::PropertyID inPropertyID, dfx::Scope inScope, unsigned int inItemIndex,
+                                        void* outData)
+{
+  switch (inPropertyID)
+  {
+    case PROP_INDEX_PROGRESS:
+      dfx::MemCpyObject(indexprogress.load(std::memory_order_relaxed), outData);
+      return dfx::kStatus_NoError;
+    case PROP_CORPUS_PATH:
+    {
+      std::lock_guard const guard(corpuslock);
+      std::memcpy(outData, corpuspath.c_str(), corpuspath.size() + 1);
+      return dfx::kStatus_NoError;
+    }
+    case PROP_CORPUS_SAVE_STATUS:
+      dfx::MemCpyObject(corpussavestatus.load(std::memory_order_relaxed), outData);
+      return dfx::kStatus_NoError;
+    default:
+      return DfxPlugin::dfx_GetProperty(inPropertyID, inScope, inItemIndex, outData);
+  }
+}
+
+dfx::StatusCode PLUGIN::dfx_SetProperty(dfx::PropertyID inPropertyID, dfx::Scope inScope, unsigned int inItemIndex,
+                                        void const* inData, size_t inDataSize)
+{
+  /* the text might or might not come terminated */
+  auto const getpath = [inData, inDataSize] {
+    auto const text = static_cast<char const*>(inData);
+    return std::string(text, std::find(text, text + inDataSize, '\0'));
+  };
+
+  switch (inPropertyID)
+  {
+    case PROP_CORPUS_PATH:
+    {
+      auto path = getpath();
+      if (path.size() >= CORPUSPATHSIZE)
+        return dfx::kStatus_InvalidPropertyValue;
+      std::shared_ptr<ExemplarCorpus const> newcorpus;
+      if (!path.empty()) {
+        newcorpus = ExemplarCorpus::open(path, DIMENSION, STRIDE);
+        if (!newcorpus)
+          return dfx::kStatus_InvalidPropertyValue;
+      }
+      setcorpus(std::move(path), std::move(newcorpus));
+      dfx_PropertyChanged(inPropertyID, inScope, inItemIndex);
+      return dfx::kStatus_NoError;
+    }
+    case PROP_SAVE_CORPUS:
+    {
+      auto path = getpath();
+      if (path.empty() || (path.size() >= CORPUSPATHSIZE))
+        return dfx::kStatus_InvalidPropertyValue;
+      {
+        std::lock_guard const guard(corpuslock);
+        corpussavepath = std::move(path);
+      }
+      setcorpussavestatus(CORPUS_SAVE_PENDING);
+      notifycorpuslisteners();
+      return dfx::kStatus_NoError;
+    }
+    default:
+      return DfxPlugin::dfx_SetProperty(inPropertyID, inScope, inItemIndex, inData, inDataSize);
+  }
+}
+
+/* the corpus path goes in the settings, terminated and padded to a
+   fixed size. (It's text, so byte order doesn't matter.) */
+size_t PLUGIN::settings_sizeOfExtendedData() const noexcept {
+  return CORPUSPATHSIZE;
+}
+
+void PLUGIN::settings_saveExtendedData(void* outData, bool /*isPreset*/) const {
+  std::lock_guard const guard(corpuslock);
+  std::memset(outData, 0, CORPUSPATHSIZE);
+  std::memcpy(outData, corpuspath.data(), std::min(corpuspath.size(), CORPUSPATHSIZE - 1));
+}
+
+void PLUGIN::settings_restoreExtendedData(void const* inData, size_t storedExtendedDataSize,
+                                          unsigned int /*dataVersion*/, bool /*isPreset*/) {
+  if (storedExtendedDataSize >= CORPUSPATHSIZE) {
+    auto const text = static_cast<char const*>(inData);
+    std::string path(text, std::find(text, text + CORPUSPATHSIZE - 1, '\0'));
+    /* keep the path even if its file is missing right now,
+       so that saving the session again doesn't lose it */
+    auto newcorpus = path.empty() ? nullptr : ExemplarCorpus::open(path, DIMENSION, STRIDE);
+    setcorpus(std::move(path), std::move(newcorpus));
+    dfx_PropertyChanged(PROP_CORPUS_PATH);
+  }
+}
+
+void PLUGIN::setindexprogress(float progress) {
+  indexprogress.store(progress, std::memory_order_relaxed);
+}
+
+void PLUGIN::setcorpussavestatus(int32_t status) {
+  corpussavestatus.store(status, std::memory_order_relaxed);
+  corpussavestatushasposted.clear(std::memory_order_release);
+}
+
+void PLUGIN::idle() {
+  if (!corpussavestatushasposted.test_and_set(std::memory_order_acquire))
+    dfx_PropertyChanged(PROP_CORPUS_SAVE_STATUS);
+}
+
+void PLUGIN::setcorpus(std::string path, std::shared_ptr<ExemplarCorpus const> newcorpus) {
+  {
+    std::lock_guard const guard(corpuslock);
+    corpuspath = std::move(path);
+    /* (the old one is let go of here, but the cores' indexers
+       hold on to it until they've picked up the new one) */
+    corpus = std::move(newcorpus);
+  }
+  notifycorpuslisteners();
+}
+
+void PLUGIN::notifycorpuslisteners() {
+  std::lock_guard const guard(corpuslock);
+  for (auto const core : corpuslisteners)
+    core->signalindexer();
+}
+
+void PLUGIN::addcorpuslistener(PLUGINCORE * core) {
+  std::lock_guard const guard(corpuslock);
+  corpuslisteners.push_back(core);
+}
+
+void PLUGIN::removecorpuslistener(PLUGINCORE * core) {
+  std::lock_guard const guard(corpuslock);
+  std::erase(corpuslisteners, core);
+}
+
+std::shared_ptr<ExemplarCorpus const> PLUGIN::getcorpus() const {
+  std::lock_guard const guard(corpuslock);
+  return corpus;
+}
+
+std::string PLUGIN::takecorpussave() {
+  std::lock_guard const guard(corpuslock);
+  return std::exchange(corpussavepath, {});
+}
+
+
 PLUGINCORE::PLUGINCORE(DfxPlugin& inInstance)
   : DfxPluginCore(inInstance) {
-  /* determine the size of the largest window size */
-  constexpr auto maxframe = *std::ranges::max_element(buffersizes);
 
-  /* add some leeway? */
-  in0.assign(maxframe, 0.f);
-  out0.assign(maxframe * 2, 0.f);
+  /* initialize FFT stuff */
+  classifier.setframesize(static_cast<int>(windowing.getFrameSize()));
 
-  /* prevmix is only a single third long */
-  prevmix.assign(maxframe / 2, 0.f);
+  framepoint = annAllocPt(DIMENSION);
 
-  /* initialize FFT stuff */
-  plan.reset(rfftw_create_plan(framesize, FFTW_FORWARD, FFTW_ESTIMATE));
-  // rplan.reset(rfftw_create_plan(framesize, FFTW_BACKWARD, FFTW_ESTIMATE));
+  static_cast<PLUGIN&>(getplugin()).addcorpuslistener(this);
+}
 
+PLUGINCORE::~PLUGINCORE() {
+  static_cast<PLUGIN&>(getplugin()).removecorpuslistener(this);
+  stopindexer();
+  annDeallocPt(framepoint);
 }
 
 
 void PLUGINCORE::reset() {
 
-  framesize = buffersizes.at(getparameter_i(P_BUFSIZE));
-  third = framesize / 2;
-  bufsize = third * 3;
-
+  /* start input at beginning. Output has a frame of silence. */
+  windowing.setFrameSize(dfx::math::ToUnsigned(buffersizes.at(getparameter_i(P_BUFSIZE))));
+  updatewindowshape();
 
-  shape = getparameter_i(P_SHAPE);
+  /* an FFT of the new frame size */
+  classifier.setframesize(static_cast<int>(windowing.getFrameSize()));
+  classifier.fftrange = getparameter_i(P_FFTRANGE);
 
   bool newcapture = MODE_CAPTURE == getparameter_i(P_MODE);
-  if (newcapture != capturemode) {
-    /* switching modes. this can be expensive, since we have
-       to build the nearest neighbor tree. */
-    capturemode = newcapture;
-    if (capturemode) {
-      /* entering capture mode. discard the existing tree */
-      nntree.reset(); /* XXX do it... */
-
-      ncapsamples = 0;
-      npoints = 0;
-    } else {
-      /* entering match mode. build new tree. */
-
-      int wsize = getwindowsize();
-      int exstart = 0;
-      /* make points */
-      for (exstart = 0; exstart < (ncapsamples - wsize); exstart += STRIDE) {
-        /* save which start point this is */
-        cap_index[npoints] = exstart;
-        classify(&(capsamples[exstart]), 
-                 cap_scale[npoints],
-                 cap_point[npoints], wsize);
-        npoints++;
+  bool const enteringcapture = newcapture && !capturemode;
+  capturemode = newcapture;
+  /* (entering match mode needs nothing, since the capture
+     has been getting indexed all along) */
+  if (enteringcapture) {
+    /* discard the existing capture and its index */
+    stopindexer();
+    matchindex.reset();
+    capture.clear();
+    startindexer();
+  } else if (getwindowsize() != indexwsize) {
+    /* the captured windows need to be classified at the new size.
+       Meanwhile, matching goes on against the old index. */
+    stopindexer();
+    startindexer();
+  }
+
+  dfxplugin->setlatency_samples(windowing.getLatency());
+  /* tail is the same as delay, of course */
+  dfxplugin->settailsize_samples(windowing.getLatency());
+}
+
+void PLUGINCORE::startindexer() {
+
+  /* classifying the same way that the audio thread does */
+  auto const framesize = static_cast<long>(windowing.getFrameSize());
+  buildclassifier.setframesize(static_cast<int>(framesize));
+  buildclassifier.fftrange = classifier.fftrange;
+
+  /* so that capturing can begin right away */
+  capture.reserveahead();
+
+  indexwsize = getwindowsize();
+  indexthread = std::jthread([this, wsize = indexwsize, framesize](std::stop_token stoptoken) {
+    indexloop(stoptoken, wsize, framesize);
+  });
+}
+
+void PLUGINCORE::stopindexer() {
+
+  /* classifying checks for the stop request between windows,
+     but building a tree has to be waited out */
+  indexthread.request_stop();
+  if (indexthread.joinable())
+    indexthread.join();
+
+  /* whether or not it got taken, whatever is here is now stale */
+  pendingindexready.store(false, std::memory_order_relaxed);
+  pendingindex.reset();
+  publishindexprogress(1.0f);
+}
+
+void PLUGINCORE::signalindexer() {
+  indexsignal.fetch_add(1, std::memory_order_release);
+  indexsignal.notify_one();
+}
+
+/* runs on indexthread, starting over from the beginning of the capture */
+void PLUGINCORE::indexloop(std::stop_token stoptoken, long wsize, long framesize) {
+
+  std::stop_callback const wakeforstop(stoptoken, [this] { signalindexer(); });
+  auto & exemplar = static_cast<PLUGIN&>(getplugin());
+
+  /* levels[i] is a tree of INDEXBLOCK * 2^i windows, or nothing */
+  std::vector<std::shared_ptr<IndexTree const>> levels;
+  /* windows classified since the last full block */
+  std::vector<ANNcoord> stagedcoords;
+  std::vector<float> stagedscales;
+  int nwindows = 0;
+  bool changed = false;
+  /* the plugin's corpus, if it was saved at our frame size */
+  std::shared_ptr<ExemplarCorpus const> corpus;
+  std::shared_ptr<ExemplarCorpus const> pluginscorpus;
+
+  while (true) {
+    /* (the stop callback signals after the stop is requested,
+       so checking in this order never misses it) */
+    auto const signal = indexsignal.load(std::memory_order_acquire);
+    if (stoptoken.stop_requested())
+      break;
+    capture.reserveahead();
+
+    if (auto latest = exemplar.getcorpus(); latest != pluginscorpus) {
+      pluginscorpus = std::move(latest);
+      auto const usable = pluginscorpus && (pluginscorpus->framesize() == framesize);
+      corpus = usable ? pluginscorpus : nullptr;
+      /* get it off of the disk now, rather than when matching */
+      if (corpus)
+        corpus->prefault();
+      changed = true;
+    }
+
+    /* one window every STRIDE samples, for each whole frame
+       captured, since the FFT reads a frame's worth */
+    long const captured = capture.size();
+    int const available = (captured >= framesize) ? static_cast<int>(((captured - framesize) / STRIDE) + 1) : 0;
+
+    while ((nwindows < available) && !stoptoken.stop_requested()) {
+      float scale = 1.0f;
+      auto const offset = stagedcoords.size();
+      stagedcoords.resize(offset + DIMENSION);
+      classify(buildclassifier, capture.window(static_cast<long>(nwindows) * STRIDE),
+               scale, &(stagedcoords[offset]), wsize);
+      stagedscales.push_back(scale);
+      nwindows++;
+      changed = true;
+
+      if (stagedscales.size() == INDEXBLOCK) {
+        /* carry it up through the levels, merging with each full one */
+        auto tree = std::make_shared<IndexTree const>(nwindows - INDEXBLOCK, std::move(stagedcoords), std::move(stagedscales));
+        stagedcoords.clear();
+        stagedscales.clear();
+        for (size_t level = 0; ; level++) {
+          if (level == levels.size()) {
+            levels.push_back(std::move(tree));
+            break;
+          }
+          if (!levels[level]) {
+            levels[level] = std::move(tree);
+            break;
+          }
+          tree = std::make_shared<IndexTree const>(*levels[level], *tree);
+          levels[level].reset();
+        }
       }
 
-      nntree = std::make_unique<ANNkd_tree>(cap_point, npoints, DIMENSION);
-      std::array<char, 512> msg {};
-      // std::snprintf(msg.data(), msg.size(), "ok %p", this);
-      // MessageBoxA(0, "match mode", msg.data(), MB_OK);
-      #if 0
-      std::ofstream f;
-      f.open("c:\\code\\vstplugins\\exemplar\\dump.ann");
-      if (f) {
-        nntree->Dump(ANNtrue, f);
-        f.close();
+      if ((nwindows % 256) == 0)
+        publishindexprogress(static_cast<float>(nwindows) / static_cast<float>(available));
+    }
+    publishindexprogress(1.0f);
+
+    if (GetChannelNum() == 0) {
+      if (auto const savepath = exemplar.takecorpussave(); !savepath.empty())
+        savecorpus(savepath, levels, stagedcoords, stagedscales, wsize, framesize);
+    }
+
+    /* if the audio thread has taken the last one, hand it another */
+    if (changed && !pendingindexready.load(std::memory_order_acquire)) {
+      auto index = std::make_unique<MatchIndex>();
+      for (auto const & tree : levels) {
+        if (tree)
+          index->trees.push_back(tree);
+      }
+      /* the windows that aren't in a block yet get a little tree
+         of their own, which is rebuilt every time */
+      if (!stagedscales.empty()) {
+        auto const nstaged = static_cast<int>(stagedscales.size());
+        index->trees.push_back(std::make_shared<IndexTree const>(nwindows - nstaged, stagedcoords, stagedscales));
       }
-      #endif
+      index->corpus = corpus;
+      pendingindex = std::move(index);
+      pendingindexready.store(true, std::memory_order_release);
+      changed = false;
+    }
 
-      /* ok, ready! */
+    /* until there is more captured audio, the audio thread takes the
+       index, or it's time to stop */
+    indexsignal.wait(signal, std::memory_order_acquire);
+  }
+}
+
+void PLUGINCORE::savecorpus(std::string const & path,
+                            std::vector<std::shared_ptr<IndexTree const>> const & levels,
+                            std::vector<ANNcoord> const & stagedcoords,
+                            std::vector<float> const & stagedscales,
+                            long wsize, long framesize) {
+
+  /* gather the windows back into order, oldest first */
+  std::vector<ANNcoord> coords;
+  std::vector<float> scales;
+  for (auto const & tree : levels | std::views::reverse) {
+    if (tree) {
+      assert(tree->first == std::ssize(scales));
+      coords.insert(coords.end(), tree->coords.cbegin(), tree->coords.cend());
+      scales.insert(scales.end(), tree->scales.cbegin(), tree->scales.cend());
     }
-  } /* mode changed */
+  }
+  coords.insert(coords.end(), stagedcoords.cbegin(), stagedcoords.cend());
+  scales.insert(scales.end(), stagedscales.cbegin(), stagedscales.cend());
 
-  /* set up buffers. Prevmix and first frame of output are always 
-     filled with zeros. XXX memset */
+  std::vector<float> audio(static_cast<size_t>(capture.size()));
+  for (long start = 0; start < std::ssize(audio); start += CaptureArena::CHUNKSIZE) {
+    auto const count = std::min(CaptureArena::CHUNKSIZE, std::ssize(audio) - start);
+    std::copy_n(capture.window(start), count, audio.begin() + start);
+  }
 
-  std::fill_n(prevmix.begin(), third, 0.f);
-  std::fill_n(out0.begin(), framesize, 0.f)
+  auto const saved = ExemplarCorpus::write(path, audio, scales, coords, DIMENSION, STRIDE, wsize, framesize);
+  static_cast<PLUGIN&>(getplugin()).setcorpussavestatus(saved ? CORPUS_SAVE_DONE : CORPUS_SAVE_FAILED);
+}
 
-  /* start input at beginning. Output has a frame of silence. */
-  insize = 0;
-  outstart = 0;
-  outsize = framesize;
+void PLUGINCORE::publishindexprogress(float progress) {
 
-  /* restore FFT plans */
-  plan.reset(rfftw_create_plan(framesize, FFTW_FORWARD, FFTW_ESTIMATE));
-  // rplan.reset(rfftw_create_plan(framesize, FFTW_BACKWARD, FFTW_ESTIMATE));
+  /* every DSP core indexes its own channel, and they all
+     take about as long, so the first one speaks for all */
+  if (GetChannelNum() == 0)
+    static_cast<PLUGIN&>(getplugin()).setindexprogress(progress);
+}
 
-  dfxplugin->setlatency_samples(dfx::math::ToUnsigned(framesize));
-  /* tail is the same as delay, of course */
-  dfxplugin->settailsize_samples(dfx::math::ToUnsigned(framesize));
+PLUGINCORE::IndexTree::IndexTree(int first, std::vector<ANNcoord> coords, std::vector<float> scales)
+  : first(first),
+    coords(std::move(coords)),
+    scales(std::move(scales)) {
+
+  auto const npoints = this->scales.size();
+  assert(this->coords.size() == (npoints * DIMENSION));
+  points.reserve(npoints);
+  for (size_t i = 0; i < npoints; i++) {
+    points.push_back(&(this->coords[i * DIMENSION]));
+  }
+  tree = std::make_unique<ANNkd_tree>(points.data(), static_cast<int>(npoints), DIMENSION);
+}
+
+PLUGINCORE::IndexTree::IndexTree(IndexTree const & older, IndexTree const & newer)
+  : IndexTree(older.first,
+              [&] {
+                auto result = older.coords;
+                result.insert(result.end(), newer.coords.cbegin(), newer.coords.cend());
+                return result;
+              }(),
+              [&] {
+                auto result = older.scales;
+                result.insert(result.end(), newer.scales.cbegin(), newer.scales.cend());
+                return result;
+              }()) {
+  assert((older.first + std::ssize(older.scales)) == newer.first);
+}
+
+
+void CaptureArena::append(float const * in, long samples) {
+
+  auto position = nsamples.load(std::memory_order_relaxed);
+  auto const end = std::min(position + samples, CAPACITY);
+  auto const available = nchunks.load(std::memory_order_acquire);
+
+  while (position < end) {
+    auto const chunk = static_cast<size_t>(position / CHUNKSIZE);
+    if (chunk >= available)
+      break;  /* the indexer is behind on allocating; drop it */
+    auto const offset = position % CHUNKSIZE;
+    auto const count = std::min(end - position, CHUNKSIZE - offset);
+    std::copy_n(in, count, chunks[chunk].get() + offset);
+    /* the previous chunk repeats the start of this one */
+    if ((chunk > 0) && (offset < MAXFRAME))
+      std::copy_n(in, std::min(count, MAXFRAME - offset), chunks[chunk - 1].get() + CHUNKSIZE + offset);
+    in += count;
+    position += count;
+  }
+
+  nsamples.store(position, std::memory_order_release);
+}
+
+float const * CaptureArena::window(long start) const {
+  assert(start >= 0 && start < CAPACITY);
+  return chunks[static_cast<size_t>(start / CHUNKSIZE)].get() + (start % CHUNKSIZE);
+}
+
+void CaptureArena::reserveahead() {
+  auto const needed = std::min(static_cast<size_t>(size() / CHUNKSIZE) + 2, MAXCHUNKS);
+  for (auto i = nchunks.load(std::memory_order_relaxed); i < needed; i++) {
+    chunks[i] = std::make_unique<float[]>(CHUNKSIZE + MAXFRAME);
+    nchunks.store(i + 1, std::memory_order_release);
+  }
+}
+
+void CaptureArena::clear() {
+  /* keep the first chunk, which would just get allocated again */
+  std::for_each(std::next(chunks.begin()), chunks.end(), [](auto & chunk) { chunk.reset(); });
+  nchunks.store(std::min(nchunks.load(std::memory_order_relaxed), size_t(1)), std::memory_order_relaxed);
+  nsamples.store(0, std::memory_order_relaxed);
+}
+
+void PLUGINCORE::Classifier::setframesize(int framesize) {
+  auto const size = static_cast<size_t>(framesize);
+  if (!fft || fft->size() != size) {
+    fft.emplace(size);
+  }
+  fftr.assign(size, 0.0f);
+}
+
+void PLUGINCORE::updatewindowshape() {
+
+  using WindowShape = decltype(windowing)::WindowShape;
+  switch (getparameter_i(P_SHAPE)) {
+    case WINDOW_TRIANGLE:
+    default:
+      windowing.setWindowShape(WindowShape::Triangle);
+      break;
+    case WINDOW_ARROW:
+      windowing.setWindowShape(WindowShape::Arrow);
+      break;
+    case WINDOW_WEDGE:
+      windowing.setWindowShape(WindowShape::Wedge);
+      break;
+    case WINDOW_COS:
+      windowing.setWindowShape(WindowShape::Cosine);
+      break;
+  }
 }
 
 void PLUGINCORE::processparameters() {
-  
+
+  if (getparameterchanged(P_SHAPE))
+    updatewindowshape();
+
   /* can safely change this whenever... */
   erroramount = getparameter_f(P_ERRORAMOUNT);
 
@@ -225,28 +646,61 @@ void PLUGINCORE::processw(float const * in, float * out, long samples) {
   
   parity = !parity;
   if (capturemode) {
-    /* capture mode.. just record into capsamples */
+    /* capture mode.. just record, and let the indexer know */
     if (parity == 0) {
-      for(int i = 0; i < samples && ncapsamples < CAPBUFFER; i ++) {
-        capsamples[ncapsamples++] = in[i];
-      }
+      capture.append(in, samples);
+      signalindexer();
     }
   } else {
 
-    ANNpoint p;
-    ANNidx res;
-    ANNdist dist;
-    float scale;
-    classify(in, scale, p, samples);
+    /* take a newly finished index, leaving the old one
+       behind to be deleted off of the audio thread */
+    if (pendingindexready.load(std::memory_order_acquire)) {
+      std::swap(matchindex, pendingindex);
+      pendingindexready.store(false, std::memory_order_release);
+      signalindexer();
+    }
 
-    if (1 && nntree) {
+    ExemplarCorpus const * const corpus = matchindex ? matchindex->corpus.get() : nullptr;
+    if (corpus || (matchindex && !matchindex->trees.empty())) {
       /* match mode */
-      nntree->annkSearch(p, 1, &res, &dist /* distance array -- not needed */, erroramount);
-      
-      annDeallocPt(p);
+      float scale;
+      classify(classifier, in, scale, framepoint, samples);
+
+      ANNidx res = ANN_NULL_IDX;
+      ANNdist dist = 0;
+      float matchscale = 1.0f;
+      /* the matched window's audio, and how much of it there is */
+      float const * captured = nullptr;
+      long available = samples;
+      if (corpus) {
+        corpus->tree().annkSearch(framepoint, 1, &res, &dist, erroramount);
+        if (res != ANN_NULL_IDX) {
+          auto const matchstart = static_cast<size_t>(res) * STRIDE;
+          matchscale = corpus->scales()[static_cast<size_t>(res)];
+          captured = corpus->audio().data() + matchstart;
+          available = std::min(samples, static_cast<long>(corpus->audio().size() - matchstart));
+        }
+      } else {
+        /* the closest point of all of the trees */
+        long matchstart = 0;
+        for (auto const & tree : matchindex->trees) {
+          ANNidx treeres;
+          ANNdist treedist;
+          tree->tree->annkSearch(framepoint, 1, &treeres, &treedist /* distance array -- not needed */, erroramount);
+          if ((treeres != ANN_NULL_IDX) && ((res == ANN_NULL_IDX) || (treedist < dist))) {
+            res = treeres;
+            dist = treedist;
+            matchscale = tree->scales[treeres];
+            matchstart = static_cast<long>(tree->first + treeres) * STRIDE;
+          }
+        }
+        if (res != ANN_NULL_IDX)
+          captured = capture.window(matchstart);
+      }
 
       /* now res holds the closest point index */
-      if (res != ANN_NULL_IDX) {
+      if (captured) {
         /* so copy that captured window into output */
         /* really should use the window size that this
            originally represented, perhaps stretching it... */
@@ -254,27 +708,26 @@ void PLUGINCORE::processw(float const * in, float * out, long samples) {
         /* scale is the boost we would need to apply to
            normalize the existing sample.
 
-           cap_scale[res] is the boost we would apply
+           matchscale is the boost we would apply
            to normalize the match sample.
 
            so we boost the match sample
-           ( capsamples[i] * cap_scale[res] ) and then
+           ( captured[i] * matchscale ) and then
            dim the result to the volume of the existing
            sample ( .. / scale ).
         */
 
-        float matchvol = cap_scale[res] / scale;
+        float matchvol = matchscale / scale;
 
-        for(int i = 0; i < samples && (cap_index[res] + i < CAPBUFFER) ; i ++) {
-          out[i] = capsamples[cap_index[res] + i] * matchvol;
+        for(int i = 0; i < available; i ++) {
+          out[i] = captured[i] * matchvol;
         }
+        /* (a corpus can end partway into its last windows) */
+        std::fill(out + available, out + samples, 0.0f);
       } /* otherwise ??? */
     } else {
-      /* error noise */
-      for(int i = 0; i < samples; i ++) {
-        out[i] = sin((float)i / 100.0);
-      }
-
+      /* no index yet (it's still being built), so pass audio through */
+      std::copy_n(in, samples, out);
     }
   }
 }
@@ -302,8 +755,7 @@ void PLUGINCORE::processw(float const * in, float * out, long samples) {
 
 /* assumes samples is a power of two. */
 void PLUGINCORE::classify_haar(float const * in, float & scale, 
-                               ANNpoint & out, long samples) {
-  out = annAllocPt(DIMENSION);
+                               ANNpoint out, long samples) {
 
   /* first we normalize, since we are not really trying to
      match by scale but by the characteristic of the wave. */
@@ -371,9 +823,8 @@ void PLUGINCORE::classify_haar(float const * in, float & scale,
 
 }
 
-void PLUGINCORE::classify_fft(float const * in, float & scale, 
-                              ANNpoint & out, long samples) {
-  out = annAllocPt(DIMENSION);
+void PLUGINCORE::classify_fft(Classifier & classifier, float const * in, float & scale, 
+                              ANNpoint out, long samples) {
 
   /* first we normalize, since we are not really trying to
      match by scale but by the characteristic of the wave. */
@@ -398,7 +849,8 @@ void PLUGINCORE::classify_fft(float const * in, float & scale,
 # endif
 
   /* do the fft */
-  rfftw_one(plan.get(), in, fftr);
+  classifier.fft->forwardHalfComplex(in, classifier.fftr.data());
+  float const * const fftr = classifier.fftr.data();
 
   /* what we've got now is frequency/amplitude pairs.
      we want to represent the characteristics of this
@@ -468,7 +920,7 @@ void PLUGINCORE::classify_fft(float const * in, float & scale,
     int low = 0;
     int hi = samples;
 
-    if (getparameter_i(P_FFTRANGE) == FFTR_AUDIBLE) {
+    if (classifier.fftrange == FFTR_AUDIBLE) {
       /* XXX just a guess. Need to know the sample rate.
          But, whatever. */
       low = .005 * samples;
@@ -518,123 +970,20 @@ void PLUGINCORE::classify_fft(float const * in, float & scale,
   }
 }
 
-void PLUGINCORE::classify(float const * in, float & scale, 
-                          ANNpoint & out, long samples) {
-  classify_fft(in, scale, out, samples);
+void PLUGINCORE::classify(Classifier & classifier, float const * in, float & scale, 
+                          ANNpoint out, long samples) {
+  classify_fft(classifier, in, scale, out, samples);
 }
 
 
-/* this windowing process function reads samples one at a time
-   from the true input. It simultaneously copies samples from
-   the beginning of the output buffer to the true output.
-   We maintain that out0 always has at least 'third' samples
-   in it; this is enough to pick up for the delay of input
-   processing and to make sure we always have enough samples
-   to fill the true output buffer.
-
-   If the input frame is full:
-    - calls wprocess on this full input frame
-    - applies the windowing envelope to the tail of out0 (output frame)
-    - mixes in prevmix with the first half of the output frame
-    - increases outsize so that the first half of the output frame is
-      now available output
-    - copies the second half of the output to be prevmix for next frame.
-    - copies the second half of the input buffer to the first,
-      resets the size (thus we process each third-size chunk twice)
-
-  If we have read more than 'third' samples out of the out0 buffer:
-   - Slide contents to beginning of buffer
-   - Reset outstart
-
-*/
-
-/* PERF: 
-   - use memcpy and arithmetic instead of
-     sample-by-sample copy 
-   - can we use tail of out0 as prevmix, instead of copying?
-   - can we use circular buffers instead of memmoving a lot?
-     (probably not)
-*/
-
-
+/* the windowing engine feeds processw frames of the true input
+   that overlap by half (so each stretch of input is seen twice; see
+   the capture parity in processw), windows what comes back, and
+   crossfades it into the true output one frame late. */
 void PLUGINCORE::process(std::span<float const> tin, std::span<float> tout) {
-  int z = 0;
-
-  for (size_t ii = 0; ii < tout.size(); ii++) {
-
-    /* copy sample in */
-    in0[insize] = tin[ii];
-    insize ++;
- 
-    if (insize == framesize) {
-      /* frame is full! */
-
-      /* in0 -> process -> out0(first free space) */
-      processw(in0.data(), out0.data()+outstart+outsize, framesize);
-
-      float oneDivThird = 1.0f / (float)third;
-      /* apply envelope */
-
-      switch(shape) {
-
-        case WINDOW_TRIANGLE:
-          for(z = 0; z < third; z++) {
-            out0[z+outstart+outsize] *= ((float)z * oneDivThird);
-            out0[z+outstart+outsize+third] *= (1.0f - ((float)z * oneDivThird));
-          }
-          break;
-        case WINDOW_ARROW:
-          for(z = 0; z < third; z++) {
-            float p = (float)z * oneDivThird;
-            p *= p;
-            out0[z+outstart+outsize] *= p;
-            out0[z+outstart+outsize+third] *= (1.0f - p);
-          }
-          break;
-        case WINDOW_WEDGE:
-          for(z = 0; z < third; z++) {
-            float p = sqrtf((float)z * oneDivThird);
-            out0[z+outstart+outsize] *= p;
-            out0[z+outstart+outsize+third] *= (1.0f - p);
-          }
-          break;
-        case WINDOW_COS:
-          for(z = 0; z < third; z ++) {
-            float p = 0.5f * (-cosf(PI * ((float)z * oneDivThird)) + 1.0f);
-            out0[z+outstart+outsize] *= p;
-            out0[z+outstart+outsize+third] *= (1.0f - p);
-          }
-          break;
-      }
-
-      /* mix in prevmix */
-      for(int u = 0; u < third; u ++)
-        out0[u+outstart+outsize] += prevmix[u];
-
-      /* prevmix becomes out1 */
-      std::copy_n(std::next(out0.cbegin(), outstart + outsize + third), third, prevmix.begin());
-
-      /* copy 2nd third of input over in0 (need to re-use it for next frame), 
-         now insize = third */
-      std::copy_n(std::next(in0.cbegin(), third), third, in0.begin());
-
-      insize = third;
-      
-      outsize += third;
-    }
-
-    /* send sample out */
-    tout[ii] = out0[outstart];
-
-    outstart ++;
-    outsize --;
-
-    /* make sure there is always enough room for a frame in out buffer */
-    if (outstart == third) {
-      memmove(out0.data(), out0.data() + outstart, outsize * sizeof (float));
-      outstart = 0;
-    }
-  }
+  windowing.process(tin, tout, [this](float const * in, float * out, size_t samples) {
+    processw(in, out, static_cast<long>(samples));
+  });
 }
 
 
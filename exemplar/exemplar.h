@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2006-2023  Tom Murphy 7
+Copyright (C) 2006-2026  Tom Murphy 7
 
 This file is part of Exemplar.
 
@@ -25,13 +25,22 @@ DFX Exemplar, starring the Super Destroy FX Windowing System!
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include "dfxfft.h"
 #include "dfxmisc.h"
 #include "dfxplugin.h"
+#include "dfxwindowing.h"
+#include "exemplarcorpus.h"
 #include "ANN/ANN.h"
-#include "rfftw.h"
 
 /* change these for your plugins */
 #define PLUGIN Exemplar
@@ -41,6 +50,8 @@ static constexpr std::array buffersizes {
   1024, 2048, 4096, 8192, 16384, 32768, 
 };
 
+static constexpr long MAXFRAME = *std::ranges::max_element(buffersizes);
+
 
 // PLUGIN ## DSP
 #define PLUGINCORE ExemplarDSP
@@ -69,73 +80,214 @@ enum : dfx::ParameterID { P_BUFSIZE, P_SHAPE,
                           NUM_PARAMS
 };
 
+enum : dfx::PropertyID {
+  /* how far along building the match index is, from 0 to 1 (float).
+     It's 1 whenever no build is in progress. */
+  PROP_INDEX_PROGRESS = dfx::kPluginProperty_EndOfList,
+  /* the path (UTF-8 text) of a corpus file to match against instead
+     of the capture, or empty for none. It's saved with the settings,
+     so the corpus comes back when the session is opened. A corpus is
+     only used at the window size that it was saved with. */
+  PROP_CORPUS_PATH,
+  /* setting this to a path (write-only) saves the first channel's
+     capture and its index there as a corpus file. That happens on
+     the indexing thread, once it has caught up with the capture. */
+  PROP_SAVE_CORPUS,
+  /* how the most recent corpus save went, one of the CORPUS_SAVE_
+     values below (int32_t, read-only). Listeners hear about it when
+     a save finishes. */
+  PROP_CORPUS_SAVE_STATUS,
+};
+
+enum : int32_t {
+  CORPUS_SAVE_NONE,     /* none has been asked for */
+  CORPUS_SAVE_PENDING,  /* waiting on the indexing thread */
+  CORPUS_SAVE_DONE,
+  CORPUS_SAVE_FAILED,
+};
+
+/* the longest corpus path, including its terminator */
+static constexpr size_t CORPUSPATHSIZE = 1024;
+
+
+class PLUGINCORE;
 
 class PLUGIN final : public DfxPlugin {
 public:
   explicit PLUGIN(TARGET_API_BASE_INSTANCE_TYPE inInstance);
 
+  dfx::StatusCode dfx_GetPropertyInfo(dfx::PropertyID inPropertyID, dfx::Scope inScope, unsigned int inItemIndex,
+                                      size_t& outDataSize, dfx::PropertyFlags& outFlags) override;
+  dfx::StatusCode dfx_GetProperty(dfx::PropertyID inPropertyID, dfx::Scope inScope, unsigned int inItemIndex,
+                                  void* outData) override;
+  dfx::StatusCode dfx_SetProperty(dfx::PropertyID inPropertyID, dfx::Scope inScope, unsigned int inItemIndex,
+                                  void const* inData, size_t inDataSize) override;
+
+  size_t settings_sizeOfExtendedData() const noexcept override;
+  void settings_saveExtendedData(void* outData, bool isPreset) const override;
+  void settings_restoreExtendedData(void const* inData, size_t storedExtendedDataSize,
+                                    unsigned int dataVersion, bool isPreset) override;
+  void idle() override;
+
+  void setindexprogress(float progress);
+  /* any thread: lets listeners know, at idle time */
+  void setcorpussavestatus(int32_t status);
+
+  /* DSP cores hear about it whenever the corpus changes, or a save
+     is asked for, through their signalindexer */
+  void addcorpuslistener(PLUGINCORE * core);
+  void removecorpuslistener(PLUGINCORE * core);
+  std::shared_ptr<ExemplarCorpus const> getcorpus() const;
+  /* the path that a save has been asked for, if any, which is
+     then forgotten */
+  std::string takecorpussave();
+
 private:
   static constexpr size_t NUM_PRESETS = 16;
 
+  std::atomic<float> indexprogress {1.0f};
+  std::atomic<int32_t> corpussavestatus {CORPUS_SAVE_NONE};
+  std::atomic_flag corpussavestatushasposted;
+
+  /* sets the corpus, and lets the DSP cores know */
+  void setcorpus(std::string path, std::shared_ptr<ExemplarCorpus const> newcorpus);
+  void notifycorpuslisteners();
+
+  /* everything below is guarded by corpuslock */
+  mutable std::mutex corpuslock;
+  std::string corpuspath;
+  /* null when there's no path, or its file couldn't be opened */
+  std::shared_ptr<ExemplarCorpus const> corpus;
+  std::string corpussavepath;
+  std::vector<PLUGINCORE *> corpuslisteners;
+
   /* set up the built-in presets */
   void makepresets();
 };
 
+/* the captured audio, kept in chunks that the indexing thread
+   allocates ahead of the audio thread as the capture grows, so that
+   memory goes with the length of the capture rather than its limit.
+   Each chunk also holds a copy of the start of the next one, so that
+   any MAXFRAME samples can be read contiguously. */
+class CaptureArena {
+public:
+  static constexpr long CAPACITY = 500000; /* 1000000 */
+  static constexpr long CHUNKSIZE = 65536;
+
+  /* audio thread: appends as much as there is room for */
+  void append(float const * in, long samples);
+  /* how much has been appended. Any thread can read below this. */
+  long size() const noexcept { return nsamples.load(std::memory_order_acquire); }
+  /* MAXFRAME samples beginning at start */
+  float const * window(long start) const;
+
+  /* indexing thread: makes sure that the chunk after the one being
+     appended to is there */
+  void reserveahead();
+  /* only while neither of the other threads is using it */
+  void clear();
+
+private:
+  static constexpr size_t MAXCHUNKS = (CAPACITY + CHUNKSIZE - 1) / CHUNKSIZE;
+
+  std::array<std::unique_ptr<float[]>, MAXCHUNKS> chunks;
+  std::atomic<size_t> nchunks {0};
+  std::atomic<long> nsamples {0};
+};
+
+
 class PLUGINCORE final : public DfxPluginCore {
 public:
   explicit PLUGINCORE(DfxPlugin& inInstance);
+  ~PLUGINCORE() override;
 
   void reset() override;
   void processparameters() override;
   void process(std::span<float const> in, std::span<float> out) override;
 
-  long getwindowsize() const noexcept { return third; }
-
-private:
+  long getwindowsize() const noexcept { return static_cast<long>(windowing.getHopSize()); }
 
-  /* input and output buffers. out is framesize*2 samples long, in is framesize
-     samples long. (for maximum framesize)
-  */
-  std::vector<float> in0, out0;
+  /* wakes the indexer up to look for new work */
+  void signalindexer();
 
-  /* bufsize is 3 * third, framesize is 2 * third 
-     bufsize is used for outbuf.
-  */
-  long bufsize = 0, framesize = 0, third = 0;
+private:
 
   void processw(float const * in, float * out, long samples);
 
-  int shape = 0;
+  void updatewindowshape();
 
-  /* third-sized tail of previous processed frame. already has mixing envelope
-     applied.
-   */
-  std::vector<float> prevmix;
+  /* supplies processw with overlapping frames of input and
+     overlap-adds its enveloped output */
+  dfx::OverlapAdd<float> windowing {static_cast<size_t>(MAXFRAME)};
 
-  /* number of samples in in0 */
-  int insize = 0;
 
-  /* number of samples and starting position of valid samples in out0 */
-  int outsize = 0;
-  int outstart = 0;
 
+  /* Exemplar stuff */
 
+  /* the FFT and spectrum that classifying uses, so that the
+     audio thread and the index builder can each have their own */
+  struct Classifier {
+    void setframesize(int framesize);
 
-  /* Exemplar stuff */
-  /* classifies a window */
-  void classify(float const * in, float & scale, ANNpoint & out, long samples);
+    std::optional<dfx::FFT> fft;
+    std::vector<float> fftr;
+    int fftrange = FFTR_AUDIBLE;
+  };
+
+  /* classifies a window into the DIMENSION coordinates of out */
+  void classify(Classifier & classifier, float const * in, float & scale, ANNpoint out, long samples);
 
   /* specific classifiers */
-  void classify_haar(float const * in, float & scale, ANNpoint & out, long samples);
-  void classify_fft (float const * in, float & scale, ANNpoint & out, long samples);
+  void classify_haar(float const * in, float & scale, ANNpoint out, long samples);
+  void classify_fft (Classifier & classifier, float const * in, float & scale, ANNpoint out, long samples);
+
+  /* the classifications of a run of consecutive captured windows,
+     and the search tree over them. These never change once built. */
+  struct IndexTree {
+    IndexTree(int first, std::vector<ANNcoord> coords, std::vector<float> scales);
+    /* the two runs, end to end */
+    IndexTree(IndexTree const & older, IndexTree const & newer);
+
+    /* the number of its first window, which starts at first * STRIDE */
+    int first = 0;
+    /* DIMENSION of these for each window */
+    std::vector<ANNcoord> coords;
+    std::vector<ANNpoint> points;
+    std::vector<float> scales;
+    std::unique_ptr<ANNkd_tree> tree;
+  };
+
+  /* trees that together cover all of the captured windows indexed so far */
+  struct MatchIndex {
+    std::vector<std::shared_ptr<IndexTree const>> trees;
+    /* when there's a corpus, it's matched against instead */
+    std::shared_ptr<ExemplarCorpus const> corpus;
+  };
+
+  /* windows are classified on a thread of their own as they are
+     captured, and added to a forest of trees of doubling sizes
+     (like a binary counter, so that each window only gets rebuilt
+     into a tree a logarithmic number of times). Whenever the audio
+     thread has taken the previous index, the indexer hands it a new
+     one in pendingindex, and processw swaps it in. */
+  void startindexer();
+  void stopindexer();
+  void indexloop(std::stop_token stoptoken, long wsize, long framesize);
+  void publishindexprogress(float progress);
+  /* writes the capture so far and its classifications, which are
+     the levels (newest first) followed by the staged windows */
+  void savecorpus(std::string const & path,
+                  std::vector<std::shared_ptr<IndexTree const>> const & levels,
+                  std::vector<ANNcoord> const & stagedcoords,
+                  std::vector<float> const & stagedscales,
+                  long wsize, long framesize);
 
 
   bool capturemode = true;
   float erroramount = 0.f;
 
-  static constexpr size_t CAPBUFFER = 500000; /* 1000000 */
-  float capsamples[CAPBUFFER] {};
-  int ncapsamples = 0; /* < CAPBUFFER */
+  CaptureArena capture;
   
 #if 0
   /* an individual capture */
@@ -148,17 +300,22 @@ private:
   };
 #endif
 
-  ANNpoint cap_point[CAPBUFFER] {};
-  int cap_index[CAPBUFFER] {};
-  float cap_scale[CAPBUFFER] {};
-  int npoints = 0;
-
-  std::unique_ptr<ANNkd_tree> nntree;
-
-  /* for FFTW: current analysis plan */
-  dfx::UniqueOpaqueType<rfftw_plan, rfftw_destroy_plan> plan, rplan;
-
-  /* result of ffts ( */
-  float fftr[*std::ranges::max_element(buffersizes)] {};
-
+  /* the index being matched against, owned by the audio thread */
+  std::unique_ptr<MatchIndex> matchindex;
+  /* while pendingindexready is set, a newer index waiting to be
+     taken by the audio thread. Otherwise, the indexer's to replace,
+     which may mean deleting the one the audio thread gave up. */
+  std::unique_ptr<MatchIndex> pendingindex;
+  std::atomic<bool> pendingindexready {false};
+  std::atomic<uint32_t> indexsignal {0};
+  /* the window size that the indexer is classifying with */
+  long indexwsize = 0;
+  /* the classification of the current frame */
+  ANNpoint framepoint = nullptr;
+
+  /* the audio thread's classifier, and the indexer's */
+  Classifier classifier, buildclassifier;
+
+  /* declared last, so that it's stopped before anything it uses goes away */
+  std::jthread indexthread;
 };
@@ -0,0 +1,281 @@
+/*------------------------------------------------------------------------
+Copyright (C) 2026  Tom Murphy 7
+
+This file is part of Exemplar.
+
+Exemplar is free software:  you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+Exemplar is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Exemplar.  If not, see <http://www.gnu.org/licenses/>.
+
+To contact the author, use the contact form at http://destroyfx.org
+
+DFX Exemplar corpus files.
+------------------------------------------------------------------------*/
+
+#include "exemplarcorpus.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+
+static constexpr std::array<char, 8> MAGIC {'D', 'F', 'X', 'e', 'x', 'm', 'p', '\0'};
+static constexpr uint32_t VERSION = 3;
+static constexpr uint32_t BYTEORDER = 0x01020304;
+/* sections start on these, which also suits the flattened tree */
+static constexpr uint64_t ALIGNMENT = 64;
+
+static constexpr uint64_t align(uint64_t offset) noexcept {
+  return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+/* every open corpus, so that opening one again shares it */
+static std::mutex registrylock;
+static std::map<std::string, std::weak_ptr<ExemplarCorpus const>> registry;
+
+
+class ExemplarCorpus::Mapping {
+public:
+  /* null if the file can't be mapped */
+  static std::unique_ptr<Mapping> create(std::string const & path);
+  ~Mapping();
+
+  std::byte const * data() const noexcept { return base; }
+  size_t size() const noexcept { return length; }
+
+private:
+  Mapping(std::byte const * base, size_t length) : base(base), length(length) {}
+
+  std::byte const * base = nullptr;
+  size_t length = 0;
+};
+
+#ifdef _WIN32
+
+std::unique_ptr<ExemplarCorpus::Mapping> ExemplarCorpus::Mapping::create(std::string const & path) {
+
+  /* the view keeps the file open after the handles are closed */
+  HANDLE const file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return {};
+  LARGE_INTEGER filesize {};
+  HANDLE mapping = nullptr;
+  if (GetFileSizeEx(file, &filesize) && (filesize.QuadPart > 0))
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (!mapping)
+    return {};
+  void const * const view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!view)
+    return {};
+  return std::unique_ptr<Mapping>(new Mapping(static_cast<std::byte const *>(view),
+                                              static_cast<size_t>(filesize.QuadPart)));
+}
+
+ExemplarCorpus::Mapping::~Mapping() {
+  UnmapViewOfFile(base);
+}
+
+#else
+
+std::unique_ptr<ExemplarCorpus::Mapping> ExemplarCorpus::Mapping::create(std::string const & path) {
+
+  /* the mapping keeps the file open after it's closed */
+  int const fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return {};
+  struct stat info {};
+  void * view = MAP_FAILED;
+  if ((fstat(fd, &info) == 0) && (info.st_size > 0))
+    view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED)
+    return {};
+  return std::unique_ptr<Mapping>(new Mapping(static_cast<std::byte const *>(view),
+                                              static_cast<size_t>(info.st_size)));
+}
+
+ExemplarCorpus::Mapping::~Mapping() {
+  munmap(const_cast<std::byte *>(base), length);
+}
+
+#endif
+
+
+ExemplarCorpus::ExemplarCorpus(std::string path, std::unique_ptr<Mapping> mapping)
+  : path(std::move(path)),
+    mapping(std::move(mapping)) {
+
+  auto const base = this->mapping->data();
+  std::memcpy(&header, base, sizeof(header));
+  audiosamples = {reinterpret_cast<float const *>(base + header.audiooffset), header.nsamples};
+  windowscales = {reinterpret_cast<float const *>(base + header.scalesoffset), header.nwindows};
+  flattree = std::make_unique<ANNkd_flat_tree>(base + header.treeoffset, header.treesize);
+}
+
+/* (out of line, where Mapping is complete) */
+ExemplarCorpus::~ExemplarCorpus() = default;
+
+std::shared_ptr<ExemplarCorpus const> ExemplarCorpus::open(std::string const & path, int dimension, int stride) {
+
+  std::lock_guard const guard(registrylock);
+  std::erase_if(registry, [](auto const & entry) { return entry.second.expired(); });
+  if (auto const found = registry.find(path); found != registry.end()) {
+    auto corpus = found->second.lock();
+    if (corpus && (corpus->header.dimension == dimension) && (corpus->header.stride == stride))
+      return corpus;
+    return {};
+  }
+
+  auto mapping = Mapping::create(path);
+  if (!mapping || (mapping->size() < sizeof(Header)))
+    return {};
+
+  /* check everything that will be read, so a bad file can't
+     send anybody outside of the mapping */
+  Header header {};
+  std::memcpy(&header, mapping->data(), sizeof(header));
+  uint64_t const size = mapping->size();
+  auto const section = [size](uint64_t offset, uint64_t count, uint64_t itemsize) {
+    return ((offset % ALIGNMENT) == 0) && (offset <= size) && (count <= ((size - offset) / itemsize));
+  };
+  if (!std::ranges::equal(header.magic, MAGIC) || (header.version != VERSION) ||
+      (header.byteorder != BYTEORDER) || (header.dimension != dimension) ||
+      (header.stride != stride) || (header.windowsize <= 0) || (header.framesize <= 0) ||
+      (header.nwindows == 0) || (header.nwindows > static_cast<uint64_t>(std::numeric_limits<int>::max())) ||
+      /* every window starts inside of the audio */
+      (((header.nwindows - 1) * static_cast<uint64_t>(stride)) >= header.nsamples) ||
+      !section(header.audiooffset, header.nsamples, sizeof(float)) ||
+      !section(header.scalesoffset, header.nwindows, sizeof(float)) ||
+      !section(header.treeoffset, header.treesize, 1))
+    return {};
+  auto const tree = mapping->data() + header.treeoffset;
+  if (!ANNkd_flat_tree::isValidImage(tree, header.treesize))
+    return {};
+  {
+    ANNkd_flat_tree const check(tree, header.treesize);
+    if ((check.theDim() != dimension) || (static_cast<uint64_t>(check.nPoints()) != header.nwindows))
+      return {};
+  }
+
+  std::shared_ptr<ExemplarCorpus const> corpus(new ExemplarCorpus(path, std::move(mapping)));
+  registry[path] = corpus;
+  return corpus;
+}
+
+bool ExemplarCorpus::write(std::string const & path, std::span<float const> audio,
+                           std::span<float const> scales, std::span<ANNcoord const> coords,
+                           int dimension, int stride, long windowsize, long framesize) {
+
+  auto const nwindows = scales.size();
+  assert(coords.size() == (nwindows * static_cast<size_t>(dimension)));
+  if ((nwindows == 0) || (((nwindows - 1) * static_cast<size_t>(stride)) >= audio.size()))
+    return false;
+
+  /* build the tree, and flatten it so that it can be saved. several
+     windows per leaf lets the flattened tree compare them with SIMD.
+     a whole capture is a big tree, so it's built on every processor */
+  static constexpr int BUCKETSIZE = 8;
+  static constexpr int BUILDTHREADS = 0;
+  std::vector<ANNcoord> treecoords(coords.begin(), coords.end());
+  std::vector<ANNpoint> points(nwindows);
+  for (size_t i = 0; i < nwindows; i++)
+    points[i] = &(treecoords[i * static_cast<size_t>(dimension)]);
+  ANNkd_tree tree(points.data(), static_cast<int>(nwindows), dimension,
+                  BUCKETSIZE, ANN_KD_SUGGEST, BUILDTHREADS);
+  ANNkd_flat_tree const flattree(tree);
+
+  Header header {};
+  std::ranges::copy(MAGIC, header.magic);
+  header.version = VERSION;
+  header.byteorder = BYTEORDER;
+  header.dimension = dimension;
+  header.stride = stride;
+  header.windowsize = static_cast<int32_t>(windowsize);
+  header.framesize = static_cast<int32_t>(framesize);
+  header.nsamples = audio.size();
+  header.nwindows = nwindows;
+  header.audiooffset = align(sizeof(header));
+  header.scalesoffset = align(header.audiooffset + audio.size_bytes());
+  header.treeoffset = align(header.scalesoffset + scales.size_bytes());
+  header.treesize = flattree.theImageSize();
+
+  /* write it beside the destination and then move it into place,
+     since other instances might be reading the file that's there */
+  auto const temppath = path + ".tmp";
+  {
+    std::ofstream out(temppath, std::ios::binary | std::ios::trunc);
+    uint64_t position = 0;
+    auto const put = [&](uint64_t offset, void const * data, size_t size) {
+      static constexpr std::array<char, ALIGNMENT> padding {};
+      assert(offset >= position && (offset - position) <= padding.size());
+      out.write(padding.data(), static_cast<std::streamsize>(offset - position));
+      out.write(static_cast<char const *>(data), static_cast<std::streamsize>(size));
+      position = offset + size;
+    };
+    put(0, &header, sizeof(header));
+    put(header.audiooffset, audio.data(), audio.size_bytes());
+    put(header.scalesoffset, scales.data(), scales.size_bytes());
+    put(header.treeoffset, flattree.theImage(), flattree.theImageSize());
+    out.close();
+    if (!out) {
+      std::error_code ignored;
+      std::filesystem::remove(temppath, ignored);
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temppath, path, error);
+  if (error) {
+    std::filesystem::remove(temppath, error);
+    return false;
+  }
+
+  /* so that opening it from now on gets the new one */
+  std::lock_guard const guard(registrylock);
+  registry.erase(path);
+  return true;
+}
+
+void ExemplarCorpus::prefault() const {
+
+  /* touch every page of what matching reads, so that the audio
+     thread doesn't end up waiting on the disk */
+#ifndef _WIN32
+  madvise(const_cast<std::byte *>(mapping->data()), mapping->size(), MADV_WILLNEED);
+#endif
+  static constexpr size_t PAGESIZE = 4096;
+  auto const base = mapping->data();
+  std::byte touched {};
+  for (size_t offset = 0; offset < mapping->size(); offset += PAGESIZE)
+    touched |= static_cast<std::byte const volatile &>(base[offset]);
+  (void)touched;
+}
@@ -0,0 +1,107 @@
+/*------------------------------------------------------------------------
+Copyright (C) 2026  Tom Murphy 7
+
+This file is part of Exemplar.
+
+Exemplar is free software:  you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+Exemplar is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Exemplar.  If not, see <http://www.gnu.org/licenses/>.
+
+To contact the author, use the contact form at http://destroyfx.org
+
+DFX Exemplar corpus files.
+------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "ANN/ANN.h"
+
+/* A corpus is a capture and its match index, saved in a file that is
+   used in place through a read-only memory mapping. Opening one is
+   instant, no matter how long the capture, and every Exemplar
+   instance in the process that opens the same file shares the same
+   mapping.
+
+   The file is the header below, followed by these sections, each
+   starting at a multiple of 64 bytes:
+
+     audio    nsamples floats
+     scales   nwindows floats, the normalizing boost of each window
+     tree     the flattened kd-tree of the windows' points
+              (ANNkd_flat_tree, which holds the points themselves)
+
+   Window i starts at sample i * stride. The file is in the byte order
+   of the machine that wrote it, and other machines refuse it. */
+class ExemplarCorpus {
+public:
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteorder;
+    int32_t dimension;
+    int32_t stride;
+    /* what the windows were classified with */
+    int32_t windowsize;
+    int32_t framesize;
+    uint64_t nsamples;
+    uint64_t nwindows;
+    uint64_t audiooffset;
+    uint64_t scalesoffset;
+    uint64_t treeoffset;
+    uint64_t treesize;
+  };
+
+  ~ExemplarCorpus();
+  ExemplarCorpus(ExemplarCorpus const &) = delete;
+  ExemplarCorpus & operator=(ExemplarCorpus const &) = delete;
+
+  /* the corpus in the file at path, which is shared with whoever
+     else has it open. Null if it can't be read or isn't a corpus
+     with these dimensions. */
+  static std::shared_ptr<ExemplarCorpus const> open(std::string const & path, int dimension, int stride);
+
+  /* writes a corpus file (replacing any file that's there, but not
+     disturbing anybody who has that one open). The coordinates are
+     dimension per window. Returns false if it couldn't be written. */
+  static bool write(std::string const & path, std::span<float const> audio,
+                    std::span<float const> scales, std::span<ANNcoord const> coords,
+                    int dimension, int stride, long windowsize, long framesize);
+
+  std::string const & getpath() const noexcept { return path; }
+  long windowsize() const noexcept { return header.windowsize; }
+  long framesize() const noexcept { return header.framesize; }
+  std::span<float const> audio() const noexcept { return audiosamples; }
+  std::span<float const> scales() const noexcept { return windowscales; }
+  /* indices of its points are window numbers */
+  ANNkd_flat_tree const & tree() const noexcept { return *flattree; }
+
+  /* reads the whole file in, ahead of anybody needing it */
+  void prefault() const;
+
+private:
+  /* the platform's read-only file mapping */
+  class Mapping;
+
+  ExemplarCorpus(std::string path, std::unique_ptr<Mapping> mapping);
+
+  std::string path;
+  std::unique_ptr<Mapping> mapping;
+  Header header {};
+  std::span<float const> audiosamples;
+  std::span<float const> windowscales;
+  std::unique_ptr<ANNkd_flat_tree> flattree;
+};
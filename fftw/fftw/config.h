@@ -118,6 +118,15 @@
 /* #undef HAVE_MAC_PCI_TIMER */
 #endif
 
+/* Use gettimeofday on Unix (including Mac OS X), since the default
+   clock() timer makes FFTW_MEASURE planning take minutes */
+#if !defined(HAVE_WIN32_TIMER) && !defined(HAVE_MAC_TIMER) && \
+    (defined(__unix__) || defined(__APPLE__))
+#  define HAVE_GETTIMEOFDAY
+#  define HAVE_SYS_TIME_H
+#  define HAVE_UNISTD_H
+#endif
+
 /* define if you have alloca.h: */
 /* #undef HAVE_ALLOCA_H */
 
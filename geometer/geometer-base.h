@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2002-2022  Tom Murphy 7 and Sophia Poirier
+Copyright (C) 2002-2026  Tom Murphy 7 and Sophia Poirier
 
 This file is part of Geometer.
 
@@ -94,11 +94,13 @@ enum : dfx::ParameterID { P_BUFSIZE, P_SHAPE,
                             P_OPPAR2S,
                           P_POINTOP3 = P_OPPAR2S + MAX_OPS,
                             P_OPPAR3S,
-                          NUM_PARAMS = P_OPPAR3S + MAX_OPS
+                          P_BACKGROUND = P_OPPAR3S + MAX_OPS,
+                          NUM_PARAMS
 };
 
 enum : dfx::PropertyID { PROP_LAST_WINDOW_TIMESTAMP = dfx::kPluginProperty_EndOfList,
-                         PROP_WAVEFORM_DATA
+                         PROP_WAVEFORM_DATA,
+                         PROP_BACKGROUND_OVERRUNS
 };
 
 struct GeometerViewData {
@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2002-2024  Tom Murphy 7 and Sophia Poirier
+Copyright (C) 2002-2026  Tom Murphy 7 and Sophia Poirier
 
 This file is part of Geometer.
 
@@ -24,10 +24,8 @@ Featuring the Super Destroy FX Windowing System!
 
 #include "geometer.h"
 
-#if TARGET_OS_MAC
-  #include <Accelerate/Accelerate.h>
-#endif
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -36,12 +34,38 @@ Featuring the Super Destroy FX Windowing System!
 #include <numbers>
 #include <numeric>
 #include <string>
+#include <utility>
 
 #include "dfxmath.h"
 #include "dfxmisc.h"
 
 using namespace std::string_literals;
 
+/* one cycle of a sine wave, with a guard point at the end, for the
+   interpolation styles that draw (co)sine curves. Read with linear
+   interpolation, it's within 3e-7 of the real thing. */
+static constexpr size_t SINE_TABLE_SIZE = 4096;
+using SineTable = std::array<float, SINE_TABLE_SIZE + 1>;
+
+static SineTable const & sinetable() {
+  static SineTable const table = [] {
+    SineTable result {};
+    for (size_t i = 0; i < result.size(); i++) {
+      result[i] = static_cast<float>(std::sin(2.0 * std::numbers::pi * static_cast<double>(i) / static_cast<double>(SINE_TABLE_SIZE)));
+    }
+    return result;
+  }();
+  return table;
+}
+
+/* phase is in cycles, from 0 to 1 */
+static inline float tablesine(SineTable const & table, float phase) {
+  float const position = phase * static_cast<float>(SINE_TABLE_SIZE);
+  int const index = std::min(static_cast<int>(position), static_cast<int>(SINE_TABLE_SIZE) - 1);
+  float const fract = position - static_cast<float>(index);
+  return table[index] + ((table[index + 1] - table[index]) * fract);
+}
+
 /* this macro does boring entry point stuff for us */
 DFX_EFFECT_ENTRY(Geometer)
 DFX_CORE_ENTRY(PLUGINCORE)
@@ -51,6 +75,8 @@ PLUGIN::PLUGIN(TARGET_API_BASE_INSTANCE_TYPE inInstance)
 
   initparameter_list(P_BUFSIZE, {"wsize", "WSiz"}, 9, 9, std::ssize(buffersizes), DfxParam::Unit::Samples);
   initparameter_list(P_SHAPE, {"wshape", "WShp"}, WINDOW_TRIANGLE, WINDOW_TRIANGLE, MAX_WINDOWSHAPES);
+  initparameter_b(P_BACKGROUND, {"background frames", "BkgFrms", "BkgFrm", "Bkgd"}, false);
+  addparameterattributes(P_BACKGROUND, DfxParam::kAttribute_OmitFromRandomizeAll);
 
   initparameter_list(P_POINTSTYLE, {"points where", "PntWher", "PWhere", "PWhr"}, POINT_EXTNCROSS, POINT_EXTNCROSS, MAX_POINTSTYLES);
 
@@ -162,7 +188,7 @@ PLUGIN::PLUGIN(TARGET_API_BASE_INSTANCE_TYPE inInstance)
   for (int i=NUM_OPS; i < MAX_OPS; i++)
     allopstr(i, "unsup");
 
-  addparametergroup("windowing", {P_BUFSIZE, P_SHAPE});
+  addparametergroup("windowing", {P_BUFSIZE, P_SHAPE, P_BACKGROUND});
   auto const addparameterrangegroup = [this](auto name, dfx::ParameterID parameterIndexBegin, dfx::ParameterID parameterIndexEnd) {
     assert(parameterIndexBegin < parameterIndexEnd);
     std::vector<dfx::ParameterID> parameters(parameterIndexEnd - parameterIndexBegin, dfx::kParameterID_Invalid);
@@ -174,13 +200,14 @@ PLUGIN::PLUGIN(TARGET_API_BASE_INSTANCE_TYPE inInstance)
   addparameterrangegroup("interpolation", P_INTERPSTYLE, P_POINTOP1);
   addparameterrangegroup("pointop1", P_POINTOP1, P_POINTOP2);
   addparameterrangegroup("pointop2", P_POINTOP2, P_POINTOP3);
-  addparameterrangegroup("pointop3", P_POINTOP3, NUM_PARAMS);
+  addparameterrangegroup("pointop3", P_POINTOP3, P_BACKGROUND);
 
   setpresetname(0, "Geometer LoFi");	/* default preset name */
   makepresets();
 
   windowcache_reader = &windowcaches.front();
   windowcache_writer = &windowcaches.back();
+  registerSpinLock(windowcachelock);
   tmpx.fill(0);
   tmpy.fill(0.0f);
 }
@@ -206,6 +233,10 @@ dfx::StatusCode PLUGIN::dfx_GetPropertyInfo(dfx::PropertyID inPropertyID, dfx::S
       outDataSize = sizeof(GeometerViewData);
       outFlags = dfx::kPropertyFlag_Readable;
       return dfx::kStatus_NoError;
+    case PROP_BACKGROUND_OVERRUNS:
+      outDataSize = sizeof(uint64_t);
+      outFlags = dfx::kPropertyFlag_Readable;
+      return dfx::kStatus_NoError;
     default:
       return DfxPlugin::dfx_GetPropertyInfo(inPropertyID, inScope, inItemIndex, outDataSize, outFlags);
   }
@@ -224,6 +255,9 @@ dfx::StatusCode PLUGIN::dfx_GetProperty(dfx::PropertyID inPropertyID, dfx::Scope
       dfx::MemCpyObject(*windowcache_reader, outData);
       return dfx::kStatus_NoError;
     }
+    case PROP_BACKGROUND_OVERRUNS:
+      dfx::MemCpyObject(backgroundoverruns.load(std::memory_order_relaxed), outData);
+      return dfx::kStatus_NoError;
     default:
       return DfxPlugin::dfx_GetProperty(inPropertyID, inScope, inItemIndex, outData);
   }
@@ -272,17 +306,17 @@ void PLUGIN::clearwindowcache()
   lastwindowtimestamp.fetch_add(1, std::memory_order_relaxed);
 }
 
-void PLUGIN::updatewindowcache(PLUGINCORE * geometercore)
+void PLUGIN::updatewindowcache(PLUGINCORE * geometercore, float const * input, int framesize)
 {
 #if 1
-  std::copy_n(geometercore->getinput(), GeometerViewData::samples, windowcache_writer->inputs.data());
+  std::copy_n(input, GeometerViewData::samples, windowcache_writer->inputs.data());
 #else
   for (int i=0; i < GeometerViewData::samples; i++) {
     windowcache_writer->inputs[i] = std::sin((i * 10 * std::numbers::pi_v<float>) / GeometerViewData::samples);
   }
 #endif
 
-  windowcache_writer->apts = std::min(geometercore->getframesize(), GeometerViewData::samples);
+  windowcache_writer->apts = std::min(framesize, GeometerViewData::samples);
 
   windowcache_writer->numpts = geometercore->processw(windowcache_writer->inputs.data(), windowcache_writer->outputs.data(),
                                                       windowcache_writer->apts,
@@ -305,15 +339,18 @@ void PLUGIN::updatewindowcache(PLUGINCORE * geometercore)
 
 void PLUGINCORE::clearwindowcache()
 {
-  if (iswaveformsource()) {
+  /* a frame still in flight in the background is using the window
+     cache, and will be refreshing it anyway. Otherwise no frame can
+     start until the next render, which this is serialized with. */
+  if (iswaveformsource() && !backgroundframeinflight()) {
     geometer.clearwindowcache();
   }
 }
 
-void PLUGINCORE::updatewindowcache()
+void PLUGINCORE::updatewindowcache(float const * in, int framesize)
 {
   if (iswaveformsource()) {
-    geometer.updatewindowcache(this);
+    geometer.updatewindowcache(this, in, framesize);
   }
 }
 
@@ -356,13 +393,6 @@ PLUGINCORE::PLUGINCORE(DfxPlugin& inDfxPlugin)
   constexpr auto maxframe = *std::ranges::max_element(PLUGIN::buffersizes);
   static_assert(maxframe >= GeometerViewData::samples);
 
-  /* add some leeway? */
-  in0.assign(maxframe, 0.0f);
-  out0.assign(maxframe * 2, 0.0f);
-
-  /* prevmix is only a single third long */
-  prevmix.assign(maxframe / 2, 0.0f);
-
   /* geometer buffers */
   pointx.assign(maxframe * 2 + 3, 0);
   storex.assign(maxframe * 2 + 3, 0);
@@ -370,7 +400,12 @@ PLUGINCORE::PLUGINCORE(DfxPlugin& inDfxPlugin)
   pointy.assign(maxframe * 2 + 3, 0.0f);
   storey.assign(maxframe * 2 + 3, 0.0f);
 
-  windowenvelope.assign(maxframe, 0.0f);
+  /* build this now rather than during the first frame */
+  sinetable();
+
+  backgroundinput.assign(maxframe, 0.0f);
+  backgroundoutput.assign(maxframe, 0.0f);
+  backgroundthread = std::jthread(&PLUGINCORE::backgroundloop, this);
 
   if (iswaveformsource()) {  // does not matter which DSP core, but this just should happen only once
     auto const delay_samples = dfx::math::ToUnsigned(PLUGIN::buffersizes.at(getparameter_i(P_BUFSIZE)));
@@ -379,6 +414,12 @@ PLUGINCORE::PLUGINCORE(DfxPlugin& inDfxPlugin)
   }
 }
 
+PLUGINCORE::~PLUGINCORE()
+{
+  backgroundstate.store(BackgroundState::Quit, std::memory_order_release);
+  backgroundstate.notify_one();
+}
+
 void PLUGINCORE::reset() {
 
   updatewindowsize();
@@ -390,18 +431,19 @@ void PLUGINCORE::reset() {
 
 void PLUGINCORE::processparameters() {
 
-  pointstyle = getparameter_i(P_POINTSTYLE);
-  pointparam = getparameter_f(P_POINTPARAMS + static_cast<dfx::ParameterID>(pointstyle));
-  interpstyle = getparameter_i(P_INTERPSTYLE);
-  interparam = getparameter_f(P_INTERPARAMS + static_cast<dfx::ParameterID>(interpstyle));
-  pointop1 = getparameter_i(P_POINTOP1);
-  oppar1 = getparameter_f(P_OPPAR1S + static_cast<dfx::ParameterID>(pointop1));
-  pointop2 = getparameter_i(P_POINTOP2);
-  oppar2 = getparameter_f(P_OPPAR2S + static_cast<dfx::ParameterID>(pointop2));
-  pointop3 = getparameter_i(P_POINTOP3);
-  oppar3 = getparameter_f(P_OPPAR3S + static_cast<dfx::ParameterID>(pointop3));
-
-  if (getparameterchanged(P_BUFSIZE)) {
+  auto& settings = nextframesettings;
+  settings.pointstyle = getparameter_i(P_POINTSTYLE);
+  settings.pointparam = getparameter_f(P_POINTPARAMS + static_cast<dfx::ParameterID>(settings.pointstyle));
+  settings.interpstyle = getparameter_i(P_INTERPSTYLE);
+  settings.interparam = getparameter_f(P_INTERPARAMS + static_cast<dfx::ParameterID>(settings.interpstyle));
+  settings.pointop1 = getparameter_i(P_POINTOP1);
+  settings.oppar1 = getparameter_f(P_OPPAR1S + static_cast<dfx::ParameterID>(settings.pointop1));
+  settings.pointop2 = getparameter_i(P_POINTOP2);
+  settings.oppar2 = getparameter_f(P_OPPAR2S + static_cast<dfx::ParameterID>(settings.pointop2));
+  settings.pointop3 = getparameter_i(P_POINTOP3);
+  settings.oppar3 = getparameter_f(P_OPPAR3S + static_cast<dfx::ParameterID>(settings.pointop3));
+
+  if (getparameterchanged(P_BUFSIZE) || getparameterchanged(P_BACKGROUND)) {
     updatewindowsize();
     updatewindowshape();
   }
@@ -613,6 +655,9 @@ int PLUGINCORE::processw(float const * in, float * out, int samples,
                          int * px, float * py, int maxpts,
                          int * tempx, float * tempy) {
 
+  auto const& [pointstyle, pointparam, interpstyle, interparam,
+               pointop1, oppar1, pointop2, oppar2, pointop3, oppar3] = framesettings;
+
   /* collect points. */
 
   px[0] = 0;
@@ -960,8 +1005,7 @@ int PLUGINCORE::processw(float const * in, float * out, int samples,
 
     /* copy last block verbatim. */
     if (numpts > 2)
-      for(int s=px[numpts-2]; s < px[numpts-1]; s++)
-        out[s] = in[s];
+      std::copy(in + px[numpts-2], in + px[numpts-1], out + px[numpts-2]);
 
     /* steady state */
     for(int x = numpts - 2; x > 0; x--) {
@@ -973,36 +1017,25 @@ int PLUGINCORE::processw(float const * in, float * out, int samples,
       int const tgtlen = static_cast<int>(sizeleft + (sizeright * interparam));
 
       if (tgtlen > 0) {
-        /* to avoid using temporary storage, copy from end of target
-           towards beginning, overwriting already used source parts on
-           the way.
-
-           j is an offset from p[x-1], ranging from 0 to tgtlen-1.
-           Once we reach p[x], we have to start mixing with the
-           data that's already there.
+        /* j is an offset from p[x-1], ranging from 0 to tgtlen-1.
+           Once we pass p[x], we have to start mixing with the
+           data that's already there. Every output sample only
+           depends on itself, so each part is a flat loop.
         */
-        for (int j = tgtlen - 1;
-             j >= 0;
-             j--) {
+        float * const dest = out + px[x-1];
+        int const unmixed = std::min(tgtlen, sizeleft + 1);
 
+        /* up to p[x] -- no mix */
+        for (int j = 0; j < unmixed; j++) {
           /* XXX. use interpolated sampling for this */
-          float const wet = in[(int)(px[x-1] + sizeleft *
-                                     (j/(float)tgtlen))];
-
-          if ((j + px[x-1]) > px[x]) {
-            /* after p[x] -- mix */
-
-            /* linear fade-out */
-            float const pct = (j - sizeleft) / (float)(tgtlen - sizeleft);
-
-            out[j + px[x-1]] =
-              wet * (1.0f - pct) +
-              out[j + px[x-1]] * pct;
-          } else {
-            /* before p[x] -- no mix */
-            out[j + px[x-1]] = wet;
-          }
+          dest[j] = in[(int)(px[x-1] + sizeleft * (j/(float)tgtlen))];
+        }
 
+        /* after p[x] -- mix, with a linear fade-out */
+        for (int j = unmixed; j < tgtlen; j++) {
+          float const wet = in[(int)(px[x-1] + sizeleft * (j/(float)tgtlen))];
+          float const pct = (j - sizeleft) / (float)(tgtlen - sizeleft);
+          dest[j] = wet * (1.0f - pct) + dest[j] * pct;
         }
       }
     }
@@ -1016,12 +1049,14 @@ int PLUGINCORE::processw(float const * in, float * out, int samples,
     */
 
     for(int u=1; u < numpts; u++) {
-      float const denom = (px[u] - px[u-1]);
+      /* the line is folded into a start and a slope per segment */
+      int const length = px[u] - px[u-1];
       float const minterparam = interparam * (py[u-1] + py[u]) * 0.5f;
-      for(int z=px[u-1]; z < px[u]; z++) {
-        float const pct = (float)(z-px[u-1]) / denom;
-        float const s = py[u-1] * (1.0f - pct) + py[u] * pct;
-        out[z] = minterparam + (1.0f - interparam) * s;
+      float const start = minterparam + (1.0f - interparam) * py[u-1];
+      float const slope = (1.0f - interparam) * (py[u] - py[u-1]) / (float)length;
+      float * const segout = out + px[u-1];
+      for(int k=0; k < length; k++) {
+        segout[k] = start + slope * (float)k;
       }
     }
 
@@ -1036,12 +1071,13 @@ int PLUGINCORE::processw(float const * in, float * out, int samples,
     */
 
     for(int u=1; u < numpts; u++) {
-      float const denom = (px[u] - px[u-1]);
+      int const length = px[u] - px[u-1];
       float const minterparam = interparam * (py[u-1] + py[u]) * 0.5f;
-      for(int z=px[u-1]; z < px[u]; z++) {
-        float const pct = (float)(z-px[u-1]) / denom;
-        float const s = py[u-1] * pct + py[u] * (1.0f - pct);
-        out[z] = minterparam + (1.0f - interparam) * s;
+      float const start = minterparam + (1.0f - interparam) * py[u];
+      float const slope = (1.0f - interparam) * (py[u-1] - py[u]) / (float)length;
+      float * const segout = out + px[u-1];
+      for(int k=0; k < length; k++) {
+        segout[k] = start + slope * (float)k;
       }
     }
 
@@ -1050,42 +1086,47 @@ int PLUGINCORE::processw(float const * in, float * out, int samples,
     break;
 
 
-  case INTERP_SMOOTHIE:
-    /* cosine up or down - "smoothie" */
-
-    for(int u=1; u < numpts; u++) {
-      float const denom = (px[u] - px[u-1]);
-      for(int z=px[u-1]; z < px[u]; z++) {
-        float const pct = (float)(z-px[u-1]) / denom;
-
-        float p = 0.5f * (-std::cos(std::numbers::pi_v<float> * pct) + 1.0f);
+  case INTERP_SMOOTHIE: {
+    /* cosine up or down - "smoothie"
 
-        if (interparam > 0.5f) {
-          p = std::pow(p, (interparam - 0.16666667f) * 3.0f);
-        } else {
-          p = std::pow(p, interparam * 2.0f);
-        }
+       the raised cosine 0.5 * (1 - cos(pi * pct)) is the same as
+       sin(pi/2 * pct) squared, so the curve raised to the exponent
+       is exp(2 * exponent * log(sin(pi/2 * pct))), from the sine
+       table and without any calls to pow. That stays within 2e-6
+       of the exact curve, which is closer than single precision
+       cos and pow get near the start of each segment. */
 
-        float const s = py[u-1] * (1.0f - p) + py[u] * p;
+    float const exponent = (interparam > 0.5f) ?
+      ((interparam - 0.16666667f) * 3.0f) : (interparam * 2.0f);
+    double const twoexponent = 2.0 * exponent;
+    /* what pow(0, exponent) gives at the start of each segment */
+    float const zeropower = (exponent > 0.0f) ? 0.0f : 1.0f;
+    auto const & table = sinetable();
 
-        out[z] = s;
+    for(int u=1; u < numpts; u++) {
+      int const length = px[u] - px[u-1];
+      float const oodenom = 1.0f / (float)length;
+      float * const segout = out + px[u-1];
+      for(int k=0; k < length; k++) {
+        float const sine = tablesine(table, 0.25f * ((float)k * oodenom));
+        float const p = (sine > 0.0f) ?
+          (float)dfx::math::FastExp(twoexponent * dfx::math::FastLog(sine)) : zeropower;
+
+        segout[k] = py[u-1] * (1.0f - p) + py[u] * p;
       }
     }
 
     out[samples-1] = in[samples-1];
 
     break;
-
+  }
 
   case INTERP_REVERSI:
     /* x-reverse input samples for each waveform - "reversi" */
 
     for(int u=1; u < numpts; u++) {
       if (px[u-1] < px[u])
-        for(int z = px[u-1]; z < px[u]; z++) {
-          int const s = (px[u] - (z + 1)) + px[u - 1];
-          out[z] = in[dfx::math::ToIndex(s)];
-        }
+        std::reverse_copy(in + px[u-1], in + px[u], out + px[u-1]);
     }
 
     break;
@@ -1095,26 +1136,30 @@ int PLUGINCORE::processw(float const * in, float * out, int samples,
 
     int const wid = (int)(100.0f * interparam);
 
-    for(int i = 0; i < samples; i++) out[i] = 0.0f;
+    std::fill_n(out, samples, 0.0f);
 
     for(int z = 0; z < numpts; z++) {
       out[px[z]] = dfx::math::MagnitudeMax(out[px[z]], py[z]);
 
       if (wid > 0) {
         /* put w samples on the left, stopping if we hit a sample
-           greater than what we're placing */
-        int w = wid;
+           greater than what we're placing.
+           w counts down from wid as k counts up from 0, and the
+           trip counts are worked out beforehand so that the loops
+           have no early exits. */
         float const onedivwid = 1.0f / (float)(wid + 1);
-        for(int i=px[z]-1; i >= 0 && w > 0; i--, w--) {
-          float sam = py[z] * (w * onedivwid);
-          if ((out[i] + sam) * (out[i] + sam) > (sam * sam)) out[i] = sam;
-          else out[i] += sam;
+        int const left = std::min(wid, px[z]);
+        float * const before = out + px[z] - 1;
+        for(int k = 0; k < left; k++) {
+          float const sam = py[z] * ((wid - k) * onedivwid);
+          float const sum = before[-k] + sam;
+          before[-k] = (sum * sum > (sam * sam)) ? sam : sum;
         }
 
-        w = wid;
-        for(int ii=px[z]+1; ii < samples && w > 0; ii++, w--) {
-          float const sam = py[z] * (w * onedivwid);
-          out[ii] = sam;
+        int const right = std::min(wid, samples - 1 - px[z]);
+        float * const after = out + px[z] + 1;
+        for(int k = 0; k < right; k++) {
+          after[k] = py[z] * ((wid - k) * onedivwid);
         }
       }
     }
@@ -1122,19 +1167,22 @@ int PLUGINCORE::processw(float const * in, float * out, int samples,
     break;
 
   }
-  case INTERP_SING:
-
-    for(int u=1; u < numpts; u++) {
-      float const oodenom = 1.0f / (px[u] - px[u-1]);
+  case INTERP_SING: {
 
-      for(int z=px[u-1]; z < px[u]; z++) {
-        float const pct = (float)(z-px[u-1]) * oodenom;
+    auto const & table = sinetable();
 
-        float const wand = sinf(2.0f * std::numbers::pi_v<float> * pct);
-        out[z] = wand *
+    for(int u=1; u < numpts; u++) {
+      int const length = px[u] - px[u-1];
+      float const oodenom = 1.0f / (float)length;
+      float const * const segin = in + px[u-1];
+      float * const segout = out + px[u-1];
+
+      for(int k=0; k < length; k++) {
+        float const wand = tablesine(table, (float)k * oodenom);
+        segout[k] = wand *
           interparam +
           ((1.0f-interparam) *
-           in[z] *
+           segin[k] *
            wand);
       }
     }
@@ -1143,10 +1191,11 @@ int PLUGINCORE::processw(float const * in, float * out, int samples,
 
 
     break;
+  }
   default:
 
     /* unsupported ... ! */
-    for(int i = 0; i < samples; i++) out[i] = 0.0f;
+    std::fill_n(out, samples, 0.0f);
 
     break;
 
@@ -1156,153 +1205,120 @@ int PLUGINCORE::processw(float const * in, float * out, int samples,
 }
 
 
-/* this fake process function reads samples one at a time
-   from the true input. It simultaneously copies samples from
-   the beginning of the output buffer to the true output.
-   We maintain that out0 always has at least 'third' samples
-   in it; this is enough to pick up for the delay of input
-   processing and to make sure we always have enough samples
-   to fill the true output buffer.
-
-   If the input frame is full:
-    - calls processw on this full input frame
-    - applies the windowing envelope to the tail of out0 (output frame)
-    - mixes in prevmix with the first half of the output frame
-    - increases outsize so that the first half of the output frame is
-      now available output
-    - copies the second half of the output to be prevmix for next frame.
-    - copies the second half of the input buffer to the first,
-      resets the size (thus we process each third-size chunk twice)
-
-  If we have read more than 'third' samples out of the out0 buffer:
-   - Slide contents to beginning of buffer
-   - Reset outstart
-
-*/
+/* the windowing engine gathers overlapping frames of the true input,
+   hands each one to processw, applies the windowing envelope to the
+   result, and mixes it into the overlapping tail of the previous
+   frame. The output is delayed by one frame (framesize samples), or
+   by one more hop when the frames are processed in the background.
 
-/* to improve:
-   - can we use tail of out0 as prevmix, instead of copying?
-   - can we use circular buffers instead of memmoving a lot?
-     (probably not)
 XXX Sophia's ideas:
-   - we only need one cache for the plugin (could be shared across DSP cores)
+   - we only need one window envelope for the plugin (could be shared across DSP cores)
    - possibly we only need to save half since the second half is always the first half reversed
-   - it would also be nice to make this windowing stuff into a reusable class so that we don't find ourselves maintaining the same code accross so many different plugins
 */
 
 void PLUGINCORE::process(std::span<float const> tin, std::span<float> tout) {
-  for (size_t ii = 0; ii < tout.size(); ii++) {
+  windowing.process(tin, tout, [this](float const * in, float * out, size_t samples) {
+    auto const framesize = static_cast<int>(samples);
+    if (background) {
+      exchangebackgroundframe(in, out, framesize);
+    } else if (backgroundframeinflight()) {
+      /* background frames were just switched off, but the last one
+         is still using the frame buffers */
+      std::fill_n(out, framesize, 0.0f);
+      geometer.countbackgroundoverrun();
+    } else {
+      framesettings = nextframesettings;
+      processframe(in, out, framesize);
+    }
+  });
+}
 
-    /* copy sample in */
-    in0[insize] = tin[ii];
-    insize++;
 
-    if (insize == framesize) {
-      /* frame is full! */
+void PLUGINCORE::processframe(float const * in, float * out, int framesize) {
+  processw(in, out, framesize,
+           pointx.data(), pointy.data(), framesize * 2,
+           storex.data(), storey.data());
+  updatewindowcache(in, framesize);
+}
 
-      /* in0 -> process -> out0(first free space) */
-      processw(in0.data(), out0.data()+outstart+outsize, framesize,
-               pointx.data(), pointy.data(), framesize * 2,
-               storex.data(), storey.data());
-      updatewindowcache();
 
-#if TARGET_OS_MAC
-      vDSP_vmul(out0.data()+outstart+outsize, 1, windowenvelope.data(), 1, out0.data()+outstart+outsize, 1, static_cast<vDSP_Length>(framesize));
-#else
-      // TODO: vector-optimize?
-      for (int z=0; z < framesize; z++) {
-        out0[z+outstart+outsize] *= windowenvelope[z];
-      }
-#endif
+void PLUGINCORE::exchangebackgroundframe(float const * in, float * out, int framesize) {
+  /* the previous frame has had a whole hop to finish. If it still
+     hasn't, this frame is skipped and the late one is collected at
+     the next hop instead. */
+  if (backgroundframeinflight()) {
+    std::fill_n(out, framesize, 0.0f);
+    geometer.countbackgroundoverrun();
+    return;
+  }
 
-      /* mix in prevmix */
-      for(int u = 0; u < third; u++)
-        out0[u+outstart+outsize] += prevmix[u];
+  if (std::exchange(discardbackgroundframe, false)) {
+    std::fill_n(out, framesize, 0.0f);
+  } else {
+    std::copy_n(backgroundoutput.cbegin(), framesize, out);
+  }
+  std::copy_n(in, framesize, backgroundinput.begin());
+  backgroundframesize = framesize;
+  framesettings = nextframesettings;
 
-      /* prevmix becomes out1 */
-      std::copy_n(std::next(out0.cbegin(), outstart + outsize + third), third, prevmix.begin());
+  backgroundstate.store(BackgroundState::Pending, std::memory_order_release);
+  backgroundstate.notify_one();
+}
 
-      /* copy 2nd third of input over in0 (need to re-use it for next frame),
-         now insize = third */
-      std::copy_n(std::next(in0.cbegin(), third), third, in0.begin());
 
-      insize = third;
+void PLUGINCORE::backgroundloop() {
+  /* the audio thread relies upon each frame being done within a hop */
+  dfx::PromoteCurrentThreadToRealtime();
 
-      outsize += third;
+  while (true) {
+    backgroundstate.wait(BackgroundState::Idle, std::memory_order_acquire);
+    if (backgroundstate.load(std::memory_order_acquire) == BackgroundState::Quit) {
+      return;
     }
 
-    /* send sample out */
-    tout[ii] = out0[outstart];
+    processframe(backgroundinput.data(), backgroundoutput.data(), backgroundframesize);
 
-    outstart++;
-    outsize--;
-
-    /* make sure there is always enough room for a frame in out buffer */
-    if (outstart == third) {
-      memmove(out0.data(), out0.data() + outstart, outsize * sizeof (out0.front()));
-      outstart = 0;
-    }
+    /* (unless told to quit in the meantime) */
+    auto expected = BackgroundState::Pending;
+    backgroundstate.compare_exchange_strong(expected, BackgroundState::Idle, std::memory_order_acq_rel);
   }
 }
 
 
 void PLUGINCORE::updatewindowsize()
 {
-  framesize = PLUGIN::buffersizes.at(getparameter_i(P_BUFSIZE));
-  third = framesize / 2;
-  bufsize = third * 3;
-
-  /* set up buffers. prevmix and first frame of output are always
-     filled with zeros. */
-
-  std::ranges::fill(prevmix, 0.f);
-
-  std::ranges::fill(out0, 0.f);
+  auto const framesize = PLUGIN::buffersizes.at(getparameter_i(P_BUFSIZE));
+  background = getparameter_b(P_BACKGROUND) && (framesize >= BACKGROUND_MIN_FRAMESIZE);
+  /* the first frame collected from the background is silence (and
+     any frame still in flight is not waited for, but dropped) */
+  discardbackgroundframe = true;
 
   /* start input at beginning. Output has a frame of silence. */
-  insize = 0;
-  outstart = 0;
-  outsize = framesize;
+  windowing.setFrameSize(dfx::math::ToUnsigned(framesize));
 
-  getplugin().setlatency_samples(dfx::math::ToUnsigned(framesize));
+  auto const latency = windowing.getLatency() + (background ? windowing.getHopSize() : 0);
+  getplugin().setlatency_samples(latency);
   /* tail is the same as delay, of course */
-  getplugin().settailsize_samples(dfx::math::ToUnsigned(framesize));
+  getplugin().settailsize_samples(latency);
 }
 
 
 void PLUGINCORE::updatewindowshape()
 {
-  shape = getparameter_i(P_SHAPE);
-
-  float const oneDivThird = 1.0f / static_cast<float>(third);
-  switch(shape) {
+  using WindowShape = decltype(windowing)::WindowShape;
+  switch(getparameter_i(P_SHAPE)) {
     case WINDOW_TRIANGLE:
-      for(int z = 0; z < third; z++) {
-        windowenvelope[z] = (static_cast<float>(z) * oneDivThird);
-        windowenvelope[z+third] = (1.0f - (static_cast<float>(z) * oneDivThird));
-      }
+    default:
+      windowing.setWindowShape(WindowShape::Triangle);
       break;
     case WINDOW_ARROW:
-      for(int z = 0; z < third; z++) {
-        float p = static_cast<float>(z) * oneDivThird;
-        p *= p;
-        windowenvelope[z] = p;
-        windowenvelope[z+third] = (1.0f - p);
-      }
+      windowing.setWindowShape(WindowShape::Arrow);
       break;
     case WINDOW_WEDGE:
-      for(int z = 0; z < third; z++) {
-        float const p = std::sqrt(static_cast<float>(z) * oneDivThird);
-        windowenvelope[z] = p;
-        windowenvelope[z+third] = (1.0f - p);
-      }
+      windowing.setWindowShape(WindowShape::Wedge);
       break;
     case WINDOW_COS:
-      for(int z = 0; z < third; z++) {
-        float const p = 0.5f * (-std::cos(std::numbers::pi_v<float> * (static_cast<float>(z) * oneDivThird)) + 1.0f);
-        windowenvelope[z] = p;
-        windowenvelope[z+third] = (1.0f - p);
-      }
+      windowing.setWindowShape(WindowShape::Cosine);
       break;
   }
 }
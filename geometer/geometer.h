@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2002-2024  Tom Murphy 7 and Sophia Poirier
+Copyright (C) 2002-2026  Tom Murphy 7 and Sophia Poirier
 
 This file is part of Geometer.
 
@@ -23,13 +23,17 @@ Geometer, starring the Super Destroy FX Windowing System!
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <thread>
 #include <vector>
 
 #include "dfxmath.h"
 #include "dfxmisc.h"
 #include "dfxmutex.h"
 #include "dfxplugin.h"
+#include "dfxwindowing.h"
 #include "geometer-base.h"
 
 /* change these for your plugins */
@@ -56,7 +60,12 @@ public:
   void randomizeparameter(dfx::ParameterID inParameterID) override;
 
   void clearwindowcache();
-  void updatewindowcache(class PLUGINCORE * geometercore);
+  void updatewindowcache(class PLUGINCORE * geometercore, float const * input, int framesize);
+
+  /* counts background frames that were not ready in time */
+  void countbackgroundoverrun() {
+    backgroundoverruns.fetch_add(1, std::memory_order_relaxed);
+  }
 
 protected:
   std::optional<dfx::ParameterAssignment> settings_getLearningAssignData(dfx::ParameterID inParameterID) const override;
@@ -69,18 +78,23 @@ private:
 
   std::array<GeometerViewData, 2> windowcaches;
   /* access via reader is protected by a lock */
-  /* access via writer is always on or serialized with the audio render thread */
+  /* access via writer is only by the waveform source DSP core's frames, which
+     are processed either on the audio render thread or, for background frames,
+     on that core's background thread, but never on both at once (see
+     PLUGINCORE::clearwindowcache and PLUGINCORE::process) */
   GeometerViewData* windowcache_reader = nullptr, * windowcache_writer = nullptr;
   /* passed to processw for window cache */
   std::array<int, GeometerViewData::arraysize> tmpx {};
   std::array<float, GeometerViewData::arraysize> tmpy {};
   dfx::SpinLock windowcachelock;
   dfx::LockFreeAtomic<uint64_t> lastwindowtimestamp {0};
+  dfx::LockFreeAtomic<uint64_t> backgroundoverruns {0};
 };
 
 class PLUGINCORE final : public DfxPluginCore {
 public:
   explicit PLUGINCORE(DfxPlugin& inDfxPlugin);
+  ~PLUGINCORE() override;
 
   void reset() override;
   void processparameters() override;
@@ -91,41 +105,26 @@ public:
                int * px, float * py, int maxpts,
                int * tx, float * ty);
 
-  int getframesize() const noexcept { return framesize; }
-  float const* getinput() const noexcept { return in0.data(); }
+  /* at these window sizes, the background frames option can take
+     the frame work off of the audio thread */
+  static constexpr int BACKGROUND_MIN_FRAMESIZE = 16384;
 
 private:
 
   void updatewindowsize();
   void updatewindowshape();
 
+  /* processw plus the window cache, for one frame */
+  void processframe(float const * in, float * out, int framesize);
+
   bool iswaveformsource() { return (GetChannelNum() == 0); }
   void clearwindowcache();
-  void updatewindowcache();
+  void updatewindowcache(float const * in, int framesize);
 
   PLUGIN& geometer;
 
-  /* input and output buffers. out is framesize*2 samples long, in is framesize
-     samples long. (for maximum framesize)
-  */
-  std::vector<float> in0, out0;
-
-  /* buffersize is 3 * third, framesize is 2 * third
-     buffersize is used for outbuf.
-  */
-  int bufsize = 0, framesize = 0, third = 0;
-
-  /* third-sized tail of previous processed frame. already has mixing envelope
-     applied.
-  */
-  std::vector<float> prevmix;
-
-  /* number of samples in in0 */
-  int insize = 0;
-
-  /* number of samples and starting position of valid samples in out0 */
-  int outsize = 0;
-  int outstart = 0;
+  /* frames the input, applies the envelope, and overlaps the output */
+  dfx::OverlapAdd<float> windowing {static_cast<size_t>(*std::ranges::max_element(PLUGIN::buffersizes))};
 
   /* ---------- geometer stuff ----------- */
 
@@ -133,22 +132,25 @@ private:
                       int * px, float * py, int maxpts,
                       int * tempx, float * tempy);
 
-  /* shape of envelope */
-  long shape {};
-
-  long pointstyle {};
-  float pointparam = 0.0f;
-
-  long interpstyle {};
-  float interparam = 0.0f;
-
-  long pointop1 {};
-  long pointop2 {};
-  long pointop3 {};
-
-  float oppar1 = 0.0f;
-  float oppar2 = 0.0f;
-  float oppar3 = 0.0f;
+  /* the parameter values that processw works with. processparameters
+     fills in nextframesettings, which is copied to framesettings each
+     time a frame is started, so that a frame being processed in the
+     background never sees settings change underneath it. */
+  struct FrameSettings {
+    long pointstyle {};
+    float pointparam = 0.0f;
+
+    long interpstyle {};
+    float interparam = 0.0f;
+
+    long pointop1 {};
+    float oppar1 = 0.0f;
+    long pointop2 {};
+    float oppar2 = 0.0f;
+    long pointop3 {};
+    float oppar3 = 0.0f;
+  };
+  FrameSettings framesettings, nextframesettings;
 
   std::vector<int> pointx;
   std::vector<float> pointy;
@@ -156,7 +158,31 @@ private:
   std::vector<int> storex;
   std::vector<float> storey;
 
-  std::vector<float> windowenvelope;
-
   dfx::math::RandomEngine randomengine {dfx::math::RandomSeed::Entropic};
+
+  /* ---------- background frames ----------- */
+
+  /* Instead of processing each frame as soon as it is full, hand it
+     to the background thread and use the one that was handed over a
+     hop earlier. The work then happens between audio callbacks, at
+     the cost of one more hop of latency. The audio thread never
+     waits for the background thread: a frame that is not ready in
+     time is an overrun, and that hop's output is silent instead. */
+  bool background = false;
+  void exchangebackgroundframe(float const * in, float * out, int framesize);
+  bool backgroundframeinflight() const {
+    return backgroundstate.load(std::memory_order_acquire) == BackgroundState::Pending;
+  }
+  void backgroundloop();
+
+  enum class BackgroundState { Idle, Pending, Quit };
+  std::atomic<BackgroundState> backgroundstate {BackgroundState::Idle};
+  std::vector<float> backgroundinput, backgroundoutput;
+  int backgroundframesize = 0;
+  /* the frame in flight was started before the frame size changed,
+     so its output is dropped rather than used */
+  bool discardbackgroundframe = true;
+  /* started with the DSP core, off of the audio thread. Declared
+     last so that it stops before anything it uses goes away */
+  std::jthread backgroundthread;
 };
@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2001-2024  Sophia Poirier
+Copyright (C) 2001-2026  Sophia Poirier
 
 This file is part of Rez Synth.
 
@@ -23,14 +23,38 @@ To contact the author, use the contact form at http://destroyfx.org
 
 
 #include <array>
+#include <cstdint>
+#include <memory>
 #include <span>
 #include <vector>
 
+#include "dfxmutex.h"
 #include "dfxplugin.h"
 #include "dfxsmoothedvalue.h"
 #include "iirfilter.h"
 
 
+// define this as 0 to run the resonator bank in single precision, which doubles its 
+// SIMD throughput but loses accuracy with very narrow bandwidths at low frequencies
+#ifndef REZSYNTH_DOUBLE_PRECISION_RESONATORS
+	#define REZSYNTH_DOUBLE_PRECISION_RESONATORS	1
+#endif
+
+// the maximum number of simultaneously sounding notes (beyond this, new notes take the voices of 
+// notes that have been releasing or sounding the longest, which then go silent)
+#ifndef REZSYNTH_POLYPHONY
+	#define REZSYNTH_POLYPHONY	32
+#endif
+
+// define this as 1 to spread large chords across a pool of realtime worker threads 
+// (up to kMaxRenderWorkers per plugin instance), rather than always rendering voices 
+// one after another on the audio thread; it is off by default because every instance 
+// would then hold its own threads, competing with those of the host and other plugins
+#ifndef REZSYNTH_PARALLEL_VOICE_RENDERING
+	#define REZSYNTH_PARALLEL_VOICE_RENDERING	0
+#endif
+
+
 //-----------------------------------------------------------------------------
 // enums
 
@@ -144,22 +168,103 @@ private:
 		FadeOut
 	};
 
-	using ChannelsOfNotesOfBands = std::vector<std::array<std::array<double, kMaxBands>, DfxMidi::kNumNotesWithLegatoVoice>>;
-	static void clearChannelsOfNotesOfBands(ChannelsOfNotesOfBands& channelsOfNotesOfBands);
+#if REZSYNTH_DOUBLE_PRECISION_RESONATORS
+	using ResonatorValue = double;
+#else
+	using ResonatorValue = float;
+#endif
+	// The resonator bank processes bands in parallel SIMD lanes, so per-band values 
+	// are stored contiguously, aligned for the widest vectors, and padded to a whole 
+	// number of lane groups (the padding bands get zero coefficients and stay silent).
+	static constexpr size_t kResonatorAlignment = 64;
+	static constexpr size_t kBandLaneGroupSize = kResonatorAlignment / sizeof(ResonatorValue);
+	static constexpr size_t kNumBandLanes = ((static_cast<size_t>(kMaxBands) + kBandLaneGroupSize - 1) / kBandLaneGroupSize) * kBandLaneGroupSize;
+	struct alignas(kResonatorAlignment) BandValues : public std::array<ResonatorValue, kNumBandLanes> {};
+	static constexpr size_t getNumBandLanes(int numBands) noexcept
+	{
+		return ((static_cast<size_t>(numBands) + kBandLaneGroupSize - 1) / kBandLaneGroupSize) * kBandLaneGroupSize;
+	}
+
+	struct ResonatorCoefficients
+	{
+		// zero the coefficients of unused bands so that they produce silence when processed in SIMD lanes
+		void silenceBands(int bandIndexBegin);
+
+		BandValues mInputAmp {};  // gains for the current sample input, for each band
+		BandValues mPrevOutCoeff {};  // coefficients for the 1-sample delayed ouput, for each band
+		BandValues mPrevPrevOutCoeff {};  // coefficients for the 2-sample delayed ouput, for each band
+		BandValues mPrevPrevInCoeff {};  // coefficients for the 2-sample delayed input, for each band
+	};
+
+	// Per-note state lives in a pool of voices that are bound to notes only while they sound, 
+	// so memory, and the work of clearing it, scale with the polyphony rather than the MIDI note range.
+	struct Voice
+	{
+		static constexpr int kNoNote = -1;
+
+		// the resonator feedback state for one audio channel, all adjacent in memory
+		struct ChannelState
+		{
+			BandValues mPrevOutValue {}, mPrevPrevOutValue {};  // previous resonator output values, for each band
+			ResonatorValue mPrevInValue {}, mPrevPrevInValue {};  // previous audio input values
+		};
+
+		bool isLive() const noexcept
+		{
+			return mNote != kNoNote;
+		}
+		void clearFilterOutputForBands(int bandIndexBegin);
+		void clear();
+
+		int mNote = kNoNote;
+		uint64_t mAcquisitionOrder = 0;  // when it was bound to its note, relative to other voices
+		dfx::SmoothedValue<double> mAmpEvener;
+		dfx::SmoothedValue<double> mBaseFreq;
+		std::array<dfx::SmoothedValue<double>, kMaxBands> mBandCenterFreq;
+		std::array<dfx::SmoothedValue<double>, kMaxBands> mBandBandwidth;
+		ResonatorCoefficients mCoefficients;
+		std::vector<ChannelState> mChannels;
+		std::vector<dfx::IIRFilter> mLowpassGateFilters;
+	};
+	static constexpr size_t kPolyphony = REZSYNTH_POLYPHONY;
+	static_assert(kPolyphony > 0);
+
+	// Voices only interact when summed into the output, so with enough of them sounding, 
+	// they are divided among worker threads, each summing into its own scratch output.
+	static constexpr size_t kMaxRenderWorkers = 3;  // in addition to the audio thread
+	static constexpr size_t kMinVoicesForParallelRendering = 3;
+	struct VoiceRenderScratch
+	{
+		std::vector<float> mBuffer;  // every channel, each one the maximum block size
+		std::vector<float*> mChannels;
+		bool mUsed = false;
+	};
+
+	Voice& acquireVoice(int note);
+	Voice& stealVoice();
+	void releaseVoice(int note);
 	void clearFilterOutputForBands(int bandIndexBegin);
 	void clearLowpassGateFilters();
 
 	double calculateAmpEvener(int currentNote) const;
-	[[nodiscard]] int calculateCoefficients(int currentNote);
+	[[nodiscard]] int calculateCoefficients(int currentNote, Voice& voice) const;
+	void renderVoices(std::span<float const* const> inAudio, std::span<float* const> outAudio,
+					  size_t sampleFrameOffset, size_t sampleFrames, std::span<Voice* const> voices);
+	void renderVoice(std::span<float const* const> inAudio, std::span<float* const> outAudio,
+					 size_t sampleFrameOffset, size_t sampleFrames, Voice& voice);
 	void processFilterOuts(std::span<float const* const> inAudio, std::span<float* const> outAudio,
 						   size_t sampleFrameOffset, size_t sampleFrames,
-						   int currentNote, int numBands);
+						   Voice& voice, int numBands,
+						   dfx::SmoothedValue<float>& outputGain, dfx::SmoothedValue<float>& wetGain);
+	static ResonatorValue processResonatorBank(ResonatorValue input, size_t numBandLanes,
+											   ResonatorCoefficients const& coefficients, Voice::ChannelState& state);
 	void processUnaffected(std::span<float const> inAudio, std::span<float> outAudio);
 	double getBandwidthForFreq(double inFreq) const;
 	void checkForNewNote(size_t currentEvent);
 
 	// parameters
 	double mBandwidthAmount_Hz = 1.0, mBandwidthAmount_Q = 1.0, mSepAmount_Octaval = 0.0, mSepAmount_Linear = 0.0;
+	std::array<double, kMaxBands> mOctavalBandRatios {};  // the frequency ratio of each band to the base, for octaval separation
 	float mAttack_Seconds = 0.0f, mDecay_Seconds = 0.0f, mSustain = 0.0f, mRelease_Seconds = 0.0f;
 	float mVelocityCurve = 0.0f, mVelocityInfluence = 0.0f;
 	dfx::SmoothedValue<float> mOutputGain;
@@ -168,23 +273,16 @@ private:
 	int mBandwidthMode {}, mNumBands = 1, mSepMode {}, mScaleMode {}, mResonAlgorithm {}, mDryWetMixMode {};
 	DfxEnvelope::CurveType mFadeType {};
 	bool mFoldover = false, mWiseAmp = false;
-	std::array<dfx::SmoothedValue<double>, DfxMidi::kNumNotesWithLegatoVoice> mAmpEvener;
 
-	std::array<std::vector<dfx::IIRFilter>, DfxMidi::kNumNotesWithLegatoVoice> mLowpassGateFilters;
-
-	std::array<dfx::SmoothedValue<double>, DfxMidi::kNumNotesWithLegatoVoice> mBaseFreq;
-	std::array<std::array<dfx::SmoothedValue<double>, kMaxBands>, DfxMidi::kNumNotesWithLegatoVoice> mBandCenterFreq;
-	std::array<std::array<dfx::SmoothedValue<double>, kMaxBands>, DfxMidi::kNumNotesWithLegatoVoice> mBandBandwidth;
-	std::array<bool, DfxMidi::kNumNotesWithLegatoVoice> mNoteActiveLastRender {};
+	std::array<Voice, kPolyphony> mVoices;
+	std::array<Voice*, DfxMidi::kNumNotesWithLegatoVoice> mNoteVoices {};  // the voice bound to each note, if any
+	std::array<bool, DfxMidi::kNumNotesWithLegatoVoice> mNoteVoiceStolen {};  // whether each note lost its voice to another
+	uint64_t mVoiceAcquisitionCount = 0;
+	std::array<Voice*, kPolyphony> mVoicesToRender {};
+	std::unique_ptr<dfx::RealtimeWorkerPool> mRenderWorkers;
+	std::vector<VoiceRenderScratch> mVoiceRenderScratch;  // one for each render worker participant
 	size_t mFreqSmoothingStride = 1;
 
-	std::array<double, kMaxBands> mInputAmp {};  // gains for the current sample input, for each band
-	std::array<double, kMaxBands> mPrevOutCoeff {};  // coefficients for the 1-sample delayed ouput, for each band
-	std::array<double, kMaxBands> mPrevPrevOutCoeff {};  // coefficients for the 2-sample delayed ouput, for each band
-	std::array<double, kMaxBands> mPrevPrevInCoeff {};  // coefficients for the 2-sample delayed input, for each band
-	ChannelsOfNotesOfBands mPrevOutValue, mPrevPrevOutValue;  // arrays of previous resonator output values
-	std::vector<std::array<double, DfxMidi::kNumNotesWithLegatoVoice>> mPrevInValue, mPrevPrevInValue;  // arrays of previous audio input values
-
 	double mPiDivSR = 0.0, mTwoPiDivSR = 0.0, mNyquist = 0.0;  // values that are needed when calculating coefficients
 
 	UnaffectedState mUnaffectedState = UnaffectedState::FadeIn;
@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2001-2024  Sophia Poirier
+Copyright (C) 2001-2026  Sophia Poirier
 
 This file is part of Rez Synth.
 
@@ -22,7 +22,11 @@ To contact the author, use the contact form at http://destroyfx.org
 #include "rezsynth.h"
 
 #include <algorithm>
+#include <cmath>
 #include <numbers>
+#include <thread>
+#include <tuple>
+#include <utility>
 
 #include "dfxmath.h"
 #include "dfxmisc.h"
@@ -98,24 +102,13 @@ RezSynth::RezSynth(TARGET_API_BASE_INSTANCE_TYPE inInstance)
 	registerSmoothedAudioValue(mBetweenGain);
 	registerSmoothedAudioValue(mDryGain);
 	registerSmoothedAudioValue(mWetGain);
-	std::ranges::for_each(mAmpEvener, [this](auto& value){ registerSmoothedAudioValue(value); });
 
-	for (size_t noteIndex = 0; noteIndex < mBaseFreq.size(); noteIndex++)
+	for (auto& voice : mVoices)
 	{
-		registerSmoothedAudioValue(mBaseFreq[noteIndex]);
-		auto const noteToQuery = (static_cast<int>(noteIndex) == DfxMidi::kLegatoVoiceNoteIndex) ? (DfxMidi::kNumNotes / 2) : static_cast<int>(noteIndex);
-		mBaseFreq[noteIndex].setValueNow(getmidistate().getNoteFrequency(noteToQuery));
-
-		std::ranges::for_each(mBandCenterFreq[noteIndex], [this, noteIndex](auto& value)
-		{
-			registerSmoothedAudioValue(value);
-			value.setValueNow(mBaseFreq[noteIndex].getValue());
-		});
-		std::ranges::for_each(mBandBandwidth[noteIndex], [this, noteIndex](auto& value)
-		{
-			registerSmoothedAudioValue(value);
-			value.setValueNow(getBandwidthForFreq(mBaseFreq[noteIndex].getValue()));
-		});
+		registerSmoothedAudioValue(voice.mAmpEvener);
+		registerSmoothedAudioValue(voice.mBaseFreq);
+		std::ranges::for_each(voice.mBandCenterFreq, [this](auto& value){ registerSmoothedAudioValue(value); });
+		std::ranges::for_each(voice.mBandBandwidth, [this](auto& value){ registerSmoothedAudioValue(value); });
 	}
 }
 
@@ -134,23 +127,41 @@ void RezSynth::initialize()
 	mFreqSmoothingStride = dfx::math::GetFrequencyBasedSmoothingStride(getsamplerate());
 
 	auto const numChannels = getnumoutputs();
-	mPrevOutValue.assign(numChannels, {});
-	mPrevPrevOutValue.assign(numChannels, {});
-	mPrevInValue.assign(numChannels, {});
-	mPrevPrevInValue.assign(numChannels, {});
+	for (auto& voice : mVoices)
+	{
+		voice.mChannels.assign(numChannels, {});
+		voice.mLowpassGateFilters.assign(numChannels, dfx::IIRFilter(getsamplerate()));
+	}
 
-	std::ranges::fill(mLowpassGateFilters, decltype(mLowpassGateFilters)::value_type(numChannels, dfx::IIRFilter(getsamplerate())));
+#if REZSYNTH_PARALLEL_VOICE_RENDERING
+	if (auto const numCPUs = static_cast<size_t>(std::thread::hardware_concurrency()); numCPUs > 1)
+	{
+		mRenderWorkers = std::make_unique<dfx::RealtimeWorkerPool>(std::min(numCPUs - 1, kMaxRenderWorkers));
+		mVoiceRenderScratch.resize(mRenderWorkers->getNumParticipants());
+		for (auto& scratch : mVoiceRenderScratch)
+		{
+			scratch.mBuffer.assign(numChannels * getmaxframes(), 0.0f);
+			scratch.mChannels.clear();
+			for (size_t ch = 0; ch < numChannels; ch++)
+			{
+				scratch.mChannels.push_back(std::next(scratch.mBuffer.data(), ch * getmaxframes()));
+			}
+		}
+	}
+#endif
 }
 
 //-----------------------------------------------------------------------------------------
 void RezSynth::cleanup()
 {
-	mPrevOutValue = {};
-	mPrevPrevOutValue = {};
-	mPrevInValue = {};
-	mPrevPrevInValue = {};
+	for (auto& voice : mVoices)
+	{
+		voice.mChannels = {};
+		voice.mLowpassGateFilters = {};
+	}
 
-	std::ranges::fill(mLowpassGateFilters, decltype(mLowpassGateFilters)::value_type{});
+	mRenderWorkers.reset();
+	mVoiceRenderScratch = {};
 }
 
 //-----------------------------------------------------------------------------------------
@@ -160,20 +171,11 @@ void RezSynth::reset()
 	mUnaffectedState = UnaffectedState::FadeIn;
 	mUnaffectedFadeSamples = 0;
 
-	mNoteActiveLastRender.fill(false);
-
-	clearChannelsOfNotesOfBands(mPrevOutValue);
-	clearChannelsOfNotesOfBands(mPrevPrevOutValue);
-	for (auto& values : mPrevInValue)
+	// voices are cleared as they get bound to notes, so there is nothing to do but unbind them
+	for (int noteIndex = 0; noteIndex < DfxMidi::kNumNotesWithLegatoVoice; noteIndex++)
 	{
-		values.fill(0.0);
+		releaseVoice(noteIndex);
 	}
-	for (auto& values : mPrevPrevInValue)
-	{
-		values.fill(0.0);
-	}
-
-	clearLowpassGateFilters();
 }
 
 //-----------------------------------------------------------------------------------------
@@ -186,6 +188,13 @@ void RezSynth::processparameters()
 	mBandwidthMode = static_cast<int>(getparameter_i(kBandwidthMode));
 	mNumBands = static_cast<int>(std::clamp(getparameter_i(kNumBands), getparametermin_i(kNumBands), kMaxBands));
 	mSepAmount_Octaval = getparameter_f(kSepAmount_Octaval) / 12.0;
+	if (getparameterchanged(kSepAmount_Octaval))
+	{
+		for (size_t bandIndex = 0; bandIndex < mOctavalBandRatios.size(); bandIndex++)
+		{
+			mOctavalBandRatios[bandIndex] = std::pow(2.0, mSepAmount_Octaval * static_cast<double>(bandIndex));
+		}
+	}
 	mSepAmount_Linear = getparameter_f(kSepAmount_Linear);
 	mSepMode = static_cast<int>(getparameter_i(kSepMode));
 	mFoldover = getparameter_b(kFoldover);  // true for allow, false for resist
@@ -237,8 +246,7 @@ void RezSynth::processparameters()
 	// feedback buffers need to be cleared
 	if (getparameterchanged(kScaleMode) || getparameterchanged(kResonAlgorithm))
 	{
-		clearChannelsOfNotesOfBands(mPrevOutValue);
-		clearChannelsOfNotesOfBands(mPrevPrevOutValue);
+		clearFilterOutputForBands(0);
 	}
 
 	if (getparameterchanged(kEnvAttack) || getparameterchanged(kEnvDecay)
@@ -259,26 +267,81 @@ void RezSynth::processparameters()
 }
 
 //-----------------------------------------------------------------------------------------
-void RezSynth::clearChannelsOfNotesOfBands(ChannelsOfNotesOfBands& channelsOfNotesOfBands)
+// binds a voice to the note, if the note does not already have one, 
+// taking one from another note if the whole pool is already in use
+RezSynth::Voice& RezSynth::acquireVoice(int note)
 {
-	for (auto& notesOfBands : channelsOfNotesOfBands)
+	auto& noteVoice = mNoteVoices[note];
+	if (!noteVoice)
 	{
-		for (auto& bands : notesOfBands)
+		auto const freeVoice = std::ranges::find_if_not(mVoices, &Voice::isLive);
+		auto& voice = (freeVoice != mVoices.end()) ? *freeVoice : stealVoice();
+		voice.clear();
+		voice.mNote = note;
+		voice.mAcquisitionOrder = mVoiceAcquisitionCount++;
+
+		// the smoothed values still hold whatever the voice's previous note left them at, 
+		// so jump them straight to this note's values, without smoothing, before it first renders
+		auto const numBands = calculateCoefficients(note, voice);
+		voice.mAmpEvener.setValueNow(calculateAmpEvener(note));
+		voice.mBaseFreq.snap();
+		auto const baseFreq = voice.mBaseFreq.getValue();
+		for (int bandIndex = 0; bandIndex < kMaxBands; bandIndex++)
 		{
-			bands.fill(0.0);
+			if (bandIndex < numBands)
+			{
+				voice.mBandCenterFreq[bandIndex].snap();
+				voice.mBandBandwidth[bandIndex].snap();
+			}
+			else
+			{
+				voice.mBandCenterFreq[bandIndex].setValueNow(baseFreq);
+				voice.mBandBandwidth[bandIndex].setValueNow(getBandwidthForFreq(baseFreq));
+			}
 		}
+
+		noteVoice = &voice;
+	}
+	return *noteVoice;
+}
+
+//-----------------------------------------------------------------------------------------
+// unbinds a voice from its note, for when every voice is in use, choosing 
+// one whose note has already ended, or else the one that has been releasing the longest, 
+// or else the one that has been sounding the longest
+// (the note then stays silent until it ends or is played again)
+RezSynth::Voice& RezSynth::stealVoice()
+{
+	auto& voice = *std::ranges::min_element(mVoices, {}, [this](Voice const& candidate)
+	{
+		auto const noteActive = getmidistate().isNoteActive(candidate.mNote);
+		auto const noteReleasing = getmidistate().isNoteReleasing(candidate.mNote);
+		return std::tuple(noteActive, !noteReleasing, candidate.mAcquisitionOrder);
+	});
+	mNoteVoiceStolen[voice.mNote] = getmidistate().isNoteActive(voice.mNote);
+	mNoteVoices[voice.mNote] = nullptr;
+	voice.mNote = Voice::kNoNote;
+	return voice;
+}
+
+//-----------------------------------------------------------------------------------------
+void RezSynth::releaseVoice(int note)
+{
+	mNoteVoiceStolen[note] = false;
+	if (auto const voice = std::exchange(mNoteVoices[note], nullptr))
+	{
+		voice->mNote = Voice::kNoNote;
 	}
 }
 
 //-----------------------------------------------------------------------------------------
 void RezSynth::clearFilterOutputForBands(int bandIndexBegin)
 {
-	for (size_t ch = 0; ch < mPrevOutValue.size(); ch++)
+	for (auto& voice : mVoices)
 	{
-		for (size_t note = 0; note < mPrevOutValue[ch].size(); note++)
+		if (voice.isLive())
 		{
-			std::fill(std::next(mPrevOutValue[ch][note].begin(), bandIndexBegin), mPrevOutValue[ch][note].end(), 0.0);
-			std::fill(std::next(mPrevPrevOutValue[ch][note].begin(), bandIndexBegin), mPrevPrevOutValue[ch][note].end(), 0.0);
+			voice.clearFilterOutputForBands(bandIndexBegin);
 		}
 	}
 }
@@ -286,8 +349,29 @@ void RezSynth::clearFilterOutputForBands(int bandIndexBegin)
 //-----------------------------------------------------------------------------------------
 void RezSynth::clearLowpassGateFilters()
 {
-	std::ranges::for_each(mLowpassGateFilters, [](auto& channelFilters)
+	for (auto& voice : mVoices)
 	{
-		std::ranges::for_each(channelFilters, [](auto& filter){ filter.reset(); });
-	});
+		if (voice.isLive())
+		{
+			std::ranges::for_each(voice.mLowpassGateFilters, [](auto& filter){ filter.reset(); });
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+void RezSynth::Voice::clearFilterOutputForBands(int bandIndexBegin)
+{
+	for (auto& channelState : mChannels)
+	{
+		std::fill(std::next(channelState.mPrevOutValue.begin(), bandIndexBegin), channelState.mPrevOutValue.end(), ResonatorValue(0));
+		std::fill(std::next(channelState.mPrevPrevOutValue.begin(), bandIndexBegin), channelState.mPrevPrevOutValue.end(), ResonatorValue(0));
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// wipes out everything carried over from whichever note the voice last played
+void RezSynth::Voice::clear()
+{
+	std::ranges::fill(mChannels, ChannelState{});
+	std::ranges::for_each(mLowpassGateFilters, [](auto& filter){ filter.reset(); });
 }
@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2001-2024  Sophia Poirier
+Copyright (C) 2001-2026  Sophia Poirier
 
 This file is part of Rez Synth.
 
@@ -22,6 +22,7 @@ To contact the author, use the contact form at http://destroyfx.org
 #include "rezsynth.h"
 
 #include <algorithm>
+#include <utility>
 
 #include "dfxmath.h"
 
@@ -83,71 +84,66 @@ void RezSynth::processaudio(std::span<float const* const> inAudio, std::span<flo
 		// test for whether all notes are off and unprocessed audio can be outputted
 		bool notesActive = false;  // none yet for this chunk
 
-		// these will increment for every note on every channel, so restore before iterations
-		auto const entryOutputGain = mOutputGain;
-		auto const entryWetGain = mWetGain;
+		// the voices sounding during this chunk are gathered first, since they can be rendered in any order
+		size_t numVoicesToRender = 0;
 		for (int noteIndex = 0; noteIndex < DfxMidi::kNumNotesWithLegatoVoice; noteIndex++)
 		{
 			// only go into the output processing cycle if a note is happening
 			if (getmidistate().isNoteActive(noteIndex))
 			{
 				notesActive = true;
+				if (auto const voice = mNoteVoices[noteIndex])
+				{
+					voice->mAmpEvener = calculateAmpEvener(noteIndex);  // a scalar for balancing outputs from the normalizing modes
+					mVoicesToRender[numVoicesToRender++] = voice;
+				}
+			}
+		}
 
-				mAmpEvener[noteIndex] = calculateAmpEvener(noteIndex);  // a scalar for balancing outputs from the normalizing modes
+		// then notes that are starting to sound get voices, which can mean taking one from another note
+		for (int noteIndex = 0; noteIndex < DfxMidi::kNumNotesWithLegatoVoice; noteIndex++)
+		{
+			if (getmidistate().isNoteActive(noteIndex) && !mNoteVoices[noteIndex] && !mNoteVoiceStolen[noteIndex])
+			{
+				auto const voice = &acquireVoice(noteIndex);
+				std::span const voicesToRender(mVoicesToRender.data(), numVoicesToRender);
+				// a stolen voice is already in the list, and now renders this note instead
+				if (std::ranges::find(voicesToRender, voice) == voicesToRender.end())
+				{
+					mVoicesToRender[numVoicesToRender++] = voice;
+				}
+			}
+		}
 
-				for (size_t subSlicePosition = 0; subSlicePosition < numFramesToProcess; )
+		// notes whose voices were taken stay silent, but their envelopes still have to progress
+		for (int noteIndex = 0; noteIndex < DfxMidi::kNumNotesWithLegatoVoice; noteIndex++)
+		{
+			if (getmidistate().isNoteActive(noteIndex) && !mNoteVoices[noteIndex])
+			{
+				for (size_t sampleIndex = 0; sampleIndex < numFramesToProcess; sampleIndex++)
 				{
-					// this is the resonator stuff
-					auto const activeNumBands = calculateCoefficients(noteIndex);
-
-					// if a note is just begin, skip smoothing for all of the per-note smoothed parameter values
-					if (!mNoteActiveLastRender[noteIndex] && (subSlicePosition == 0))
-					{
-						mAmpEvener[noteIndex].snap();
-						mBaseFreq[noteIndex].snap();
-						std::ranges::for_each(mBandCenterFreq[noteIndex], [](auto& value){ value.snap(); });
-						std::ranges::for_each(mBandBandwidth[noteIndex], [](auto& value){ value.snap(); });
-					}
-
-					auto const subSliceFrameCount = [this, numFramesToProcess, subSlicePosition, noteIndex, activeNumBands]
-					{
-						auto const valueIsSmoothing = [](auto const& value){ return value.isSmoothing(); };
-						auto const freqIsSmoothing = mBaseFreq[noteIndex].isSmoothing()
-						|| std::any_of(mBandCenterFreq[noteIndex].cbegin(),
-									   std::next(mBandCenterFreq[noteIndex].cbegin(), activeNumBands),
-									   valueIsSmoothing)
-						|| std::any_of(mBandBandwidth[noteIndex].cbegin(),
-									   std::next(mBandBandwidth[noteIndex].cbegin(), activeNumBands),
-									   valueIsSmoothing);
-						auto const remainingFrames = numFramesToProcess - subSlicePosition;
-						return freqIsSmoothing ? std::min(mFreqSmoothingStride, remainingFrames) : remainingFrames;
-					}();
-
-					// restore values before doing processFilterOuts for the next channel
-					mOutputGain = entryOutputGain;
-					mWetGain = entryWetGain;
-
-					// render the filtered audio output for the note
-					processFilterOuts(inAudio, outAudio,
-									  currentBlockPosition + subSlicePosition, subSliceFrameCount,
-									  noteIndex, activeNumBands);
-
-					mBaseFreq[noteIndex].inc(subSliceFrameCount);
-					std::ranges::for_each(mBandCenterFreq[noteIndex], [subSliceFrameCount](auto& value){ value.inc(subSliceFrameCount); });
-					std::ranges::for_each(mBandBandwidth[noteIndex], [subSliceFrameCount](auto& value){ value.inc(subSliceFrameCount); });
-
-					subSlicePosition += subSliceFrameCount;
+					getmidistate().processEnvelope(noteIndex);
 				}
 			}
+		}
 
+		// these increment for every note on every channel, so each voice begins from the entry values
+		auto const entryWetGain = mWetGain;
+		renderVoices(inAudio, outAudio, currentBlockPosition, numFramesToProcess, {mVoicesToRender.data(), numVoicesToRender});
+		if (notesActive)
+		{
+			mOutputGain.inc(numFramesToProcess);
+			mWetGain.inc(numFramesToProcess);
+		}
+
+		for (int noteIndex = 0; noteIndex < DfxMidi::kNumNotesWithLegatoVoice; noteIndex++)
+		{
 			// could be because it already was inactive, or because we just completed articulation of the note
 			if (!getmidistate().isNoteActive(noteIndex))
 			{
-				std::ranges::for_each(mLowpassGateFilters[noteIndex], [](auto& filter){ filter.reset(); });
+				releaseVoice(noteIndex);
 			}
-
-			mNoteActiveLastRender[noteIndex] = getmidistate().isNoteActive(noteIndex);
-		}  // end of notes loop
+		}
 
 		if (!notesActive)
 		{
@@ -218,3 +214,87 @@ void RezSynth::processaudio(std::span<float const* const> inAudio, std::span<flo
 		}
 	}
 }
+
+//-----------------------------------------------------------------------------------------
+// This renders all of the sounding voices for a chunk of the block, adding them into the output.
+void RezSynth::renderVoices(std::span<float const* const> inAudio, std::span<float* const> outAudio,
+							size_t sampleFrameOffset, size_t sampleFrames, std::span<Voice* const> voices)
+{
+	if (!mRenderWorkers || (voices.size() < kMinVoicesForParallelRendering))
+	{
+		for (auto const voice : voices)
+		{
+			renderVoice(inAudio, outAudio, sampleFrameOffset, sampleFrames, *voice);
+		}
+		return;
+	}
+
+	// each voice (and its note's MIDI state) is only touched by whichever thread renders it, 
+	// and each thread sums its voices into its own scratch output, cleared upon first use
+	mRenderWorkers->run(voices.size(), [&](size_t voiceIndex, size_t participantIndex)
+	{
+		auto& scratch = mVoiceRenderScratch[participantIndex];
+		if (!scratch.mUsed)
+		{
+			for (auto const channel : scratch.mChannels)
+			{
+				std::fill_n(std::next(channel, sampleFrameOffset), sampleFrames, 0.0f);
+			}
+			scratch.mUsed = true;
+		}
+		renderVoice(inAudio, scratch.mChannels, sampleFrameOffset, sampleFrames, *voices[voiceIndex]);
+	});
+
+	for (auto& scratch : mVoiceRenderScratch)
+	{
+		if (std::exchange(scratch.mUsed, false))
+		{
+			for (size_t ch = 0; ch < outAudio.size(); ch++)
+			{
+				for (size_t sampleIndex = sampleFrameOffset; sampleIndex < (sampleFrameOffset + sampleFrames); sampleIndex++)
+				{
+					outAudio[ch][sampleIndex] += scratch.mChannels[ch][sampleIndex];
+				}
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+void RezSynth::renderVoice(std::span<float const* const> inAudio, std::span<float* const> outAudio,
+						   size_t sampleFrameOffset, size_t sampleFrames, Voice& voice)
+{
+	auto outputGain = mOutputGain;
+	auto wetGain = mWetGain;
+
+	for (size_t subSlicePosition = 0; subSlicePosition < sampleFrames; )
+	{
+		// this is the resonator stuff
+		auto const activeNumBands = calculateCoefficients(voice.mNote, voice);
+
+		auto const subSliceFrameCount = [this, sampleFrames, subSlicePosition, &voice, activeNumBands]
+		{
+			auto const valueIsSmoothing = [](auto const& value){ return value.isSmoothing(); };
+			auto const freqIsSmoothing = voice.mBaseFreq.isSmoothing()
+			|| std::any_of(voice.mBandCenterFreq.cbegin(),
+						   std::next(voice.mBandCenterFreq.cbegin(), activeNumBands),
+						   valueIsSmoothing)
+			|| std::any_of(voice.mBandBandwidth.cbegin(),
+						   std::next(voice.mBandBandwidth.cbegin(), activeNumBands),
+						   valueIsSmoothing);
+			auto const remainingFrames = sampleFrames - subSlicePosition;
+			return freqIsSmoothing ? std::min(mFreqSmoothingStride, remainingFrames) : remainingFrames;
+		}();
+
+		// render the filtered audio output for the note
+		processFilterOuts(inAudio, outAudio,
+						  sampleFrameOffset + subSlicePosition, subSliceFrameCount,
+						  voice, activeNumBands, outputGain, wetGain);
+
+		voice.mBaseFreq.inc(subSliceFrameCount);
+		std::ranges::for_each(voice.mBandCenterFreq, [subSliceFrameCount](auto& value){ value.inc(subSliceFrameCount); });
+		std::ranges::for_each(voice.mBandBandwidth, [subSliceFrameCount](auto& value){ value.inc(subSliceFrameCount); });
+
+		subSlicePosition += subSliceFrameCount;
+	}
+}
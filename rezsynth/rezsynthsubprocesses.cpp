@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2001-2024  Sophia Poirier
+Copyright (C) 2001-2026  Sophia Poirier
 
 This file is part of Rez Synth.
 
@@ -21,11 +21,17 @@ To contact the author, use the contact form at http://destroyfx.org
 
 #include "rezsynth.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
+#include <numeric>
 #include <tuple>
 #include <type_traits>
 
+#include "dfxmath.h"
+
+
 //-----------------------------------------------------------------------------------------
 // this function tries to even out the wildly erratic resonant amplitudes
 double RezSynth::calculateAmpEvener(int currentNote) const
@@ -67,124 +73,158 @@ double RezSynth::calculateAmpEvener(int currentNote) const
 //-----------------------------------------------------------------------------------------
 // This function calculates the 3 coefficients in the resonant filter equation,
 // 1 for the current sample input and 2 for the last 2 samples.
-int RezSynth::calculateCoefficients(int currentNote)
+// While frequencies are smoothing, this runs every few samples for every active note, 
+// so it is arranged as straight loops across the bands, free of standard library 
+// math calls (but still in double precision), which the compiler can vectorize.
+int RezSynth::calculateCoefficients(int currentNote, Voice& voice) const
 {
-	mBaseFreq[currentNote] = getmidistate().getNoteFrequency(currentNote) * getmidistate().getPitchBend();
-	auto const baseFreq = mBaseFreq[currentNote].getValue();
+	voice.mBaseFreq = getmidistate().getNoteFrequency(currentNote) * getmidistate().getPitchBend();
+	auto const baseFreq = voice.mBaseFreq.getValue();
 
+	std::array<double, kMaxBands> bandCenterFreqs {}, bandCenterAngles {}, bandBandwidths {};
+	auto numBands = mNumBands;
 	for (int bandcount = 0; bandcount < mNumBands; bandcount++)
 	{
 // GET THE CURRENT BAND'S CENTER FREQUENCY
-		mBandCenterFreq[currentNote][bandcount] = [this, baseFreq, bandcount]
-		{
-			// do logarithmic band separation, octave-style
-			if (mSepMode == kSeparationMode_Octaval)
-			{
-				return baseFreq * std::pow(2.0, mSepAmount_Octaval * bandcount);
-			}
-			// do linear band separation, hertz-style
-			return baseFreq + (baseFreq * mSepAmount_Linear * bandcount);
-		}();
-		auto const bandCenterFreq = mBandCenterFreq[currentNote][bandcount].getValue();
+		// do logarithmic band separation, octave-style, using the precomputed band frequency ratios, 
+		// otherwise do linear band separation, hertz-style
+		voice.mBandCenterFreq[bandcount] = (mSepMode == kSeparationMode_Octaval)
+												  ? (baseFreq * mOctavalBandRatios[bandcount])
+												  : (baseFreq + (baseFreq * mSepAmount_Linear * bandcount));
+		bandCenterFreqs[bandcount] = voice.mBandCenterFreq[bandcount].getValue();
 
 // SHRINK THE NUMBER OF BANDS IF MISTAKES ARE "OFF" AND THE NEXT BAND WILL EXCEED THE NYQUIST
-		if (!mFoldover && (bandCenterFreq > mNyquist))
+		if (!mFoldover && (bandCenterFreqs[bandcount] > mNyquist))
 		{
-			clearFilterOutputForBands(bandcount);
-			return bandcount;  // there's no need to do the calculations if we won't be using this or the remaining bands
+			voice.clearFilterOutputForBands(bandcount);
+			numBands = bandcount;  // there's no need to do the calculations if we won't be using this or the remaining bands
+			break;
 		}
 
-		mBandBandwidth[currentNote][bandcount] = getBandwidthForFreq(bandCenterFreq);
+		// with foldover, octaval separation can put the upper bands many octaves beyond the sample rate, 
+		// so alias them back down before they become cosine arguments
+		bandCenterAngles[bandcount] = dfx::math::GetAngularFrequency(bandCenterFreqs[bandcount], getsamplerate());
+		voice.mBandBandwidth[bandcount] = getBandwidthForFreq(bandCenterFreqs[bandcount]);
+		bandBandwidths[bandcount] = voice.mBandBandwidth[bandcount].getValue();
+	}
+	auto const bandCount = static_cast<size_t>(numBands);
 
 // CALCULATE THE COEFFICIENTS FOR THE 2 DELAYED INPUTS IN THE FILTER
 // and CALCULATE THE COEFFICIENT FOR THE CURRENT INPUT SAMPLE IN THE FILTER
-		// kScaleMode_None -> no scaling; input gain = 1
-		mInputAmp[bandcount] = 1.0;
-		auto const r = std::exp(mBandBandwidth[currentNote][bandcount].getValue() * -mPiDivSR);
-		switch (mResonAlgorithm)
-		{
-			// based on the reson opcode in Csound
-			case kResonAlg_2PoleNoZero:
-			default:
+	// (calculated in double precision regardless of the resonator precision)
+	std::array<double, kMaxBands> inputAmp {}, prevOutCoeff {}, prevPrevOutCoeff {}, prevPrevInCoeff {};
+	// kScaleMode_None -> no scaling; input gain = 1
+	std::fill_n(inputAmp.begin(), bandCount, 1.0);
+	switch (mResonAlgorithm)
+	{
+		// based on the reson opcode in Csound
+		case kResonAlg_2PoleNoZero:
+		default:
+			for (size_t i = 0; i < bandCount; i++)
+			{
 				// this value is usually just approaching 1 from below (i.e. 0.999) but gets smaller
 				// and perhaps approaches 0 as bandwidth and/or the center freq distance from base freq grow
-				mPrevPrevOutCoeff[bandcount] = std::exp((bandCenterFreq / baseFreq) * mBandBandwidth[currentNote][bandcount].getValue() * -mTwoPiDivSR);
+				prevPrevOutCoeff[i] = dfx::math::FastExp((bandCenterFreqs[i] / baseFreq) * bandBandwidths[i] * -mTwoPiDivSR);
 				// this value, at 44.1 kHz, moves in a curve from 2 to -2 as the center frequency goes from 0 to ~20 kHz
-				mPrevOutCoeff[bandcount] = mPrevPrevOutCoeff[bandcount] * 4.0 * std::cos(bandCenterFreq * mTwoPiDivSR) / (mPrevPrevOutCoeff[bandcount] + 1.0);
-				// unused in this algorithm
-				mPrevPrevInCoeff[bandcount] = 0.0;
-				//
-				// RMS gain = 1
-				if (mScaleMode == kScaleMode_RMS)
-				{
-					mInputAmp[bandcount] = std::sqrt(((mPrevPrevOutCoeff[bandcount] + 1.0) * (mPrevPrevOutCoeff[bandcount] + 1.0) - (mPrevOutCoeff[bandcount] * mPrevOutCoeff[bandcount])) * (1.0 - mPrevPrevOutCoeff[bandcount]) / (mPrevPrevOutCoeff[bandcount] + 1.0));
-				}
-				// peak gain at center = 1
-				else if (mScaleMode == kScaleMode_Peak)
-				{
-					mInputAmp[bandcount] = (1.0 - mPrevPrevOutCoeff[bandcount]) * std::sqrt(1.0 - (mPrevOutCoeff[bandcount] * mPrevOutCoeff[bandcount] / (mPrevPrevOutCoeff[bandcount] * 4.0)));
-				}
-				break;
-
-			// an implementation of the 2-pole, 2-zero resononant filter
-			// described by Julius O. Smith and James B. Angell in
-			// "A Constant Gain Digital Resonator Tuned By A Single Coefficient,"
-			// Computer Music Journal, Vol. 6, No. 4, Winter 1982, p.36-39
-			// (where the zeros are at +/- the square root of r,
-			// where r is the pole radius of the resonant filter)
-			case kResonAlg_2Pole2ZeroR:
-				mPrevOutCoeff[bandcount] = 2.0 * r * std::cos(bandCenterFreq * mTwoPiDivSR);
-				mPrevPrevOutCoeff[bandcount] = r * r;
-				mPrevPrevInCoeff[bandcount] = r;
-				//
-				if (mScaleMode == kScaleMode_Peak)
+				prevOutCoeff[i] = prevPrevOutCoeff[i] * 4.0 * dfx::math::FastCos(bandCenterAngles[i]) / (prevPrevOutCoeff[i] + 1.0);
+				// (the 2-sample delayed input coefficient is unused in this algorithm)
+			}
+			//
+			// RMS gain = 1
+			if (mScaleMode == kScaleMode_RMS)
+			{
+				for (size_t i = 0; i < bandCount; i++)
 				{
-					mInputAmp[bandcount] = 1.0 - r;
+					inputAmp[i] = std::sqrt(((prevPrevOutCoeff[i] + 1.0) * (prevPrevOutCoeff[i] + 1.0) - (prevOutCoeff[i] * prevOutCoeff[i])) * (1.0 - prevPrevOutCoeff[i]) / (prevPrevOutCoeff[i] + 1.0));
 				}
-				else if (mScaleMode == kScaleMode_RMS)
+			}
+			// peak gain at center = 1
+			else if (mScaleMode == kScaleMode_Peak)
+			{
+				for (size_t i = 0; i < bandCount; i++)
 				{
-					mInputAmp[bandcount] = std::sqrt(1.0 - r);
+					inputAmp[i] = (1.0 - prevPrevOutCoeff[i]) * std::sqrt(1.0 - (prevOutCoeff[i] * prevOutCoeff[i] / (prevPrevOutCoeff[i] * 4.0)));
 				}
-				break;
-
-			// version of the above filter where the zeros are located at z = 1 and z = -1
-			case kResonAlg_2Pole2Zero1:
-				mPrevOutCoeff[bandcount] = 2.0 * r * std::cos(bandCenterFreq * mTwoPiDivSR);
-				mPrevPrevOutCoeff[bandcount] = r * r;
-				mPrevPrevInCoeff[bandcount] = 1.0;
-				//
-				if (mScaleMode == kScaleMode_Peak)
+			}
+			break;
+
+		// an implementation of the 2-pole, 2-zero resononant filter
+		// described by Julius O. Smith and James B. Angell in
+		// "A Constant Gain Digital Resonator Tuned By A Single Coefficient,"
+		// Computer Music Journal, Vol. 6, No. 4, Winter 1982, p.36-39
+		// (where the zeros are at +/- the square root of r,
+		// where r is the pole radius of the resonant filter)
+		case kResonAlg_2Pole2ZeroR:
+		// and a version of that filter where the zeros are located at z = 1 and z = -1
+		case kResonAlg_2Pole2Zero1:
+		{
+			bool const zerosAtR = (mResonAlgorithm == kResonAlg_2Pole2ZeroR);
+			std::array<double, kMaxBands> r {};
+			for (size_t i = 0; i < bandCount; i++)
+			{
+				r[i] = dfx::math::FastExp(bandBandwidths[i] * -mPiDivSR);
+				prevOutCoeff[i] = 2.0 * r[i] * dfx::math::FastCos(bandCenterAngles[i]);
+				prevPrevOutCoeff[i] = r[i] * r[i];
+				prevPrevInCoeff[i] = zerosAtR ? r[i] : 1.0;
+			}
+			//
+			if (mScaleMode == kScaleMode_Peak)
+			{
+				for (size_t i = 0; i < bandCount; i++)
 				{
-					mInputAmp[bandcount] = (1.0 - mPrevPrevOutCoeff[bandcount]) * 0.5;
+					inputAmp[i] = zerosAtR ? (1.0 - r[i]) : ((1.0 - prevPrevOutCoeff[i]) * 0.5);
 				}
-				else if (mScaleMode == kScaleMode_RMS)
+			}
+			else if (mScaleMode == kScaleMode_RMS)
+			{
+				for (size_t i = 0; i < bandCount; i++)
 				{
-					mInputAmp[bandcount] = std::sqrt((1.0 - mPrevPrevOutCoeff[bandcount]) * 0.5);
+					inputAmp[i] = std::sqrt(zerosAtR ? (1.0 - r[i]) : ((1.0 - prevPrevOutCoeff[i]) * 0.5));
 				}
-				break;
+			}
+			break;
 		}
-	}  // end of bands loop
+	}
 
-	return mNumBands;  // unchanged
+	auto& coefficients = voice.mCoefficients;
+	std::copy_n(inputAmp.cbegin(), bandCount, coefficients.mInputAmp.begin());
+	std::copy_n(prevOutCoeff.cbegin(), bandCount, coefficients.mPrevOutCoeff.begin());
+	std::copy_n(prevPrevOutCoeff.cbegin(), bandCount, coefficients.mPrevPrevOutCoeff.begin());
+	std::copy_n(prevPrevInCoeff.cbegin(), bandCount, coefficients.mPrevPrevInCoeff.begin());
+	coefficients.silenceBands(numBands);
+
+	return numBands;
+}
+
+//-----------------------------------------------------------------------------------------
+void RezSynth::ResonatorCoefficients::silenceBands(int bandIndexBegin)
+{
+	for (auto* const coefficients : {&mInputAmp, &mPrevOutCoeff, &mPrevPrevOutCoeff, &mPrevPrevInCoeff})
+	{
+		std::fill(std::next(coefficients->begin(), bandIndexBegin), coefficients->end(), ResonatorValue(0));
+	}
 }
 
 //-----------------------------------------------------------------------------------------
 // This function writes the filtered audio output.
 void RezSynth::processFilterOuts(std::span<float const* const> inAudio, std::span<float* const> outAudio,
 								 size_t sampleFrameOffset, size_t sampleFrames,
-								 int currentNote, int numBands)
+								 Voice& voice, int numBands,
+								 dfx::SmoothedValue<float>& outputGain, dfx::SmoothedValue<float>& wetGain)
 {
 	assert(inAudio.size() == outAudio.size());
 
 	auto const numChannels = outAudio.size();
+	auto const numBandLanes = getNumBandLanes(numBands);
+	auto const currentNote = voice.mNote;
 	float envAmp = 1.f;
-	auto& channelFilters = mLowpassGateFilters[currentNote];
+	auto& channelFilters = voice.mLowpassGateFilters;
 
 	// here we do the resonant filter equation using our filter coefficients, and related stuff
 	for (size_t sampleIndex = sampleFrameOffset; sampleIndex < (sampleFrames + sampleFrameOffset); sampleIndex++)
 	{
 		auto const noteAmp = getmidistate().getNoteAmplitude(currentNote);
-		auto const ampEvener = mAmpEvener[currentNote].getValue();
+		auto const ampEvener = voice.mAmpEvener.getValue();
 		// see whether attack or release are active and fetch the output scalar
 		if (mFadeType == kCurveType_Lowpass)
 		{
@@ -206,7 +246,7 @@ void RezSynth::processFilterOuts(std::span<float const* const> inAudio, std::spa
 		{
 			envAmp = getmidistate().processEnvelope(currentNote);
 		}
-		float const envedTotalAmp = noteAmp * envAmp * mWetGain.getValue() * mOutputGain.getValue();
+		float const envedTotalAmp = noteAmp * envAmp * wetGain.getValue() * outputGain.getValue();
 
 		for (size_t ch = 0; ch < numChannels; ch++)
 		{
@@ -219,19 +259,8 @@ void RezSynth::processFilterOuts(std::span<float const* const> inAudio, std::spa
 				return value;
 			};
 
-			double bandOutputSum = 0.;
-			for (int bandIndex = 0; bandIndex < numBands; bandIndex++)
-			{
-				// filter using the input, delayed values, and their filter coefficients
-				double curBandOutValue = (mInputAmp[bandIndex] * (inAudio[ch][sampleIndex] - mPrevPrevInCoeff[bandIndex] * mPrevPrevInValue[ch][currentNote]))
-										 + (mPrevOutCoeff[bandIndex] * mPrevOutValue[ch][currentNote][bandIndex])
-										 - (mPrevPrevOutCoeff[bandIndex] * mPrevPrevOutValue[ch][currentNote][bandIndex]);
-				curBandOutValue = clampInfinities(curBandOutValue);
-
-				bandOutputSum += curBandOutValue;
-				// very old outValue gets old outValue and old outValue gets current outValue (no longer current)
-				mPrevPrevOutValue[ch][currentNote][bandIndex] = std::exchange(mPrevOutValue[ch][currentNote][bandIndex], curBandOutValue);
-			}
+			auto& channelState = voice.mChannels[ch];
+			double bandOutputSum = processResonatorBank(inAudio[ch][sampleIndex], numBandLanes, voice.mCoefficients, channelState);
 			bandOutputSum = clampInfinities(bandOutputSum);
 			auto const scaledBandOutputSum = static_cast<float>(bandOutputSum * ampEvener);
 
@@ -251,15 +280,55 @@ void RezSynth::processFilterOuts(std::span<float const* const> inAudio, std::spa
 				outAudio[ch][sampleIndex] = entryOutput;
 			}
 
-			mPrevPrevInValue[ch][currentNote] = std::exchange(mPrevInValue[ch][currentNote], inAudio[ch][sampleIndex]);
+			channelState.mPrevPrevInValue = std::exchange(channelState.mPrevInValue, inAudio[ch][sampleIndex]);
 		}
 
-		mOutputGain.inc();
-		mWetGain.inc();
-		mAmpEvener[currentNote].inc();
+		outputGain.inc();
+		wetGain.inc();
+		voice.mAmpEvener.inc();
 	}
 }
 
+//-----------------------------------------------------------------------------------------
+// This runs one sample of input through the bank of resonators for a note, returning their summed output.
+// The bands are independent of each other, so each lane group's worth of bands is computed in parallel, 
+// accumulating into per-lane partial sums to avoid serializing on a single floating point accumulator.
+RezSynth::ResonatorValue RezSynth::processResonatorBank(ResonatorValue input, size_t numBandLanes, 
+														ResonatorCoefficients const& coefficients, Voice::ChannelState& state)
+{
+	assert(numBandLanes <= kNumBandLanes);
+	assert((numBandLanes % kBandLaneGroupSize) == 0);
+
+	auto const prevPrevInput = state.mPrevPrevInValue;
+	auto& prevOutValues = state.mPrevOutValue;
+	auto& prevPrevOutValues = state.mPrevPrevOutValue;
+
+	// replaces infinities with the largest finite values (and lets NaN through, like std::isinf would)
+	constexpr auto clampMax = std::numeric_limits<ResonatorValue>::max();
+	std::array<ResonatorValue, kBandLaneGroupSize> laneSums {};
+	for (size_t laneGroupStart = 0; laneGroupStart < numBandLanes; laneGroupStart += kBandLaneGroupSize)
+	{
+		// working on local copies of the state assures the compiler that nothing aliases
+		std::array<ResonatorValue, kBandLaneGroupSize> prevOut, prevPrevOut, curOut;
+		std::copy_n(std::next(prevOutValues.cbegin(), laneGroupStart), kBandLaneGroupSize, prevOut.begin());
+		std::copy_n(std::next(prevPrevOutValues.cbegin(), laneGroupStart), kBandLaneGroupSize, prevPrevOut.begin());
+		for (size_t lane = 0; lane < kBandLaneGroupSize; lane++)
+		{
+			auto const bandIndex = laneGroupStart + lane;
+			// filter using the input, delayed values, and their filter coefficients
+			auto const value = (coefficients.mInputAmp[bandIndex] * (input - (coefficients.mPrevPrevInCoeff[bandIndex] * prevPrevInput)))
+							   + (coefficients.mPrevOutCoeff[bandIndex] * prevOut[lane])
+							   - (coefficients.mPrevPrevOutCoeff[bandIndex] * prevPrevOut[lane]);
+			curOut[lane] = (value > clampMax) ? clampMax : ((value < -clampMax) ? -clampMax : value);
+			laneSums[lane] += curOut[lane];
+		}
+		// very old outValue gets old outValue and old outValue gets current outValue (no longer current)
+		std::copy_n(prevOut.cbegin(), kBandLaneGroupSize, std::next(prevPrevOutValues.begin(), laneGroupStart));
+		std::copy_n(curOut.cbegin(), kBandLaneGroupSize, std::next(prevOutValues.begin(), laneGroupStart));
+	}
+	return std::accumulate(laneSums.cbegin(), laneSums.cend(), ResonatorValue(0));
+}
+
 //-----------------------------------------------------------------------------------------
 // this function outputs the unprocessed audio input between notes, if desired
 void RezSynth::processUnaffected(std::span<float const> inAudio, std::span<float> outAudio)
@@ -322,19 +391,22 @@ void RezSynth::checkForNewNote(size_t currentEvent)
 	// store the current note MIDI number
 	auto const currentNote = getmidistate().getBlockEvent(currentEvent).mByte1;
 
+	// a note that lost its voice to another gets one again when it is played again
+	if (getmidistate().getBlockEvent(currentEvent).mStatus == DfxMidi::kStatus_NoteOn)
+	{
+		mNoteVoiceStolen[currentNote] = false;
+	}
+
 	// if this latest event is a note-on and this note isn't still active
 	// from being previously played, then clear this note's delay buffers
 	if ((getmidistate().getBlockEvent(currentEvent).mStatus == DfxMidi::kStatus_NoteOn)  // it's a note-on
 		&& !getmidistate().isNoteActive(currentNote))  // this note is currently off
 	{
-		// wipe out the feedback buffers
-		for (auto& values : mPrevOutValue)
-		{
-			values[currentNote].fill(0.0);
-		}
-		for (auto& values : mPrevPrevOutValue)
+		// a voice still bound to the note gets its feedback buffers wiped out 
+		// (otherwise a fresh voice gets cleared when it is bound to the note)
+		if (auto const voice = mNoteVoices[currentNote])
 		{
-			values[currentNote].fill(0.0);
+			voice->clearFilterOutputForBands(0);
 		}
 	}
 }
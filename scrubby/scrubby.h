@@ -23,6 +23,7 @@ To contact the author, use the contact form at http://destroyfx.org
 
 
 #include <array>
+#include <span>
 #include <vector>
 
 #include "dfxmath.h"
@@ -117,10 +118,23 @@ public:
 private:
 	static constexpr size_t kNumPresets = 16;
 	static constexpr double kHighpassFilterCutoff = 39.;
+	// each channel's buffer is padded on either end with copies of the samples from the opposite end,
+	// enough for the neighbors of interpolated reads to need no wraparound
+	static constexpr long kBufferPadding = 2;
+	// audio is rendered in spans between seek events, each channel at a time across up to this many frames
+	static constexpr size_t kMaxRenderSpanSize = 512;
 
 
 	void initPresets();
 
+	void renderSpan(std::span<float const* const> inAudio, std::span<float* const> outAudio, size_t inOffset, size_t inSpanSize);
+	bool planReads(size_t channel, size_t inSpanSize);
+	void advanceReadPosition(size_t channel);
+	float* getAudioBuffer(size_t channel) noexcept
+	{
+		return mAudioBuffers[channel].data() + kBufferPadding;
+	}
+	void refreshBufferPadding(size_t channel);
 	void generateNewTarget(size_t channel);
 	double processPitchConstraint(double readStep) const;
 	void checkTempoSyncStuff();
@@ -142,7 +156,7 @@ private:
 	bool mUseSeekRateRandMin = false, mUseSeekDurRandMin = false;
 
 	// buffers and associated position values/counters/etc.
-	std::vector<std::vector<float>> mAudioBuffers;
+	std::vector<std::vector<float>> mAudioBuffers;  // (each including its padding)
 	long mWritePos = 0;
 	std::vector<double> mReadPos, mReadStep, mPortamentoStep;
 	std::vector<long> mMoveCount, mSeekCount;
@@ -152,6 +166,11 @@ private:
 
 	std::vector<dfx::IIRFilter> mHighpassFilters;
 
+	// per-frame values for the span being rendered
+	std::array<long, kMaxRenderSpanSize> mSpanReadIndices {};
+	std::array<float, kMaxRenderSpanSize> mSpanReadFractions {};
+	std::array<float, kMaxRenderSpanSize> mSpanInputGains {}, mSpanOutputGains {}, mSpanOutput {};
+
 	dfx::math::RandomEngine mRandomEngine {dfx::math::RandomSeed::Entropic};
 
 	// tempo sync stuff
@@ -149,7 +149,7 @@ void Scrubby::initialize()
 	mAudioBuffers.assign(numChannels, {});
 	for (auto& buffer : mAudioBuffers)
 	{
-		buffer.assign(mMaxAudioBufferSize, 0.0f);
+		buffer.assign(mMaxAudioBufferSize + (kBufferPadding * 2), 0.0f);
 	}
 	mReadPos.assign(numChannels, 0.0);
 	mReadStep.assign(numChannels, 0.0);
@@ -362,6 +362,8 @@ void Scrubby::initPresets()
 //-------------------------------------------------------------------------
 void Scrubby::randomizeparameters()
 {
+	GroupedParameterUpdates const groupedUpdates(*this);
+
 	// store the current total mix gain sum
 	auto const entryDryLevel = getparameter_f(kDryLevel);
 	auto const entryWetLevel = getparameter_f(kWetLevel);
@@ -27,6 +27,8 @@ To contact the author, use the contact form at http://destroyfx.org
 #include <cstdlib>
 #include <functional>
 #include <numbers>
+#include <optional>
+#include <utility>
 
 #include "dfxmath.h"
 
@@ -430,114 +432,266 @@ void Scrubby::processaudio(std::span<float const* const> inAudio, std::span<floa
 	// now remember the current situation for informing the next processing block
 	mNotesWereAlreadyActive = notesActive;
 
-	for (size_t sampleIndex = 0; sampleIndex < inNumFrames; sampleIndex++)
+	// a new target is sought at the end of the frame in which a seek count runs out
+	auto const getFramesUntilNewTarget = [this, numChannels]
 	{
-		// cache first channel input audio sample so that in-place processing can overwrite it for subsequent channels
-		auto const inputValue_firstChannel = inAudio.front()[sampleIndex];
-
-		// update the buffers with the latest samples
-		if (!mFreeze)
+		auto const framesUntil = [](long seekCount)
 		{
-			for (size_t ch = 0; ch < numChannels; ch++)
-			{
-				mAudioBuffers[ch][mWritePos] = inAudio[std::min(ch, inAudio.size() - 1)][sampleIndex];
-			}
-#if 0  // melody test
-			for (size_t ch = 0; ch < numChannels; ch++)
-			{
-				mAudioBuffers[ch][mWritePos] = 0.69f * std::sin(24.f * std::numbers::pi_v<float> * (static_cast<float>(sampleIndex) / static_cast<float>(inNumFrames)));
-				mAudioBuffers[ch][mWritePos] = 0.69f * std::sin(2.f * std::numbers::pi_v<float> * (static_cast<float>(mSineCount) / 169.f));
-			}
-			// produce a sine wave of C4 when using 44.1 kHz sample rate
-			if (++mSineCount > 168)
+			return static_cast<size_t>(std::max(seekCount, 0L)) + 1;
+		};
+		auto frames = framesUntil(mSeekCount[0]);
+		if (mSplitChannels)
+		{
+			for (size_t ch = 1; ch < numChannels; ch++)
 			{
-				mSineCount = 0;
+				frames = std::min(frames, framesUntil(mSeekCount[ch]));
 			}
-#endif
 		}
+		return frames;
+	};
 
-		// write the output to the output streams, interpolated for smoothness
-		for (size_t ch = 0; ch < numChannels; ch++)
-		{
-			auto const inputValue = (ch < inAudio.size()) ? inAudio[ch][sampleIndex] : inputValue_firstChannel;
-			auto outputValue = dfx::math::InterpolateHermite(std::span(mAudioBuffers[ch]).subspan(0, mMaxAudioBufferSize), mReadPos[ch]);
-			outputValue = mHighpassFilters[ch].process(outputValue);
-			outAudio[ch][sampleIndex] = (inputValue * mInputGain.getValue()) + (outputValue * mOutputGain.getValue());
-		}
+	for (size_t spanStart = 0; spanStart < inNumFrames;)
+	{
+		auto const spanSize = std::min({inNumFrames - spanStart, getFramesUntilNewTarget(), kMaxRenderSpanSize});
+		renderSpan(inAudio, outAudio, spanStart, spanSize);
+		spanStart += spanSize;
+	}
+}
 
-		// increment/decrement the position trackers and counters
-		if (!mFreeze)
+//-----------------------------------------------------------------------------------------
+// Renders frames that are all read with the same targets, so that only the last of them 
+// can be where a seek count runs out.  The results are exactly those of going through 
+// the frames one at a time.
+void Scrubby::renderSpan(std::span<float const* const> inAudio, std::span<float* const> outAudio, size_t inOffset, size_t inSpanSize)
+{
+	assert(inSpanSize > 0);
+	assert(inSpanSize <= kMaxRenderSpanSize);
+	auto const numChannels = outAudio.size();
+	auto const spanSize_l = static_cast<long>(inSpanSize);
+	auto const writePos = mWritePos;
+
+	for (size_t i = 0; i < inSpanSize; i++)
+	{
+		mSpanInputGains[i] = mInputGain.getValue();
+		mSpanOutputGains[i] = mOutputGain.getValue();
+		incrementSmoothedAudioValues();
+	}
+
+	// the read position plan of the most recently rendered channel, for channels that are reading in unison
+	struct ReadState
+	{
+		double mReadPos = 0.0, mReadStep = 0.0, mPortamentoStep = 0.0;
+		long mMoveCount = 0;
+		bool operator==(ReadState const&) const = default;
+	};
+	auto const getReadState = [this](size_t ch)
+	{
+		return ReadState{mReadPos[ch], mReadStep[ch], mPortamentoStep[ch], mMoveCount[ch]};
+	};
+	std::optional<std::pair<ReadState, ReadState>> plannedReadStates;  // (before and after)
+	bool readsSeeSpanWrites = false;
+
+	// (in reverse, so that in-place processing doesn't overwrite the first channel's input before any 
+	// channels beyond the inputs, which share it, have taken it)
+	for (size_t ch = numChannels; ch-- > 0;)
+	{
+		auto const inputIndex = std::min(ch, inAudio.size() - 1);
+		auto const input = inAudio[inputIndex] + inOffset;
+		auto const dryInput = ((ch < inAudio.size()) ? inAudio[ch] : inAudio.front()) + inOffset;
+		auto const output = outAudio[ch] + inOffset;
+		auto const buffer = getAudioBuffer(ch);
+
+		auto const readState = getReadState(ch);
+		if (plannedReadStates && (plannedReadStates->first == readState))
 		{
-			mWritePos = (mWritePos + 1) % mMaxAudioBufferSize;
+			mReadPos[ch] = plannedReadStates->second.mReadPos;
+			mReadStep[ch] = plannedReadStates->second.mReadStep;
 		}
-		for (size_t ch = 0; ch < numChannels; ch++)
+		else
 		{
-			mSeekCount[ch]--;
-			mMoveCount[ch]--;
+			readsSeeSpanWrites = planReads(ch, inSpanSize);
+			plannedReadStates.emplace(readState, getReadState(ch));
 		}
-		//
-		// it's time to find a new target to seek
-		if (mSeekCount[0] < 0)
+
+		auto const interpolate = [this, buffer](size_t i)
 		{
-			generateNewTarget(0);
+			auto const pos = mSpanReadIndices[i];
+			return dfx::math::InterpolateHermite(buffer[pos - 1], buffer[pos], buffer[pos + 1], buffer[pos + 2], mSpanReadFractions[i]);
+		};
 
-			// copy the left channel's new values if we're in unified channels mode
-			if (!mSplitChannels)
+		// update the buffer with the latest samples, then read from it, interpolated for smoothness
+		if (mFreeze)
+		{
+			for (size_t i = 0; i < inSpanSize; i++)
 			{
-				auto const fillWithFirst = [](auto& container)
-				{
-					std::fill(std::next(container.begin()), container.end(), container.front());
-				};
-				fillWithFirst(mReadPos);
-				fillWithFirst(mReadStep);
-				fillWithFirst(mPortamentoStep);
-				fillWithFirst(mSeekCount);
-				fillWithFirst(mMoveCount);
-				fillWithFirst(mNeedResync);
+				mSpanOutput[i] = interpolate(i);
 			}
 		}
-		// find a new target to seek for the right channel if we're in split channels mode
-		if (mSplitChannels)
+		else if (readsSeeSpanWrites)
 		{
-			for (size_t ch = 1; ch < numChannels; ch++)
+			// reading right around the write position must only see what's been written so far
+			for (size_t i = 0; i < inSpanSize; i++)
 			{
-				if (mSeekCount[ch] < 0)
+				auto const pos = (writePos + static_cast<long>(i)) % mMaxAudioBufferSize;
+				buffer[pos] = input[i];
+				if ((pos < kBufferPadding) || (pos >= (mMaxAudioBufferSize - kBufferPadding)))
 				{
-					generateNewTarget(ch);
+					refreshBufferPadding(ch);
 				}
+				mSpanOutput[i] = interpolate(i);
 			}
 		}
-		//
-		// only increment the read position trackers if we're still moving towards the target
-		for (size_t ch = 0; ch < numChannels; ch++)
+		else
 		{
-			if (mMoveCount[ch] >= 0)
+			auto const firstChunkSize = std::min(spanSize_l, mMaxAudioBufferSize - writePos);
+			std::copy_n(input, firstChunkSize, buffer + writePos);
+			std::copy(input + firstChunkSize, input + inSpanSize, buffer);
+			refreshBufferPadding(ch);
+#if 0  // melody test
+			for (size_t i = 0; i < inSpanSize; i++)
 			{
-				if (mSpeedMode == kSpeedMode_DJ)
-				{
-#if USE_LINEAR_ACCELERATION
-					mReadStep[ch] += mPortamentoStep[ch];
-#else
-					mReadStep[ch] *= mPortamentoStep[ch];
+				// produce a sine wave of C4 when using 44.1 kHz sample rate
+				auto const sineCount = static_cast<float>((mSineCount + i) % 169);
+				buffer[(writePos + static_cast<long>(i)) % mMaxAudioBufferSize] = 0.69f * std::sin(2.f * std::numbers::pi_v<float> * (sineCount / 169.f));
+			}
+			refreshBufferPadding(ch);
 #endif
-				}
-				mReadPos[ch] += mReadStep[ch];
-				// wraparound the read position tracker if necessary
-				if (mReadPos[ch] >= mMaxAudioBufferSize_f)
-				{
-					mReadPos[ch] = std::fmod(mReadPos[ch], mMaxAudioBufferSize_f);
-				}
-				while (mReadPos[ch] < 0.0)
-				{
-					mReadPos[ch] += mMaxAudioBufferSize_f;
-				}
-				assert(static_cast<long>(mReadPos[ch]) >= 0);
-				assert(static_cast<long>(mReadPos[ch]) < mMaxAudioBufferSize);
+			for (size_t i = 0; i < inSpanSize; i++)
+			{
+				mSpanOutput[i] = interpolate(i);
 			}
 		}
 
-		incrementSmoothedAudioValues();
+		mHighpassFilters[ch].process(std::span(mSpanOutput).first(inSpanSize));
+
+		// write the output to the output streams
+		for (size_t i = 0; i < inSpanSize; i++)
+		{
+			output[i] = (dryInput[i] * mSpanInputGains[i]) + (mSpanOutput[i] * mSpanOutputGains[i]);
+		}
+	}
+
+	// increment/decrement the position trackers and counters
+	if (!mFreeze)
+	{
+		mWritePos = (mWritePos + spanSize_l) % mMaxAudioBufferSize;
+#if 0  // melody test
+		mSineCount = (mSineCount + inSpanSize) % 169;
+#endif
+	}
+	for (size_t ch = 0; ch < numChannels; ch++)
+	{
+		mSeekCount[ch] -= spanSize_l;
+		mMoveCount[ch] -= spanSize_l;
+	}
+	//
+	// it's time to find a new target to seek
+	if (mSeekCount[0] < 0)
+	{
+		generateNewTarget(0);
+
+		// copy the left channel's new values if we're in unified channels mode
+		if (!mSplitChannels)
+		{
+			auto const fillWithFirst = [](auto& container)
+			{
+				std::fill(std::next(container.begin()), container.end(), container.front());
+			};
+			fillWithFirst(mReadPos);
+			fillWithFirst(mReadStep);
+			fillWithFirst(mPortamentoStep);
+			fillWithFirst(mSeekCount);
+			fillWithFirst(mMoveCount);
+			fillWithFirst(mNeedResync);
+		}
 	}
+	// find a new target to seek for the right channel if we're in split channels mode
+	if (mSplitChannels)
+	{
+		for (size_t ch = 1; ch < numChannels; ch++)
+		{
+			if (mSeekCount[ch] < 0)
+			{
+				generateNewTarget(ch);
+			}
+		}
+	}
+	//
+	// the read position moves on from the last frame with whatever target it has now
+	for (size_t ch = 0; ch < numChannels; ch++)
+	{
+		if (mMoveCount[ch] >= 0)
+		{
+			advanceReadPosition(ch);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// Fills the span's read indices and fractions, advancing the channel's read position (and step) 
+// through each frame but the last, whose target might change before it moves on.
+// Returns whether any of the reads come near enough to where the span is being written 
+// that they could see samples from later frames if the whole span were written first.
+bool Scrubby::planReads(size_t channel, size_t inSpanSize)
+{
+	auto const spanSize_l = static_cast<long>(inSpanSize);
+	assert(mMaxAudioBufferSize > (spanSize_l + kBufferPadding));
+	bool nearWrites = false;
+	for (size_t i = 0; i < inSpanSize; i++)
+	{
+		auto const [posFract, pos] = dfx::math::ModF<long>(mReadPos[channel]);
+		mSpanReadIndices[i] = pos;
+		mSpanReadFractions[i] = static_cast<float>(posFract);
+
+		// the reads span pos - 1 through pos + 2, and the writes after the first frame 
+		// span (mWritePos + 1) through (mWritePos + inSpanSize - 1), around the buffer
+		auto distanceAhead = pos - mWritePos;
+		if (distanceAhead < 0)
+		{
+			distanceAhead += mMaxAudioBufferSize;
+		}
+		nearWrites |= (distanceAhead <= spanSize_l) || (distanceAhead == (mMaxAudioBufferSize - 1));
+
+		// only increment the read position tracker if we're still moving towards the target
+		if (((i + 1) < inSpanSize) && ((mMoveCount[channel] - static_cast<long>(i + 1)) >= 0))
+		{
+			advanceReadPosition(channel);
+		}
+	}
+	return nearWrites;
+}
+
+//-----------------------------------------------------------------------------------------
+void Scrubby::advanceReadPosition(size_t channel)
+{
+	if (mSpeedMode == kSpeedMode_DJ)
+	{
+#if USE_LINEAR_ACCELERATION
+		mReadStep[channel] += mPortamentoStep[channel];
+#else
+		mReadStep[channel] *= mPortamentoStep[channel];
+#endif
+	}
+	mReadPos[channel] += mReadStep[channel];
+	// wraparound the read position tracker if necessary
+	if (mReadPos[channel] >= mMaxAudioBufferSize_f)
+	{
+		mReadPos[channel] = std::fmod(mReadPos[channel], mMaxAudioBufferSize_f);
+	}
+	while (mReadPos[channel] < 0.0)
+	{
+		mReadPos[channel] += mMaxAudioBufferSize_f;
+	}
+	assert(static_cast<long>(mReadPos[channel]) >= 0);
+	assert(static_cast<long>(mReadPos[channel]) < mMaxAudioBufferSize);
+}
+
+//-----------------------------------------------------------------------------------------
+void Scrubby::refreshBufferPadding(size_t channel)
+{
+	auto const buffer = getAudioBuffer(channel);
+	std::copy_n(buffer + mMaxAudioBufferSize - kBufferPadding, kBufferPadding, buffer - kBufferPadding);
+	std::copy_n(buffer, kBufferPadding, buffer + mMaxAudioBufferSize);
 }
 
 //-----------------------------------------------------------------------------------------
@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2005-2023  Tom Murphy 7
+Copyright (C) 2005-2026  Tom Murphy 7
 
 This file is part of Slowft.
 
@@ -25,7 +25,9 @@ Slowft, featuring the Super Destroy FX Windowing System!
 
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstdio>
+#include <numbers>
 
 #include "dfxmath.h"
 
@@ -75,43 +77,54 @@ PLUGIN::PLUGIN(TARGET_API_BASE_INSTANCE_TYPE inInstance)
 
 PLUGINCORE::PLUGINCORE(DfxPlugin& inInstance)
   : DfxPluginCore(inInstance) {
-  /* determine the size of the largest window size */
-  constexpr auto maxframe = *std::ranges::max_element(buffersizes);
 
-  /* add some leeway? */
-  in0.assign(maxframe, 0.f);
-  out0.assign(maxframe * 2, 0.f);
-
-  /* prevmix is only a single third long */
-  prevmix.assign(maxframe / 2, 0.f);
+  /* freq given in hz */
+  float freq = BASE_FREQ;
+  for (size_t key = 0; key < NUM_KEYS; key++) {
+    keyomega[key] = static_cast<double>(freq) * std::numbers::pi * 2.0 / static_cast<double>(RATE);
+    keycos[key] = std::cos(keyomega[key]);
+    keysin[key] = std::sin(keyomega[key]);
+    /* go to next key */
+    freq *= HALFSTEP_RATIO;
+  }
 }
 
 
 void PLUGINCORE::reset() {
 
-  framesize = buffersizes.at(getparameter_i(P_BUFSIZE));
-  third = framesize / 2;
-  bufsize = third * 3;
-
-  /* set up buffers. Prevmix and first frame of output are always 
-     filled with zeros. XXX memset */
-
-  std::fill_n(prevmix.begin(), third, 0.f);
-  std::fill_n(out0.begin(), framesize, 0.f);
-
   /* start input at beginning. Output has a frame of silence. */
-  insize = 0;
-  outstart = 0;
-  outsize = framesize;
+  windowing.setFrameSize(dfx::math::ToUnsigned(buffersizes.at(getparameter_i(P_BUFSIZE))));
+  updatewindowshape();
 
-  dfxplugin->setlatency_samples(dfx::math::ToUnsigned(framesize));
+  dfxplugin->setlatency_samples(windowing.getLatency());
   /* tail is the same as delay, of course */
-  dfxplugin->settailsize_samples(dfx::math::ToUnsigned(framesize));
+  dfxplugin->settailsize_samples(windowing.getLatency());
+}
+
+void PLUGINCORE::updatewindowshape() {
+
+  using WindowShape = decltype(windowing)::WindowShape;
+  switch (getparameter_i(P_SHAPE)) {
+    case WINDOW_TRIANGLE:
+    default:
+      windowing.setWindowShape(WindowShape::Triangle);
+      break;
+    case WINDOW_ARROW:
+      windowing.setWindowShape(WindowShape::Arrow);
+      break;
+    case WINDOW_WEDGE:
+      windowing.setWindowShape(WindowShape::Wedge);
+      break;
+    case WINDOW_COS:
+      windowing.setWindowShape(WindowShape::Cosine);
+      break;
+  }
 }
 
 void PLUGINCORE::processparameters() {
 
-  shape = getparameter_i(P_SHAPE);
+  if (getparameterchanged(P_SHAPE))
+    updatewindowshape();
 
   #ifdef TARGET_API_VST
     /* this tells the host to call a suspend()-resume() pair, 
@@ -127,45 +140,47 @@ void PLUGINCORE::processparameters() {
    automatically overlapped. */
 void PLUGINCORE::processw(float const * in, float * out, long samples) {
 
-  /* compute the 'slow fourier transform' */
+  /* compute the 'slow fourier transform'. It's not so slow: instead
+     of a sine and cosine for every key and sample, each key runs
+     Goertzel's recurrence
 
+       g[s] = in[s] + 2 cos(w) g[s-1] - g[s-2]
 
-  /* XXX get sample rate from parameter somewhere. */
-  float rate = 44100.0f;
+     which costs one multiply-add per sample. Several keys go at once,
+     since each one's recurrence has to wait on itself. Doubles keep
+     the low keys (whose 2 cos(w) is nearly 2) accurate over long
+     windows. */
+  for (size_t firstkey = 0; firstkey < NUM_KEYS; firstkey += KEY_LANES) {
 
-  /* freq given in hz */
-  {
-    float freq = BASE_FREQ;
-    for(size_t key = 0; key < NUM_KEYS; key ++) {
-      
-      /* compute dot product */
-      sines[key] = 0.0f;
-      cosines[key] = 0.0f;
-      
-      /* PERF this is probably really inefficient. pre-computing
-         tables of sines first, at least, would probably help. */
-      for(int s = 0; s < samples; s ++) {
-
-        // float frac = ((float)s / (float)samples);
-
-        /* PERF This could be strength-reduced */
-        float seconds = ((float)s / (float)rate);
-
-        /* argument to sin, cosine. */
-        float arg = freq * seconds * SLOWFT_2PI;
-
-        sines[key] += sin(arg) * in[s];
-        cosines[key] += cos(arg) * in[s];
+    std::array<double, KEY_LANES> coeff {}, g1 {}, g2 {};
+    for (size_t k = 0; k < KEY_LANES; k++)
+      coeff[k] = 2.0 * keycos[firstkey + k];
+
+    for (long s = 0; s < samples; s++) {
+      auto const x = static_cast<double>(in[s]);
+      for (size_t k = 0; k < KEY_LANES; k++) {
+        double const g0 = x + (coeff[k] * g1[k]) - g2[k];
+        g2[k] = g1[k];
+        g1[k] = g0;
       }
+    }
+
+    for (size_t k = 0; k < KEY_LANES; k++) {
+      size_t const key = firstkey + k;
+      /* g[N-1] - e^-iw g[N-2] is the sum of in[s] e^iw(N-1-s), so
+         turning it back by w(N-1) gives the sum of in[s] e^-iws:
+         the cosine product is its real part, and the sine product
+         is minus its imaginary part. */
+      double const re = g1[k] - (keycos[key] * g2[k]);
+      double const im = keysin[key] * g2[k];
+      double const back = keyomega[key] * static_cast<double>(samples - 1);
+      double const cb = std::cos(back), sb = std::sin(back);
 
       /* XXX this normalization is wrong: it should be the
          maximum possible score, which is the area under
          the curve of abs(sin(..)) within the region. */
-      sines[key] /= (float)samples;
-      cosines[key] /= (float)samples;
-      
-      /* go to next key */
-      freq *= HALFSTEP_RATIO;
+      cosines[key] = static_cast<float>(((re * cb) + (im * sb)) / static_cast<double>(samples));
+      sines[key] = static_cast<float>(((re * sb) - (im * cb)) / static_cast<double>(samples));
     }
   }
 
@@ -186,146 +201,41 @@ void PLUGINCORE::processw(float const * in, float * out, long samples) {
   /* now generate output! */
 
   /* Start silent */
-  {
-    for(int s = 0; s < samples; s++) {
-      out[s] = 0.0f;
-    }
-  }
-
-  {
-    float freq = BASE_FREQ;
-
-    /* now add back in sines and cosines */
-    for(size_t key = 0; key < NUM_KEYS; key ++) {
-      
-      if (key == maxkey)
-      for(int s = 0; s < samples; s ++) {
-
-        float seconds = ((float)s / (float)rate);
+  std::fill_n(out, samples, 0.0f);
 
-        /* argument to sin, cosine. */
-        float arg = freq * seconds * SLOWFT_2PI;
-
-        out[s] += (sines[key] * sin(arg)) + (cosines[key] * cos(arg));
-      }
+  /* now add back in sines and cosines */
+  synthesizekey(maxkey, sines[maxkey], cosines[maxkey], out, samples);
+}
 
-      freq *= HALFSTEP_RATIO;
-    }
+void PLUGINCORE::synthesizekey(size_t key, float sine, float cosine, float * out, long samples) const {
+
+  /* y[s] = sine sin(ws) + cosine cos(ws) obeys the same recurrence,
+     y[s] = 2 cos(w) y[s-1] - y[s-2], so after its first two samples
+     the rest come without any sines or cosines at all. */
+  double const coeff = 2.0 * keycos[key];
+  double y2 = static_cast<double>(cosine);
+  double y1 = (static_cast<double>(sine) * keysin[key]) + (static_cast<double>(cosine) * keycos[key]);
+  if (samples > 0)
+    out[0] += static_cast<float>(y2);
+  if (samples > 1)
+    out[1] += static_cast<float>(y1);
+  for (long s = 2; s < samples; s++) {
+    double const y0 = (coeff * y1) - y2;
+    out[s] += static_cast<float>(y0);
+    y2 = y1;
+    y1 = y0;
   }
 }
 
 
-/* this fake process function reads samples one at a time
-   from the true input. It simultaneously copies samples from
-   the beginning of the output buffer to the true output.
-   We maintain that out0 always has at least 'third' samples
-   in it; this is enough to pick up for the delay of input
-   processing and to make sure we always have enough samples
-   to fill the true output buffer.
-
-   If the input frame is full:
-    - calls wprocess on this full input frame
-    - applies the windowing envelope to the tail of out0 (output frame)
-    - mixes in prevmix with the first half of the output frame
-    - increases outsize so that the first half of the output frame is
-      now available output
-    - copies the second half of the output to be prevmix for next frame.
-    - copies the second half of the input buffer to the first,
-      resets the size (thus we process each third-size chunk twice)
-
-  If we have read more than 'third' samples out of the out0 buffer:
-   - Slide contents to beginning of buffer
-   - Reset outstart
-
-*/
-
-/* to improve: 
-   - use memcpy and arithmetic instead of
-     sample-by-sample copy 
-   - can we use tail of out0 as prevmix, instead of copying?
-   - can we use circular buffers instead of memmoving a lot?
-     (probably not)
-*/
-
-
+/* the windowing engine takes care of everything else: it collects
+   the true input into half-overlapping frames for processw, applies
+   the window envelope to each processed frame, and crossfades it with
+   the tail of the previous one on the way to the true output. */
 void PLUGINCORE::process(std::span<float const> tin, std::span<float> tout) {
-  int z = 0;
-
-  for (size_t ii = 0; ii < tout.size(); ii++) {
-
-    /* copy sample in */
-    in0[insize] = tin[ii];
-    insize ++;
- 
-    if (insize == framesize) {
-      /* frame is full! */
-
-      /* in0 -> process -> out0(first free space) */
-      processw(in0.data(), out0.data()+outstart+outsize, framesize);
-
-      float oneDivThird = 1.0f / (float)third;
-      /* apply envelope */
-
-      switch(shape) {
-
-        case WINDOW_TRIANGLE:
-          for(z = 0; z < third; z++) {
-            out0[z+outstart+outsize] *= ((float)z * oneDivThird);
-            out0[z+outstart+outsize+third] *= (1.0f - ((float)z * oneDivThird));
-          }
-          break;
-        case WINDOW_ARROW:
-          for(z = 0; z < third; z++) {
-            float p = (float)z * oneDivThird;
-            p *= p;
-            out0[z+outstart+outsize] *= p;
-            out0[z+outstart+outsize+third] *= (1.0f - p);
-          }
-          break;
-        case WINDOW_WEDGE:
-          for(z = 0; z < third; z++) {
-            float p = sqrtf((float)z * oneDivThird);
-            out0[z+outstart+outsize] *= p;
-            out0[z+outstart+outsize+third] *= (1.0f - p);
-          }
-          break;
-        case WINDOW_COS:
-          for(z = 0; z < third; z ++) {
-            float p = 0.5f * (-cosf(PI * ((float)z * oneDivThird)) + 1.0f);
-            out0[z+outstart+outsize] *= p;
-            out0[z+outstart+outsize+third] *= (1.0f - p);
-          }
-          break;
-      }
-
-      /* mix in prevmix */
-      for(int u = 0; u < third; u ++)
-        out0[u+outstart+outsize] += prevmix[u];
-
-      /* prevmix becomes out1 */
-      std::copy_n(std::next(out0.cbegin(), outstart + outsize + third), third, prevmix.begin());
-
-      /* copy 2nd third of input over in0 (need to re-use it for next frame), 
-         now insize = third */
-      std::copy_n(std::next(in0.cbegin(), third), third, in0.begin());
-
-      insize = third;
-      
-      outsize += third;
-    }
-
-    /* send sample out */
-    tout[ii] = out0[outstart];
-
-    outstart ++;
-    outsize --;
-
-    /* make sure there is always enough room for a frame in out buffer */
-    if (outstart == third) {
-      memmove(out0.data(), out0.data() + outstart, outsize * sizeof (float));
-      outstart = 0;
-    }
-  }
+  windowing.process(tin, tout, [this](float const * in, float * out, size_t samples) {
+    processw(in, out, static_cast<long>(samples));
+  });
 }
 
 
@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2005-2023  Tom Murphy 7
+Copyright (C) 2005-2026  Tom Murphy 7
 
 This file is part of Slowft.
 
@@ -23,11 +23,12 @@ Slowft, starring the Super Destroy FX Windowing System!
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <numbers>
-#include <vector>
 
 #include "dfxplugin.h"
+#include "dfxwindowing.h"
 
 /* change these for your plugins */
 #define PLUGIN Slowft
@@ -75,40 +76,36 @@ public:
   void processparameters() override;
   void process(std::span<float const> in, std::span<float> out) override;
 
-  long getwindowsize() const noexcept { return third; }
+  long getwindowsize() const noexcept { return static_cast<long>(windowing.getHopSize()); }
 
 private:
   static constexpr float BASE_FREQ = 27.5f;
   static constexpr size_t NUM_KEYS = 88;
   static constexpr float HALFSTEP_RATIO = 1.05946309436f;
   static constexpr float SLOWFT_2PI = std::numbers::pi_v<float> * 2.f;
-
-  /* input and output buffers. out is framesize*2 samples long, in is framesize
-     samples long. (for maximum framesize)
-  */
-  std::vector<float> in0, out0;
-
-  /* bufsize is 3 * third, framesize is 2 * third 
-     bufsize is used for outbuf.
-  */
-  long bufsize = 0, framesize = 0, third = 0;
+  /* XXX get sample rate from parameter somewhere. */
+  static constexpr float RATE = 44100.0f;
+  /* keys analyzed side by side, which keeps the processor busy */
+  static constexpr size_t KEY_LANES = 8;
+  static_assert(NUM_KEYS % KEY_LANES == 0);
 
   void processw(float const * in, float * out, long samples);
+  /* adds the key's sinusoid, with the given sine and cosine
+     amplitudes, to the output */
+  void synthesizekey(size_t key, float sine, float cosine, float * out, long samples) const;
 
-  int shape = 0;
-
-  /* third-sized tail of previous processed frame. already has mixing envelope
-     applied.
-   */
-  std::vector<float> prevmix;
+  void updatewindowshape();
 
-  /* number of samples in in0 */
-  int insize = 0;
+  /* overlapping frames of input go to processw, and its
+     windowed output comes back overlapped */
+  dfx::OverlapAdd<float> windowing {static_cast<size_t>(*std::ranges::max_element(buffersizes))};
 
-  /* number of samples and starting position of valid samples in out0 */
-  int outsize = 0;
-  int outstart = 0;
 
+  /* per key, the angle that it advances each sample, and its
+     cosine and sine */
+  std::array<double, NUM_KEYS> keyomega {};
+  std::array<double, NUM_KEYS> keycos {};
+  std::array<double, NUM_KEYS> keysin {};
 
   /* the transformed data */
   float sines[NUM_KEYS] {};
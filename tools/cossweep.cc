@@ -0,0 +1,88 @@
+// Checks dfx::math::FastCos, and the angles that RezSynth feeds it,
+// across the full range of RezSynth's parameters. Exits nonzero on
+// any failure.
+
+#include "dfxmath.h"
+
+#include <array>
+#include <cmath>
+#include <stdio.h>
+
+using namespace std;
+
+static int failures = 0;
+
+static void Check(bool ok, const char *what, double x, double got,
+                  double want) {
+  if (!ok) {
+    if (failures < 20) {
+      printf("FAIL %s: x=%.17g got=%.17g want=%.17g\n", what, x, got, want);
+    }
+    failures++;
+  }
+}
+
+int main(int argc, char **argv) {
+
+  // FastCos itself, over its whole documented range.
+  {
+    constexpr double LIMIT = 1048576.0 * 3.14159265358979323846;
+    double worst = 0.0;
+    for (double x = -LIMIT; x < LIMIT; x += 0.0937) {
+      const double got = dfx::math::FastCos(x);
+      const double want = std::cos(x);
+      const double err = std::fabs(got - want);
+      worst = std::max(worst, err);
+      Check(err < 1.0e-12, "FastCos", x, got, want);
+    }
+    printf("FastCos max error over |x| < 2^20 pi: %.3g\n", worst);
+  }
+
+  // Every band's center frequency that RezSynth can produce: notes
+  // 0-127, pitch bend of up to 36 semitones either way, octaval
+  // separation up to 36 semitones or linear separation up to 3x,
+  // with up to 30 bands, and foldover allowing all of it.
+  constexpr std::array SAMPLE_RATES = {
+    22050.0, 44100.0, 48000.0, 88200.0, 96000.0, 192000.0, 384000.0
+  };
+  constexpr int MAX_BANDS = 30;
+  int64_t count = 0;
+  double worst = 0.0;
+  for (const double samplerate : SAMPLE_RATES) {
+    for (int note = 0; note < 128; note++) {
+      for (double bend = -36.0; bend <= 36.0; bend += 6.0) {
+        const double baseFreq =
+          440.0 * std::exp2((note - 69 + bend) / 12.0);
+        for (double sep = 0.0; sep <= 36.0; sep += 0.25) {
+          for (int band = 0; band < MAX_BANDS; band++) {
+            for (const double freq :
+                   {baseFreq * std::exp2(sep / 12.0 * band),
+                    baseFreq + baseFreq * (sep / 12.0) * band}) {
+              const double angle =
+                dfx::math::GetAngularFrequency(freq, samplerate);
+              Check(std::fabs(angle) < 2.0 * 3.14159265358979323846,
+                    "angle range", freq, angle, 0.0);
+              const double got = dfx::math::FastCos(angle);
+              const double want = std::cos(angle);
+              const double err = std::fabs(got - want);
+              worst = std::max(worst, err);
+              Check(std::isfinite(got) && err < 1.0e-12,
+                    "band cosine", freq, got, want);
+              // the resonator's feedback coefficient (pole radius r <= 1)
+              // must stay within the stable range
+              const double coeff = 2.0 * got;
+              Check(std::fabs(coeff) <= 2.0 + 1.0e-12,
+                    "coefficient", freq, coeff, 2.0);
+              count++;
+            }
+          }
+        }
+      }
+    }
+  }
+  printf("%lld band angles, max cosine error %.3g\n",
+         (long long)count, worst);
+
+  printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+
+// Benchmarks dfx::FFT against the bundled FFTW 2 (rfftw), and checks
+// that they agree, at every size that dfx::FFT supports.
+
+#include "dfxfft.h"
+#include "rfftw.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// microseconds per call of f, the best of several trials of about
+// 20 milliseconds each (so that other things running count less)
+template <typename F>
+static double Time(F f) {
+  double best = 0.0;
+  for (int trial = 0; trial < 7; trial++) {
+    int64_t iters = 0;
+    const auto time_start = std::chrono::steady_clock::now();
+    double seconds = 0.0;
+    do {
+      for (int i = 0; i < 16; i++) f();
+      iters += 16;
+      const std::chrono::duration<double> time_elapsed =
+        std::chrono::steady_clock::now() - time_start;
+      seconds = time_elapsed.count();
+    } while (seconds < 0.02);
+    const double us = (seconds * 1.0e6) / iters;
+    if (trial == 0 || us < best) best = us;
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+
+  // FFTW_MEASURE is fairer to FFTW, but takes a while to plan
+  const bool measure = (argc > 1) && (string(argv[1]) == "measure");
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+  printf("%6s  %12s %12s %8s  %12s %12s %8s  %10s %10s\n",
+         "size", "fftw fwd us", "dfx fwd us", "speedup",
+         "fftw inv us", "dfx inv us", "speedup", "fwd error", "inv error");
+
+  for (size_t n = dfx::FFT::kMinSize; n <= dfx::FFT::kMaxSize; n *= 2) {
+    vector<float> in(n), fftwout(n), dfxout(n), fftwback(n), dfxback(n), scratch(n);
+    for (float &f : in) f = dist(rng);
+
+    rfftw_plan fplan = rfftw_create_plan(n, FFTW_REAL_TO_COMPLEX,
+                                         measure ? FFTW_MEASURE : FFTW_ESTIMATE);
+    rfftw_plan iplan = rfftw_create_plan(n, FFTW_COMPLEX_TO_REAL,
+                                         measure ? FFTW_MEASURE : FFTW_ESTIMATE);
+    dfx::FFT fft(n);
+
+    // both in the halfcomplex layout, so that they can be compared directly
+    rfftw_one(fplan, in.data(), fftwout.data());
+    fft.forwardHalfComplex(in.data(), dfxout.data());
+    // (FFTW's inverse destroys its input)
+    scratch = fftwout;
+    rfftw_one(iplan, scratch.data(), fftwback.data());
+    fft.inverseHalfComplex(fftwout.data(), dfxback.data());
+
+    // relative to the largest value
+    auto Error = [](const vector<float> &a, const vector<float> &b) {
+      double diff = 0.0, mag = 0.0;
+      for (size_t i = 0; i < a.size(); i++) {
+        diff = std::max(diff, (double)std::fabs(a[i] - b[i]));
+        mag = std::max(mag, (double)std::fabs(a[i]));
+      }
+      return (mag > 0.0) ? (diff / mag) : diff;
+    };
+    const double ferr = Error(fftwout, dfxout);
+    const double ierr = Error(fftwback, dfxback);
+
+    const double fftwf = Time([&]() { rfftw_one(fplan, in.data(), fftwout.data()); });
+    const double dfxf = Time([&]() { fft.forwardHalfComplex(in.data(), dfxout.data()); });
+    // both copy the input first, so that FFTW transforms the same thing every time
+    const double fftwi = Time([&]() {
+        std::copy(fftwout.begin(), fftwout.end(), scratch.begin());
+        rfftw_one(iplan, scratch.data(), fftwback.data());
+      });
+    const double dfxi = Time([&]() {
+        std::copy(fftwout.begin(), fftwout.end(), scratch.begin());
+        fft.inverseHalfComplex(scratch.data(), dfxback.data());
+      });
+
+    printf("%6d  %12.3f %12.3f %7.2fx  %12.3f %12.3f %7.2fx  %10.2g %10.2g\n",
+           (int)n, fftwf, dfxf, fftwf / dfxf, fftwi, dfxi, fftwi / dfxi, ferr, ierr);
+
+    rfftw_destroy_plan(fplan);
+    rfftw_destroy_plan(iplan);
+  }
+
+  return 0;
+}
@@ -0,0 +1,24 @@
+// Prefix header for morphcheck, which builds the dfx-library preset
+// morphing code into a bare VST DfxPlugin with DSP cores.
+
+#ifndef MORPHCHECK_DEF_H
+#define MORPHCHECK_DEF_H
+
+#include "dfxplugin-prefix.h"
+
+#define PLUGIN_NAME_STRING "morphcheck"
+#define PLUGIN_ID FOURCC('m', 'c', 'h', 'k')
+#define PLUGIN_VERSION_MAJOR 1
+#define PLUGIN_VERSION_MINOR 0
+#define PLUGIN_VERSION_BUGFIX 0
+#define PLUGIN_CLASS_NAME MorphCheck
+#define PLUGIN_BUNDLE_IDENTIFIER DESTROYFX_BUNDLE_ID_PREFIX "MorphCheck" DFX_BUNDLE_ID_SUFFIX
+#define PLUGIN_COPYRIGHT_YEAR_STRING "2026"
+#define TARGET_PLUGIN_USES_MIDI 0
+#define TARGET_PLUGIN_IS_INSTRUMENT 0
+#define TARGET_PLUGIN_USES_DSPCORE 1
+#define TARGET_PLUGIN_HAS_GUI 0
+
+#define VST_NUM_CHANNELS 2
+
+#endif
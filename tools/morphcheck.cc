@@ -0,0 +1,132 @@
+// Checks that a preset morph reaches DSP cores in the block that it is
+// applied in: the value that a core reads and the parameter's changed
+// flag both have to agree with the morph position. Also checks that
+// morphing leaves the stored presets alone. Exits nonzero on any
+// failure.
+
+#include "dfxplugin.h"
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <optional>
+
+using namespace std;
+
+enum : dfx::ParameterID { P_LEVEL, P_STEPS, NUM_PARAMETERS };
+static constexpr size_t NUM_PRESETS = 2;
+static constexpr size_t BLOCK = 64;
+
+class MorphCheckDSP final : public DfxPluginCore {
+public:
+  explicit MorphCheckDSP(DfxPlugin &inDfxPlugin)
+    : DfxPluginCore(inDfxPlugin) {}
+
+  void processparameters() override {
+    changedlevel = getparameterifchanged_f(P_LEVEL);
+    changedsteps = getparameterifchanged_i(P_STEPS);
+  }
+
+  void process(std::span<float const> inAudio,
+               std::span<float> outAudio) override {
+    level = getparameter_f(P_LEVEL);
+    steps = getparameter_i(P_STEPS);
+    std::ranges::copy(inAudio, outAudio.begin());
+  }
+
+  // what the core saw in the most recent block
+  std::optional<double> changedlevel;
+  std::optional<int64_t> changedsteps;
+  double level = -1.0;
+  int64_t steps = -1;
+};
+
+class MorphCheck final : public DfxPlugin {
+public:
+  explicit MorphCheck(TARGET_API_BASE_INSTANCE_TYPE inInstance)
+    : DfxPlugin(inInstance, NUM_PARAMETERS, NUM_PRESETS) {
+    initparameter_f(P_LEVEL, {"level"}, 0.0, 0.0, 0.0, 1.0);
+    initparameter_i(P_STEPS, {"steps"}, 0, 0, 0, 10);
+    setpresetname(0, "low");
+    setpresetname(1, "high");
+  }
+
+  void dfx_PostConstructor() override {
+    setpresetparameter_f(0, P_LEVEL, 0.0);
+    setpresetparameter_i(0, P_STEPS, 2);
+    setpresetparameter_f(1, P_LEVEL, 1.0);
+    setpresetparameter_i(1, P_STEPS, 8);
+  }
+
+  MorphCheckDSP &core(size_t ch) {
+    return *static_cast<MorphCheckDSP *>(getplugincore(ch));
+  }
+};
+
+DFX_CORE_ENTRY(MorphCheckDSP)
+
+static VstIntPtr Callback(AEffect *, VstInt32, VstInt32, VstIntPtr,
+                          void *, float) {
+  return 0;
+}
+
+static int failures = 0;
+
+static void Check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+int main(int argc, char **argv) {
+  MorphCheck plugin(Callback);
+  plugin.do_PostConstructor();
+  plugin.resume();
+  plugin.loadpreset(0);
+
+  std::array<float, BLOCK> in {}, out0 {}, out1 {};
+  std::array<float *, 2> inputs {in.data(), in.data()};
+  std::array<float *, 2> outputs {out0.data(), out1.data()};
+  auto Render = [&]() {
+    plugin.processReplacing(inputs.data(), outputs.data(), BLOCK);
+  };
+  Render();
+
+  Check(plugin.setpresetmorph(0, 1), "setpresetmorph");
+  for (const double position : {0.25, 0.75, 0.0, 0.5}) {
+    plugin.setpresetmorphposition(position);
+    Render();
+    const int64_t wantsteps = (position < 0.5) ? 2 : 8;
+    for (size_t ch = 0; ch < 2; ch++) {
+      const MorphCheckDSP &core = plugin.core(ch);
+      printf("position %.2f channel %zu: level %.3f (changed %s), "
+             "steps %lld\n", position, ch, core.level,
+             core.changedlevel ? "yes" : "no", (long long)core.steps);
+      Check(std::fabs(core.level - position) < 1.0e-6,
+            "the core read the morphed value in the same block");
+      Check(core.changedlevel && std::fabs(*core.changedlevel - position) < 1.0e-6,
+            "the core saw the morph as a change in the same block");
+      Check(core.steps == wantsteps, "discrete value switches at the midpoint");
+    }
+
+    // nothing moved, so the next block has no changes
+    Render();
+    Check(!plugin.core(0).changedlevel && !plugin.core(0).changedsteps,
+          "no change flagged once the morph position holds still");
+    Check(std::fabs(plugin.core(0).level - position) < 1.0e-6,
+          "the value holds in the following block");
+  }
+
+  // preset 0 is the current one, and morphing must not overwrite it
+  Check(plugin.getpresetparameter_f(0, P_LEVEL) == 0.0 &&
+        plugin.getpresetparameter_i(0, P_STEPS) == 2,
+        "the current preset keeps its stored values");
+  Check(plugin.getpresetparameter_f(1, P_LEVEL) == 1.0 &&
+        plugin.getpresetparameter_i(1, P_STEPS) == 8,
+        "the other preset keeps its stored values");
+
+  plugin.do_PreDestructor();
+  printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,25 @@
+// Prefix header for settingsbench, which builds the dfx-library
+// settings code against a bare VST DfxPlugin.
+
+#ifndef SETTINGSBENCH_DEF_H
+#define SETTINGSBENCH_DEF_H
+
+#include "dfxplugin-prefix.h"
+
+#define PLUGIN_NAME_STRING "settingsbench"
+#define PLUGIN_ID FOURCC('s', 'b', 'n', 'c')
+#define PLUGIN_VERSION_MAJOR 1
+#define PLUGIN_VERSION_MINOR 0
+#define PLUGIN_VERSION_BUGFIX 0
+#define PLUGIN_CLASS_NAME SettingsBench
+#define PLUGIN_BUNDLE_IDENTIFIER DESTROYFX_BUNDLE_ID_PREFIX "SettingsBench" DFX_BUNDLE_ID_SUFFIX
+#define PLUGIN_COPYRIGHT_YEAR_STRING "2026"
+// DfxSettings only exists for plugins that use MIDI
+#define TARGET_PLUGIN_USES_MIDI 1
+#define TARGET_PLUGIN_IS_INSTRUMENT 0
+#define TARGET_PLUGIN_USES_DSPCORE 0
+#define TARGET_PLUGIN_HAS_GUI 0
+
+#define VST_NUM_CHANNELS 2
+
+#endif
@@ -1,6 +1,8 @@
 
 #include "trans.hpp"
 
+#include "dfxfftplan.h"
+
 #include <windows.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -24,7 +26,7 @@ PLUGIN::PLUGIN(audioMasterCallback audioMaster)
   fftbuf = (float*)malloc((MAXFRAME + 4) * sizeof (float));
 
   lastsamples = 2048;
-  plan = rfftw_create_plan(2048, FFTW_FORWARD, FFTW_ESTIMATE);
+  plan = dfx::GetRealFFTPlan(2048, FFTW_REAL_TO_COMPLEX);
   olddir = (inverse < 0.5);
 
   setup();
@@ -34,8 +36,6 @@ PLUGIN::~PLUGIN() {
 
   free(fftbuf);
 
-  rfftw_destroy_plan(plan);
-
 }
 
 void PLUGIN::setParameter(long index, float value) {
@@ -167,14 +167,16 @@ void PLUGIN::process(float **inputs, float **outputs, long samples) {
   } else if (function <= 1.0) {
     if (samples > MAXFRAME) samples = MAXFRAME;
 
+    /* only planned the first time any instance uses this size and
+       direction; after that the cache just hands it back */
     if (lastsamples != samples || olddir != (inverse < 0.5)) {
-      rfftw_destroy_plan(plan);
-      plan = rfftw_create_plan(lastsamples=samples, 
-			       (inverse < 0.5)?FFTW_FORWARD:FFTW_BACKWARD, 
-			       FFTW_ESTIMATE);
+      plan = dfx::GetRealFFTPlan(lastsamples=samples, 
+				 (inverse < 0.5)?FFTW_REAL_TO_COMPLEX:FFTW_COMPLEX_TO_REAL);
       olddir = (inverse < 0.5);
     }
 
+    if (!plan) return;
+
     rfftw_one(plan, in, fftbuf);
 
     if (inverse < 0.5) {
@@ -95,6 +95,7 @@ protected:
   double deriv_last;
   double integrate_sum;
 
+  /* shared, from dfx::GetRealFFTPlan, so never destroyed here */
   rfftw_plan plan;
   int lastsamples;
   int olddir;
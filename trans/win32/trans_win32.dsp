@@ -43,7 +43,7 @@ RSC=rc.exe
 # PROP Ignore_Export_Lib 0
 # PROP Target_Dir ""
 # ADD BASE CPP /nologo /MT /W3 /GX /O2 /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_MBCS" /D "_USRDLL" /D "TRANS_WIN32_EXPORTS" /YX /FD /c
-# ADD CPP /nologo /MT /W3 /Ox /Ot /Og /Oi /Ob2 /I "../fftw/fftw" /I "../fftw/rfftw" /I "../vstsdk/" /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_MBCS" /D "_USRDLL" /D "TRANS_WIN32_EXPORTS" /YX /FD /c
+# ADD CPP /nologo /MT /W3 /Ox /Ot /Og /Oi /Ob2 /I "../fftw/fftw" /I "../fftw/rfftw" /I "../vstsdk/" /I "../dfx-library/" /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_MBCS" /D "_USRDLL" /D "TRANS_WIN32_EXPORTS" /YX /FD /c
 # SUBTRACT CPP /Oa /Ow
 # ADD BASE MTL /nologo /D "NDEBUG" /mktyplib203 /win32
 # ADD MTL /nologo /D "NDEBUG" /mktyplib203 /win32
@@ -70,7 +70,7 @@ LINK32=link.exe
 # PROP Ignore_Export_Lib 0
 # PROP Target_Dir ""
 # ADD BASE CPP /nologo /MTd /W3 /Gm /GX /ZI /Od /D "WIN32" /D "_DEBUG" /D "_WINDOWS" /D "_MBCS" /D "_USRDLL" /D "TRANS_WIN32_EXPORTS" /YX /FD /GZ /c
-# ADD CPP /nologo /MTd /W3 /Gm /ZI /Od /I "../vstsdk/" /I "../fftw/fftw" /I "../fftw/rfftw" /D "WIN32" /D "_DEBUG" /D "_WINDOWS" /D "_MBCS" /D "_USRDLL" /D "TRANS_WIN32_EXPORTS" /YX /FD /GZ /c
+# ADD CPP /nologo /MTd /W3 /Gm /ZI /Od /I "../vstsdk/" /I "../dfx-library/" /I "../fftw/fftw" /I "../fftw/rfftw" /D "WIN32" /D "_DEBUG" /D "_WINDOWS" /D "_MBCS" /D "_USRDLL" /D "TRANS_WIN32_EXPORTS" /YX /FD /GZ /c
 # ADD BASE MTL /nologo /D "_DEBUG" /mktyplib203 /win32
 # ADD MTL /nologo /D "_DEBUG" /mktyplib203 /win32
 # ADD BASE RSC /l 0x409 /d "_DEBUG"
@@ -667,6 +667,14 @@ SOURCE=..\fftw\fftw\wisdom.c
 SOURCE=..\fftw\fftw\wisdomio.c
 # End Source File
 # End Group
+# Begin Group "dfxlibrary_code"
+
+# PROP Default_Filter "*.cpp"
+# Begin Source File
+
+SOURCE=..\dfx-library\dfxfftplan.cpp
+# End Source File
+# End Group
 # Begin Source File
 
 SOURCE=..\trans\trans.cpp
@@ -735,6 +743,14 @@ SOURCE=..\fftw\fftw\fftw.h
 SOURCE=..\fftw\rfftw\rfftw.h
 # End Source File
 # End Group
+# Begin Group "dfxlibrary_h"
+
+# PROP Default_Filter "*.h"
+# Begin Source File
+
+SOURCE=..\dfx-library\dfxfftplan.h
+# End Source File
+# End Group
 # Begin Source File
 
 SOURCE=..\trans\trans.hpp
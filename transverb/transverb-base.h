@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2001-2022  Tom Murphy 7 and Sophia Poirier
+Copyright (C) 2001-2026  Tom Murphy 7 and Sophia Poirier
 
 This file is part of Transverb.
 
@@ -48,12 +48,15 @@ enum : dfx::ParameterID
 	kTomsound,
 	kFreeze,
 	kAttenuateFeedbackByMixLevel,
+	kHeadCount,
 
 	kNumParameters
 };
 
 
 static constexpr size_t kNumDelays = 2;
+// additional heads have no parameters of their own and are spread between the settings of heads 1 and 2
+static constexpr size_t kMaxHeads = 16;
 
 static constexpr std::array<dfx::ParameterID, kNumDelays> kSpeedParameters { kSpeed1, kSpeed2 };
 static constexpr std::array<dfx::ParameterID, kNumDelays> kFeedParameters { kFeed1, kFeed2 };
@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2001-2023  Tom Murphy 7 and Sophia Poirier
+Copyright (C) 2001-2026  Tom Murphy 7 and Sophia Poirier
 
 This file is part of Transverb.
 
@@ -36,6 +36,15 @@ To contact the author, use the contact form at http://destroyfx.org
 #include "transverb-base.h"
 
 
+// Define this as 1 for a memory-lean build in which the two parameterized heads share a single
+// history buffer (half the memory), with the feedback of both heads summed into it.
+// The sound is unchanged when the feedback of both heads is zero.  Otherwise the heads hear
+// each other's feedback, and their combined feedback is scaled down if it exceeds unity.
+#ifndef TRANSVERB_SHARED_HISTORY
+  #define TRANSVERB_SHARED_HISTORY  0
+#endif
+
+
 class TransverbDSP final : public DfxPluginCore {
 
 public:
@@ -51,6 +60,13 @@ private:
   static constexpr size_t kNumFIRTaps = 23;
   static constexpr double kFIRSpeedThreshold = 5.;
   static constexpr double kUnitySpeed = 1.;
+  // each head's history is padded on either end with copies of the samples from the opposite end,
+  // enough for the neighbors of interpolated reads and for IIR preprocessing to need no wraparound
+  static constexpr int kBufferPadding = 4;
+  // heads are rendered one at a time across this many samples, summing into a stack buffer
+  static constexpr size_t kMaxHeadBlockSize = 512;
+  // whether all heads read from the first head's history (the others then have none of their own)
+  static constexpr bool kSharedHistory = TRANSVERB_SHARED_HISTORY;
 
   enum class FilterMode { None, Highpass, LowpassIIR, LowpassFIR };
 
@@ -59,7 +75,11 @@ private:
     dfx::SmoothedValue<float> mix, feed;
 
     double read = 0.;
-    std::vector<float> buf;
+    std::vector<float> bufStorage;  // the history (of which bsize samples are in use) plus its padding
+    // the padding past the end overlays history beyond bsize, which is kept here 
+    // so that it reads back as it was if the buffer grows again
+    std::array<float, kBufferPadding> historyUnderPadding {};
+    int paddedBsize = 0;  // the bsize that the padding currently mirrors (0 if none yet)
 
     dfx::IIRFilter filter;
     std::array<float, kNumFIRTaps> firCoefficients {};
@@ -70,9 +90,60 @@ private:
     float lastdelayval = 0.f;
 
     void reset();
+
+    float* buf() noexcept {
+      return bufStorage.data() + kBufferPadding;
+    }
+    // writes into the history, mirroring the sample into the padding if it is near an end
+    void write(int pos, float value, int bsize);
+    void refreshBufferPadding(int bsize);
+  };
+
+  // per-head filter state that carries across the blocks of a single process call
+  struct HeadFilterState {
+    FilterMode filtermode = FilterMode::None;
+    int speed_int = 0;  // int version of the speed value, for reducing casting operations
+    int lowpasspos = 0;  // position tracker for the lowpass filter
+    float mug = 1.f;  // make-up gain for lowpass filtering
+    int prevread_int = 0;  // the read position before the most recent advance
+  };
+
+  // with a shared history, the head's feedback is summed into feedbacksums rather than written
+  void processHead(Head& head, HeadFilterState& filterState, std::span<float const> inAudio, std::span<float> delaysums,
+                   std::span<float> feedbacksums, size_t blockPosition, int blockWriter, int writerIncrement,
+                   bool attenuateFeedbackByMixLevel);
+  // feeds the head's filter the history traversed during the latest sample, including what was just written
+  void feedFilterHistory(Head& head, HeadFilterState& filterState, float const* buf, int read_int);
+
+  // when there are more than the two parameterized heads, all of them read from (and feed back into)
+  // the first head's history, and each head's state occupies one lane of these SIMD-friendly arrays
+  static constexpr size_t kHeadLaneAlignment = 64;
+  template <typename T>
+  struct alignas(kHeadLaneAlignment) HeadLaneValues : public std::array<T, dfx::TV::kMaxHeads> {};
+
+  struct HeadLanes {
+    HeadLaneValues<float> position {};  // where each head lies between head 1 (0) and head 2 (1)
+    HeadLaneValues<double> read {};
+    HeadLaneValues<int> smoothcount {};
+    HeadLaneValues<float> smoothstep {}, lastdelayval {};
+    // ultra hi-fi filtering is FIR lowpassing at the read position above unity speed, otherwise highpassing
+    // of the read output (the highpass state runs in every lane so that heads can cross unity speed cleanly)
+    std::array<std::array<float, kNumFIRTaps>, dfx::TV::kMaxHeads> firCoefficients {};
+    HeadLaneValues<float> mug {};
+    HeadLaneValues<float> highpassPrevIn {}, highpassPrevPrevIn {}, highpassPrevOut {}, highpassPrevPrevOut {};
+    bool speedHasChanged = true;
+
+    void reset();
   };
 
-  static constexpr float interpolateHermite(std::span<float const> data, double readaddress, int writeaddress);
+  void processHeadsInterleaved(std::span<float const> inAudio, std::span<float> outAudio, int writerIncrement, bool attenuateFeedbackByMixLevel);
+
+  void processHeadLanes(std::span<float const> inAudio, std::span<float> outAudio, int writerIncrement, bool attenuateFeedbackByMixLevel);
+  // places the read positions of the heads whose distances derive from those of heads 1 and/or 2
+  void positionHeadLanes(bool head1DistanceChanged, bool head2DistanceChanged);
+
+  // reads from a padded history, so the neighbors at either end need no wraparound
+  static constexpr float interpolateHermite(float const* data, double readaddress, int writeaddress, int bsize);
   // uses only the fractional portion of the address
   static constexpr float interpolateLinear(float value1, float value2, double address)
   {
@@ -80,6 +151,8 @@ private:
     return std::lerp(value1, value2, posFract);
   }
   static constexpr float interpolateLinear(std::span<float const> data, double readaddress/*, int writeaddress*/);
+  // linearly interpolates the two FIR-lowpassed samples preceding the read position
+  static float interpolateLowpassFIR(std::span<float const> history, std::span<float const> coefficients, double readaddress);
 
   // negative input values are bumped into non-negative range by incremements of modulo
   static constexpr int mod_bipolar(int value, int modulo);
@@ -91,8 +164,12 @@ private:
   long quality = 0;
   bool tomsound = false;
 
+  size_t numHeads = dfx::TV::kNumDelays;
+
   int writer = 0;
   std::array<Head, dfx::TV::kNumDelays> heads;
+  HeadLanes headLanes;
+  dfx::IIRFilter::Coefficients headLaneHighpassCoefficients;
 
   int const MAXBUF;  // the size of the audio buffer (dependent on sampling rate)
 
@@ -153,39 +230,42 @@ inline double TransverbDSP::fmod_bipolar(double value, double modulo) {
   return std::fmod(value, modulo);
 }
 
-constexpr float TransverbDSP::interpolateHermite(std::span<float const> data, double readaddress,
-                                                 int writeaddress) {
+inline void TransverbDSP::Head::write(int pos, float value, int bsize) {
+  assert(pos >= 0);
+  assert(pos < bsize);
+  auto const data = buf();
+  data[pos] = value;
+  // (these loop more than once only for buffers smaller than the padding)
+  for (auto mirrorPos = pos + bsize; mirrorPos < (bsize + kBufferPadding); mirrorPos += bsize) {
+    data[mirrorPos] = value;
+  }
+  for (auto mirrorPos = pos - bsize; mirrorPos >= -kBufferPadding; mirrorPos -= bsize) {
+    data[mirrorPos] = value;
+  }
+}
+
+constexpr float TransverbDSP::interpolateHermite(float const* data, double readaddress,
+                                                 int writeaddress, int bsize) {
   assert(readaddress >= 0.);
   assert(writeaddress >= 0);
-  assert(!data.empty());
+  assert(bsize > 0);
 
-  auto const [posFract, pos] = dfx::math::ModF<size_t>(readaddress);
-  assert(pos < data.size());
-  size_t posMinus1 = 0, posPlus1 = 0, posPlus2 = 0;
+  auto const [posFract, pos_u] = dfx::math::ModF<size_t>(readaddress);
+  auto const pos = static_cast<int>(pos_u);
+  assert(pos < bsize);
 
   // because the readers and writer are not necessarily aligned,
   // upcoming or previous samples could be discontiguous, in which case
   // just "interpolate" with repeated samples
-  switch (mod_bipolar(writeaddress - static_cast<int>(pos), static_cast<int>(std::ssize(data)))) {
-    case 0:  // the previous sample is bogus
-      posMinus1 = pos;
-      posPlus1 = (pos + 1) % data.size();
-      posPlus2 = (pos + 2) % data.size();
-      break;
-    case 1:  // the next 2 samples are bogus
-      posMinus1 = (pos == 0) ? (data.size() - 1) : (pos - 1);
-      posPlus1 = posPlus2 = pos;
-      break;
-    case 2:  // the sample 2 steps ahead is bogus
-      posMinus1 = (pos == 0) ? (data.size() - 1) : (pos - 1);
-      posPlus1 = posPlus2 = (pos + 1) % data.size();
-      break;
-    default:  // everything's cool
-      posMinus1 = (pos == 0) ? (data.size() - 1) : (pos - 1);
-      posPlus1 = (pos + 1) % data.size();
-      posPlus2 = (pos + 2) % data.size();
-      break;
-  }
+  auto writerDistance = writeaddress - pos;
+  writerDistance += (writerDistance < 0) ? bsize : 0;
+  writerDistance -= (writerDistance >= bsize) ? bsize : 0;
+  // at distance 0, the previous sample is bogus
+  auto const posMinus1 = pos - ((writerDistance != 0) ? 1 : 0);
+  // at distance 1, the next 2 samples are bogus
+  auto const posPlus1 = pos + ((writerDistance != 1) ? 1 : 0);
+  // at distance 2, the sample 2 steps ahead is bogus
+  auto const posPlus2 = posPlus1 + (((writerDistance == 0) || (writerDistance > 2)) ? 1 : 0);
 
   return dfx::math::InterpolateHermite(data[posMinus1], data[pos], data[posPlus1], data[posPlus2], posFract);
 }
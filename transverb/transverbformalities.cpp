@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2001-2025  Tom Murphy 7 and Sophia Poirier
+Copyright (C) 2001-2026  Tom Murphy 7 and Sophia Poirier
 
 This file is part of Transverb.
 
@@ -23,6 +23,7 @@ To contact the author, use the contact form at http://destroyfx.org
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cassert>
 #include <cmath>
 #include <cstring>
@@ -57,6 +58,7 @@ Transverb::Transverb(TARGET_API_BASE_INSTANCE_TYPE inInstance)
   initparameter_b(kTomsound, {"TOMSOUND", "TomSnd", "Tom7"}, false);
   initparameter_b(kFreeze, {dfx::kParameterNames_Freeze}, false);
   initparameter_b(kAttenuateFeedbackByMixLevel, {"attenuate feedback by mix level", "AtnFdbk", "AtnFdb", "-fdb"}, false);
+  initparameter_i(kHeadCount, {"heads", "Heads", "Hds"}, kNumDelays, kNumDelays, kNumDelays, kMaxHeads, DfxParam::Unit::Generic);
 
   setparameterenforcevaluelimits(kBsize, true);
   for (auto const parameterID : kDistParameters) {
@@ -73,6 +75,8 @@ Transverb::Transverb(TARGET_API_BASE_INSTANCE_TYPE inInstance)
   addparameterattributes(kDist2, DfxParam::kAttribute_OmitFromRandomizeAll);
   addparameterattributes(kFreeze, DfxParam::kAttribute_OmitFromRandomizeAll);
   addparameterattributes(kAttenuateFeedbackByMixLevel, DfxParam::kAttribute_OmitFromRandomizeAll);
+  // the processing cost grows with each head, so leave that choice to the user
+  addparameterattributes(kHeadCount, DfxParam::kAttribute_OmitFromRandomizeAll);
 
   std::vector<dfx::ParameterID> mixparameters(1, kDrymix);
   for (size_t head = 0; head < kNumDelays; head++) {
@@ -114,18 +118,23 @@ TransverbDSP::TransverbDSP(DfxPlugin& inDfxPlugin)
   registerSmoothedAudioValue(drymix);
 
   for (auto& head : heads) {
-    head.buf.assign(MAXBUF, 0.f);
+    if (!kSharedHistory || (&head == &heads.front())) {
+      head.bufStorage.assign(MAXBUF + (kBufferPadding * 2), 0.f);
+    }
     head.filter.setSampleRate(getsamplerate());
     registerSmoothedAudioValue(head.speed);
     registerSmoothedAudioValue(head.mix);
     registerSmoothedAudioValue(head.feed);
   }
+
+  headLaneHighpassCoefficients = dfx::IIRFilter(getsamplerate()).setHighpassCoefficients(kHighpassFilterCutoff);
 }
 
 
 void TransverbDSP::reset() {
 
   std::ranges::for_each(heads, [](Head& head){ head.reset(); });
+  headLanes.reset();
 }
 
 void TransverbDSP::Head::reset() {
@@ -135,7 +144,39 @@ void TransverbDSP::Head::reset() {
   filter.reset();
   speedHasChanged = true;
 
-  std::ranges::fill(buf, 0.f);
+  std::ranges::fill(bufStorage, 0.f);
+  historyUnderPadding.fill(0.f);
+}
+
+void TransverbDSP::HeadLanes::reset() {
+
+  smoothcount.fill(0);
+  lastdelayval.fill(0.f);
+  highpassPrevIn.fill(0.f);
+  highpassPrevPrevIn.fill(0.f);
+  highpassPrevOut.fill(0.f);
+  highpassPrevPrevOut.fill(0.f);
+  speedHasChanged = true;
+}
+
+void TransverbDSP::Head::refreshBufferPadding(int bsize) {
+
+  assert(bsize > 0);
+  if (bufStorage.empty())  // (heads without their own history when it is shared)
+  {
+    return;
+  }
+  auto const data = buf();
+  if (paddedBsize > 0)
+  {
+    std::ranges::copy(historyUnderPadding, data + paddedBsize);
+  }
+  std::copy_n(data + bsize, kBufferPadding, historyUnderPadding.begin());
+  paddedBsize = bsize;
+  for (int i = 0; i < kBufferPadding; i++) {
+    data[bsize + i] = data[i % bsize];
+    data[-1 - i] = data[bsize - 1 - (i % bsize)];
+  }
 }
 
 
@@ -158,6 +199,7 @@ void TransverbDSP::processparameters() {
     {
       heads[head].speed = std::pow(2., *value);
       heads[head].speedHasChanged = true;
+      headLanes.speedHasChanged = true;
     }
     if (auto const value = getparameterifchanged_scalar(kFeedParameters[head]))
     {
@@ -179,7 +221,7 @@ void TransverbDSP::processparameters() {
         //std::fill(std::next(head.buf.begin(), entryBsize), std::next(head.buf.begin(), bsize), 0.f);
       }
     }
-    else if (writer > bsize)
+    else if (writer >= bsize)
     {
       //auto const entryWriter = writer;
       writer %= bsize;
@@ -191,6 +233,18 @@ void TransverbDSP::processparameters() {
     }
     auto const bsize_f = static_cast<double>(bsize);
     std::ranges::for_each(heads, [bsize_f](Head& head){ head.read = fmod_bipolar(head.read, bsize_f); });
+    std::ranges::for_each(headLanes.read, [bsize_f](double& read){ read = fmod_bipolar(read, bsize_f); });
+    // the padding mirrors the ends of the buffer, which move when it resizes
+    if (bsize != entryBsize)
+    {
+      std::ranges::for_each(heads, [this](Head& head){ head.refreshBufferPadding(bsize); });
+    }
+  }
+
+  // TOMSOUND writes without maintaining the padding
+  if (getparameterchanged(kTomsound))
+  {
+    std::ranges::for_each(heads, [this](Head& head){ head.refreshBufferPadding(bsize); });
   }
 
   for (size_t head = 0; head < kNumDelays; head++)
@@ -202,9 +256,23 @@ void TransverbDSP::processparameters() {
     }
   }
 
+  if (auto const value = getparameterifchanged_i(kHeadCount))
+  {
+    numHeads = static_cast<size_t>(std::clamp<int64_t>(*value, kNumDelays, kMaxHeads));
+    auto const lastHeadIndex = static_cast<float>(numHeads - 1);
+    for (size_t head = 0; head < kMaxHeads; head++)
+    {
+      headLanes.position[head] = (head < numHeads) ? (static_cast<float>(head) / lastHeadIndex) : 0.f;
+    }
+    headLanes.reset();
+  }
+  bool const headCountChanged = getparameterchanged(kHeadCount);
+  positionHeadLanes(headCountChanged || getparameterchanged(kDist1), headCountChanged || getparameterchanged(kDist2));
+
   if (getparameterchanged(kQuality) || getparameterchanged(kTomsound))
   {
     std::ranges::for_each(heads, [](Head& head){ head.speedHasChanged = true; });
+    headLanes.speedHasChanged = true;
   }
 
   // stereo-split-heads mode (head 1 goes to left output and 2 to right)
@@ -224,6 +292,23 @@ void TransverbDSP::processparameters() {
 }
 
 
+void TransverbDSP::positionHeadLanes(bool head1DistanceChanged, bool head2DistanceChanged) {
+
+  auto const bsize_f = static_cast<double>(bsize);
+  auto const dist1 = getparameter_f(kDist1);
+  auto const dist2 = getparameter_f(kDist2);
+  for (size_t head = 0; head < numHeads; head++)
+  {
+    auto const position = static_cast<double>(headLanes.position[head]);
+    if ((head1DistanceChanged && (position < 1.)) || (head2DistanceChanged && (position > 0.)))
+    {
+      auto const dist = dist1 + ((dist2 - dist1) * position);
+      headLanes.read[head] = fmod_bipolar(static_cast<double>(writer) - (dist * bsize_f), bsize_f);
+    }
+  }
+}
+
+
 
 //--------- presets --------
 
@@ -421,6 +506,8 @@ bool Transverb::loadpreset(size_t index)
 /* this randomizes the values of all of Transverb's parameters, sometimes in smart ways */
 void Transverb::randomizeparameters()
 {
+	GroupedParameterUpdates const groupedUpdates(*this);
+
 	// randomize the non-mix-level parameters
 
 	for (dfx::ParameterID i = 0; i < kDrymix; i++)
@@ -443,8 +530,6 @@ void Transverb::randomizeparameters()
 		}
 		else
 		{
-			// TODO: this is not thread-safe (wrt randomizer state) given that Transverb can execute this method
-			// from the main thread (GUI) or MIDI thread (though likelihood of concurrency is quite low)
 			randomizeparameter(i);
 		}
 	}
@@ -550,8 +635,9 @@ size_t Transverb::settings_sizeOfExtendedData() const noexcept
 
 void Transverb::settings_saveExtendedData(void* outData, bool /*isPreset*/) const
 {
+  // (this stays big-endian, as all settings data used to be)
   auto speedModeStatesSerialization = speedModeStates;
-  if constexpr (!DfxSettings::serializationIsNativeEndian())
+  if constexpr (std::endian::native != std::endian::big)
   {
     dfx::ReverseBytes(speedModeStatesSerialization);
   }
@@ -564,7 +650,7 @@ void Transverb::settings_restoreExtendedData(void const* inData, size_t storedEx
   if (storedExtendedDataSize >= settings_sizeOfExtendedData())
   {
     std::memcpy(speedModeStates.data(), inData, settings_sizeOfExtendedData());
-    if constexpr (!DfxSettings::serializationIsNativeEndian())
+    if constexpr (std::endian::native != std::endian::big)
     {
       dfx::ReverseBytes(speedModeStates);
     }
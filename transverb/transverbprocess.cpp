@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2001-2022  Tom Murphy 7 and Sophia Poirier
+Copyright (C) 2001-2026  Tom Murphy 7 and Sophia Poirier
 
 This file is part of Transverb.
 
@@ -43,227 +43,52 @@ void TransverbDSP::process(std::span<float const> inAudio, std::span<float> outA
   auto const attenuateFeedbackByMixLevel = getparameter_b(kAttenuateFeedbackByMixLevel);
 
 
+  // beyond the two parameterized heads, the heads render together across lanes over a single history
+  if (!tomsound && (numHeads > kNumDelays)) {
+    processHeadLanes(inAudio, outAudio, writerIncrement, attenuateFeedbackByMixLevel);
+    return;
+  }
+  if constexpr (kSharedHistory) {
+    if (!tomsound) {
+      processHeadsInterleaved(inAudio, outAudio, writerIncrement, attenuateFeedbackByMixLevel);
+      return;
+    }
+  }
+
+
   /////////////   S O P H I A S O U N D   //////////////
   // do it proper
   if (!tomsound) {
 
-    auto const samplerate = getsamplerate();
-    auto const speedSmoothingStride = dfx::math::GetFrequencyBasedSmoothingStride(samplerate);
-    // int versions of these float values, for reducing casting operations
-    std::array<int, kNumDelays> speed_ints {};
-    // position trackers for the lowpass filters
-    std::array<int, kNumDelays> lowpasspos {};
-    // the type of filtering to use in ultra hi-fi mode
-    std::array<FilterMode, kNumDelays> filtermodes {};
-    filtermodes.fill(FilterMode::None);
-    // make-up gain for lowpass filtering
-    std::array<float, kNumDelays> mugs {};
-    mugs.fill(1.f);
-
-    for (size_t i = 0; i < outAudio.size(); i++)  // samples loop
+    // the heads only meet in the output mix, so each renders a whole block at a time
+    std::array<HeadFilterState, kNumDelays> filterStates {};
+    std::array<float, kMaxHeadBlockSize> delaysums;
+
+    for (size_t blockPosition = 0; blockPosition < outAudio.size(); blockPosition += kMaxHeadBlockSize)
     {
-      bool const firstSample = (i == 0);
-      bool const speedSmoothingStrideHit = ((i % speedSmoothingStride) == 0);
-      float delaysum = 0.f;
+      auto const blockSize = std::min(outAudio.size() - blockPosition, kMaxHeadBlockSize);
+      auto const blockInAudio = inAudio.subspan(blockPosition, blockSize);
+      auto const blockDelaySums = std::span(delaysums).first(blockSize);
 
+      std::ranges::fill(blockDelaySums, 0.f);
       for (size_t h = 0; h < kNumDelays; h++)  // delay heads loop
       {
-        auto const read_int = static_cast<int>(heads[h].read);
-
-        // filter setup
-        if (quality == kQualityMode_UltraHiFi)
-        {
-          if (firstSample || (heads[h].speed.isSmoothing() && speedSmoothingStrideHit))
-          {
-            lowpasspos[h] = read_int;
-            // check to see if we need to lowpass the first delay head and init coefficients if so
-            if (heads[h].speed.getValue() > kUnitySpeed)
-            {
-              filtermodes[h] = FilterMode::LowpassIIR;
-              speed_ints[h] = static_cast<int>(heads[h].speed.getValue());
-              // it becomes too costly to try to IIR at higher speeds, so switch to FIR filtering
-              if (heads[h].speed.getValue() >= kFIRSpeedThreshold)
-              {
-                filtermodes[h] = FilterMode::LowpassFIR;
-                // compensate for gain lost from filtering
-                mugs[h] = static_cast<float>(std::pow(heads[h].speed.getValue() / kFIRSpeedThreshold, 0.78));
-                // update the coefficients only if necessary
-                if (std::exchange(heads[h].speedHasChanged, false))
-                {
-                  dfx::FIRFilter::calculateIdealLowpassCoefficients((samplerate / heads[h].speed.getValue()) * dfx::FIRFilter::kShelfStartLowpass,
-                                                                    samplerate, heads[h].firCoefficients, firCoefficientsWindow);
-                  heads[h].filter.reset();
-                }
-              }
-              else if (std::exchange(heads[h].speedHasChanged, false))
-              {
-                heads[h].filter.setLowpassCoefficients((samplerate / heads[h].speed.getValue()) * dfx::IIRFilter::kShelfStartLowpass);
-              }
-            }
-            // we need to highpass the delay head to remove mega sub bass
-            else
-            {
-              filtermodes[h] = FilterMode::Highpass;
-              if (std::exchange(heads[h].speedHasChanged, false))
-              {
-                heads[h].filter.setHighpassCoefficients(kHighpassFilterCutoff / heads[h].speed.getValue());
-              }
-            }
-          }
-        }
-
-        // read from read heads
-        switch (quality)
-        {
-          // no interpolation or filtering
-          case kQualityMode_DirtFi:
-          default:
-            delayvals[h] = heads[h].buf[read_int];
-            break;
-          // spline interpolation, but no filtering
-          case kQualityMode_HiFi:
-            //delayvals[h] = interpolateLinear(std::span(heads[h].buf).subspan(0, bsize), heads[h].read, writer);
-            delayvals[h] = interpolateHermite(std::span(heads[h].buf).subspan(0, bsize), heads[h].read, writer);
-            break;
-          // spline interpolation plus anti-aliasing lowpass filtering for high speeds
-          // or sub-bass-removing highpass filtering for low speeds
-          case kQualityMode_UltraHiFi:
-            switch (filtermodes[h])
-            {
-              case FilterMode::Highpass:
-              case FilterMode::LowpassIIR:
-                // interpolate the values in the IIR output history
-                delayvals[h] = heads[h].filter.interpolateHermitePostFilter(heads[h].read);
-                break;
-              case FilterMode::LowpassFIR:
-              {
-                // get two consecutive FIR output values for linear interpolation
-                auto const lp1 = dfx::FIRFilter::process(std::span(heads[h].buf).subspan(0, bsize), heads[h].firCoefficients,
-                                                         mod_bipolar(read_int - static_cast<int>(kNumFIRTaps), bsize));
-                auto const lp2 = dfx::FIRFilter::process(std::span(heads[h].buf).subspan(0, bsize), heads[h].firCoefficients,
-                                                         mod_bipolar(read_int - static_cast<int>(kNumFIRTaps) + 1, bsize));
-                // interpolate output linearly (avoid shit sound) and compensate gain
-                delayvals[h] = interpolateLinear(lp1, lp2, heads[h].read) * mugs[h];
-                break;
-              }
-              default:
-                delayvals[h] = interpolateHermite(std::span(heads[h].buf).subspan(0, bsize), heads[h].read, writer);
-                break;
-            }
-            break;
-        }  // end of quality switch
-
-        // crossfade the last stored smoothing sample with
-        // the current sample if smoothing is in progress
-        if (heads[h].smoothcount > 0) {
-          auto const smoothpos = heads[h].smoothstep * static_cast<float>(heads[h].smoothcount);
-          delayvals[h] = std::lerp(delayvals[h], heads[h].lastdelayval, smoothpos);
-          heads[h].smoothcount--;
-        }
-
-        // then write into buffer (w/ feedback)
-        if (!freeze) {
-          float const mixlevel = attenuateFeedbackByMixLevel ? heads[h].mix.getValue() : 1.f;
-          heads[h].buf[writer] = inAudio[i] + (delayvals[h] * heads[h].feed.getValue() * mixlevel);
-        }
-
-        // make output
-        delaysum += delayvals[h] * heads[h].mix.getValue();
-
-        // start smoothing if the writer has passed a reader or vice versa,
-        // though not if reader and writer move at the same speed
-        // (check the positions before wrapping around the heads)
-        auto const nextRead = static_cast<int>(heads[h].read + heads[h].speed.getValue());
-        auto const nextWrite = writer + 1;
-        bool const readCrossingAhead = (read_int < writer) && (nextRead >= nextWrite);
-        bool const readCrossingBehind = (read_int >= writer) && (nextRead <= nextWrite);
-        bool const speedIsUnity = heads[h].speed.getValue() == kUnitySpeed;
-        if ((readCrossingAhead || readCrossingBehind) && !speedIsUnity) {
-          // check because, at slow speeds, it's possible to go into this twice or more in a row
-          if (heads[h].smoothcount <= 0) {
-            // store the most recent output as the head's smoothing sample
-            heads[h].lastdelayval = delayvals[h];
-            // truncate the smoothing duration if we're using too small of a buffer size
-            auto const bufferReadSteps = static_cast<int>(bsize_float / heads[h].speed.getValue());
-            auto const smoothdur = std::min(bufferReadSteps, kAudioSmoothingDur_samples);
-            heads[h].smoothstep = 1.f / static_cast<float>(smoothdur);  // the scalar step value
-            heads[h].smoothcount = smoothdur;  // set the counter to the total duration
-          }
-        }
-
-        // update read heads, wrapping around if they have gone past the end of the buffer
-        heads[h].read += heads[h].speed.getValue();
-        if (heads[h].read >= bsize_float) {
-          heads[h].read = fmod_bipolar(heads[h].read, bsize_float);
-        }
-
-        // if we're doing IIR lowpass filtering,
-        // then we probably need to process a few consecutive samples in order
-        // to get the continuous impulse (or whatever you call that),
-        // probably whatever the speed multiplier is, that's how many samples
-        if (filtermodes[h] == FilterMode::LowpassIIR)
-        {
-          int lowpasscount = 0;
-          while (lowpasscount < speed_ints[h])
-          {
-            switch (speed_ints[h] - lowpasscount)
-            {
-              case 1:
-                heads[h].filter.processToCacheH1(heads[h].buf[lowpasspos[h]]);
-                lowpasspos[h] = (lowpasspos[h] + 1) % bsize;
-                lowpasscount++;
-                break;
-              case 2:
-                heads[h].filter.processToCacheH2(std::span(heads[h].buf).subspan(0, bsize), dfx::math::ToUnsigned(lowpasspos[h]));
-                lowpasspos[h] = (lowpasspos[h] + 2) % bsize;
-                lowpasscount += 2;
-                break;
-              case 3:
-                heads[h].filter.processToCacheH3(std::span(heads[h].buf).subspan(0, bsize), dfx::math::ToUnsigned(lowpasspos[h]));
-                lowpasspos[h] = (lowpasspos[h] + 3) % bsize;
-                lowpasscount += 3;
-                break;
-              default:
-                heads[h].filter.processToCacheH4(std::span(heads[h].buf).subspan(0, bsize), dfx::math::ToUnsigned(lowpasspos[h]));
-                lowpasspos[h] = (lowpasspos[h] + 4) % bsize;
-                lowpasscount += 4;
-                break;
-            }
-          }
-          auto const nextread_int = static_cast<int>(heads[h].read);
-          // check whether we need to consume one more sample
-          bool const extrasample = ((lowpasspos[h] < nextread_int) && ((lowpasspos[h] + 1) == nextread_int)) ||
-                                   ((lowpasspos[h] == (bsize - 1)) && (nextread_int == 0));
-          if (extrasample)
-          {
-            heads[h].filter.processToCacheH1(heads[h].buf[lowpasspos[h]]);
-            lowpasspos[h] = (lowpasspos[h] + 1) % bsize;
-          }
-        }
-        // it's simpler for highpassing;
-        // we may not even need to process anything for this sample
-        else if (filtermodes[h] == FilterMode::Highpass)
-        {
-          // only if we've traversed to a new integer sample position
-          if (static_cast<int>(heads[h].read) != read_int)
-          {
-            heads[h].filter.processToCache(heads[h].buf[read_int]);
-          }
-        }
-
-        heads[h].speedHasChanged |= heads[h].speed.isSmoothing();
-      }  // end of delay heads loop
+        processHead(heads[h], filterStates[h], blockInAudio, blockDelaySums, {}, blockPosition, writer, writerIncrement, attenuateFeedbackByMixLevel);
+      }
 
       // mix output
-      outAudio[i] = (inAudio[i] * drymix.getValue()) + delaysum;
-
-      // update write head
-      writer += writerIncrement;
-      // wrap around the write head if it has gone past the end of the buffer
-      writer %= bsize;
+      for (size_t i = 0; i < blockSize; i++)
+      {
+        outAudio[blockPosition + i] = (blockInAudio[i] * drymix.getValue()) + blockDelaySums[i];
+        drymix.inc();
+      }
 
-      incrementSmoothedAudioValues();
-    }  // end of samples loop
+      // update write head, wrapping around if it has gone past the end of the buffer
+      writer += writerIncrement * static_cast<int>(blockSize);
+      while (writer >= bsize) {
+        writer -= bsize;
+      }
+    }
 
   }  // end of !TOMSOUND
 
@@ -300,7 +125,7 @@ void TransverbDSP::process(std::span<float const> inAudio, std::span<float> outA
       for(size_t h = 0; h < kNumDelays; h++) {
         /* another characteristic of TOMSOUND is sharing a single buffer across heads */
         /* (however it is only viable with the legacy behavior of applying mix to feedback) */
-        auto& buf = attenuateFeedbackByMixLevel ? heads.front().buf : heads[h].buf;
+        auto const buf = (attenuateFeedbackByMixLevel || kSharedHistory) ? heads.front().buf() : heads[h].buf();
 
         switch(quality) {
           case kQualityMode_DirtFi:
@@ -308,26 +133,26 @@ void TransverbDSP::process(std::span<float const> inAudio, std::span<float> outA
             delayvals[h] = buf[static_cast<size_t>(heads[h].read)];
             break;
           case kQualityMode_HiFi:
-            delayvals[h] = interpolateLinear(std::span(buf).subspan(0, bsize), heads[h].read);
+            delayvals[h] = interpolateLinear(std::span(buf, static_cast<size_t>(bsize)), heads[h].read);
             break;
           case kQualityMode_UltraHiFi:
-            delayvals[h] = dfx::math::InterpolateHermite(std::span(buf).subspan(0, bsize), heads[h].read);
+            delayvals[h] = dfx::math::InterpolateHermite(std::span(buf, static_cast<size_t>(bsize)), heads[h].read);
             break;
         }
       }
 
       /* then write into buffer (w/ feedback) */
       if (!freeze) {
-        if(attenuateFeedbackByMixLevel) {
-          auto& buf = heads.front().buf;
+        if(attenuateFeedbackByMixLevel || kSharedHistory) {
+          auto const buf = heads.front().buf();
           buf[writer] = inAudio[i];
           for(size_t h = 0; h < kNumDelays; h++) {
             buf[writer] +=
-              heads[h].feed.getValue() * heads[h].mix.getValue() * delayvals[h];
+              heads[h].feed.getValue() * (attenuateFeedbackByMixLevel ? heads[h].mix.getValue() : 1.f) * delayvals[h];
           }
         } else {
           for(size_t h = 0; h < kNumDelays; h++) {
-            heads[h].buf[writer] =
+            heads[h].buf()[writer] =
               inAudio[i] +
               (heads[h].feed.getValue() * delayvals[h]);
           }
@@ -356,3 +181,477 @@ void TransverbDSP::process(std::span<float const> inAudio, std::span<float> outA
     }  /* end of samples loop */
   }  /* end of TOMSOUND */
 }
+
+
+
+void TransverbDSP::processHead(Head& head, HeadFilterState& filterState, std::span<float const> inAudio, std::span<float> delaysums,
+                               std::span<float> feedbacksums, size_t blockPosition, int blockWriter, int writerIncrement,
+                               bool attenuateFeedbackByMixLevel) {
+
+  assert(inAudio.size() == delaysums.size());
+  assert(!kSharedHistory || (inAudio.size() == feedbacksums.size()));
+
+  auto const bsize_float = static_cast<double>(bsize);  // cut down on casting
+  auto const samplerate = getsamplerate();
+  auto const speedSmoothingStride = dfx::math::GetFrequencyBasedSmoothingStride(samplerate);
+  auto const buf = kSharedHistory ? heads.front().buf() : head.buf();
+  auto writer = blockWriter;
+  auto speedSmoothingStridePosition = blockPosition % speedSmoothingStride;
+
+  for (size_t i = 0; i < inAudio.size(); i++)  // samples loop
+  {
+    bool const firstSample = ((blockPosition + i) == 0);
+    bool const speedSmoothingStrideHit = (speedSmoothingStridePosition == 0);
+    auto const read_int = static_cast<int>(head.read);
+    float delayval = 0.f;
+
+    // filter setup
+    if (quality == kQualityMode_UltraHiFi)
+    {
+      if (firstSample || (head.speed.isSmoothing() && speedSmoothingStrideHit))
+      {
+        filterState.lowpasspos = read_int;
+        // check to see if we need to lowpass the delay head and init coefficients if so
+        if (head.speed.getValue() > kUnitySpeed)
+        {
+          filterState.filtermode = FilterMode::LowpassIIR;
+          filterState.speed_int = static_cast<int>(head.speed.getValue());
+          // it becomes too costly to try to IIR at higher speeds, so switch to FIR filtering
+          if (head.speed.getValue() >= kFIRSpeedThreshold)
+          {
+            filterState.filtermode = FilterMode::LowpassFIR;
+            // compensate for gain lost from filtering
+            filterState.mug = static_cast<float>(std::pow(head.speed.getValue() / kFIRSpeedThreshold, 0.78));
+            // update the coefficients only if necessary
+            if (std::exchange(head.speedHasChanged, false))
+            {
+              dfx::FIRFilter::calculateIdealLowpassCoefficients((samplerate / head.speed.getValue()) * dfx::FIRFilter::kShelfStartLowpass,
+                                                                samplerate, head.firCoefficients, firCoefficientsWindow);
+              head.filter.reset();
+            }
+          }
+          else if (std::exchange(head.speedHasChanged, false))
+          {
+            head.filter.setLowpassCoefficients((samplerate / head.speed.getValue()) * dfx::IIRFilter::kShelfStartLowpass);
+          }
+        }
+        // we need to highpass the delay head to remove mega sub bass
+        else
+        {
+          filterState.filtermode = FilterMode::Highpass;
+          if (std::exchange(head.speedHasChanged, false))
+          {
+            head.filter.setHighpassCoefficients(kHighpassFilterCutoff / head.speed.getValue());
+          }
+        }
+      }
+    }
+
+    // read from read heads
+    switch (quality)
+    {
+      // no interpolation or filtering
+      case kQualityMode_DirtFi:
+      default:
+        delayval = buf[read_int];
+        break;
+      // spline interpolation, but no filtering
+      case kQualityMode_HiFi:
+        delayval = interpolateHermite(buf, head.read, writer, bsize);
+        break;
+      // spline interpolation plus anti-aliasing lowpass filtering for high speeds
+      // or sub-bass-removing highpass filtering for low speeds
+      case kQualityMode_UltraHiFi:
+        switch (filterState.filtermode)
+        {
+          case FilterMode::Highpass:
+          case FilterMode::LowpassIIR:
+            // interpolate the values in the IIR output history
+            delayval = head.filter.interpolateHermitePostFilter(head.read);
+            break;
+          case FilterMode::LowpassFIR:
+            // compensate gain
+            delayval = interpolateLowpassFIR(std::span(buf, static_cast<size_t>(bsize)), head.firCoefficients, head.read) * filterState.mug;
+            break;
+          default:
+            delayval = interpolateHermite(buf, head.read, writer, bsize);
+            break;
+        }
+        break;
+    }  // end of quality switch
+
+    // crossfade the last stored smoothing sample with
+    // the current sample if smoothing is in progress
+    if (head.smoothcount > 0) {
+      auto const smoothpos = head.smoothstep * static_cast<float>(head.smoothcount);
+      delayval = std::lerp(delayval, head.lastdelayval, smoothpos);
+      head.smoothcount--;
+    }
+
+    // then write into buffer (w/ feedback), unless frozen
+    if (writerIncrement != 0) {
+      float const mixlevel = attenuateFeedbackByMixLevel ? head.mix.getValue() : 1.f;
+      auto const feedback = delayval * head.feed.getValue() * mixlevel;
+      if constexpr (kSharedHistory) {
+        feedbacksums[i] += feedback;
+      } else {
+        head.write(writer, inAudio[i] + feedback, bsize);
+      }
+    }
+
+    // make output
+    delaysums[i] += delayval * head.mix.getValue();
+
+    // start smoothing if the writer has passed a reader or vice versa,
+    // though not if reader and writer move at the same speed
+    // (check the positions before wrapping around the heads)
+    auto const nextRead = static_cast<int>(head.read + head.speed.getValue());
+    auto const nextWrite = writer + 1;
+    bool const readCrossingAhead = (read_int < writer) && (nextRead >= nextWrite);
+    bool const readCrossingBehind = (read_int >= writer) && (nextRead <= nextWrite);
+    bool const speedIsUnity = head.speed.getValue() == kUnitySpeed;
+    if ((readCrossingAhead || readCrossingBehind) && !speedIsUnity) {
+      // check because, at slow speeds, it's possible to go into this twice or more in a row
+      if (head.smoothcount <= 0) {
+        // store the most recent output as the head's smoothing sample
+        head.lastdelayval = delayval;
+        // truncate the smoothing duration if we're using too small of a buffer size
+        auto const bufferReadSteps = static_cast<int>(bsize_float / head.speed.getValue());
+        auto const smoothdur = std::min(bufferReadSteps, kAudioSmoothingDur_samples);
+        head.smoothstep = 1.f / static_cast<float>(smoothdur);  // the scalar step value
+        head.smoothcount = smoothdur;  // set the counter to the total duration
+      }
+    }
+
+    // update read heads, wrapping around if they have gone past the end of the buffer
+    head.read += head.speed.getValue();
+    if (head.read >= bsize_float) {
+      // this subtraction is exact (same as fmod) while the position is less than twice the buffer size
+      head.read -= bsize_float;
+      if (head.read >= bsize_float) [[unlikely]] {
+        head.read = std::fmod(head.read, bsize_float);
+      }
+    }
+
+    if constexpr (kSharedHistory) {
+      // the other heads have yet to contribute to this sample's write,
+      // after which the caller feeds the filter
+      filterState.prevread_int = read_int;
+    } else {
+      feedFilterHistory(head, filterState, buf, read_int);
+    }
+
+    head.speedHasChanged |= head.speed.isSmoothing();
+
+    head.speed.inc();
+    head.mix.inc();
+    head.feed.inc();
+
+    writer += writerIncrement;
+    while (writer >= bsize) {
+      writer -= bsize;
+    }
+    speedSmoothingStridePosition++;
+    speedSmoothingStridePosition = (speedSmoothingStridePosition == speedSmoothingStride) ? 0 : speedSmoothingStridePosition;
+  }  // end of samples loop
+}
+
+
+
+
+void TransverbDSP::feedFilterHistory(Head& head, HeadFilterState& filterState, float const* buf, int read_int) {
+
+  auto const advanceLowpassPosition = [this, &filterState](int count) {
+    filterState.lowpasspos += count;
+    while (filterState.lowpasspos >= bsize) {
+      filterState.lowpasspos -= bsize;
+    }
+  };
+
+  // if we're doing IIR lowpass filtering,
+  // then we probably need to process a few consecutive samples in order
+  // to get the continuous impulse (or whatever you call that),
+  // probably whatever the speed multiplier is, that's how many samples
+  // (the buffer padding allows reading up to four samples past the lowpass position)
+  if (filterState.filtermode == FilterMode::LowpassIIR)
+  {
+    auto lowpasscount = filterState.speed_int;
+    for (; lowpasscount >= 4; lowpasscount -= 4)
+    {
+      head.filter.processToCacheH4(std::span<float const, 4>(buf + filterState.lowpasspos, 4));
+      advanceLowpassPosition(4);
+    }
+    switch (lowpasscount)
+    {
+      case 3:
+        head.filter.processToCacheH3(std::span<float const, 3>(buf + filterState.lowpasspos, 3));
+        advanceLowpassPosition(3);
+        break;
+      case 2:
+        head.filter.processToCacheH2(std::span<float const, 2>(buf + filterState.lowpasspos, 2));
+        advanceLowpassPosition(2);
+        break;
+      case 1:
+        head.filter.processToCacheH1(buf[filterState.lowpasspos]);
+        advanceLowpassPosition(1);
+        break;
+      default:
+        break;
+    }
+    auto const nextread_int = static_cast<int>(head.read);
+    // check whether we need to consume one more sample
+    bool const extrasample = ((filterState.lowpasspos < nextread_int) && ((filterState.lowpasspos + 1) == nextread_int)) ||
+                             ((filterState.lowpasspos == (bsize - 1)) && (nextread_int == 0));
+    if (extrasample)
+    {
+      head.filter.processToCacheH1(buf[filterState.lowpasspos]);
+      advanceLowpassPosition(1);
+    }
+  }
+  // it's simpler for highpassing;
+  // we may not even need to process anything for this sample
+  else if (filterState.filtermode == FilterMode::Highpass)
+  {
+    // only if we've traversed to a new integer sample position
+    if (static_cast<int>(head.read) != read_int)
+    {
+      head.filter.processToCache(buf[read_int]);
+    }
+  }
+}
+
+
+
+void TransverbDSP::processHeadsInterleaved(std::span<float const> inAudio, std::span<float> outAudio,
+                                           int writerIncrement, bool attenuateFeedbackByMixLevel) {
+
+  assert(kSharedHistory);
+
+  // each head reads what the other just fed back into the shared history,
+  // so rather than rendering a block per head, the heads take turns each sample
+  std::array<HeadFilterState, kNumDelays> filterStates {};
+  auto& history = heads.front();
+
+  for (size_t i = 0; i < outAudio.size(); i++)  // samples loop
+  {
+    float delaysum = 0.f, feedbacksum = 0.f, feedbackGainSum = 0.f;
+    for (size_t h = 0; h < kNumDelays; h++)  // delay heads loop
+    {
+      auto const& head = heads[h];
+      auto const makeupGain = (filterStates[h].filtermode == FilterMode::LowpassFIR) ? filterStates[h].mug : 1.f;
+      feedbackGainSum += head.feed.getValue() * (attenuateFeedbackByMixLevel ? head.mix.getValue() : 1.f) * makeupGain;
+      processHead(heads[h], filterStates[h], inAudio.subspan(i, 1), std::span(&delaysum, 1), std::span(&feedbacksum, 1),
+                  i, writer, writerIncrement, attenuateFeedbackByMixLevel);
+    }
+
+    // then write into buffer (w/ feedback), unless frozen
+    if (writerIncrement != 0) {
+      // scale down the heads' combined feedback (including any lowpass make-up gain) if it exceeds unity
+      auto const feedbackScalar = (feedbackGainSum > 1.f) ? (1.f / feedbackGainSum) : 1.f;
+      history.write(writer, inAudio[i] + (feedbacksum * feedbackScalar), bsize);
+    }
+    for (size_t h = 0; h < kNumDelays; h++)
+    {
+      feedFilterHistory(heads[h], filterStates[h], history.buf(), filterStates[h].prevread_int);
+    }
+
+    // mix output
+    outAudio[i] = (inAudio[i] * drymix.getValue()) + delaysum;
+    drymix.inc();
+
+    writer += writerIncrement;
+    while (writer >= bsize) {
+      writer -= bsize;
+    }
+  }  // end of samples loop
+}
+
+
+
+void TransverbDSP::processHeadLanes(std::span<float const> inAudio, std::span<float> outAudio,
+                                    int writerIncrement, bool attenuateFeedbackByMixLevel) {
+
+  auto& lanes = headLanes;
+  auto& history = heads.front();  // the one history that all heads share
+  auto const& head1 = heads[0];
+  auto const& head2 = heads[1];
+  auto const buf = history.buf();
+  auto const numLanes = numHeads;
+  auto const bsize_float = static_cast<double>(bsize);  // cut down on casting
+  auto const samplerate = getsamplerate();
+  auto const speedSmoothingStride = dfx::math::GetFrequencyBasedSmoothingStride(samplerate);
+  size_t speedSmoothingStridePosition = 0;
+  // keep the summed output energy of all of the heads at about that of the two parameterized heads
+  auto const mixScalar = static_cast<float>(std::sqrt(static_cast<double>(kNumDelays) / static_cast<double>(numLanes)));
+  auto const& highpassCoeff = headLaneHighpassCoefficients;
+
+  HeadLaneValues<double> speed;
+  HeadLaneValues<float> mix, feedbackGain, delayvals;
+
+  for (size_t i = 0; i < outAudio.size(); i++)  // samples loop
+  {
+    // each head's settings are interpolated between those of heads 1 and 2
+    // (in stereo-split mode, the mix level of the other output's head is zero, which pans the heads across the outputs)
+    auto const speed1 = head1.speed.getValue();
+    auto const speedRange = head2.speed.getValue() - speed1;
+    auto const mix1 = head1.mix.getValue();
+    auto const mixRange = head2.mix.getValue() - mix1;
+    auto const feed1 = head1.feed.getValue();
+    auto const feedRange = head2.feed.getValue() - feed1;
+    for (size_t h = 0; h < numLanes; h++)
+    {
+      auto const position = lanes.position[h];
+      auto const mixlevel = mix1 + (mixRange * position);
+      speed[h] = speed1 + (speedRange * static_cast<double>(position));
+      mix[h] = mixlevel * mixScalar;
+      feedbackGain[h] = (feed1 + (feedRange * position)) * (attenuateFeedbackByMixLevel ? mixlevel : 1.f);
+    }
+
+    // update the lowpass coefficients of the heads moving faster than unity speed
+    lanes.speedHasChanged |= head1.speed.isSmoothing() || head2.speed.isSmoothing();
+    if ((quality == kQualityMode_UltraHiFi) && (speedSmoothingStridePosition == 0) && std::exchange(lanes.speedHasChanged, false))
+    {
+      for (size_t h = 0; h < numLanes; h++)
+      {
+        if (speed[h] > kUnitySpeed)
+        {
+          dfx::FIRFilter::calculateIdealLowpassCoefficients((samplerate / speed[h]) * dfx::FIRFilter::kShelfStartLowpass,
+                                                            samplerate, lanes.firCoefficients[h], firCoefficientsWindow);
+          // compensate for gain lost from filtering
+          lanes.mug[h] = (speed[h] >= kFIRSpeedThreshold) ? static_cast<float>(std::pow(speed[h] / kFIRSpeedThreshold, 0.78)) : 1.f;
+        }
+      }
+    }
+
+    // read from read heads
+    switch (quality)
+    {
+      // no interpolation or filtering
+      case kQualityMode_DirtFi:
+      default:
+        for (size_t h = 0; h < numLanes; h++)
+        {
+          delayvals[h] = buf[static_cast<int>(lanes.read[h])];
+        }
+        break;
+      // spline interpolation, but no filtering
+      case kQualityMode_HiFi:
+        for (size_t h = 0; h < numLanes; h++)
+        {
+          delayvals[h] = interpolateHermite(buf, lanes.read[h], writer, bsize);
+        }
+        break;
+      // anti-aliasing lowpass filtering for high speeds
+      // or spline interpolation plus sub-bass-removing highpass filtering for low speeds
+      // (the IIR lowpassing of the parameterized heads preprocesses each head's own history,
+      // which is not possible when the history is shared, so all lowpassing is FIR here)
+      case kQualityMode_UltraHiFi:
+        for (size_t h = 0; h < numLanes; h++)
+        {
+          delayvals[h] = (speed[h] > kUnitySpeed)
+                         ? (interpolateLowpassFIR(std::span(buf, static_cast<size_t>(bsize)), lanes.firCoefficients[h], lanes.read[h]) * lanes.mug[h])
+                         : interpolateHermite(buf, lanes.read[h], writer, bsize);
+        }
+        for (size_t h = 0; h < numLanes; h++)
+        {
+          auto const input = delayvals[h];
+          auto const output = (input * highpassCoeff.mIn) + (lanes.highpassPrevIn[h] * highpassCoeff.mPrevIn) 
+                              + (lanes.highpassPrevPrevIn[h] * highpassCoeff.mPrevPrevIn) 
+                              - (lanes.highpassPrevOut[h] * highpassCoeff.mPrevOut) - (lanes.highpassPrevPrevOut[h] * highpassCoeff.mPrevPrevOut);
+          lanes.highpassPrevPrevIn[h] = lanes.highpassPrevIn[h];
+          lanes.highpassPrevIn[h] = input;
+          lanes.highpassPrevPrevOut[h] = lanes.highpassPrevOut[h];
+          lanes.highpassPrevOut[h] = dfx::math::ClampDenormal(output);
+          delayvals[h] = (speed[h] > kUnitySpeed) ? input : output;
+        }
+        break;
+    }  // end of quality switch
+
+    // crossfade the last stored smoothing sample with
+    // the current sample if smoothing is in progress
+    for (size_t h = 0; h < numLanes; h++)
+    {
+      if (lanes.smoothcount[h] > 0) {
+        auto const smoothpos = lanes.smoothstep[h] * static_cast<float>(lanes.smoothcount[h]);
+        delayvals[h] = std::lerp(delayvals[h], lanes.lastdelayval[h], smoothpos);
+        lanes.smoothcount[h]--;
+      }
+    }
+
+    float delaysum = 0.f, feedbacksum = 0.f, feedbackGainSum = 0.f;
+    for (size_t h = 0; h < numLanes; h++)
+    {
+      auto const makeupGain = ((quality == kQualityMode_UltraHiFi) && (speed[h] > kUnitySpeed)) ? lanes.mug[h] : 1.f;
+      delaysum += delayvals[h] * mix[h];
+      feedbacksum += delayvals[h] * feedbackGain[h];
+      feedbackGainSum += feedbackGain[h] * makeupGain;
+    }
+
+    // then write into buffer (w/ feedback), unless frozen
+    if (writerIncrement != 0) {
+      // every head feeds back into the same history, so scale down their combined feedback
+      // (including any lowpass make-up gain) if it exceeds unity
+      auto const feedbackScalar = (feedbackGainSum > 1.f) ? (1.f / feedbackGainSum) : 1.f;
+      history.write(writer, inAudio[i] + (feedbacksum * feedbackScalar), bsize);
+    }
+
+    // make output
+    outAudio[i] = (inAudio[i] * drymix.getValue()) + delaysum;
+
+    for (size_t h = 0; h < numLanes; h++)
+    {
+      // start smoothing if the writer has passed a reader or vice versa,
+      // though not if reader and writer move at the same speed
+      auto const read_int = static_cast<int>(lanes.read[h]);
+      auto const nextRead = static_cast<int>(lanes.read[h] + speed[h]);
+      auto const nextWrite = writer + 1;
+      bool const readCrossingAhead = (read_int < writer) && (nextRead >= nextWrite);
+      bool const readCrossingBehind = (read_int >= writer) && (nextRead <= nextWrite);
+      if ((readCrossingAhead || readCrossingBehind) && (speed[h] != kUnitySpeed) && (lanes.smoothcount[h] <= 0)) {
+        lanes.lastdelayval[h] = delayvals[h];
+        auto const bufferReadSteps = static_cast<int>(bsize_float / speed[h]);
+        auto const smoothdur = std::min(bufferReadSteps, kAudioSmoothingDur_samples);
+        lanes.smoothstep[h] = 1.f / static_cast<float>(smoothdur);
+        lanes.smoothcount[h] = smoothdur;
+      }
+
+      // update read heads, wrapping around if they have gone past the end of the buffer
+      lanes.read[h] += speed[h];
+      if (lanes.read[h] >= bsize_float) {
+        lanes.read[h] -= bsize_float;
+        if (lanes.read[h] >= bsize_float) [[unlikely]] {
+          lanes.read[h] = std::fmod(lanes.read[h], bsize_float);
+        }
+      }
+    }
+
+    incrementSmoothedAudioValues();
+
+    writer += writerIncrement;
+    while (writer >= bsize) {
+      writer -= bsize;
+    }
+    speedSmoothingStridePosition++;
+    speedSmoothingStridePosition = (speedSmoothingStridePosition == speedSmoothingStride) ? 0 : speedSmoothingStridePosition;
+  }  // end of samples loop
+}
+
+
+
+float TransverbDSP::interpolateLowpassFIR(std::span<float const> history, std::span<float const> coefficients, double readaddress) {
+
+  assert(!history.empty());
+
+  // get two consecutive FIR output values for linear interpolation
+  auto const bsize = static_cast<int>(history.size());
+  auto firpos = static_cast<int>(readaddress) - static_cast<int>(coefficients.size());
+  firpos += (firpos < 0) ? bsize : 0;
+  if (firpos < 0) [[unlikely]] {  // only for buffers smaller than the filter
+    firpos = mod_bipolar(firpos, bsize);
+  }
+  auto const firpos2 = ((firpos + 1) == bsize) ? 0 : (firpos + 1);
+  auto const lp1 = dfx::FIRFilter::process(history, coefficients, dfx::math::ToUnsigned(firpos));
+  auto const lp2 = dfx::FIRFilter::process(history, coefficients, dfx::math::ToUnsigned(firpos2));
+  // interpolate output linearly (avoid shit sound)
+  return interpolateLinear(lp1, lp2, readaddress);
+}
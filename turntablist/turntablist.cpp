@@ -137,6 +137,8 @@ Turntablist::Turntablist(TARGET_API_BASE_INSTANCE_TYPE inInstance)
 	m_nCurrentVelocity = 0x7F;
 
 	mPlayChangedInProcessHasPosted.test_and_set();
+
+	registerSpinLock(m_AudioFileLock);
 }
 
 //-----------------------------------------------------------------------------------------
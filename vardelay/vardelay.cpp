@@ -48,50 +48,23 @@ PLUGIN::PLUGIN(audioMasterCallback audioMaster)
     FPARAM(band[zz], P_DELAYS + zz, "band", 0.0f, "dist");
   }
 
-  constexpr auto maxframe = *std::ranges::max_element(buffersizes);
-
   setup();
 
-  in0 = (float*)malloc(maxframe * sizeof (float));
-  out0 = (float*)malloc(maxframe * 2 * sizeof (float));
-
-  /* prevmix is only a single third long */
-  prevmix = (float*)malloc((maxframe / 2) * sizeof (float));
-
   changed = 0;
 }
 
 PLUGIN::~PLUGIN() {
-  free (in0);
-  free (out0);
-
-  free (prevmix);
-
   if (programs) delete[] programs;
 }
 
 void PLUGIN::resume() {
 
-  framesize = MKBUFSIZE(bufsizep);
-  third = framesize / 2;
-  bufsize = third * 3;
-
-  /* set up buffers. Prevmix and first frame of output are always filled with zeros. */
-
-  for (int i = 0; i < third; i ++) {
-    prevmix[i] = 0.0f;
-  }
-
-  for (int j = 0; j < framesize; j ++) {
-    out0[j] = 0.0f;
-  }
-  
   /* start input at beginning. Output has a frame of silence. */
-  insize = 0;
-  outstart = 0;
-  outsize = framesize;
+  windowing.setFrameSize(MKBUFSIZE(bufsizep));
+  windowshape = -1.0f;
+  updatewindowshape();
 
-  setInitialDelay(framesize);
+  setInitialDelay(windowing.getLatency());
   changed = 0;
   needIdle();
 
@@ -113,7 +86,7 @@ long PLUGIN::fxIdle() {
 }
 
 /* tail is the same as delay, of course */
-long PLUGIN::getGetTailSize() { return framesize; }
+long PLUGIN::getGetTailSize() { return windowing.getLatency(); }
 
 void PLUGIN::setParameter(long index, float value) {
   switch (index) {
@@ -204,7 +177,7 @@ void PLUGIN::getParameterLabel(long index, char *label) {
    best to just use the windowing setup for functions that
    operate entirely within one buffer.
 */
-void PLUGIN::processw(float * in, float * out, long samples) {
+void PLUGIN::processw(float const * in, float * out, long samples) {
 
   /* XXX memset */
   for(int u=0; u < samples; u ++) out[u] = 0.0f;
@@ -241,120 +214,50 @@ void PLUGIN::processw(float * in, float * out, long samples) {
 }
 
 
-/* this fake processX function reads samples one at a time
-   from the true input. It simultaneously copies samples from
-   the beginning of the output buffer to the true output.
-   We maintain that out0 always has at least 'third' samples
-   in it; this is enough to pick up for the delay of input
-   processing and to make sure we always have enough samples
-   to fill the true output buffer.
-
-   If the input frame is full:
-    - calls wprocess on this full input frame
-    - applies the windowing envelope to the tail of out0 (output frame)
-    - mixes in prevmix with the first half of the output frame
-    - increases outsize so that the first half of the output frame is
-      now available output
-    - copies the second half of the output to be prevmix for next frame.
-    - copies the second half of the input buffer to the first,
-      resets the size (thus we process each third-size chunk twice)
-
-  If we have read more than 'third' samples out of the out0 buffer:
-   - Slide contents to beginning of buffer
-   - Reset outstart
-
-*/
-
-/* to improve: 
-   - use memcpy and arithmetic instead of
-     sample-by-sample copy 
-   - can we use tail of out0 as prevmix, instead of copying?
-   - can we use circular buffers instead of memmoving a lot
-     (probably not)
-*/
+/* the envelope is only rebuilt when the shape parameter has
+   moved into a different shape */
+void PLUGIN::updatewindowshape() {
+  if (shape == windowshape) return;
+  windowshape = shape;
+
+  using WindowShape = decltype(windowing)::WindowShape;
+  if (shape < 0.20f) {
+    windowing.setWindowShape(WindowShape::Wedge);
+  } else if (shape < 0.40f) {
+    windowing.setWindowShape(WindowShape::Arrow);
+  } else if (shape < 0.60f) {
+    windowing.setWindowShape(WindowShape::Triangle);
+  } else if (shape < 0.80f) {
+    windowing.setWindowShape(WindowShape::Cosine);
+  } else {
+    /* 'second half': only the middle half of each frame gets through */
+    windowing.setWindowShape([](float phase) { return (phase < 0.5f) ? 0.0f : 1.0f; });
+  }
+}
 
+/* the windowing engine hands overlapping frames of the true input
+   to processw, windows the results and overlap-adds them, so the
+   true output comes out one frame late. */
 void PLUGIN::processX(float **trueinputs, float **trueoutputs, long samples, 
 		      int replacing) {
   float * tin  = *trueinputs;
   float * tout = *trueoutputs;
 
-  for (int ii = 0; ii < samples; ii++) {
-
-    /* copy sample in */
-    in0[insize] = tin[ii];
-    insize ++;
- 
-    if (insize == framesize) {
-      /* frame is full! */
-
-      /* in0 -> process -> out0(first free space) */
-      processw(in0, out0+outstart+outsize, framesize);
-
-      float oneDivThird = 1.0f / (float)third;
-      /* apply envelope */
-
-      if (shape < 0.20f) {
-	for(int z = 0; z < third; z++) {
-	  float p = sqrtf((float)z * oneDivThird);
-	  out0[z+outstart+outsize] *= p;
-	  out0[z+outstart+outsize+third] *= (1.0f - p);
-	}
-      } else if (shape < 0.40f) {
-	for(int z = 0; z < third; z++) {
-	  float p = (float)z * oneDivThird;
-	  p *= p;
-	  out0[z+outstart+outsize] *= p;
-	  out0[z+outstart+outsize+third] *= (1.0f - p);
-	}
-      } else if (shape < 0.60f) {
-	for(int z = 0; z < third; z++) {
-	  out0[z+outstart+outsize] *= ((float)z * oneDivThird);
-	  out0[z+outstart+outsize+third] *= (1.0f - ((float)z * oneDivThird));
-	}
-      } else if (shape < 0.80f) {
-	for(int z = 0; z < third; z ++) {
-	  float p = 0.5f * (-cos(float(pi * ((float)z * oneDivThird))) + 1.0f);
-	  out0[z+outstart+outsize] *= p;
-	  out0[z+outstart+outsize+third] *= (1.0f - p);
-	}
-      } else {
-	/* 'second half */
-	int z;
-	for(z = 0; z < (third>>1); z++)
-	  out0[z+outstart+outsize] = 0.0f;
-
-	for(; z < third; z ++)
-	  out0[z+outstart+outsize+third] = 0.0f;
-
-      }
-
-      /* mix in prevmix */
-      for(int u = 0; u < third; u ++)
-	out0[u+outstart+outsize] += prevmix[u];
-
-      /* prevmix becomes out1 */
-      memcpy(prevmix, out0 + outstart + outsize + third, third * sizeof (float));
-
-      /* copy 2nd third of input over in0 (need to re-use it for next frame), 
-	 now insize = third */
-      memcpy(in0, in0 + third, third * sizeof (float));
-
-      insize = third;
-      
-      outsize += third;
-    }
-
-    /* send sample out */
-    if (replacing) tout[ii] = out0[outstart];
-    else tout[ii] += out0[outstart];
-
-    outstart ++;
-    outsize --;
-
-    /* make sure there is always enough room for a frame in out buffer */
-    if (outstart == third) {
-      memmove(out0, out0 + outstart, outsize * sizeof (float));
-      outstart = 0;
+  updatewindowshape();
+
+  auto const processframe = [this](float const * in, float * out, size_t frame) {
+    processw(in, out, (long)frame);
+  };
+
+  if (replacing) {
+    windowing.process(std::span<float const>(tin, samples), std::span<float>(tout, samples), processframe);
+  } else {
+    /* accumulating: render in pieces and add them to the true output */
+    float accum[512];
+    for (long ii = 0; ii < samples; ii += 512) {
+      long const n = std::min(samples - ii, 512L);
+      windowing.process(std::span<float const>(tin + ii, n), std::span<float>(accum, n), processframe);
+      for (long jj = 0; jj < n; jj++) tout[ii + jj] += accum[jj];
     }
   }
 }
@@ -1,5 +1,5 @@
 /*---------------------------------------------------------------
-Copyright (C) 2002-2025  Tom Murphy 7
+Copyright (C) 2002-2026  Tom Murphy 7
 
 This file is part of Vardelay.
 
@@ -25,10 +25,13 @@ Vardelay, featuring the Super Destroy FX Windowing System!
 #ifndef DFX_VARDELAY_H
 #define DFX_VARDELAY_H
 
+#include <algorithm>
 #include <array>
 #include <audioeffectx.h>
 #include <vstgui.h>
 
+#include "dfxwindowing.h"
+
 #ifdef WIN32
 /* turn off warnings about default but no cases in switch, etc. */
    #pragma warning( disable : 4065 57 4200 4244 )
@@ -108,7 +111,7 @@ public:
   virtual void resume();
   virtual long fxIdle();
 
-  virtual void processw(float * in, float * out, long samples);
+  virtual void processw(float const * in, float * out, long samples);
 
   bool getVendorString(char *text) {
     strcpy (text, "Destroy FX");
@@ -149,33 +152,18 @@ protected:
   float bufsizep;
   /* shape of envelope */
   float shape;
+  /* the shape that the window envelope was last built for */
+  float windowshape = -1.0f;
 
-  /* input and output buffers. out is framesize*2 samples long, in is framesize
-     samples long. (for maximum framesize)
-  */
-  float * in0, * out0;
-
-  /* third-sized tail of previous processed frame. already has mixing envelope
-     applied.
-   */
-  float * prevmix;
-
-  /* number of samples in in0 */
-  int insize;
-
-  /* number of samples and starting position of valid samples in out0 */
-  int outsize;
-  int outstart;
+  void updatewindowshape();
 
   static constexpr std::array buffersizes {
     2, 4, 8, 16, 32, 64, 128, 256, 512,
     1024, 2048, 4096, 8192, 16384, 32768
   };
 
-  /* buffersize is 3 * third, framesize is 2 * third 
-     buffersize is used for outbuf.
-  */
-  long bufsize, framesize, third;
+  /* overlapping input frames for processw, overlap-added output */
+  dfx::OverlapAdd<float> windowing {static_cast<size_t>(*std::ranges::max_element(buffersizes))};
 
   /* 1 if need to do ioChanged since buffer settings are different now */
   int changed;
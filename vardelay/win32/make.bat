@@ -1,3 +1,3 @@
 
-cl /nologo /O2 /Ot /Og /Oi /Oy /Gs /GD /I..\vstsdk\ /LD ..\vardelay\vardelay.cpp ..\vstsdk\AudioEffect.cpp ..\vstsdk\audioeffectx.cpp vardelay.def "/Fec:\progra~1\steinberg\vstplugins\DFX Vardelay.dll"
+cl /nologo /O2 /Ot /Og /Oi /Oy /Gs /GD /I..\vstsdk\ /I..\dfx-library\ /LD ..\vardelay\vardelay.cpp ..\vstsdk\AudioEffect.cpp ..\vstsdk\audioeffectx.cpp vardelay.def "/Fec:\progra~1\steinberg\vstplugins\DFX Vardelay.dll"
 
@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2002-2023  Tom Murphy 7
+Copyright (C) 2002-2026  Tom Murphy 7
 
 This file is part of Windowingstub.
 
@@ -78,43 +78,43 @@ PLUGIN::PLUGIN(TARGET_API_BASE_INSTANCE_TYPE inInstance)
 
 PLUGINCORE::PLUGINCORE(DfxPlugin& inInstance)
   : DfxPluginCore(inInstance) {
-  /* determine the size of the largest window size */
-  constexpr auto maxframe = *std::ranges::max_element(buffersizes);
-
-  /* add some leeway? */
-  in0.assign(maxframe, 0.f);
-  out0.assign(maxframe * 2, 0.f);
-
-  /* prevmix is only a single third long */
-  prevmix.assign(maxframe / 2, 0.f);
 }
 
 void PLUGINCORE::reset() {
 
-  framesize = buffersizes.at(getparameter_i(P_BUFSIZE));
-  third = framesize / 2;
-  bufsize = third * 3;
-
-  /* set up buffers. Prevmix and first frame of output are always 
-     filled with zeros. */
-
-
-  std::fill_n(prevmix.begin(), third, 0.f);
-  std::fill_n(out0.begin(), framesize, 0.f);
-  
   /* start input at beginning. Output has a frame of silence. */
-  insize = 0;
-  outstart = 0;
-  outsize = framesize;
+  windowing.setFrameSize(dfx::math::ToUnsigned(buffersizes.at(getparameter_i(P_BUFSIZE))));
+  updatewindowshape();
 
-  getplugin().setlatency_samples(dfx::math::ToUnsigned(framesize));
+  getplugin().setlatency_samples(windowing.getLatency());
   /* tail is the same as delay, of course */
-  getplugin().settailsize_samples(dfx::math::ToUnsigned(framesize));
+  getplugin().settailsize_samples(windowing.getLatency());
+}
+
+void PLUGINCORE::updatewindowshape() {
+
+  using WindowShape = decltype(windowing)::WindowShape;
+  switch (getparameter_i(P_SHAPE)) {
+    case WINDOW_TRIANGLE:
+    default:
+      windowing.setWindowShape(WindowShape::Triangle);
+      break;
+    case WINDOW_ARROW:
+      windowing.setWindowShape(WindowShape::Arrow);
+      break;
+    case WINDOW_WEDGE:
+      windowing.setWindowShape(WindowShape::Wedge);
+      break;
+    case WINDOW_COS:
+      windowing.setWindowShape(WindowShape::Cosine);
+      break;
+  }
 }
 
 void PLUGINCORE::processparameters() {
 
-  shape = getparameter_i(P_SHAPE);
+  if (getparameterchanged(P_SHAPE))
+    updatewindowshape();
 
   #ifdef TARGET_API_VST
     /* this tells the host to call a suspend()-resume() pair, 
@@ -134,114 +134,15 @@ void PLUGINCORE::processw(float const * in, float * out, long samples) {
 }
 
 
-/* this fake process function reads samples one at a time
-   from the true input. It simultaneously copies samples from
-   the beginning of the output buffer to the true output.
-   We maintain that out0 always has at least 'third' samples
-   in it; this is enough to pick up for the delay of input
-   processing and to make sure we always have enough samples
-   to fill the true output buffer.
-
-   If the input frame is full:
-    - calls wprocess on this full input frame
-    - applies the windowing envelope to the tail of out0 (output frame)
-    - mixes in prevmix with the first half of the output frame
-    - increases outsize so that the first half of the output frame is
-      now available output
-    - copies the second half of the output to be prevmix for next frame.
-    - copies the second half of the input buffer to the first,
-      resets the size (thus we process each third-size chunk twice)
-
-  If we have read more than 'third' samples out of the out0 buffer:
-   - Slide contents to beginning of buffer
-   - Reset outstart
-
-*/
-
-/* to improve: 
-   - can we use tail of out0 as prevmix, instead of copying?
-   - can we use circular buffers instead of memmoving a lot?
-     (probably not)
-*/
-
-
+/* the windowing engine reads the true input into frames that
+   overlap by half, calls processw on each full frame, applies the
+   window envelope, and mixes the result with the overlapping half
+   of the previous frame before it reaches the true output. The
+   output lags the input by one frame. */
 void PLUGINCORE::process(std::span<float const> tin, std::span<float> tout) {
-
-  for (size_t i = 0; i < tout.size(); i++) {
-
-    /* copy sample in */
-    in0[insize] = tin[i];
-    insize ++;
- 
-    if (insize == framesize) {
-      /* frame is full! */
-
-      /* in0 -> process -> out0(first free space) */
-      processw(in0.data(), out0.data()+outstart+outsize, framesize);
-
-      float oneDivThird = 1.0f / (float)third;
-      /* apply envelope */
-
-      switch(shape) {
-
-        case WINDOW_TRIANGLE:
-          for(int z = 0; z < third; z++) {
-            out0[z+outstart+outsize] *= ((float)z * oneDivThird);
-            out0[z+outstart+outsize+third] *= (1.0f - ((float)z * oneDivThird));
-          }
-          break;
-        case WINDOW_ARROW:
-          for(int z = 0; z < third; z++) {
-            float p = (float)z * oneDivThird;
-            p *= p;
-            out0[z+outstart+outsize] *= p;
-            out0[z+outstart+outsize+third] *= (1.0f - p);
-          }
-          break;
-        case WINDOW_WEDGE:
-          for(int z = 0; z < third; z++) {
-            float p = std::sqrt((float)z * oneDivThird);
-            out0[z+outstart+outsize] *= p;
-            out0[z+outstart+outsize+third] *= (1.0f - p);
-          }
-          break;
-        case WINDOW_COS:
-          for(int z = 0; z < third; z ++) {
-            float p = 0.5f * (-std::cos(PI * ((float)z * oneDivThird)) + 1.0f);
-            out0[z+outstart+outsize] *= p;
-            out0[z+outstart+outsize+third] *= (1.0f - p);
-          }
-          break;
-      }
-
-      /* mix in prevmix */
-      for(int u = 0; u < third; u ++)
-        out0[u+outstart+outsize] += prevmix[u];
-
-      /* prevmix becomes out1 */
-      std::copy_n(std::next(out0.cbegin(), outstart + outsize + third), third, prevmix.begin());
-
-      /* copy 2nd third of input over in0 (need to re-use it for next frame), 
-         now insize = third */
-      std::copy_n(std::next(in0.cbegin(), third), third, in0.begin());
-
-      insize = third;
-      
-      outsize += third;
-    }
-
-    /* send sample out */
-    tout[i] = out0[outstart];
-
-    outstart ++;
-    outsize --;
-
-    /* make sure there is always enough room for a frame in out buffer */
-    if (outstart == third) {
-      memmove(out0.data(), out0.data() + outstart, outsize * sizeof (float));
-      outstart = 0;
-    }
-  }
+  windowing.process(tin, tout, [this](float const * in, float * out, size_t samples) {
+    processw(in, out, static_cast<long>(samples));
+  });
 }
 
 
@@ -1,5 +1,5 @@
 /*------------------------------------------------------------------------
-Copyright (C) 2002-2023  Tom Murphy 7
+Copyright (C) 2002-2026  Tom Murphy 7
 
 This file is part of Windowingstub.
 
@@ -24,9 +24,10 @@ Windowingstub, starring the Super Destroy FX Windowing System!
 #pragma once
 
 #include "dfxplugin.h"
+#include "dfxwindowing.h"
 
+#include <algorithm>
 #include <array>
-#include <vector>
 
 /* change these for your plugins */
 #define PLUGIN Windowingstub
@@ -72,34 +73,16 @@ public:
   void processparameters() override;
   void process(std::span<float const> in, std::span<float> out) override;
 
-  long getwindowsize() const noexcept { return third; }
+  long getwindowsize() const noexcept { return static_cast<long>(windowing.getHopSize()); }
 
  private:
 
-  /* input and output buffers. out is framesize*2 samples long, in is framesize
-     samples long. (for maximum framesize)
-  */
-  std::vector<float> in0, out0;
-
-  /* bufsize is 3 * third, framesize is 2 * third 
-     bufsize is used for outbuf.
-  */
-  long bufsize = 0, framesize = 0, third = 0;
-
   void processw(float const * in, float * out, long samples);
 
-  int shape = 0;
-
-  /* third-sized tail of previous processed frame. already has mixing envelope
-     applied.
-   */
-  std::vector<float> prevmix;
-
-  /* number of samples in in0 */
-  int insize = 0;
+  void updatewindowshape();
 
-  /* number of samples and starting position of valid samples in out0 */
-  int outsize = 0;
-  int outstart = 0;
+  /* chops the input into overlapping frames for processw and
+     overlaps the enveloped results back into the output */
+  dfx::OverlapAdd<float> windowing {static_cast<size_t>(*std::ranges::max_element(buffersizes))};
 
 };